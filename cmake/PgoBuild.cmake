@@ -0,0 +1,135 @@
+########################################################################
+# Profile-guided optimized build (GCC or Clang), run with
+#   cmake -DSOURCE_DIR=<src> -DBINARY_DIR=<dir> -P cmake/PgoBuild.cmake
+# or use the "pgo" target of a configured build tree.
+#
+# - builds a plain Release rtl_433 in <dir>/base for comparison,
+# - generates the synthetic workload (tests/workload-gen.c) in <dir>/workload,
+# - builds an instrumented rtl_433 in <dir>/opt and runs it on the workload,
+# - rebuilds <dir>/opt with the profile and LTO,
+# - benchmarks the base and the optimized rtl_433 on the workload.
+#
+# Options given as -D are passed on to the builds: ENABLE_RTLSDR,
+# ENABLE_SOAPYSDR, ENABLE_OPENSSL, ENABLE_ZLIB, ENABLE_THREADS,
+# CMAKE_C_COMPILER, CMAKE_TOOLCHAIN_FILE, and WORKLOAD_ROUNDS (default 8),
+# BENCHMARK_RUNS (default 5).
+# Everything runs offline, the workload is generated from a fixed seed.
+########################################################################
+cmake_minimum_required(VERSION 3.13)
+
+if(NOT SOURCE_DIR OR NOT BINARY_DIR)
+    message(FATAL_ERROR "Usage: cmake -DSOURCE_DIR=<src> -DBINARY_DIR=<dir> -P PgoBuild.cmake")
+endif()
+if(NOT WORKLOAD_ROUNDS)
+    set(WORKLOAD_ROUNDS 8)
+endif()
+if(NOT BENCHMARK_RUNS)
+    set(BENCHMARK_RUNS 5)
+endif()
+
+set(BUILD_ARGS -DCMAKE_BUILD_TYPE=Release)
+foreach(var ENABLE_RTLSDR ENABLE_SOAPYSDR ENABLE_OPENSSL ENABLE_ZLIB ENABLE_THREADS CMAKE_C_COMPILER CMAKE_TOOLCHAIN_FILE)
+    if(DEFINED ${var} AND NOT "${${var}}" STREQUAL "")
+        list(APPEND BUILD_ARGS "-D${var}=${${var}}")
+    endif()
+endforeach()
+
+set(BASE_DIR "${BINARY_DIR}/base")
+set(OPT_DIR "${BINARY_DIR}/opt")
+set(WORKLOAD_DIR "${BINARY_DIR}/workload")
+set(PROFILE_DIR "${BINARY_DIR}/profile")
+
+function(run_step name)
+    message(STATUS "PGO: ${name}")
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(result)
+        message(FATAL_ERROR "PGO: ${name} failed (${result})")
+    endif()
+endfunction()
+
+function(configure_and_build dir)
+    run_step("configure ${dir}" ${CMAKE_COMMAND} -S "${SOURCE_DIR}" -B "${dir}" ${BUILD_ARGS} ${ARGN})
+    run_step("build ${dir}" ${CMAKE_COMMAND} --build "${dir}" --parallel --target rtl_433 workload-gen)
+endfunction()
+
+# the workload: IQ samples with OOK, FSK and Gridstream at all three bit rates, and OOK pulse data
+set(WORKLOAD_ARGS
+    -r "${WORKLOAD_DIR}/workload_915M_1000k.cu8"
+    -r "${WORKLOAD_DIR}/workload_1000k.ook"
+    -F "json:${WORKLOAD_DIR}/events.json"
+    -F log)
+
+configure_and_build("${BASE_DIR}" -DPGO_MODE=OFF)
+
+file(MAKE_DIRECTORY "${WORKLOAD_DIR}")
+run_step("generate workload" "${BASE_DIR}/tests/workload-gen" "${WORKLOAD_DIR}" ${WORKLOAD_ROUNDS})
+
+# GCC profile data is tied to the object paths, instrumented and optimized build share a tree
+file(REMOVE_RECURSE "${PROFILE_DIR}")
+file(MAKE_DIRECTORY "${PROFILE_DIR}")
+configure_and_build("${OPT_DIR}" -DPGO_MODE=GENERATE "-DPGO_PROFILE_DIR=${PROFILE_DIR}")
+run_step("train" "${OPT_DIR}/src/rtl_433" ${WORKLOAD_ARGS})
+
+file(GLOB PROFRAW_FILES "${PROFILE_DIR}/*.profraw")
+if(PROFRAW_FILES)
+    # Clang writes raw profiles which need merging
+    get_filename_component(COMPILER_DIR "${CMAKE_C_COMPILER}" DIRECTORY)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata llvm-profdata-18 llvm-profdata-17 llvm-profdata-16
+        llvm-profdata-15 llvm-profdata-14 llvm-profdata-13 HINTS "${COMPILER_DIR}")
+    if(NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "PGO: llvm-profdata not found, needed to merge the Clang profile.")
+    endif()
+    run_step("merge profile" "${LLVM_PROFDATA}" merge -o "${PROFILE_DIR}/rtl_433.profdata" ${PROFRAW_FILES})
+endif()
+
+run_step("configure ${OPT_DIR}" ${CMAKE_COMMAND} -S "${SOURCE_DIR}" -B "${OPT_DIR}" ${BUILD_ARGS} -DPGO_MODE=USE "-DPGO_PROFILE_DIR=${PROFILE_DIR}")
+run_step("clean ${OPT_DIR}" ${CMAKE_COMMAND} --build "${OPT_DIR}" --target clean)
+run_step("build ${OPT_DIR}" ${CMAKE_COMMAND} --build "${OPT_DIR}" --parallel --target rtl_433)
+
+# benchmark, best of the runs, the wall time has sub-second resolution with CMake 3.23+ only
+function(benchmark binary out_var)
+    set(best "")
+    foreach(run RANGE 1 ${BENCHMARK_RUNS})
+        if(CMAKE_VERSION VERSION_LESS 3.23)
+            string(TIMESTAMP start "%s")
+        else()
+            string(TIMESTAMP start "%s%f")
+        endif()
+        execute_process(COMMAND "${binary}" ${WORKLOAD_ARGS} RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+        if(CMAKE_VERSION VERSION_LESS 3.23)
+            string(TIMESTAMP end "%s")
+            math(EXPR elapsed "(${end} - ${start}) * 1000")
+        else()
+            string(TIMESTAMP end "%s%f")
+            math(EXPR elapsed "(${end} - ${start}) / 1000")
+        endif()
+        if(result)
+            message(FATAL_ERROR "PGO: benchmark of ${binary} failed (${result})")
+        endif()
+        if(best STREQUAL "" OR elapsed LESS best)
+            set(best ${elapsed})
+        endif()
+    endforeach()
+    set(${out_var} ${best} PARENT_SCOPE)
+endfunction()
+
+message(STATUS "PGO: benchmark, best of ${BENCHMARK_RUNS} runs")
+benchmark("${BASE_DIR}/src/rtl_433" base_ms)
+benchmark("${OPT_DIR}/src/rtl_433" opt_ms)
+if(opt_ms GREATER 0)
+    math(EXPR gain_pct "(${base_ms} - ${opt_ms}) * 100 / ${base_ms}")
+    math(EXPR speedup_x100 "${base_ms} * 100 / ${opt_ms}")
+    math(EXPR speedup_int "${speedup_x100} / 100")
+    math(EXPR speedup_frac "${speedup_x100} % 100")
+    if(speedup_frac LESS 10)
+        set(speedup_frac "0${speedup_frac}")
+    endif()
+else()
+    set(gain_pct "?")
+    set(speedup_int "?")
+    set(speedup_frac "?")
+endif()
+message(STATUS "PGO: Release     ${base_ms} ms  ${BASE_DIR}/src/rtl_433")
+message(STATUS "PGO: PGO+LTO     ${opt_ms} ms  ${OPT_DIR}/src/rtl_433")
+cmake_host_system_information(RESULT cpu QUERY PROCESSOR_DESCRIPTION)
+message(STATUS "PGO: ${gain_pct}% less time, ${speedup_int}.${speedup_frac}x speedup on ${cpu}")
@@ -29,18 +29,39 @@
 typedef uint8_t bitrow_t[BITBUF_COLS];
 typedef bitrow_t bitarray_t[BITBUF_ROWS];
 
-/// Bit buffer.
+/** Bit buffer.
+
+    The repeat analyses (compare, count, find repeated rows) and the inverted
+    copy are cached in the bitbuffer itself. Each decoder slices its own
+    bitbuffer, the cache lives as long as that slice, i.e. one decoder and one
+    package, it is not shared across decoders. The mutators clear the stamp,
+    code writing to `bb` or `bits_per_row` directly, or copying a bitbuffer,
+    needs to call bitbuffer_invalidate().
+*/
 typedef struct bitbuffer {
     uint16_t num_rows;                      ///< Number of active rows
     uint16_t free_row;                      ///< Index of next free row
     uint16_t bits_per_row[BITBUF_ROWS];     ///< Number of active bits per row
     uint16_t syncs_before_row[BITBUF_ROWS]; ///< Number of sync pulses before row
     bitarray_t bb;                          ///< The actual bits buffer
+    uint32_t stamp;                         ///< Analysis cache stamp, 0 if the content changed
+    uint32_t repeat_stamp;                  ///< Stamp the repeat groups were computed at
+    uint16_t repeat_bits;                   ///< Prefix length the repeat groups were computed for
+    uint8_t repeat_group[BITBUF_ROWS];      ///< First row with equal content, per row
+    uint8_t repeat_count[BITBUF_ROWS];      ///< Number of rows with equal content, per row
+    uint32_t inverted_stamp;                ///< Stamp the inverted copy was computed at
+    struct bitbuffer const *inverted;       ///< Inverted copy, in the storage given to bitbuffer_inverted()
 } bitbuffer_t;
 
 /// Clear the content of the bitbuffer.
 void bitbuffer_clear(bitbuffer_t *bits);
 
+/// Mark the analysis cache stale, needed after writing to `bb` or `bits_per_row` directly.
+static inline void bitbuffer_invalidate(bitbuffer_t *bits)
+{
+    bits->stamp = 0;
+}
+
 /// Add a single bit at the end of the bitbuffer (MSB first).
 void bitbuffer_add_bit(bitbuffer_t *bits, int bit);
 
@@ -145,6 +166,14 @@ int bitbuffer_find_repeated_row(bitbuffer_t *bits, unsigned min_repeats, unsigne
 /// @return the row index or -1.
 int bitbuffer_find_repeated_prefix(bitbuffer_t *bits, unsigned min_repeats, unsigned min_bits);
 
+/// Get an inverted copy of the bitbuffer.
+///
+/// The copy is cached in the bitbuffer and reused until the bitbuffer changes.
+/// If it isn't cached it is computed into @p storage, which needs to outlive
+/// the use of the copy, NULL only looks up the cache.
+/// Decoders use decoder_bitbuffer_inverted() which provides the storage.
+bitbuffer_t const *bitbuffer_inverted(bitbuffer_t *bits, bitbuffer_t *storage);
+
 /// Return a single bit from a bitrow at bit_idx position.
 static inline uint8_t bitrow_get_bit(uint8_t const *bitrow, unsigned bit_idx)
 {
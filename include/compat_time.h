@@ -9,6 +9,8 @@
 #ifndef INCLUDE_COMPAT_TIME_H_
 #define INCLUDE_COMPAT_TIME_H_
 
+#include <stdint.h>
+
 // ensure struct timeval is known
 #ifdef _WIN32
 #include <winsock2.h>
@@ -25,6 +27,12 @@
 */
 int timeval_subtract(struct timeval *result, struct timeval *x, struct timeval *y);
 
+/** Monotonic time for measuring durations, not affected by steps of the wall clock.
+
+    @return microseconds since an unspecified start
+*/
+uint64_t monotonic_time_us(void);
+
 // platform-specific functions
 
 #ifdef _WIN32
@@ -40,6 +40,7 @@
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
     DATA_DATA,   /**< pointer to data is stored */
@@ -177,4 +178,12 @@ R_API void print_array_value(data_output_t *output, data_array_t *array, char co
 
 R_API size_t data_print_jsons(data_t *data, char *dst, size_t len);
 
+/** Encodes a data object as CBOR (RFC 8949), a compact binary form of the JSON output.
+
+    Objects become maps, arrays become arrays, strings become text strings,
+    integers and doubles become integers and floats (single precision if exact).
+    Returns the encoded length, the output is incomplete if this exceeds @p len.
+*/
+R_API size_t data_print_cbor(data_t *data, uint8_t *dst, size_t len);
+
 #endif // INCLUDE_DATA_H_
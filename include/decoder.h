@@ -13,4 +13,7 @@
 #include "util.h"
 #include "decoder_util.h"
 
+/// Sync words shared by the Fine Offset decoders, defined in fineoffset.c.
+extern struct sync_word const fineoffset_syncs[];
+
 #endif /* INCLUDE_DECODER_H_ */
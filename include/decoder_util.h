@@ -31,6 +31,31 @@
 /// Create a new r_device, copy from dev_template if not NULL.
 r_device *create_device(r_device const *dev_template);
 
+/// Get scratch memory for the running decode, valid until decode_fn returns.
+///
+/// The memory comes from an arena per decoder which is reset after each decode_fn,
+/// declare the usual need as `scratch_size` to allocate the arena once.
+/// Returns NULL on alloc failure.
+void *decoder_scratch(r_device *decoder, size_t size);
+
+/// Release all scratch memory of a decoder, called after each decode_fn.
+void decoder_scratch_reset(r_device *decoder);
+
+/// Free the scratch arena of a decoder.
+void decoder_scratch_free(r_device *decoder);
+
+/// Get an inverted copy of a bitbuffer, see bitbuffer_inverted().
+///
+/// The copy is kept in the scratch memory, valid until decode_fn returns.
+/// Returns NULL on alloc failure.
+bitbuffer_t const *decoder_bitbuffer_inverted(r_device *decoder, bitbuffer_t *bitbuffer);
+
+/// Find a sync word in a row, same as bitbuffer_search().
+///
+/// Uses the hits of the sync word scan before the decode if the pattern is one of
+/// the declared sync words (`r_device.syncs`), searches the row otherwise.
+unsigned decoder_sync_search(r_device *decoder, bitbuffer_t *bitbuffer, unsigned row, unsigned start, uint8_t const *pattern, unsigned pattern_bits_len);
+
 /// Output data.
 void decoder_output_data(r_device *decoder, data_t *data);
 
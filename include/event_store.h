@@ -0,0 +1,64 @@
+/** @file
+    Embedded indexed event store.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_EVENT_STORE_H_
+#define INCLUDE_EVENT_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct data;
+struct r_cfg;
+
+/** An event store is an append-only log of events in memory-mapped segment files.
+
+    Each record has a binary header, the device key ("model/id") and the JSON event.
+    Records of a device and of a model are chained newest to oldest, a per-device
+    index holds the newest record, the event count and the first and last seen time.
+    Segments keep a sparse time index. Queries follow the chains or the time index
+    and never scan the log.
+
+    The oldest segment is removed when the total size or the maximum age is exceeded,
+    the newest record of each device in it is carried over to the head segment first
+    (compaction), so the last event of a device outlives the retention.
+    The number of indexed devices is capped, the least recently seen are evicted.
+*/
+typedef struct event_store event_store_t;
+
+/// Open (or create) a store in @p dir, 0 limits mean the defaults.
+event_store_t *event_store_open(char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices);
+
+/// Close the store.
+void event_store_close(event_store_t *store);
+
+/// Append an event, returns 1 if the event was stored, 0 otherwise.
+int event_store_append(event_store_t *store, struct data *data, time_t now);
+
+typedef struct event_store_query {
+    char const *model; ///< optional model
+    char const *id;    ///< optional id, needs the model
+    time_t from;       ///< oldest time, 0 for any
+    time_t to;         ///< newest time, 0 for any
+    unsigned limit;    ///< maximum number of events, 0 for the default
+    uint64_t cursor;   ///< the "next" value of a previous answer, 0 to start with the newest event
+} event_store_query_t;
+
+/// Answer a query as JSON, newest events first, @p store may be NULL.
+///
+/// Returns the length written (as with data_print_jsons()), the output was
+/// truncated if the length plus 1 reaches @p size.
+size_t event_store_query(event_store_t *store, event_store_query_t const *query, char *buf, size_t size);
+
+/// Create an output which appends all events to a store in @p dir, the HTTP server queries it through @p cfg.
+struct data_output *data_output_store_create(struct r_cfg *cfg, char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices);
+
+#endif /* INCLUDE_EVENT_STORE_H_ */
@@ -0,0 +1,65 @@
+/** @file
+    Automatic frequency control for FSK packages.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_FSK_AFC_H_
+#define INCLUDE_FSK_AFC_H_
+
+#include <stdint.h>
+
+struct data;
+
+/// AFC modes, each mode includes the previous ones.
+enum fsk_afc_mode {
+    FSK_AFC_OFF     = 0, ///< no AFC
+    FSK_AFC_TRACK   = 1, ///< track the offset of decoded packages and seed the FSK estimators
+    FSK_AFC_LEARN   = 2, ///< learn the offset of each device and estimate the tuner drift
+    FSK_AFC_CORRECT = 3, ///< adjust the frequency correction by the estimated drift
+};
+
+/** AFC tracks the center offset (mean of F1 and F2) and the deviation of decoded
+    FSK packages as a running average, used to seed the estimators of new packages.
+
+    With learning each device (keyed by "model/id") gets a baseline offset from its
+    first packages, later packages show the device drift against the baseline.
+    The tuner drift is common to all devices, the median device drift is the
+    estimate, reported in ppm of the center frequency.
+    The number of devices is capped, the least recently seen are evicted.
+*/
+typedef struct fsk_afc fsk_afc_t;
+
+/// Create an AFC with the given mode.
+fsk_afc_t *fsk_afc_create(int mode);
+
+/// Free the AFC.
+void fsk_afc_free(fsk_afc_t *afc);
+
+/// Get the AFC mode.
+int fsk_afc_mode(fsk_afc_t const *afc);
+
+/// Forget all offsets, e.g. after a frequency change.
+void fsk_afc_reset(fsk_afc_t *afc);
+
+/// Update with the F1 and F2 offsets (in Hz) of a decoded package, @p key is the optional "model/id".
+void fsk_afc_update(fsk_afc_t *afc, float f1_hz, float f2_hz, char const *key);
+
+/// Get the expected F1 and F2 in FM sample units at @p samp_rate, returns 0 if there is no estimate yet.
+int fsk_afc_seed(fsk_afc_t const *afc, uint32_t samp_rate, int *fm_f1, int *fm_f2);
+
+/// Get the estimated tuner drift in ppm of @p frequency, returns 0 if there is no estimate yet.
+int fsk_afc_drift(fsk_afc_t *afc, uint32_t frequency, float *drift_ppm);
+
+/// Account for a change of the frequency correction by @p ppm at @p frequency.
+void fsk_afc_corrected(fsk_afc_t *afc, uint32_t frequency, int ppm);
+
+/// Create a stats report of the AFC state.
+struct data *fsk_afc_report(fsk_afc_t *afc, uint32_t frequency);
+
+#endif /* INCLUDE_FSK_AFC_H_ */
@@ -0,0 +1,53 @@
+/** @file
+    Gridstream mesh topology index.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_MESH_TOPOLOGY_H_
+#define INCLUDE_MESH_TOPOLOGY_H_
+
+#include <stddef.h>
+#include <time.h>
+
+struct data;
+
+/** A mesh topology is a directed graph built from Gridstream events.
+
+    Nodes are meters (LAN addresses) and collectors (WAN addresses),
+    edges are source to destination links seen in 0x55 and 0xD5 frames.
+    Edges carry a frame count, the last seen time and the RSSI (if levels
+    are reported). The number of nodes and edges is capped, entries not seen
+    for the maximum age are expired and the oldest entries are evicted first.
+*/
+typedef struct mesh_topology mesh_topology_t;
+
+enum mesh_topology_format {
+    MESH_TOPOLOGY_JSON,    ///< JSON adjacency list
+    MESH_TOPOLOGY_GRAPHML, ///< GraphML document
+};
+
+/// Create a topology index, 0 caps mean the defaults.
+mesh_topology_t *mesh_topology_new(unsigned max_nodes, unsigned max_edges, unsigned max_age);
+
+/// Free the topology index.
+void mesh_topology_free(mesh_topology_t *topo);
+
+/// Update the index from an event, returns 1 if the event was used, 0 otherwise.
+int mesh_topology_update(mesh_topology_t *topo, struct data *data, time_t now);
+
+/// Expire entries which are older than the maximum age.
+void mesh_topology_expire(mesh_topology_t *topo, time_t now);
+
+/// Print a snapshot of the topology, @p topo may be NULL for an empty graph.
+///
+/// Returns the length written (as with data_print_jsons()), the output was
+/// truncated if the length plus 1 reaches @p size.
+size_t mesh_topology_print(mesh_topology_t const *topo, int format, char *buf, size_t size);
+
+#endif /* INCLUDE_MESH_TOPOLOGY_H_ */
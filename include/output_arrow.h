@@ -0,0 +1,30 @@
+/** @file
+    Arrow IPC stream output for rtl_433 events.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_OUTPUT_ARROW_H_
+#define INCLUDE_OUTPUT_ARROW_H_
+
+#include "data.h"
+
+#include <stddef.h>
+
+struct r_cfg;
+
+/** Create an Arrow output writing one IPC stream file per decoder model to @p dir.
+
+    Rows are buffered per model and written as a record batch once @p max_rows rows
+    or @p max_bytes bytes are buffered or the oldest row is @p max_secs seconds old,
+    0 means the default. The schema of a model is the list of well-known and decoder
+    fields, the column types are taken from the values in the first record batch.
+*/
+struct data_output *data_output_arrow_create(struct r_cfg *cfg, char const *dir, unsigned max_rows, size_t max_bytes, unsigned max_secs);
+
+#endif /* INCLUDE_OUTPUT_ARROW_H_ */
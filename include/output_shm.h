@@ -0,0 +1,22 @@
+/** @file
+    Shared memory ring output for rtl_433 events.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_OUTPUT_SHM_H_
+#define INCLUDE_OUTPUT_SHM_H_
+
+#include "data.h"
+
+#include <stddef.h>
+
+/// Create a shared memory ring output at @p path with a data area of @p size bytes (rounded to a power of 2).
+struct data_output *data_output_shm_create(int log_level, char const *path, size_t size);
+
+#endif /* INCLUDE_OUTPUT_SHM_H_ */
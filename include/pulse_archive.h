@@ -0,0 +1,57 @@
+/** @file
+    Pulse-level archive of detected packages.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_PULSE_ARCHIVE_H_
+#define INCLUDE_PULSE_ARCHIVE_H_
+
+#include <stdint.h>
+#include "pulse_data.h"
+
+/** A pulse archive is an append-only file of detected OOK and FSK packages.
+
+    Each package is a record of the time, sample offset, sample rate, frequencies,
+    levels and estimates, followed by the pulse and gap widths. All values are
+    varints, widths and most fields are delta coded against the previous value.
+    Records are collected in blocks of at most 64 KiB (or one minute), each block
+    is deflated (if built with zlib) and written with a header carrying the time
+    range. The block headers are the time index: a reader skips blocks outside
+    the wanted time range without reading or inflating them.
+
+    A block is only written complete, a truncated last block (e.g. after a crash)
+    is dropped when the archive is opened for appending again.
+*/
+typedef struct pulse_archive pulse_archive_t;
+
+/// Open an archive for appending, creates it if needed, @p truncate starts a new archive.
+pulse_archive_t *pulse_archive_create(char const *path, int truncate);
+
+/// Append a package, @p fsk is set for FSK packages, @p time_us is the unix time in microseconds.
+int pulse_archive_write(pulse_archive_t *archive, pulse_data_t const *data, int fsk, int64_t time_us);
+
+/// Write the pending block and close the archive.
+void pulse_archive_close(pulse_archive_t *archive);
+
+/// Called for each replayed package, the pulse data may be modified.
+typedef int (*pulse_archive_cb)(pulse_data_t *data, int fsk, int64_t time_us, void *ctx);
+
+/** Replay an archive, @p spec is "path[,from=<time>][,to=<time>][,jobs=<n>]".
+
+    The times are unix seconds or "YYYY-MM-DD[THH:MM[:SS]]" in local time.
+    With jobs (default: the number of CPU cores) the blocks are split in time
+    slices, each decoded by a worker process. The workers share the outputs of the
+    caller and exit right after their slice, the main process waits for all workers.
+    Use jobs=1 if the outputs can't be shared, e.g. files that aren't line oriented.
+
+    @return the number of packages replayed by this process, -1 on error
+*/
+int pulse_archive_replay(char const *spec, pulse_archive_cb cb, void *ctx);
+
+#endif /* INCLUDE_PULSE_ARCHIVE_H_ */
@@ -39,6 +39,8 @@ typedef struct pulse_data {
     int ook_high_estimate;    ///< Estimate for the OOK high level at end of package.
     int fsk_f1_est;           ///< Estimate for the F1 frequency for FSK.
     int fsk_f2_est;           ///< Estimate for the F2 frequency for FSK.
+    int fsk_f1_avg;           ///< Average of the F1 frequency samples while the carrier is on for FSK.
+    int fsk_f2_avg;           ///< Average of the F2 frequency samples while the carrier is on for FSK.
     float freq1_hz;
     float freq2_hz;
     float centerfreq_hz;
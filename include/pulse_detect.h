@@ -29,6 +29,7 @@ enum {
     FSK_PULSE_DETECT_OLD,
     FSK_PULSE_DETECT_NEW,
     FSK_PULSE_DETECT_AUTO,
+    FSK_PULSE_DETECT_BLOCK,
     FSK_PULSE_DETECT_END,
 };
 
@@ -48,6 +49,13 @@ void pulse_detect_free(pulse_detect_t *pulse_detect);
 /// @param verbosity Debug output verbosity, 0=None, 1=Levels, 2=Histograms
 void pulse_detect_set_levels(pulse_detect_t *pulse_detect, int use_mag_est, float fixed_high_level, float min_high_level, float high_low_ratio, int verbosity);
 
+/// Set the expected FSK frequencies to seed the estimators of new packages, e.g. from AFC.
+///
+/// @param pulse_detect The pulse_detect instance
+/// @param fm_f1 Expected F1 (high) frequency in FM sample units, 0 for none
+/// @param fm_f2 Expected F2 (low) frequency in FM sample units, 0 for none
+void pulse_detect_set_fsk_seed(pulse_detect_t *pulse_detect, int fm_f1, int fm_f2);
+
 /// Demodulate On/Off Keying (OOK) and Frequency Shift Keying (FSK) from an envelope signal.
 ///
 /// Function is stateful and can be called with chunks of input data.
@@ -31,6 +31,13 @@ typedef struct {
 
     int fm_f1_est; ///< Estimate for the F1 frequency for FSK
     int fm_f2_est; ///< Estimate for the F2 frequency for FSK
+    int fm_f1_seed; ///< Expected F1 frequency from AFC, 0 if not seeded
+    int fm_f2_seed; ///< Expected F2 frequency from AFC, 0 if not seeded
+
+    int64_t fm_f1_sum;     ///< Sum of the F1 samples, to average the frequency while the carrier is on
+    int64_t fm_f2_sum;     ///< Sum of the F2 samples
+    unsigned fm_f1_count;  ///< Number of F1 samples
+    unsigned fm_f2_count;  ///< Number of F2 samples
 
     int16_t var_test_max;
     int16_t var_test_min;
@@ -45,6 +52,15 @@ typedef struct {
 /// @param s Internal state
 void pulse_detect_fsk_init(pulse_detect_fsk_t *s);
 
+/// Seed the estimators of a new package with expected frequencies, e.g. from AFC.
+///
+/// The classic detector uses the seed if the initial frequency is near F1 or F2,
+/// the minmax detector starts with the seed as limits and skips the warm-up.
+/// @param s Internal state, after pulse_detect_fsk_init()
+/// @param fm_f1 Expected F1 (high) frequency
+/// @param fm_f2 Expected F2 (low) frequency
+void pulse_detect_fsk_seed(pulse_detect_fsk_t *s, int fm_f1, int fm_f2);
+
 /// Demodulate Frequency Shift Keying (FSK) sample by sample.
 ///
 /// Function is stateful between calls
@@ -74,4 +90,17 @@ void pulse_detect_fsk_wrap_up(pulse_detect_fsk_t *s, pulse_data_t *fsk_pulses);
 /// @param fsk_pulses Will return a pulse_data_t structure for FSK demodulated data
 void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses);
 
+/// Demodulate Frequency Shift Keying (FSK) block by block.
+///
+/// Function is stateful between calls, the blocks are consecutive FM samples of one package.
+/// Tracks the limits like the minmax detector but per block of 64 samples: each block is
+/// thresholded against the midpoint into a bit mask, the pulse and gap widths are then
+/// taken from the transitions in the mask with bit scans instead of a per-sample state machine.
+/// Also sums the F1 and F2 samples, the estimates are the averages.
+/// @param s Internal state
+/// @param fm_data FM data of the package
+/// @param len Number of FM samples
+/// @param fsk_pulses Will return a pulse_data_t structure for FSK demodulated data
+void pulse_detect_fsk_block(pulse_detect_fsk_t *s, int16_t const *fm_data, unsigned len, pulse_data_t *fsk_pulses);
+
 #endif /* INCLUDE_PULSE_DETECT_FSK_H_ */
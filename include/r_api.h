@@ -20,6 +20,7 @@ struct data;
 struct pulse_data;
 struct list;
 struct mg_mgr;
+struct data_output;
 
 /* general */
 
@@ -41,6 +42,18 @@ void unregister_protocol(struct r_cfg *cfg, struct r_device *r_dev);
 
 void register_all_protocols(struct r_cfg *cfg, unsigned disabled);
 
+/// Find a registered protocol by number, or by name if @p protocol_num is 0.
+struct r_device *find_protocol(struct r_cfg *cfg, unsigned protocol_num, char const *name);
+
+/// Rebuild the decoder dispatch state, call after the registered protocols changed.
+void update_dispatch(struct r_cfg *cfg);
+
+/// Set the per decoder time budget in microseconds, 0 disables the budget.
+void set_decode_budget(struct r_cfg *cfg, unsigned budget_us);
+
+/// Restore demoted decoders, all if protocol_num is 0, returns the number restored.
+int restore_demoted(struct r_cfg *cfg, unsigned protocol_num);
+
 /* output helper */
 
 void calc_rssi_snr(struct r_cfg *cfg, struct pulse_data *pulse_data);
@@ -51,10 +64,21 @@ char const **well_known_output_fields(struct r_cfg *cfg);
 
 char const **determine_csv_fields(struct r_cfg *cfg, char const *const *well_known, int *num_fields);
 
+char const **determine_device_fields(struct r_cfg *cfg, struct r_device *r_dev);
+
 int run_ook_demods(struct list *r_devs, struct pulse_data *pulse_data);
 
 int run_fsk_demods(struct list *r_devs, struct pulse_data *fsk_pulse_data);
 
+/// Run the OOK decoders, ordered by hit rate and first match wins if enabled.
+int run_ook_dispatch(struct r_cfg *cfg, struct pulse_data *pulse_data);
+
+/// Run the FSK decoders, ordered by hit rate and first match wins if enabled.
+int run_fsk_dispatch(struct r_cfg *cfg, struct pulse_data *fsk_pulse_data);
+
+/// Enable first match dispatch with a full run on every Nth package, 0 disables.
+void set_first_match(struct r_cfg *cfg, unsigned full_interval);
+
 /* handlers */
 
 void r_redirect_logging(struct r_cfg *cfg);
@@ -69,30 +93,47 @@ struct data *create_report_data(struct r_cfg *cfg, int level);
 
 void flush_report_data(struct r_cfg *cfg);
 
-/* setup */
+/* setup, the add_*_output functions return -1 if the spec is invalid or the output can't be created */
 
-void add_json_output(struct r_cfg *cfg, char *param);
+int add_json_output(struct r_cfg *cfg, char *param);
 
-void add_csv_output(struct r_cfg *cfg, char *param);
+int add_csv_output(struct r_cfg *cfg, char *param);
 
-void add_log_output(struct r_cfg *cfg, char *param);
+int add_log_output(struct r_cfg *cfg, char *param);
 
-void add_kv_output(struct r_cfg *cfg, char *param);
+int add_kv_output(struct r_cfg *cfg, char *param);
 
-void add_mqtt_output(struct r_cfg *cfg, char *param);
+int add_mqtt_output(struct r_cfg *cfg, char *param);
 
-void add_influx_output(struct r_cfg *cfg, char *param);
+int add_influx_output(struct r_cfg *cfg, char *param);
 
-void add_syslog_output(struct r_cfg *cfg, char *param);
+int add_syslog_output(struct r_cfg *cfg, char *param);
 
-void add_http_output(struct r_cfg *cfg, char *param);
+int add_http_output(struct r_cfg *cfg, char *param);
 
-void add_trigger_output(struct r_cfg *cfg, char *param);
+int add_shm_output(struct r_cfg *cfg, char *param);
+
+int add_arrow_output(struct r_cfg *cfg, char *param);
+
+int add_store_output(struct r_cfg *cfg, char *param);
+
+int add_trigger_output(struct r_cfg *cfg, char *param);
 
 void add_null_output(struct r_cfg *cfg, char *param);
 
 void add_rtltcp_output(struct r_cfg *cfg, char *param);
 
+/// Add an output from a `-F` style spec, returns -1 if the spec is invalid or the output can't be created.
+int add_output(struct r_cfg *cfg, char *arg);
+
+/// Check if an output spec is a kv, json, csv, or log output to stdout.
+int output_spec_console(char const *spec);
+
+/// Remove and free the output at index @p idx, returns -1 if there is no such output.
+int remove_output(struct r_cfg *cfg, unsigned idx);
+
+void start_output(struct r_cfg *cfg, struct data_output *output);
+
 void start_outputs(struct r_cfg *cfg, char const *const *well_known);
 
 void add_sr_dumper(struct r_cfg *cfg, char const *spec, int overwrite);
@@ -115,6 +156,8 @@ void set_freq_correction(struct r_cfg *cfg, int freq_correction);
 
 void set_sample_rate(struct r_cfg *cfg, uint32_t sample_rate);
 
+void set_hop_frequencies(struct r_cfg *cfg, uint32_t const *frequencies, int count);
+
 void set_gain_str(struct r_cfg *cfg, char const *gain_str);
 
 #endif /* INCLUDE_R_API_H_ */
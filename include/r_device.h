@@ -5,6 +5,8 @@
 #ifndef INCLUDE_R_DEVICE_H_
 #define INCLUDE_R_DEVICE_H_
 
+#include <stdint.h>
+
 /**
     Supported Modulation and Coding types.
 
@@ -53,6 +55,13 @@ enum decode_return_codes {
 
 struct bitbuffer;
 struct data;
+struct sync_match;
+
+/** A sync word, the first `bits` bits of `bytes` (1 to 64), see r_device.syncs. */
+struct sync_word {
+    uint8_t bytes[8];
+    unsigned bits;
+};
 
 /** Device protocol decoder struct. */
 typedef struct r_device {
@@ -68,10 +77,11 @@ typedef struct r_device {
     float sync_width;
     float tolerance;
     int (*decode_fn)(struct r_device *decoder, struct bitbuffer *bitbuffer);
-    struct r_device *(*create_fn)(char *args);
+    struct r_device *(*create_fn)(char *args); ///< @p args are only valid during the call, copy what is kept
     unsigned priority; ///< Run later and only if no previous events were produced
     unsigned disabled; ///< 0: default enabled, 1: default disabled, 2: disabled, 3: disabled and hidden
     char const *const *fields; ///< List of fields this decoder produces; required for CSV output. NULL-terminated.
+    struct sync_word const *syncs; ///< Sync words, the decoder only runs if one is seen. Terminated by a zero bits entry.
 
     /* public for each decoder */
     int verbose;
@@ -84,6 +94,28 @@ typedef struct r_device {
     unsigned decode_ok;
     unsigned decode_messages;
     unsigned decode_fails[5];
+    unsigned decode_us; ///< time spent in decode_fn, only measured with a budget
+
+    /* Time budget, see account_event() */
+    unsigned budget_us;      ///< max time per package, 0: no budget
+    unsigned budget_strikes; ///< recent over budget runs without events
+    unsigned demoted;        ///< 0: runs on every package, N: runs on every Nth package only
+    unsigned demoted_skip;   ///< packages since the last run while demoted
+
+    /* Dispatch order, see run_ook_dispatch() */
+    unsigned dispatch_hits;  ///< packages decoded since the last re-sort
+    unsigned dispatch_score; ///< decayed hit count
+
+    /* Scratch arena, see decoder_scratch(), a decoder's own malloc() calls are not counted */
+    unsigned scratch_size;   ///< arena size, set to the bytes a decode needs, grows to the peak use
+    unsigned scratch_used;   ///< bytes handed out since the last reset
+    unsigned scratch_allocs; ///< heap allocations for scratch memory, flat once the arena has its size
+    void *scratch;           ///< the arena, allocated on first use
+    void *scratch_extra;     ///< blocks which didn't fit the arena, freed on reset
+
+    /* Sync word matching, see sync_match_create() */
+    struct sync_match *sync_match; ///< automaton of all decoders, NULL to always run
+    uint64_t sync_mask;            ///< sync words of this decoder in the automaton
 
     /* private for flex decoder and output callback */
     void *decode_ctx;
@@ -27,6 +27,7 @@ struct dm_state {
     float low_pass;
     int use_mag_est;
     int detect_verbosity;
+    unsigned decode_budget_us; ///< per decoder time budget, 0: no budget
 
     int16_t am_buf[MAXIMAL_BUF_LENGTH];  // AM demodulated signal (for OOK decoding)
     union {
@@ -48,10 +49,28 @@ struct dm_state {
     int analyze_pulses;
     file_info_t load_info;
     list_t dumper;
+    struct pulse_archive *pulse_archive; ///< NULL if not archiving pulses
 
     /* Protocol states */
     list_t r_devs;
 
+    /* First match dispatch */
+    int first_match;              ///< stop at the first decoder producing events
+    unsigned first_match_full;    ///< run all decoders on every Nth package
+    list_t dispatch;              ///< r_devs ordered by priority and hit rate
+    unsigned dispatch_gen;        ///< devices_gen the dispatch list was built for
+    unsigned dispatch_packages;
+    unsigned dispatch_full_runs;  ///< stats: packages run with all decoders
+    unsigned dispatch_overlaps;   ///< stats: full runs with more than one decoder of a priority matching
+
+    /* Sync words of all decoders */
+    struct sync_match *sync_match; ///< NULL if no decoder declares sync words
+
+    /* FSK automatic frequency control */
+    struct fsk_afc *fsk_afc;      ///< NULL if not enabled
+    int afc_drift_logged;         ///< last logged tuner drift in ppm
+    uint64_t afc_last_offset;     ///< offset of the last package used by AFC
+
     pulse_data_t    pulse_data;
     pulse_data_t    fsk_pulse_data;
     unsigned frame_event_count;
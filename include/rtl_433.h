@@ -104,12 +104,21 @@ typedef struct r_cfg {
     int report_stats;
     int stats_interval;
     volatile sig_atomic_t stats_now;
+    volatile sig_atomic_t reload_now; ///< re-read the config file between blocks
+    char const *conf_file; ///< config file used for reload
     time_t stats_time;
     int no_default_devices;
     struct r_device *devices;
     uint16_t num_r_devices;
+    unsigned devices_gen; ///< bumped whenever the registered decoders change
     list_t data_tags;
     list_t output_handler;
+    list_t output_specs; ///< output spec strings, in step with output_handler
+    list_t output_args;  ///< parsed copies of the specs, outputs may keep pointers into them, in step with output_handler
+    list_t conf_outputs; ///< specs of the outputs from the config file, the only ones a reload changes
+    struct r_device *output_device; ///< decoder of the event being output, NULL otherwise
+    struct event_store *event_store; ///< queried by the HTTP server, NULL if not enabled
+    struct mesh_topology *mesh;      ///< Gridstream mesh index, queried by the HTTP server, NULL until the first Gridstream event
     list_t raw_handler;
     int has_logout;
     struct dm_state *demod;
@@ -121,6 +130,7 @@ typedef struct r_cfg {
     unsigned frames_count; ///< stats counter for interval
     unsigned frames_fsk; ///< stats counter for interval
     unsigned frames_events; ///< stats counter for interval
+    unsigned startup_us; ///< time from start to ready for input
     struct mg_mgr *mgr;
 } r_cfg_t;
 
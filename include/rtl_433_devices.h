@@ -257,6 +257,9 @@
     DECL(gridstream96) \
     DECL(gridstream192) \
     DECL(gridstream384) \
+    DECL(ert_amr) \
+    DECL(acurite_pwm) \
+    DECL(fineoffset_fsk) \
     /* Add new decoders here. */
 
 #define DECL(name) extern r_device name;
@@ -0,0 +1,187 @@
+/** @file
+    Shared memory event ring, format and header-only reader.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_SHM_RING_H_
+#define INCLUDE_SHM_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The ring is a memory-mapped file (usually in `/dev/shm`) with a single writer.
+
+    The file is a header followed by a power of 2 sized data area.
+    Records are a record header followed by the JSON event, padded to 8 bytes.
+    Positions are byte offsets which never wrap, the data offset is the position
+    modulo the data size. A record never wraps, if it does not fit at the end of
+    the data area a skip record fills the rest.
+
+    The writer never waits for readers. Before overwriting old records it
+    advances `tail` past them, then writes the record, then advances `head`.
+    A reader copies a record at its own position and checks afterwards that
+    the position is still at or after `tail`, otherwise it was overrun and
+    skips ahead to `tail`. Lost records show as a gap in the sequence numbers.
+
+    Example reader:
+
+        shm_ring_reader_t ring;
+        if (shm_ring_open(&ring, "/dev/shm/rtl_433", 0) < 0)
+            exit(1);
+        char buf[4096];
+        for (;;) {
+            int len = shm_ring_read(&ring, buf, sizeof(buf));
+            if (len > 0)
+                printf("%.*s\n", len, buf);
+            else if (len == 0)
+                usleep(10000);
+            else
+                break; // the writer closed the ring
+        }
+        shm_ring_close(&ring);
+*/
+
+#define SHM_RING_MAGIC 0x33333452u // "R433"
+#define SHM_RING_VERSION 1
+#define SHM_RING_SKIP 0xffffffffu // record length of a skip record
+
+typedef struct shm_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;   ///< size of the data area, a power of 2
+    uint64_t head;   ///< position after the newest record
+    uint64_t tail;   ///< position of the oldest record
+    uint64_t seq;    ///< sequence number of the newest record, starts at 1
+    uint32_t closed; ///< set when the writer exits
+    uint32_t reserved[7];
+} shm_ring_header_t;
+
+typedef struct shm_ring_record {
+    uint32_t len; ///< length of the data, or SHM_RING_SKIP
+    uint32_t time; ///< unix time the record was written
+    uint64_t seq;
+} shm_ring_record_t;
+
+/// Size of a record with @p len bytes of data.
+static inline size_t shm_ring_record_size(size_t len)
+{
+    return (sizeof(shm_ring_record_t) + len + 7) & ~(size_t)7;
+}
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct shm_ring_reader {
+    shm_ring_header_t const *hdr;
+    uint8_t const *data;
+    size_t map_size;
+    uint64_t pos;      ///< position of the next record to read
+    uint64_t next_seq; ///< expected sequence number of the next record, 0 if unknown
+    uint64_t lost;     ///< number of records overrun by the writer
+} shm_ring_reader_t;
+
+/// Open a ring, start at the oldest record if @p replay is set, otherwise with the next new record.
+/// Returns 0 on success, -1 on error.
+static inline int shm_ring_open(shm_ring_reader_t *r, char const *path, int replay)
+{
+    memset(r, 0, sizeof(*r));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(shm_ring_header_t)) {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    shm_ring_header_t const *hdr = map;
+    if (hdr->magic != SHM_RING_MAGIC || hdr->version != SHM_RING_VERSION
+            || sizeof(*hdr) + hdr->size > (size_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+    r->hdr      = hdr;
+    r->data     = (uint8_t const *)map + sizeof(*hdr);
+    r->map_size = (size_t)st.st_size;
+    r->pos      = __atomic_load_n(replay ? &hdr->tail : &hdr->head, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+/// Close a ring.
+static inline void shm_ring_close(shm_ring_reader_t *r)
+{
+    if (r->hdr)
+        munmap((void *)r->hdr, r->map_size);
+    memset(r, 0, sizeof(*r));
+}
+
+/// Read the next record into @p buf, truncated to @p size.
+/// Returns the record length, 0 if there is no new record, -1 if the writer closed the ring.
+static inline int shm_ring_read(shm_ring_reader_t *r, char *buf, size_t size)
+{
+    shm_ring_header_t const *hdr = r->hdr;
+    uint64_t mask                = hdr->size - 1;
+
+    for (;;) {
+        uint64_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+        if (r->pos == head) {
+            // closed only counts once all records are read
+            if (!__atomic_load_n(&hdr->closed, __ATOMIC_ACQUIRE)
+                    || __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE) != head)
+                return 0;
+            return -1;
+        }
+
+        uint64_t tail = __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE);
+        if (r->pos < tail || r->pos > head)
+            r->pos = tail; // overrun (or the writer restarted), skip ahead
+
+        shm_ring_record_t rec;
+        memcpy(&rec, &r->data[r->pos & mask], sizeof(rec));
+        size_t len   = 0;
+        size_t avail = hdr->size - (r->pos & mask) - sizeof(rec); // a torn length must not read out of bounds
+        if (rec.len != SHM_RING_SKIP) {
+            len = rec.len < size ? rec.len : size;
+            len = len < avail ? len : avail;
+            memcpy(buf, &r->data[(r->pos & mask) + sizeof(rec)], len);
+        }
+
+        // the copy is only valid if the writer did not reclaim the record meanwhile
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (r->pos < __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE))
+            continue;
+
+        if (rec.len == SHM_RING_SKIP) {
+            r->pos += hdr->size - (r->pos & mask);
+            continue;
+        }
+        if (rec.len > avail) {
+            r->pos = head; // corrupt, resync with the writer
+            continue;
+        }
+        r->pos += shm_ring_record_size(rec.len);
+        if (r->next_seq && rec.seq > r->next_seq)
+            r->lost += rec.seq - r->next_seq;
+        r->next_seq = rec.seq + 1;
+        return (int)len;
+    }
+}
+
+#endif /* !_WIN32 */
+
+#endif /* INCLUDE_SHM_RING_H_ */
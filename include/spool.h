@@ -0,0 +1,53 @@
+/** @file
+    Durable on-disk event spool for network outputs.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_SPOOL_H_
+#define INCLUDE_SPOOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** A spool is an append-only log of records in a directory.
+
+    Every record gets a monotonically increasing sequence number (starting at 1).
+    The log is kept in memory-mapped segment files which rotate at a fixed size.
+    The owner acknowledges records once they are delivered, the acknowledged
+    cursor is kept in the directory, thus delivery resumes after a restart.
+    Segments are dropped once fully acknowledged, or when the total size or
+    the age of the records exceed the caps (the records are then lost).
+*/
+typedef struct spool spool_t;
+
+/// Open or create a spool in directory @p path, 0 caps mean the defaults.
+spool_t *spool_open(char const *path, size_t max_bytes, unsigned max_age);
+
+/// Close the spool, unacknowledged records stay on disk.
+void spool_close(spool_t *spool);
+
+/// Append a record, returns the sequence number or 0 on failure.
+uint64_t spool_append(spool_t *spool, void const *data, size_t len);
+
+/// Get the record for sequence number @p seq (zero-copy), returns 0 if not available.
+int spool_read(spool_t *spool, uint64_t seq, void const **data, size_t *len);
+
+/// Acknowledge all records up to and including sequence number @p seq.
+void spool_ack(spool_t *spool, uint64_t seq);
+
+/// The last acknowledged sequence number.
+uint64_t spool_acked(spool_t const *spool);
+
+/// The sequence number the next record will get.
+uint64_t spool_next(spool_t const *spool);
+
+/// Number of records lost to the size and age caps.
+uint64_t spool_dropped(spool_t const *spool);
+
+#endif /* INCLUDE_SPOOL_H_ */
@@ -0,0 +1,56 @@
+/** @file
+    Sync word matching for all decoders in one pass.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#ifndef INCLUDE_SYNC_MATCH_H_
+#define INCLUDE_SYNC_MATCH_H_
+
+#include <stdint.h>
+
+struct list;
+struct bitbuffer;
+struct r_device;
+
+/** The sync words declared by the decoders (`r_device.syncs`) are compiled to one
+    Aho-Corasick automaton over bits, with a table per state to step a whole byte.
+    A scan of a bitbuffer finds all sync words of all decoders in a single pass,
+    a decoder is only run if one of its sync words was seen.
+
+    Identical sync words of different decoders are matched once, at most 64
+    distinct sync words are supported, decoders with more always run.
+*/
+typedef struct sync_match sync_match_t;
+
+/// A sync word seen in a scan.
+typedef struct sync_hit {
+    uint16_t row;     ///< bitbuffer row
+    uint16_t offset;  ///< bit offset of the first sync word bit in the row
+    unsigned pattern; ///< index of the sync word in the automaton
+} sync_hit_t;
+
+/// Build the automaton for the decoders in @p r_devs, sets `sync_match` and `sync_mask` of each decoder.
+sync_match_t *sync_match_create(struct list *r_devs);
+
+/// Free the automaton.
+void sync_match_free(sync_match_t *sm);
+
+/// Scan a bitbuffer for all sync words, returns the mask of sync words seen.
+uint64_t sync_match_scan(sync_match_t *sm, struct bitbuffer const *bitbuffer);
+
+/// Forget the last scan, the hits are only valid for the scanned bitbuffer.
+void sync_match_done(sync_match_t *sm);
+
+/// Get the hits of the last scan of @p bitbuffer, NULL if it wasn't scanned or had too many hits.
+sync_hit_t const *sync_match_hits(sync_match_t const *sm, struct bitbuffer const *bitbuffer, unsigned *count);
+
+/// Get the index of a sync word in the automaton, -1 if not found.
+int sync_match_pattern(sync_match_t const *sm, uint8_t const *bytes, unsigned bits);
+
+#endif /* INCLUDE_SYNC_MATCH_H_ */
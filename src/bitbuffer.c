@@ -21,6 +21,7 @@ void bitbuffer_clear(bitbuffer_t *bits)
 
 void bitbuffer_add_bit(bitbuffer_t *bits, int bit)
 {
+    bits->stamp = 0;
     if (bits->num_rows == 0)
         bits->free_row = bits->num_rows = 1; // Add first row automatically
 
@@ -74,6 +75,7 @@ void bitbuffer_add_bit(bitbuffer_t *bits, int bit)
 /// Set the width of the current (last) row by expanding or truncating as needed.
 static void bitbuffer_set_width(bitbuffer_t *bits, uint16_t width)
 {
+    bits->stamp = 0;
     if (bits->num_rows == 0)
         bits->free_row = bits->num_rows = 1; // Add first row automatically
 
@@ -103,6 +105,7 @@ static void bitbuffer_set_width(bitbuffer_t *bits, uint16_t width)
 
 void bitbuffer_add_row(bitbuffer_t *bits)
 {
+    bits->stamp = 0;
     if (bits->num_rows == 0)
         bits->free_row = bits->num_rows = 1; // Add first row automatically
     if (bits->free_row == BITBUF_ROWS - 1) {
@@ -120,6 +123,7 @@ void bitbuffer_add_row(bitbuffer_t *bits)
 
 void bitbuffer_add_sync(bitbuffer_t *bits)
 {
+    bits->stamp = 0;
     if (bits->num_rows == 0)
         bits->free_row = bits->num_rows = 1; // Add first row automatically
     if (bits->bits_per_row[bits->num_rows - 1]) {
@@ -130,6 +134,7 @@ void bitbuffer_add_sync(bitbuffer_t *bits)
 
 void bitbuffer_invert(bitbuffer_t *bits)
 {
+    bits->stamp = 0;
     for (unsigned row = 0; row < bits->num_rows; ++row) {
         if (bits->bits_per_row[row] > 0) {
             uint8_t *b = bits->bb[row];
@@ -146,6 +151,7 @@ void bitbuffer_invert(bitbuffer_t *bits)
 
 void bitbuffer_nrzs_decode(bitbuffer_t *bits)
 {
+    bits->stamp = 0;
     for (unsigned row = 0; row < bits->num_rows; ++row) {
         if (bits->bits_per_row[row] > 0) {
             uint8_t *b = bits->bb[row];
@@ -166,6 +172,7 @@ void bitbuffer_nrzs_decode(bitbuffer_t *bits)
 
 void bitbuffer_nrzm_decode(bitbuffer_t *bits)
 {
+    bits->stamp = 0;
     for (unsigned row = 0; row < bits->num_rows; ++row) {
         if (bits->bits_per_row[row] > 0) {
             uint8_t *b = bits->bb[row];
@@ -468,7 +475,8 @@ void bitbuffer_parse(bitbuffer_t *bits, const char *code)
     }
 }
 
-int bitbuffer_compare_rows(bitbuffer_t *bits, unsigned row_a, unsigned row_b, unsigned max_bits)
+/// Compare two rows, the uncached version.
+static int compare_rows(bitbuffer_t const *bits, unsigned row_a, unsigned row_b, unsigned max_bits)
 {
     if (max_bits == 0 || bits->bits_per_row[row_a] < max_bits || bits->bits_per_row[row_b] < max_bits) {
         // full compare, no max_bits or rows too short
@@ -478,8 +486,8 @@ int bitbuffer_compare_rows(bitbuffer_t *bits, unsigned row_a, unsigned row_b, un
     }
     else {
         // prefix-only compare, both rows are at least max_bits long
-        uint8_t *a = bits->bb[row_a];
-        uint8_t *b = bits->bb[row_b];
+        uint8_t const *a = bits->bb[row_a];
+        uint8_t const *b = bits->bb[row_b];
         unsigned last = (max_bits - 1) / 8; // max_bits is at least 1
         unsigned mask = 0xff00 >> (max_bits & 7); // mask off bottom bits
         return (!memcmp(bits->bb[row_a], bits->bb[row_b], max_bits / 8)
@@ -487,11 +495,100 @@ int bitbuffer_compare_rows(bitbuffer_t *bits, unsigned row_a, unsigned row_b, un
     }
 }
 
+/// Hash a row with the same notion of equality as compare_rows() (FNV-1a).
+static uint32_t hash_row(bitbuffer_t const *bits, unsigned row, unsigned max_bits)
+{
+    uint8_t const *b = bits->bb[row];
+    unsigned len     = bits->bits_per_row[row];
+    uint32_t hash    = 2166136261u;
+
+    if (max_bits == 0 || len < max_bits) {
+        // full rows, the length is part of the content
+        hash = (hash ^ (len & 0xff)) * 16777619u;
+        hash = (hash ^ (len >> 8)) * 16777619u;
+        for (unsigned i = 0; i < (len + 7) / 8; ++i) {
+            hash = (hash ^ b[i]) * 16777619u;
+        }
+    }
+    else {
+        // prefix only, mask off the bottom bits of the last byte
+        hash = (hash ^ 0xff) * 16777619u;
+        for (unsigned i = 0; i < max_bits / 8; ++i) {
+            hash = (hash ^ b[i]) * 16777619u;
+        }
+        if (max_bits & 7) {
+            hash = (hash ^ (b[max_bits / 8] & (0xff00 >> (max_bits & 7)))) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static uint32_t bitbuffer_stamps; // last stamp handed out
+
+/// Ensure the bitbuffer carries a valid stamp for its current content.
+static uint32_t bitbuffer_stamp(bitbuffer_t *bits)
+{
+    if (!bits->stamp) {
+        if (!++bitbuffer_stamps)
+            ++bitbuffer_stamps; // skip 0 on wrap around
+        bits->stamp = bitbuffer_stamps;
+    }
+    return bits->stamp;
+}
+
+#define REPEAT_SLOTS 128 // hash table size, a power of 2 and more than twice BITBUF_ROWS
+
+/// Group equal rows by hash, once per content and prefix length.
+static void bitbuffer_group_rows(bitbuffer_t *bits, unsigned max_bits)
+{
+    if (bits->stamp && bits->repeat_stamp == bits->stamp && bits->repeat_bits == max_bits)
+        return; // cached
+
+    uint32_t hashes[REPEAT_SLOTS];
+    uint8_t slots[REPEAT_SLOTS] = {0}; // first row of a group plus 1, 0 for empty
+
+    for (unsigned row = 0; row < bits->num_rows; ++row) {
+        uint32_t hash = hash_row(bits, row, max_bits);
+        unsigned slot = hash & (REPEAT_SLOTS - 1);
+        // linear probing, verify on hash match to rule out collisions
+        while (slots[slot] && (hashes[slot] != hash || !compare_rows(bits, slots[slot] - 1, row, max_bits))) {
+            slot = (slot + 1) & (REPEAT_SLOTS - 1);
+        }
+        if (!slots[slot]) {
+            slots[slot]  = row + 1;
+            hashes[slot] = hash;
+            bits->repeat_count[row] = 0;
+        }
+        bits->repeat_group[row] = slots[slot] - 1;
+        bits->repeat_count[slots[slot] - 1]++;
+    }
+    for (unsigned row = 0; row < bits->num_rows; ++row) {
+        bits->repeat_count[row] = bits->repeat_count[bits->repeat_group[row]];
+    }
+
+    bits->repeat_stamp = bitbuffer_stamp(bits);
+    bits->repeat_bits  = max_bits;
+}
+
+int bitbuffer_compare_rows(bitbuffer_t *bits, unsigned row_a, unsigned row_b, unsigned max_bits)
+{
+    if (bits->stamp && bits->repeat_stamp == bits->stamp && bits->repeat_bits == max_bits
+            && row_a < bits->num_rows && row_b < bits->num_rows) {
+        return bits->repeat_group[row_a] == bits->repeat_group[row_b];
+    }
+    return compare_rows(bits, row_a, row_b, max_bits);
+}
+
 unsigned bitbuffer_count_repeats(bitbuffer_t *bits, unsigned row, unsigned max_bits)
 {
+    if (row < bits->num_rows) {
+        bitbuffer_group_rows(bits, max_bits);
+        return bits->repeat_count[row];
+    }
+
     unsigned cnt = 0;
     for (int i = 0; i < bits->num_rows; ++i) {
-        if (bitbuffer_compare_rows(bits, row, i, max_bits)) {
+        if (compare_rows(bits, row, i, max_bits)) {
             ++cnt;
         }
     }
@@ -500,9 +597,10 @@ unsigned bitbuffer_count_repeats(bitbuffer_t *bits, unsigned row, unsigned max_b
 
 int bitbuffer_find_repeated_row(bitbuffer_t *bits, unsigned min_repeats, unsigned min_bits)
 {
+    bitbuffer_group_rows(bits, 0);
     for (int i = 0; i < bits->num_rows; ++i) {
         if (bits->bits_per_row[i] >= min_bits &&
-                bitbuffer_count_repeats(bits, i, 0) >= min_repeats) {
+                bits->repeat_count[i] >= min_repeats) {
             return i;
         }
     }
@@ -511,15 +609,33 @@ int bitbuffer_find_repeated_row(bitbuffer_t *bits, unsigned min_repeats, unsigne
 
 int bitbuffer_find_repeated_prefix(bitbuffer_t *bits, unsigned min_repeats, unsigned min_bits)
 {
+    bitbuffer_group_rows(bits, min_bits);
     for (int i = 0; i < bits->num_rows; ++i) {
         if (bits->bits_per_row[i] >= min_bits &&
-                bitbuffer_count_repeats(bits, i, min_bits) >= min_repeats) {
+                bits->repeat_count[i] >= min_repeats) {
             return i;
         }
     }
     return -1;
 }
 
+bitbuffer_t const *bitbuffer_inverted(bitbuffer_t *bits, bitbuffer_t *storage)
+{
+    uint32_t stamp = bitbuffer_stamp(bits);
+    if (bits->inverted && bits->inverted_stamp == stamp)
+        return bits->inverted;
+    if (!storage)
+        return NULL;
+
+    *storage = *bits;
+    bitbuffer_invert(storage); // also clears the copied stamp
+    storage->inverted = NULL;
+
+    bits->inverted       = storage;
+    bits->inverted_stamp = stamp;
+    return storage;
+}
+
 // Unit testing
 #ifdef _TEST
 
@@ -597,6 +713,57 @@ int main(void)
     bitbuffer_add_bit(&bits, 1);
     bitbuffer_print(&bits);
 
+    fprintf(stderr, "TEST: bitbuffer:: Repeated rows\n");
+    bitbuffer_parse(&bits, "{12}a5f {12}123 {12}a5f {16}a5f0 {12}a5f");
+    ASSERT(bitbuffer_find_repeated_row(&bits, 3, 12) == 0);
+    ASSERT(bitbuffer_find_repeated_row(&bits, 4, 12) == -1);
+    ASSERT(bitbuffer_count_repeats(&bits, 1, 0) == 1);
+    ASSERT(bitbuffer_count_repeats(&bits, 4, 0) == 3);
+    ASSERT(bitbuffer_compare_rows(&bits, 0, 2, 0));
+    ASSERT(!bitbuffer_compare_rows(&bits, 0, 3, 0));
+    ASSERT(bitbuffer_find_repeated_prefix(&bits, 4, 12) == 0);
+    ASSERT(bitbuffer_count_repeats(&bits, 3, 12) == 4);
+
+    fprintf(stderr, "TEST: bitbuffer:: Repeated rows after change\n");
+    bits.bb[0][0] = 0x12;
+    bits.bb[0][1] = 0x30;
+    bitbuffer_invalidate(&bits);
+    ASSERT(bitbuffer_count_repeats(&bits, 0, 0) == 2);
+    ASSERT(bitbuffer_find_repeated_row(&bits, 3, 12) == -1);
+    bitbuffer_add_row(&bits);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 1);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 1);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 0);
+    bitbuffer_add_bit(&bits, 1);
+    bitbuffer_add_bit(&bits, 1);
+    ASSERT(bitbuffer_find_repeated_row(&bits, 3, 12) == 0);
+
+    fprintf(stderr, "TEST: bitbuffer:: Inverted copy\n");
+    bitbuffer_t storage;
+    ASSERT(bitbuffer_inverted(&bits, NULL) == NULL);
+    bitbuffer_t const *inv = bitbuffer_inverted(&bits, &storage);
+    ASSERT(inv == &storage);
+    ASSERT(inv->bb[1][0] == 0xed && inv->bb[1][1] == 0xc0);
+    ASSERT(bitbuffer_inverted(&bits, NULL) == inv);
+    ASSERT(bits.bb[1][0] == 0x12);
+
+    fprintf(stderr, "TEST: bitbuffer:: Inverted copy of a changed copy\n");
+    bitbuffer_t copy = bits;
+    bitbuffer_invalidate(&copy);
+    copy.bb[1][0] = 0x34;
+    ASSERT(bitbuffer_inverted(&copy, NULL) == NULL);
+    bitbuffer_t storage2;
+    inv = bitbuffer_inverted(&copy, &storage2);
+    ASSERT(inv == &storage2 && inv->bb[1][0] == 0xcb);
+    ASSERT(bitbuffer_inverted(&bits, NULL) == &storage);
+
     fprintf(stderr, "bitbuffer:: test (%u/%u) passed, (%u) failed.\n", passed, passed + failed, failed);
 
     return failed > 0 ? 1 : 0;
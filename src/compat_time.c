@@ -33,6 +33,32 @@ int gettimeofday(struct timeval *tv, void *tz)
     return 0;
 }
 
+uint64_t monotonic_time_us(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq); // fixed at boot, never fails on XP and later
+    QueryPerformanceCounter(&count);
+    return (uint64_t)(count.QuadPart / freq.QuadPart * 1000000
+            + count.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+}
+
+#else
+
+#include <stdio.h>
+#include <time.h>
+
+uint64_t monotonic_time_us(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
+        perror("clock_gettime");
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
 #endif // _WIN32
 
 int timeval_subtract(struct timeval *result, struct timeval *x, struct timeval *y)
@@ -558,3 +558,130 @@ R_API size_t data_print_jsons(data_t *data, char *dst, size_t len)
 
     return len - jsons.msg.left;
 }
+
+/* CBOR printer */
+
+typedef struct {
+    struct data_output output;
+    uint8_t *buf;
+    size_t size;
+    size_t pos; ///< may exceed size, then the output is incomplete
+} data_print_cbor_t;
+
+static void cbor_put(data_print_cbor_t *cbor, uint8_t const *src, size_t len)
+{
+    if (len && cbor->pos + len <= cbor->size)
+        memcpy(&cbor->buf[cbor->pos], src, len);
+    cbor->pos += len;
+}
+
+/// Encode a major type with the shortest argument encoding.
+static void cbor_head(data_print_cbor_t *cbor, unsigned major, uint64_t arg)
+{
+    uint8_t head[9];
+    size_t len = 1;
+    if (arg < 24) {
+        head[0] = (uint8_t)(major << 5 | arg);
+    }
+    else {
+        int n   = arg <= 0xff ? 1 : arg <= 0xffff ? 2 : arg <= 0xffffffff ? 4 : 8;
+        head[0] = (uint8_t)(major << 5 | (n == 1 ? 24 : n == 2 ? 25 : n == 4 ? 26 : 27));
+        for (int i = n; i > 0; --i) {
+            head[i] = (uint8_t)arg;
+            arg >>= 8;
+        }
+        len += n;
+    }
+    cbor_put(cbor, head, len);
+}
+
+static void R_API_CALLCONV format_cbor_array(data_output_t *output, data_array_t *array, char const *format)
+{
+    data_print_cbor_t *cbor = (data_print_cbor_t *)output;
+
+    cbor_head(cbor, 4, (uint64_t)array->num_values);
+    for (int c = 0; c < array->num_values; ++c) {
+        print_array_value(output, array, format, c);
+    }
+}
+
+static void R_API_CALLCONV format_cbor_object(data_output_t *output, data_t *data, char const *format)
+{
+    UNUSED(format);
+    data_print_cbor_t *cbor = (data_print_cbor_t *)output;
+
+    unsigned count = 0;
+    for (data_t *d = data; d; d = d->next)
+        count++;
+    cbor_head(cbor, 5, count);
+    for (; data; data = data->next) {
+        output->print_string(output, data->key, NULL);
+        print_value(output, data->type, data->value, data->format);
+    }
+}
+
+static void R_API_CALLCONV format_cbor_string(data_output_t *output, const char *str, char const *format)
+{
+    UNUSED(format);
+    data_print_cbor_t *cbor = (data_print_cbor_t *)output;
+
+    size_t len = strlen(str);
+    cbor_head(cbor, 3, len);
+    cbor_put(cbor, (uint8_t const *)str, len);
+}
+
+static void R_API_CALLCONV format_cbor_double(data_output_t *output, double data, char const *format)
+{
+    UNUSED(format);
+    data_print_cbor_t *cbor = (data_print_cbor_t *)output;
+
+    // most values are exact as single precision, e.g. 21.5 or 0.25
+    uint8_t b[9];
+    float f = (float)data;
+    if ((double)f == data) {
+        uint32_t v;
+        memcpy(&v, &f, sizeof(v));
+        b[0] = 0xfa;
+        for (int i = 4; i > 0; --i, v >>= 8)
+            b[i] = (uint8_t)v;
+        cbor_put(cbor, b, 5);
+    }
+    else {
+        uint64_t v;
+        memcpy(&v, &data, sizeof(v));
+        b[0] = 0xfb;
+        for (int i = 8; i > 0; --i, v >>= 8)
+            b[i] = (uint8_t)v;
+        cbor_put(cbor, b, 9);
+    }
+}
+
+static void R_API_CALLCONV format_cbor_int(data_output_t *output, int data, char const *format)
+{
+    UNUSED(format);
+    data_print_cbor_t *cbor = (data_print_cbor_t *)output;
+
+    if (data >= 0)
+        cbor_head(cbor, 0, (uint64_t)data);
+    else
+        cbor_head(cbor, 1, (uint64_t)(-1 - (int64_t)data));
+}
+
+R_API size_t data_print_cbor(data_t *data, uint8_t *dst, size_t len)
+{
+    data_print_cbor_t cbor = {
+            .output = {
+                    .print_data   = format_cbor_object,
+                    .print_array  = format_cbor_array,
+                    .print_string = format_cbor_string,
+                    .print_double = format_cbor_double,
+                    .print_int    = format_cbor_int,
+            },
+            .buf  = dst,
+            .size = len,
+    };
+
+    format_cbor_object(&cbor.output, data, NULL);
+
+    return cbor.pos;
+}
@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "fatal.h"
+#include "util.h"
+#include "sync_match.h"
 
 // create decoder functions
 
@@ -29,6 +31,106 @@ r_device *create_device(r_device const *dev_template)
     return r_dev;
 }
 
+// scratch arena
+
+#define SCRATCH_ALIGN 16 // alignment of scratch memory, enough for any scalar type
+
+static size_t scratch_align(size_t size)
+{
+    return (size + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1);
+}
+
+void *decoder_scratch(r_device *decoder, size_t size)
+{
+    size = scratch_align(size ? size : 1);
+
+    // allocate the arena on first use, with the declared size
+    if (!decoder->scratch) {
+        size_t cap = scratch_align(MAX(decoder->scratch_size, size));
+        decoder->scratch = malloc(cap);
+        if (!decoder->scratch) {
+            WARN_MALLOC("decoder_scratch()");
+            return NULL; // NOTE: returns NULL on alloc failure.
+        }
+        decoder->scratch_size = cap;
+        decoder->scratch_allocs++;
+    }
+
+    if (decoder->scratch_used + size <= decoder->scratch_size) {
+        void *p = (char *)decoder->scratch + decoder->scratch_used;
+        decoder->scratch_used += size;
+        return p;
+    }
+
+    // doesn't fit, use an extra block until the reset, the header links the blocks
+    char *block = malloc(SCRATCH_ALIGN + size);
+    if (!block) {
+        WARN_MALLOC("decoder_scratch()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    *(void **)block = decoder->scratch_extra;
+    decoder->scratch_extra = block;
+    decoder->scratch_used += size;
+    decoder->scratch_allocs++;
+    return block + SCRATCH_ALIGN;
+}
+
+void decoder_scratch_reset(r_device *decoder)
+{
+    if (!decoder->scratch_extra) {
+        decoder->scratch_used = 0;
+        return;
+    }
+
+    while (decoder->scratch_extra) {
+        void *next = *(void **)decoder->scratch_extra;
+        free(decoder->scratch_extra);
+        decoder->scratch_extra = next;
+    }
+    // grow the arena to the peak use, the next decode then fits
+    free(decoder->scratch);
+    decoder->scratch      = NULL;
+    decoder->scratch_size = decoder->scratch_used;
+    decoder->scratch_used = 0;
+}
+
+void decoder_scratch_free(r_device *decoder)
+{
+    decoder_scratch_reset(decoder);
+    free(decoder->scratch);
+    decoder->scratch = NULL;
+}
+
+bitbuffer_t const *decoder_bitbuffer_inverted(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    bitbuffer_t const *inverted = bitbuffer_inverted(bitbuffer, NULL);
+    if (inverted)
+        return inverted;
+
+    bitbuffer_t *storage = decoder_scratch(decoder, sizeof(*storage));
+    if (!storage)
+        return NULL; // NOTE: returns NULL on alloc failure.
+    return bitbuffer_inverted(bitbuffer, storage);
+}
+
+// sync words
+
+unsigned decoder_sync_search(r_device *decoder, bitbuffer_t *bitbuffer, unsigned row, unsigned start, uint8_t const *pattern, unsigned pattern_bits_len)
+{
+    unsigned count = 0;
+    sync_hit_t const *hits = sync_match_hits(decoder->sync_match, bitbuffer, &count);
+    int p = hits ? sync_match_pattern(decoder->sync_match, pattern, pattern_bits_len) : -1;
+    if (p < 0)
+        return bitbuffer_search(bitbuffer, row, start, pattern, pattern_bits_len);
+
+    // the hits are ordered by row and position
+    for (unsigned i = 0; i < count; ++i) {
+        if (hits[i].row == row && hits[i].offset >= start && hits[i].pattern == (unsigned)p)
+            return hits[i].offset;
+    }
+    return bitbuffer->bits_per_row[row];
+}
+
 // output functions
 
 void decoder_output_log(r_device *decoder, int level, data_t *data)
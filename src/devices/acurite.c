@@ -1809,6 +1809,7 @@ static int acurite_00275rm_decode(r_device *decoder, bitbuffer_t *bitbuffer)
                     (b_rows[2][i] & b_rows[0][i]);
         }
         bitbuffer->bits_per_row[bitbuffer->num_rows - 1] = 88;
+        bitbuffer_invalidate(bitbuffer);
     }
 
     // Output the first valid row
@@ -1867,6 +1868,85 @@ static int acurite_00275rm_decode(r_device *decoder, bitbuffer_t *bitbuffer)
     return result;
 }
 
+/**
+Acurite PWM front end for the 592TXR family and the 00275rm.
+
+The 592TXR family (592TXR, 5n1, 3N1, Atlas, 6045, 899, 515, 1190) and the
+00275rm/00276rm share the PWM coding (about 220 us and 410 us pulses, a
+630 us sync) and a row ends at each sync gap. Instead of slicing each package
+twice, this front end slices once and prechecks the rows:
+
+- rows of 6 to 10 bytes with an 8 bit checksum at any length from 6 bytes
+  on go to the 592TXR family decoder,
+- rows of 88 bits go to the 00275rm decoder if any of them passes the CRC
+  or there are three of them to combine.
+
+Only the plausible rows are handed on, a package with none isn't decoded at all.
+The individual decoders are disabled by default but still available.
+*/
+static int acurite_pwm_decode(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    bitbuffer_t txr_rows = {0};
+    bitbuffer_t rm_rows  = {0};
+    unsigned rm_crc_ok   = 0;
+    int plausible_len    = 0;
+
+    // prechecks on the inverted bits, the decoders invert their rows themselves
+    bitbuffer_t const *inv = decoder_bitbuffer_inverted(decoder, bitbuffer);
+    if (!inv)
+        return DECODE_FAIL_OTHER;
+    for (unsigned row = 0; row < bitbuffer->num_rows; ++row) {
+        unsigned bit_cnt = bitbuffer->bits_per_row[row];
+        unsigned browlen = bit_cnt / 8;
+        uint8_t const *b = inv->bb[row];
+        bitbuffer_t *dst = NULL;
+
+        if (bit_cnt == 88) {
+            plausible_len = 1;
+            rm_crc_ok += crc16lsb(b, 11, 0x00b2, 0x00d0) == 0;
+            dst = &rm_rows;
+        }
+        else if (browlen >= 6 && browlen <= 10) {
+            plausible_len = 1;
+            int sum = 0;
+            for (unsigned i = 0; i < browlen; ++i) {
+                if (i >= 5 && (sum & 0xff) == b[i]) {
+                    dst = &txr_rows;
+                    break;
+                }
+                sum += b[i];
+            }
+        }
+        if (!dst || dst->num_rows >= BITBUF_ROWS)
+            continue;
+
+        memcpy(dst->bb[dst->num_rows], bitbuffer->bb[row], sizeof(bitrow_t));
+        dst->bits_per_row[dst->num_rows] = bit_cnt;
+        dst->free_row = ++dst->num_rows;
+    }
+
+    int events = 0;
+    int result = plausible_len ? DECODE_FAIL_MIC : DECODE_ABORT_LENGTH;
+    if (txr_rows.num_rows) {
+        bitbuffer_invalidate(&txr_rows);
+        int ret = acurite_txr_callback(decoder, &txr_rows);
+        if (ret > 0)
+            events += ret;
+        else if (ret < 0)
+            result = ret;
+    }
+    if (rm_crc_ok || rm_rows.num_rows >= 3) {
+        bitbuffer_invalidate(&rm_rows);
+        int ret = acurite_00275rm_decode(decoder, &rm_rows);
+        if (ret > 0)
+            events += ret;
+        else if (ret < 0)
+            result = ret;
+    }
+
+    return events > 0 ? events : result;
+}
+
 static char const *const acurite_rain_gauge_output_fields[] = {
         "model",
         "id",
@@ -1950,6 +2030,7 @@ r_device const acurite_txr = {
         .gap_limit   = 500,  // longest data gap is 392 us, sync gap is 596 us
         .reset_limit = 4000, // packet gap is 2192 us
         .decode_fn   = &acurite_txr_callback,
+        .disabled    = 1, // see the Acurite PWM front end
         .fields      = acurite_txr_output_fields,
 };
 
@@ -2052,6 +2133,7 @@ r_device const acurite_00275rm = {
         .reset_limit = 708, // no packet gap, sync gap is 592 us
         .sync_width  = 632, // sync pulse is 632 us
         .decode_fn   = &acurite_00275rm_decode,
+        .disabled    = 1, // see the Acurite PWM front end
         .fields      = acurite_00275rm_output_fields,
 };
 
@@ -2066,3 +2148,50 @@ r_device const acurite_590tx = {
         .decode_fn   = &acurite_590tx_decode,
         .fields      = acurite_590_output_fields,
 };
+
+static char const *const acurite_pwm_output_fields[] = {
+        "model",
+        "message_type",
+        "subtype",
+        "id",
+        "channel",
+        "sequence_num",
+        "battery_ok",
+        "leak_detected",
+        "temperature_C",
+        "temperature_F",
+        "humidity",
+        "water",
+        "temperature_1_C",
+        "humidity_1",
+        "wind_avg_mi_h",
+        "wind_avg_km_h",
+        "wind_dir_deg",
+        "rain_in",
+        "rain_mm",
+        "storm_dist",
+        "strike_count",
+        "strike_distance",
+        "uv",
+        "lux",
+        "active",
+        "exception",
+        "raw_msg",
+        "rfi",
+        "mic",
+        NULL,
+};
+
+// The 592TXR timing, the 00275rm (232/420/632 us) is within the tolerances
+r_device const acurite_pwm = {
+        .name         = "Acurite 592TXR family and 00275rm (PWM front end)",
+        .modulation   = OOK_PULSE_PWM,
+        .short_width  = 220,  // short pulse is 220 us + 392 us gap
+        .long_width   = 408,  // long pulse is 408 us + 204 us gap
+        .sync_width   = 620,  // sync pulse is 620 us + 596 us gap
+        .gap_limit    = 500,  // longest data gap is 392 us, sync gap is 596 us
+        .reset_limit  = 4000, // packet gap is 2192 us, the 00275rm has none
+        .decode_fn    = &acurite_pwm_decode,
+        .fields       = acurite_pwm_output_fields,
+        .scratch_size = sizeof(bitbuffer_t), // the inverted copy
+};
@@ -388,5 +388,6 @@ r_device const ambientweather_wh31e = {
         .reset_limit = 1500,
         .gap_limit   = 1800,
         .decode_fn   = &ambientweather_whx_decode,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
 };
@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include "fatal.h"
 #include "decoder.h"
+#include "optparse.h"
 
 /**
 BlueLine Innovations Power Cost Monitor, tested with BLI-28000.
@@ -120,11 +121,19 @@ If you are unable to access the monitor to have it send the ID message, you can
 
 Verbose mode should be specified first on the command line to see what the "auto" mode is doing.
 
-The auto parameter will try to brute-force the ID on any messages that look like they are from a
-BlueLine monitor.  This method usually succeeds within a few minutes, but is likely to get false positives
-if there is more than one monitor in range or the messages being received are all identical (i.e. if the
-meter is continuously reporting 0 watts).  If it succeeds, it will start reporting data with the new ID,
-which you should then use as a parameter when you re-run rtl_433 in the future.
+The auto parameter will try to solve the ID from any messages that look like they are from a
+BlueLine monitor.  Each message is consistent with 64 possible IDs, which follow directly from
+an inverted CRC-8 table.  A bounded set of candidate IDs collects hits across distinct messages
+(repeated bursts count once), and a candidate that reaches the threshold and is the single best
+fit of a message is locked.  Several monitors in range are locked independently, and the search
+continues for new monitors.  Messages that are all identical (i.e. if the meter is continuously
+reporting 0 watts) can't be solved.
+
+Several IDs can be given, and locked IDs can be kept in a state file, one ID per line,
+so that a restart decodes immediately:
+
+    rtl_433 -R 176:auto,state=blueline.ids
+    rtl_433 -R 176:45364,12340
 
 Finally, passing a parameter to this decoder requires specifying it explicitly, which normally disables all
 other default decoders.  If you want to pass an option to this decoder without disabling all the other defaults,
@@ -145,46 +154,114 @@ enabled), then add this decoder back with a parameter.  The command line looks l
 #define BLUELINE_TEMPERATURE_MSG 0x02
 #define BLUELINE_ENERGY_MSG      0x03
 
-#define BLUELINE_ID_STEP_SIZE 4
-#define MAX_POSSIBLE_BLUELINE_IDS (65536/BLUELINE_ID_STEP_SIZE)
+#define BLUELINE_MAX_MONITORS     16   // locked IDs per decoder instance
+#define BLUELINE_MAX_CANDIDATES   1024 // candidate IDs tracked while searching
+#define BLUELINE_RECENT_PAYLOADS  16   // repeated payloads carry no new information
 #define BLUELINE_ID_GUESS_THRESHOLD 4
+#define BLUELINE_STATE_FILE_SIZE  256
+
+struct blueline_candidate {
+    uint16_t id;
+    uint16_t hits;      ///< number of distinct payloads the ID is consistent with
+    unsigned last_seen; ///< payload sequence when last hit
+};
 
 struct blueline_stateful_context {
-    unsigned id_guess_hits[MAX_POSSIBLE_BLUELINE_IDS];
-    uint16_t current_sensor_id;
+    uint16_t sensor_ids[BLUELINE_MAX_MONITORS]; ///< configured or locked IDs
+    unsigned num_sensor_ids;
     unsigned searching_for_new_id;
+    char state_file[BLUELINE_STATE_FILE_SIZE]; ///< locked IDs are saved here, if set
+    uint8_t crc_inv[256];                      ///< inverse of the CRC-8 table
+    unsigned payloads;                         ///< number of distinct payloads searched
+    unsigned num_candidates;
+    struct blueline_candidate candidates[BLUELINE_MAX_CANDIDATES];
+    uint32_t recent[BLUELINE_RECENT_PAYLOADS];
+    unsigned recent_pos;
 };
 
-static uint8_t rev_crc8(uint8_t const message[], unsigned nBytes, uint8_t polynomial, uint8_t remainder)
+/// Fill the inverse table, crc_inv[crc8(&b, 1, poly, 0)] == b.
+static void blueline_init_crc_inv(struct blueline_stateful_context *context)
+{
+    for (unsigned b = 0; b < 256; ++b) {
+        uint8_t const byte = (uint8_t)b;
+        context->crc_inv[crc8(&byte, 1, BLUELINE_CRC_POLY, BLUELINE_CRC_INIT)] = byte;
+    }
+}
+
+static int blueline_known_id(struct blueline_stateful_context const *context, uint16_t id)
 {
-    unsigned byte, bit;
+    for (unsigned i = 0; i < context->num_sensor_ids; ++i) {
+        if (context->sensor_ids[i] == id)
+            return 1;
+    }
+    return 0;
+}
 
-    // Run a CRC backwards to find out what the init value would have been.
-    // Alternatively, put a known init value in the first byte, and it will
-    // return a value that could be used in that place to get that init.
+static void blueline_save_ids(r_device *decoder, struct blueline_stateful_context const *context)
+{
+    if (!*context->state_file)
+        return;
 
-    // This logic only works assuming the polynomial has the lowest bit set,
-    // Which should be true for most CRC polynomials, but let's be safe...
-    if ((polynomial & 0x01) == 0) {
-        fprintf(stderr, "Cannot run reverse CRC-8 with this polynomial!\n");
-        return 0xFF;
+    FILE *fp = fopen(context->state_file, "w");
+    if (!fp) {
+        decoder_logf(decoder, 0, __func__, "Failed to write Blueline state file \"%s\"", context->state_file);
+        return;
     }
-    polynomial = (polynomial >> 1) | 0x80;
-
-    byte = nBytes;
-    while (byte--) {
-        bit = 8;
-        while (bit--) {
-            if (remainder & 0x01) {
-                remainder = (remainder >> 1) ^ polynomial;
-            }
-            else {
-                remainder = remainder >> 1;
-            }
-        }
-        remainder ^= message[byte];
+    for (unsigned i = 0; i < context->num_sensor_ids; ++i) {
+        fprintf(fp, "%u\n", context->sensor_ids[i]);
+    }
+    fclose(fp);
+}
+
+static void blueline_load_ids(struct blueline_stateful_context *context)
+{
+    FILE *fp = fopen(context->state_file, "r");
+    if (!fp)
+        return; // not yet written
+
+    char line[32];
+    while (fgets(line, sizeof(line), fp) && context->num_sensor_ids < BLUELINE_MAX_MONITORS) {
+        char *end;
+        unsigned long id = strtoul(line, &end, 0);
+        if (end != line && id && id <= 0xffff && !blueline_known_id(context, (uint16_t)id))
+            context->sensor_ids[context->num_sensor_ids++] = (uint16_t)id;
+    }
+    fclose(fp);
+}
+
+static void blueline_lock_id(r_device *decoder, struct blueline_stateful_context *context, uint16_t id)
+{
+    if (blueline_known_id(context, id) || context->num_sensor_ids >= BLUELINE_MAX_MONITORS)
+        return;
+
+    context->sensor_ids[context->num_sensor_ids++] = id;
+    if (context->num_sensor_ids >= BLUELINE_MAX_MONITORS)
+        context->searching_for_new_id = 0;
+    // the candidate has served its purpose
+    for (unsigned i = 0; i < context->num_candidates; ++i) {
+        if (context->candidates[i].id == id)
+            context->candidates[i].hits = 0;
+    }
+    blueline_save_ids(decoder, context);
+}
+
+/// Find a candidate or replace the one with the fewest hits, oldest first.
+static struct blueline_candidate *blueline_candidate(struct blueline_stateful_context *context, uint16_t id)
+{
+    struct blueline_candidate *weakest = NULL;
+    for (unsigned i = 0; i < context->num_candidates; ++i) {
+        struct blueline_candidate *cand = &context->candidates[i];
+        if (cand->id == id)
+            return cand;
+        if (!weakest || cand->hits < weakest->hits
+                || (cand->hits == weakest->hits && cand->last_seen < weakest->last_seen))
+            weakest = cand;
     }
-    return remainder;
+    if (context->num_candidates < BLUELINE_MAX_CANDIDATES)
+        weakest = &context->candidates[context->num_candidates++];
+
+    *weakest = (struct blueline_candidate){.id = id};
+    return weakest;
 }
 
 static uint16_t guess_blueline_id(r_device *decoder, const uint8_t *current_row)
@@ -193,53 +270,64 @@ static uint16_t guess_blueline_id(r_device *decoder, const uint8_t *current_row)
     const uint16_t start_value = ((current_row[2] << 8) | current_row[1]);
     const uint8_t recv_crc = current_row[3];
     const uint8_t rcv_msg_type = (current_row[1] & 0x03);
-    uint16_t working_value;
-    uint8_t working_buffer[2];
-    uint8_t reverse_crc_result;
-    uint16_t best_id;
-    unsigned best_hits;
-    unsigned num_at_best_hits;
-    unsigned high_byte_steps;
-
-    // TL;DR - Try all possible IDs against every incoming message, and count how many times each one
-    // succeeds.  If one of them passes a threshold, assume it must be the right one and return it.
-
-    // We do some optimizations to try and do all those checks quickly, but it's still about the
-    // same as doing a CRC across 512 bytes of data for every 2 byte payload received.
-
-    working_buffer[0] = BLUELINE_CRC_INIT;
-    working_buffer[1] = current_row[2];
-    high_byte_steps = 256;
-    best_id = 0;
-    best_hits = 0;
-    num_at_best_hits = 0;
-    while (high_byte_steps--) {
-        reverse_crc_result = rev_crc8(working_buffer, BLUELINE_CRC_BYTELEN, BLUELINE_CRC_POLY, recv_crc);
-        // Would this byte value have been usable while still being the same type of message we received?
-        if ((reverse_crc_result & 0x03) == rcv_msg_type) {
-            working_value = ((working_buffer[1] << 8) | reverse_crc_result);
-            working_value = start_value - working_value;
-            context->id_guess_hits[(working_value/BLUELINE_ID_STEP_SIZE)]++;
-            if (context->id_guess_hits[(working_value/BLUELINE_ID_STEP_SIZE)] >= best_hits) {
-                if (context->id_guess_hits[(working_value/BLUELINE_ID_STEP_SIZE)] > best_hits) {
-                    best_hits = context->id_guess_hits[(working_value / BLUELINE_ID_STEP_SIZE)];
-                    best_id = working_value;
-                    num_at_best_hits = 1;
-                } else {
-                    num_at_best_hits++;
-                }
-            }
+    const uint32_t payload = (uint32_t)recv_crc << 16 | start_value;
+
+    // An identical payload fits the same IDs again, it must not count twice.
+    for (unsigned i = 0; i < BLUELINE_RECENT_PAYLOADS; ++i) {
+        if (context->recent[i] == payload)
+            return 0;
+    }
+    context->recent[context->recent_pos] = payload;
+    context->recent_pos = (context->recent_pos + 1) % BLUELINE_RECENT_PAYLOADS;
+    context->payloads++;
+
+    // The CRC runs over the offset payload {lo, hi}: crc = T[T[lo] ^ hi].
+    // For each high byte the low byte follows from the inverse table,
+    // those of the received message type give the 64 IDs consistent with the message.
+    // Each ID gets a hit, an ID that collects enough hits and is the single best
+    // of this message is taken as a monitor ID.
+    const uint8_t t_lo_hi = context->crc_inv[recv_crc];
+    uint16_t best_id = 0;
+    unsigned best_hits = 0;
+    unsigned num_at_best_hits = 0;
+    for (unsigned hi = 0; hi < 256; ++hi) {
+        const uint8_t lo = context->crc_inv[t_lo_hi ^ hi];
+        if ((lo & 0x03) != rcv_msg_type)
+            continue;
+        const uint16_t id = start_value - (uint16_t)(hi << 8 | lo);
+        struct blueline_candidate *cand = blueline_candidate(context, id);
+        if (cand->hits < UINT16_MAX)
+            cand->hits++;
+        cand->last_seen = context->payloads;
+        if (cand->hits > best_hits) {
+            best_hits = cand->hits;
+            best_id = id;
+            num_at_best_hits = 1;
+        } else if (cand->hits == best_hits) {
+            num_at_best_hits++;
         }
-        working_buffer[1] += 1;
     }
 
     decoder_logf(decoder, 1, __func__, "Attempting Blueline autodetect: best_hits=%u num_at_best_hits=%u", best_hits, num_at_best_hits);
     return ((best_hits >= BLUELINE_ID_GUESS_THRESHOLD) && (num_at_best_hits == 1)) ? best_id : 0;
 }
 
+/// The state is large, only allocate it once a plausible message is seen.
+static struct blueline_stateful_context *blueline_context(r_device *decoder)
+{
+    if (!decoder->decode_ctx) {
+        decoder->decode_ctx = calloc(1, sizeof(struct blueline_stateful_context));
+        if (!decoder->decode_ctx)
+            WARN_CALLOC("blueline_context()");
+        else
+            blueline_init_crc_inv(decoder->decode_ctx);
+    }
+    return decoder->decode_ctx;
+}
+
 static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
 {
-    struct blueline_stateful_context *const context = decoder->decode_ctx;
+    struct blueline_stateful_context *context = NULL;
     data_t *data;
     int row_index;
     uint8_t *current_row;
@@ -264,19 +352,30 @@ static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             continue;
         }
 
+        if (!context)
+            context = blueline_context(decoder);
+        if (!context)
+            return DECODE_FAIL_OTHER;
+
         // We need to know which type of message to decide how to check CRC
         const unsigned message_type = (current_row[1] & 0x03);
         const uint8_t recv_crc = current_row[3];
 
+        uint16_t sensor_id = 0;
         if (message_type == BLUELINE_TXID_MSG) {
             // No offset required before CRC or data handling
             calc_crc = crc8(&current_row[1], BLUELINE_CRC_BYTELEN, BLUELINE_CRC_POLY, BLUELINE_CRC_INIT);
         } else {
-            // Offset required before CRC or datahandling
-            offset_payload_u16 = ((current_row[2] << 8) | current_row[1]) - context->current_sensor_id;
-            offset_payload_u8[0] = (offset_payload_u16 & 0xFF);
-            offset_payload_u8[1] = (offset_payload_u16 >> 8);
-            calc_crc = crc8(&offset_payload_u8[0], BLUELINE_CRC_BYTELEN, BLUELINE_CRC_POLY, BLUELINE_CRC_INIT);
+            // Offset required before CRC or datahandling, try each known ID (or 0 if there are none)
+            unsigned num_ids = context->num_sensor_ids ? context->num_sensor_ids : 1;
+            calc_crc = ~recv_crc;
+            for (unsigned i = 0; i < num_ids && calc_crc != recv_crc; ++i) {
+                sensor_id = context->num_sensor_ids ? context->sensor_ids[i] : 0;
+                offset_payload_u16 = ((current_row[2] << 8) | current_row[1]) - sensor_id;
+                offset_payload_u8[0] = (offset_payload_u16 & 0xFF);
+                offset_payload_u8[1] = (offset_payload_u16 >> 8);
+                calc_crc = crc8(&offset_payload_u8[0], BLUELINE_CRC_BYTELEN, BLUELINE_CRC_POLY, BLUELINE_CRC_INIT);
+            }
         }
 
         // If the CRC didn't match up, ignore this row!
@@ -284,9 +383,8 @@ static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             if ((context->searching_for_new_id) && (message_type != BLUELINE_TXID_MSG)) {
                 uint16_t id_guess = guess_blueline_id(decoder, current_row);
                 if (id_guess != 0) {
-                    decoder_logf(decoder, 1, __func__,"Switching to auto-detected Blueline ID %u", id_guess);
-                    context->current_sensor_id = id_guess;
-                    context->searching_for_new_id = 0;
+                    decoder_logf(decoder, 1, __func__,"Locking auto-detected Blueline ID %u", id_guess);
+                    blueline_lock_id(decoder, context, id_guess);
                 }
             }
             if (DECODE_FAIL_MIC < most_applicable_failure) {
@@ -306,17 +404,16 @@ static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             /* clang-format on */
             decoder_output_data(decoder, data);
             payloads_decoded++;
-            if (context->searching_for_new_id) {
-                decoder_logf(decoder, 1, __func__,"Switching to received Blueline ID %u", received_sensor_id);
-                context->current_sensor_id = received_sensor_id;
-                context->searching_for_new_id = 0;
+            if (context->searching_for_new_id && !blueline_known_id(context, received_sensor_id)) {
+                decoder_logf(decoder, 1, __func__,"Locking received Blueline ID %u", received_sensor_id);
+                blueline_lock_id(decoder, context, received_sensor_id);
             }
         } else if (message_type == BLUELINE_POWER_MSG) {
             const uint16_t ms_per_pulse = offset_payload_u16;
             /* clang-format off */
             data = data_make(
                     "model",        "",             DATA_STRING, "Blueline-PowerCost",
-                    "id",           "",             DATA_INT,    context->current_sensor_id,
+                    "id",           "",             DATA_INT,    sensor_id,
                     "gap",          "",             DATA_INT,    ms_per_pulse,
                     "mic",          "Integrity",    DATA_STRING, "CRC",
                     NULL);
@@ -356,7 +453,7 @@ static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             /* clang-format off */
             data = data_make(
                     "model",            "",             DATA_STRING, "Blueline-PowerCost",
-                    "id",               "",             DATA_INT,    context->current_sensor_id,
+                    "id",               "",             DATA_INT,    sensor_id,
                     "flags",            "",             DATA_FORMAT, "%02x", DATA_INT, flags,
                     "battery_ok",       "Battery",      DATA_INT,    !battery,
                     "temperature_C",    "",             DATA_DOUBLE, temperature_C,
@@ -371,7 +468,7 @@ static int blueline_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             /* clang-format off */
             data = data_make(
                     "model",            "",             DATA_STRING, "Blueline-PowerCost",
-                    "id",               "",             DATA_INT, context->current_sensor_id,
+                    "id",               "",             DATA_INT, sensor_id,
                     "impulses",         "",             DATA_INT,    pulses,
                     "mic",              "Integrity",    DATA_STRING, "CRC",
                     NULL);
@@ -406,24 +503,28 @@ static r_device *blueline_create(char *arg)
         return NULL; // NOTE: returns NULL on alloc failure.
     }
 
-    struct blueline_stateful_context *context = malloc(sizeof(*context));
-    if (!context) {
-        WARN_MALLOC("blueline_create()");
-        free(r_dev);
-        return NULL; // NOTE: returns NULL on alloc failure.
-    }
-    memset(context, 0, sizeof(*context));
-    r_dev->decode_ctx = context;
-
+    // without options the state is allocated on first use
     if (arg != NULL) {
-        if (strcmp(arg, "auto") == 0) {
-            // Setup for auto identification
-            context->searching_for_new_id = 1;
-            //fprintf(stderr, "Blueline decoder will try to autodetect ID.\n");
-        } else {
-            // Assume user is trying to pass in hex ID
-            context->current_sensor_id = strtoul(arg, NULL, 0);
-            //fprintf(stderr, "Blueline decoder using ID %u\n", context->current_sensor_id);
+        struct blueline_stateful_context *context = blueline_context(r_dev);
+        if (!context) {
+            free(r_dev);
+            return NULL; // NOTE: returns NULL on alloc failure.
+        }
+
+        char *key, *val;
+        while (getkwargs(&arg, &key, &val)) {
+            if (!strcmp(key, "auto")) {
+                // Setup for auto identification
+                context->searching_for_new_id = 1;
+            } else if (!strcmp(key, "state") && val && *val) {
+                snprintf(context->state_file, sizeof(context->state_file), "%s", val);
+                blueline_load_ids(context);
+            } else if (context->num_sensor_ids < BLUELINE_MAX_MONITORS) {
+                // Assume user is trying to pass in hex ID
+                uint16_t id = strtoul(key, NULL, 0);
+                if (!blueline_known_id(context, id))
+                    context->sensor_ids[context->num_sensor_ids++] = id;
+            }
         }
     }
 
@@ -56,6 +56,7 @@ static int bresser_3ch_decode(r_device *decoder, bitbuffer_t *bitbuffer)
     b[2] = ~b[2];
     b[3] = ~b[3];
     b[4] = ~b[4];
+    bitbuffer_invalidate(bitbuffer);
 
     if (((b[0] + b[1] + b[2] + b[3] - b[4]) & 0xFF) != 0) {
         decoder_log(decoder, 1, __func__, "checksum error");
@@ -74,6 +74,7 @@ static int eurochron_efth800_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             bitbuffer->bits_per_row[row] = 0; // cancel row
         }
     }
+    bitbuffer_invalidate(bitbuffer);
 
     /* Validation checks */
     row = bitbuffer_find_repeated_row(bitbuffer, 2, 48);
@@ -0,0 +1,225 @@
+/** @file
+    Itron ERT front end for SCM, SCM+, IDM and NetIDM.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "decoder.h"
+#include "fatal.h"
+#include <stdlib.h>
+
+/**
+Itron ERT front end for SCM, SCM+, IDM and NetIDM.
+
+The ERT messages share the modulation (OOK Manchester, 30 us half-bit) and
+differ in sync word, packet type, and CRC:
+
+- SCM: preamble 0x1F2A60 (21 bits), 96 bits, BCH (poly 0x6F63) over bits 16-95,
+  only the last 16 preamble bits are matched, the leading ones slice with an unknown phase
+- SCM+: sync 0x16A3 and type 0x1E, 128 bits, CRC-16 (poly 0x1021, init 0x0971)
+- IDM and NetIDM: sync 0x16A3 and type 0x1C, 720 bits, CRC-16 (poly 0x1021, init 0xD895)
+
+Instead of each decoder slicing the package and searching its own sync word,
+this front end slices once, searches all sync words in a single pass over the
+bits, and hands each frame that passes the CRC, aligned to a row of its own,
+to exactly one decoder. The output is that of the individual decoders.
+
+IDM and NetIDM can't be told apart by sync, type, length, or CRC. Type 0x1C
+frames are decoded as IDM, use the `netidm` option to decode them as NetIDM:
+
+    rtl_433 -R 250:netidm
+
+The individual decoders are disabled by default but still available.
+*/
+
+extern r_device const ert_scm;
+extern r_device const scmplus;
+extern r_device const ert_idm;
+extern r_device const ert_netidm;
+
+#define ERT_SCM_SYNC       0x2A60 // the last 16 preamble bits, the leading ones slice with an unknown phase
+#define ERT_SCM_SYNC_MASK  0xFFFF
+#define ERT_SCM_SYNC_END   20 // offset of the last sync bit in the frame
+#define ERT_SCM_BITLEN     96
+#define ERT_SCMPLUS_SYNC   0x16A31E
+#define ERT_SCMPLUS_BITLEN 128
+#define ERT_IDM_SYNC       0x16A31C
+#define ERT_IDM_BITLEN     720
+
+/// Check the CRC of a candidate frame, returns the frame length or 0.
+static unsigned ert_amr_check(bitbuffer_t *bitbuffer, unsigned row, unsigned start, uint32_t sync)
+{
+    uint8_t b[ERT_IDM_BITLEN / 8];
+
+    if (sync == ERT_SCM_SYNC) {
+        bitbuffer_extract_bytes(bitbuffer, row, start, b, ERT_SCM_BITLEN);
+        return crc16(&b[2], 10, 0x6F63, 0) ? 0 : ERT_SCM_BITLEN;
+    }
+    if (sync == ERT_SCMPLUS_SYNC) {
+        bitbuffer_extract_bytes(bitbuffer, row, start, b, ERT_SCMPLUS_BITLEN);
+        return crc16(&b[2], 12, 0x1021, 0x0971) != (b[14] << 8 | b[15]) ? 0 : ERT_SCMPLUS_BITLEN;
+    }
+    bitbuffer_extract_bytes(bitbuffer, row, start, b, ERT_IDM_BITLEN);
+    return crc16(&b[2], 86, 0x1021, 0xD895) != (b[88] << 8 | b[89]) ? 0 : ERT_IDM_BITLEN;
+}
+
+static int ert_amr_decode(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    int const netidm = decoder->decode_ctx != NULL;
+    int events = 0;
+    int result = DECODE_ABORT_EARLY;
+
+    for (unsigned row = 0; row < bitbuffer->num_rows; ++row) {
+        uint8_t const *bits = bitbuffer->bb[row];
+        unsigned const len  = bitbuffer->bits_per_row[row];
+        if (len < ERT_SCM_BITLEN) {
+            if (result == DECODE_ABORT_EARLY)
+                result = DECODE_ABORT_LENGTH;
+            continue;
+        }
+
+        // one pass over the bits, matching all sync words on a shift register
+        uint32_t reg = 0;
+        for (unsigned pos = 0; pos < len; ++pos) {
+            reg = (reg << 1) | ((bits[pos >> 3] >> (7 - (pos & 7))) & 1);
+
+            uint32_t sync;
+            unsigned start;
+            unsigned need;
+            if ((reg & ERT_SCM_SYNC_MASK) == ERT_SCM_SYNC && pos >= ERT_SCM_SYNC_END) {
+                sync  = ERT_SCM_SYNC;
+                start = pos - ERT_SCM_SYNC_END;
+                need  = ERT_SCM_BITLEN;
+            }
+            else if ((reg & 0xFFFFFF) == ERT_SCMPLUS_SYNC && pos >= 23) {
+                sync  = ERT_SCMPLUS_SYNC;
+                start = pos - 23;
+                need  = ERT_SCMPLUS_BITLEN;
+            }
+            else if ((reg & 0xFFFFFF) == ERT_IDM_SYNC && pos >= 23) {
+                sync  = ERT_IDM_SYNC;
+                start = pos - 23;
+                need  = ERT_IDM_BITLEN;
+            }
+            else {
+                continue;
+            }
+            if (start + need > len) {
+                result = DECODE_ABORT_LENGTH;
+                continue;
+            }
+            unsigned frame_len = ert_amr_check(bitbuffer, row, start, sync);
+            if (!frame_len) {
+                result = DECODE_FAIL_MIC;
+                continue;
+            }
+
+            // hand the aligned frame to the one decoder for the packet type
+            bitbuffer_t frame = {0};
+            bitbuffer_extract_bytes(bitbuffer, row, start, frame.bb[0], frame_len);
+            frame.bits_per_row[0] = frame_len;
+            frame.num_rows        = 1;
+            bitbuffer_invalidate(&frame);
+
+            r_device const *member = sync == ERT_SCM_SYNC ? &ert_scm
+                    : sync == ERT_SCMPLUS_SYNC           ? &scmplus
+                    : netidm                             ? &ert_netidm
+                                                         : &ert_idm;
+            decoder_logf(decoder, 2, __func__, "%s frame at row %u bit %u", member->name, row, start);
+            int ret = member->decode_fn(decoder, &frame);
+            if (ret > 0) {
+                events += ret;
+                pos = start + frame_len - 1; // continue after the frame
+                reg = 0;
+            }
+            else {
+                result = ret;
+            }
+        }
+    }
+
+    return events > 0 ? events : result;
+}
+
+r_device const ert_amr;
+
+static r_device *ert_amr_create(char *arg)
+{
+    r_device *r_dev = create_device(&ert_amr);
+    if (!r_dev) {
+        fprintf(stderr, "ert_amr_create() failed\n");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    if (arg && !strcmp(arg, "netidm")) {
+        int *quirk = malloc(sizeof(*quirk));
+        if (!quirk) {
+            WARN_MALLOC("ert_amr_create()");
+            free(r_dev);
+            return NULL; // NOTE: returns NULL on alloc failure.
+        }
+        *quirk = 1;
+        r_dev->decode_ctx = quirk;
+    }
+    else if (arg && *arg && strcmp(arg, "idm")) {
+        fprintf(stderr, "ert_amr: unknown option \"%s\", use \"idm\" or \"netidm\"\n", arg);
+    }
+
+    return r_dev;
+}
+
+static char const *const output_fields[] = {
+        "model",
+        "id",
+        // SCM
+        "physical_tamper",
+        "ert_type",
+        "encoder_tamper",
+        "consumption_data",
+        // SCM+
+        "ProtocolID",
+        "EndpointType",
+        "EndpointID",
+        "Consumption",
+        "Tamper",
+        "MeterType",
+        // IDM and NetIDM
+        "PacketTypeID",
+        "PacketLength",
+        "HammingCode",
+        "ApplicationVersion",
+        "ERTType",
+        "ERTSerialNumber",
+        "ConsumptionIntervalCount",
+        "ModuleProgrammingState",
+        "Unknown_field_1",
+        "LastGenerationCount",
+        "Unknown_field_2",
+        "TamperCounters",
+        "AsynchronousCounters",
+        "PowerOutageFlags",
+        "LastConsumptionCount",
+        "DifferentialConsumptionIntervals",
+        "TransmitTimeOffset",
+        "MeterIdCRC",
+        "PacketCRC",
+        "mic",
+        NULL,
+};
+
+r_device const ert_amr = {
+        .name        = "Itron ERT SCM, SCM+, IDM and NetIDM",
+        .modulation  = OOK_PULSE_MANCHESTER_ZEROBIT,
+        .short_width = 30,
+        .long_width  = 0, // not used
+        .gap_limit   = 20000,
+        .reset_limit = 20000,
+        .decode_fn   = &ert_amr_decode,
+        .create_fn   = &ert_amr_create,
+        .fields      = output_fields,
+};
@@ -628,6 +628,7 @@ r_device const ert_idm = {
         // .gap_limit   = 2500,
         // .reset_limit = 4000,
         .decode_fn = &ert_idm_decode,
+        .disabled  = 1, // see the ERT front end
         .fields    = output_fields,
 };
 
@@ -641,5 +642,6 @@ r_device const ert_netidm = {
         // .gap_limit   = 2500,
         // .reset_limit = 4000,
         .decode_fn = &ert_netidm_decode,
+        .disabled  = 1, // see the ERT front end
         .fields    = output_fields,
 };
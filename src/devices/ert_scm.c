@@ -114,5 +114,6 @@ r_device const ert_scm = {
         .gap_limit   = 0,
         .reset_limit = 64,
         .decode_fn   = &ert_scm_decode,
+        .disabled    = 1, // see the ERT front end
         .fields      = output_fields,
 };
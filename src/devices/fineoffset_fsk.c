@@ -0,0 +1,314 @@
+/** @file
+    Fine Offset / Ecowitt FSK front end.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "decoder.h"
+
+/**
+Fine Offset / Ecowitt FSK front end.
+
+The Fine Offset and Ecowitt FSK sensors (WH24, WH25, WH32B, WH0290, WH31E,
+WH40, WH51, WH1080, WH31L, WS80, WH45, WN34, WS90, and the TFA 30.3151) share
+the modulation (FSK PCM, 56 to 60 us bit width, the bit width is tuned on the
+preamble) and the 0xAA 0x2D 0xD4 preamble and sync word. Most of them check a
+CRC-8 (poly 0x31, init 0x00) over the payload after the sync.
+
+Instead of each decoder slicing the package and searching the sync word on
+its own, this front end slices once, finds all sync words in a single pass
+over the bits, and computes the CRC-8 of every payload prefix in one table
+driven pass per sync. The family code (first payload byte) and a zero CRC
+residue at the length for that code select the member decoders, only those
+get the package. A member gets the row as its own slicer would have produced
+it (ended at its reset limit), as several classify by row length.
+
+The individual decoders are disabled by default but still available.
+*/
+
+extern r_device const fineoffset_WH25;
+extern r_device const ambientweather_wh31e;
+extern r_device const fineoffset_WH51;
+extern r_device const fineoffset_wh1080_fsk;
+extern r_device const fineoffset_wh31l;
+extern r_device const fineoffset_ws80;
+extern r_device const fineoffset_wh45;
+extern r_device const fineoffset_wn34;
+extern r_device const fineoffset_ws90;
+extern r_device const tfa_303151;
+
+// in protocol order, the order of the output
+static r_device const *const fineoffset_fsk_members[] = {
+        &fineoffset_WH25,
+        &ambientweather_wh31e,
+        &fineoffset_WH51,
+        &fineoffset_wh1080_fsk,
+        &fineoffset_wh31l,
+        &fineoffset_ws80,
+        &fineoffset_wh45,
+        &fineoffset_wn34,
+        &fineoffset_ws90,
+        &tfa_303151,
+};
+
+enum {
+    FO_WH25,
+    FO_WH31E,
+    FO_WH51,
+    FO_WH1080,
+    FO_WH31L,
+    FO_WS80,
+    FO_WH45,
+    FO_WN34,
+    FO_WS90,
+    FO_TFA,
+    FO_MEMBERS,
+};
+
+/// A member claims a payload if the family code matches and the CRC-8 residue over @p crc_len bytes is zero.
+typedef struct {
+    uint8_t code;
+    uint8_t mask;
+    uint8_t crc_len; ///< payload bytes including the CRC, 0 if the member has no CRC-8
+    uint8_t member;
+} fineoffset_fsk_claim_t;
+
+static fineoffset_fsk_claim_t const fineoffset_fsk_claims[] = {
+        {0x24, 0xff, 16, FO_WH25},   // WH24, WH65B, HP1000
+        {0xe0, 0xf0, 0, FO_WH25},    // WH25, WH32B, sum and xor only
+        {0xd0, 0xf0, 0, FO_WH25},    // WH32
+        {0x00, 0x00, 7, FO_WH25},    // WH0290, any family code
+        {0x30, 0xff, 6, FO_WH31E},   // WH31E
+        {0x37, 0xff, 6, FO_WH31E},   // WH31B
+        {0x52, 0xff, 10, FO_WH31E},  // RCC
+        {0x40, 0xff, 8, FO_WH31E},   // WH40
+        {0x68, 0xff, 15, FO_WH31E},  // WH68
+        {0x51, 0xff, 13, FO_WH51},   // WH51
+        {0xa0, 0xf0, 10, FO_WH1080}, // weather, the CRC with init 0xff over 0xff is zero
+        {0xb0, 0xf0, 10, FO_WH1080}, // datetime
+        {0x70, 0xf0, 10, FO_WH1080}, // UV/light
+        {0x57, 0xff, 8, FO_WH31L},   // WH31L
+        {0x80, 0xff, 17, FO_WS80},   // WS80
+        {0x45, 0xff, 14, FO_WH45},   // WH45
+        {0x34, 0xff, 8, FO_WN34},    // WN34
+        {0x90, 0xff, 31, FO_WS90},   // WS90
+        {0x00, 0x00, 9, FO_TFA},     // TFA 30.3151, no family code
+};
+
+/// CRC-8 poly 0x31 by byte.
+static uint8_t const fineoffset_fsk_crc8[256] = {
+        0x00, 0x31, 0x62, 0x53, 0xc4, 0xf5, 0xa6, 0x97, 0xb9, 0x88, 0xdb, 0xea, 0x7d, 0x4c, 0x1f, 0x2e,
+        0x43, 0x72, 0x21, 0x10, 0x87, 0xb6, 0xe5, 0xd4, 0xfa, 0xcb, 0x98, 0xa9, 0x3e, 0x0f, 0x5c, 0x6d,
+        0x86, 0xb7, 0xe4, 0xd5, 0x42, 0x73, 0x20, 0x11, 0x3f, 0x0e, 0x5d, 0x6c, 0xfb, 0xca, 0x99, 0xa8,
+        0xc5, 0xf4, 0xa7, 0x96, 0x01, 0x30, 0x63, 0x52, 0x7c, 0x4d, 0x1e, 0x2f, 0xb8, 0x89, 0xda, 0xeb,
+        0x3d, 0x0c, 0x5f, 0x6e, 0xf9, 0xc8, 0x9b, 0xaa, 0x84, 0xb5, 0xe6, 0xd7, 0x40, 0x71, 0x22, 0x13,
+        0x7e, 0x4f, 0x1c, 0x2d, 0xba, 0x8b, 0xd8, 0xe9, 0xc7, 0xf6, 0xa5, 0x94, 0x03, 0x32, 0x61, 0x50,
+        0xbb, 0x8a, 0xd9, 0xe8, 0x7f, 0x4e, 0x1d, 0x2c, 0x02, 0x33, 0x60, 0x51, 0xc6, 0xf7, 0xa4, 0x95,
+        0xf8, 0xc9, 0x9a, 0xab, 0x3c, 0x0d, 0x5e, 0x6f, 0x41, 0x70, 0x23, 0x12, 0x85, 0xb4, 0xe7, 0xd6,
+        0x7a, 0x4b, 0x18, 0x29, 0xbe, 0x8f, 0xdc, 0xed, 0xc3, 0xf2, 0xa1, 0x90, 0x07, 0x36, 0x65, 0x54,
+        0x39, 0x08, 0x5b, 0x6a, 0xfd, 0xcc, 0x9f, 0xae, 0x80, 0xb1, 0xe2, 0xd3, 0x44, 0x75, 0x26, 0x17,
+        0xfc, 0xcd, 0x9e, 0xaf, 0x38, 0x09, 0x5a, 0x6b, 0x45, 0x74, 0x27, 0x16, 0x81, 0xb0, 0xe3, 0xd2,
+        0xbf, 0x8e, 0xdd, 0xec, 0x7b, 0x4a, 0x19, 0x28, 0x06, 0x37, 0x64, 0x55, 0xc2, 0xf3, 0xa0, 0x91,
+        0x47, 0x76, 0x25, 0x14, 0x83, 0xb2, 0xe1, 0xd0, 0xfe, 0xcf, 0x9c, 0xad, 0x3a, 0x0b, 0x58, 0x69,
+        0x04, 0x35, 0x66, 0x57, 0xc0, 0xf1, 0xa2, 0x93, 0xbd, 0x8c, 0xdf, 0xee, 0x79, 0x48, 0x1b, 0x2a,
+        0xc1, 0xf0, 0xa3, 0x92, 0x05, 0x34, 0x67, 0x56, 0x78, 0x49, 0x1a, 0x2b, 0xbc, 0x8d, 0xde, 0xef,
+        0x82, 0xb3, 0xe0, 0xd1, 0x46, 0x77, 0x24, 0x15, 0x3b, 0x0a, 0x59, 0x68, 0xff, 0xce, 0x9d, 0xac,
+};
+
+#define FO_SYNC        0xAA2DD4
+#define FO_MAX_SYNCS   16
+#define FO_MAX_PAYLOAD 31 // WS90
+#define FO_MIN_RESET   16 // shortest reset limit of a member in bits, WH31L
+#define FO_MAX_RUNS    32
+
+/// A run of zeros, possibly the gap ending a message of a member.
+typedef struct {
+    unsigned start;
+    unsigned len;
+} fineoffset_fsk_run_t;
+
+/// Bitmask of the members claiming the payload at @p start.
+static unsigned fineoffset_fsk_claim(bitbuffer_t *bitbuffer, unsigned start)
+{
+    unsigned len = (bitbuffer->bits_per_row[0] - start) / 8;
+    if (len > FO_MAX_PAYLOAD)
+        len = FO_MAX_PAYLOAD;
+    uint8_t b[FO_MAX_PAYLOAD];
+    bitbuffer_extract_bytes(bitbuffer, 0, start, b, len * 8);
+
+    // the CRC residue of each prefix in one pass
+    uint8_t residue[FO_MAX_PAYLOAD + 1];
+    residue[0] = 0;
+    for (unsigned i = 0; i < len; ++i)
+        residue[i + 1] = fineoffset_fsk_crc8[residue[i] ^ b[i]];
+
+    unsigned members = 0;
+    for (unsigned i = 0; i < sizeof(fineoffset_fsk_claims) / sizeof(*fineoffset_fsk_claims); ++i) {
+        fineoffset_fsk_claim_t const *c = &fineoffset_fsk_claims[i];
+        if (len < 1 || (b[0] & c->mask) != c->code)
+            continue;
+        if (c->crc_len && (c->crc_len > len || residue[c->crc_len]))
+            continue;
+        members |= 1u << c->member;
+    }
+    return members;
+}
+
+static int fineoffset_fsk_decode(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    if (bitbuffer->num_rows != 1)
+        return DECODE_ABORT_EARLY;
+
+    uint8_t const *bits = bitbuffer->bb[0];
+    unsigned const len  = bitbuffer->bits_per_row[0];
+
+    // one pass over the bits for the sync words and the runs of zeros
+    unsigned sync_pos[FO_MAX_SYNCS];
+    unsigned num_syncs = 0;
+    fineoffset_fsk_run_t runs[FO_MAX_RUNS];
+    unsigned num_runs = 0;
+    unsigned zeros    = 0;
+    uint32_t reg      = 0;
+    for (unsigned pos = 0; pos < len; ++pos) {
+        int bit = (bits[pos >> 3] >> (7 - (pos & 7))) & 1;
+        reg     = (reg << 1) | bit;
+        if ((reg & 0xFFFFFF) == FO_SYNC && pos >= 23 && num_syncs < FO_MAX_SYNCS)
+            sync_pos[num_syncs++] = pos + 1;
+        if (!bit) {
+            zeros++;
+            continue;
+        }
+        if (zeros > FO_MIN_RESET && num_runs < FO_MAX_RUNS)
+            runs[num_runs++] = (fineoffset_fsk_run_t){pos - zeros, zeros};
+        zeros = 0;
+    }
+    if (!num_syncs)
+        return DECODE_ABORT_EARLY;
+
+    unsigned claims[FO_MAX_SYNCS];
+    unsigned claimed = 0;
+    for (unsigned i = 0; i < num_syncs; ++i) {
+        claims[i] = fineoffset_fsk_claim(bitbuffer, sync_pos[i]);
+        claimed |= claims[i];
+    }
+    if (!claimed)
+        return DECODE_FAIL_MIC;
+
+    int events = 0;
+    int result = DECODE_FAIL_SANITY;
+    for (unsigned m = 0; m < FO_MEMBERS; ++m) {
+        if (!(claimed & (1u << m)))
+            continue;
+        r_device const *member = fineoffset_fsk_members[m];
+        // a member ends a message at a gap over its reset limit, and keeps at most the gap limit as zeros
+        unsigned reset_bits = member->reset_limit / member->long_width;
+        unsigned gap_bits   = (member->gap_limit ? member->gap_limit : member->reset_limit) / member->long_width;
+
+        unsigned seg_start = 0;
+        unsigned next_sync = 0;
+        for (unsigned r = 0; r <= num_runs; ++r) {
+            unsigned seg_end;
+            unsigned next_start;
+            if (r < num_runs && runs[r].len > reset_bits) {
+                seg_end    = runs[r].start + MIN(runs[r].len, gap_bits);
+                next_start = runs[r].start + runs[r].len;
+            }
+            else if (r == num_runs) {
+                seg_end    = len - zeros + MIN(zeros, gap_bits); // the trailing zeros
+                next_start = len;
+            }
+            else {
+                continue;
+            }
+
+            // only hand on messages with a payload claimed by this member
+            int wanted = 0;
+            for (; next_sync < num_syncs && sync_pos[next_sync] < next_start; ++next_sync)
+                wanted |= sync_pos[next_sync] >= seg_start && (claims[next_sync] & (1u << m));
+            if (wanted && seg_end > seg_start) {
+                bitbuffer_t msg = {0};
+                bitbuffer_extract_bytes(bitbuffer, 0, seg_start, msg.bb[0], seg_end - seg_start);
+                msg.bits_per_row[0] = seg_end - seg_start;
+                msg.num_rows        = 1;
+                msg.free_row        = 1;
+                bitbuffer_invalidate(&msg);
+
+                decoder_logf(decoder, 2, __func__, "%s message at bit %u", member->name, seg_start);
+                int ret = member->decode_fn(decoder, &msg);
+                if (ret > 0)
+                    events += ret;
+                else if (ret < 0)
+                    result = ret;
+            }
+            seg_start = next_start;
+        }
+    }
+
+    return events > 0 ? events : result;
+}
+
+static char const *const output_fields[] = {
+        "model",
+        "id",
+        "channel",
+        "battery_ok",
+        "battery_v",
+        "battery_mV",
+        "ext_power",
+        "supercap_V",
+        "firmware",
+        "subtype",
+        "sensor_code",
+        "msg_type",
+        "flags",
+        "temperature_C",
+        "humidity",
+        "pressure_hPa",
+        "wind_dir_deg",
+        "wind_avg_m_s",
+        "wind_max_m_s",
+        "wind_avg_km_h",
+        "wind_max_km_h",
+        "rain_mm",
+        "uv",
+        "uvi",
+        "uv_sensor_id",
+        "uv_status",
+        "uv_index",
+        "lux",
+        "light_lux",
+        "pm2_5_ug_m3",
+        "pm10_0_ug_m3",
+        "estimated_pm10_0_ug_m3",
+        "co2_ppm",
+        "moisture",
+        "boost",
+        "ad_raw",
+        "storm_dist_km",
+        "strike_count",
+        "data",
+        "radio_clock",
+        "signal",
+        "wm",
+        "state",
+        "unknown",
+        "mic",
+        NULL,
+};
+
+// The bit width is tuned on the preamble, the reset limit is the longest of the members (WH25, WH32B)
+r_device const fineoffset_fsk = {
+        .name        = "Fine Offset / Ecowitt FSK sensors (front end)",
+        .modulation  = FSK_PULSE_PCM,
+        .short_width = 58,
+        .long_width  = 58,
+        .reset_limit = 20000,
+        .decode_fn   = &fineoffset_fsk_decode,
+        .fields      = output_fields,
+        .syncs       = fineoffset_syncs,
+};
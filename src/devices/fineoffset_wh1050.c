@@ -262,5 +262,6 @@ r_device const tfa_303151 = {
         .long_width  = 60,
         .reset_limit = 2500,
         .decode_fn   = &fineoffset_wh1050_callback,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
 };
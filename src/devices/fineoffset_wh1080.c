@@ -137,7 +137,7 @@ static int fineoffset_wh1080_callback(r_device *decoder, bitbuffer_t *bitbuffer,
     }
 
     if (type == TYPE_FSK) {
-        int bit_offset = bitbuffer_search(bitbuffer, 0, 0, fsk_preamble, sizeof(fsk_preamble) * 8) + sizeof(fsk_preamble) * 8;
+        int bit_offset = decoder_sync_search(decoder, bitbuffer, 0, 0, fsk_preamble, sizeof(fsk_preamble) * 8) + sizeof(fsk_preamble) * 8;
         if (bit_offset + sizeof(bbuf) * 8 > bitbuffer->bits_per_row[0]) {  // Did not find a big enough package
             decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "short package. Header index: %u", bit_offset);
             return DECODE_ABORT_LENGTH;
@@ -366,5 +366,7 @@ r_device const fineoffset_wh1080_fsk = {
         .long_width  = 58,
         .reset_limit = 5800,
         .decode_fn   = &fineoffset_wh1080_callback_fsk,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
+        .syncs       = fineoffset_syncs,
 };
@@ -91,7 +91,7 @@ static int fineoffset_wh31l_decode(r_device *decoder, bitbuffer_t *bitbuffer)
 
     int row = 0;
     // Search for preamble and sync-word
-    unsigned start_pos = bitbuffer_search(bitbuffer, row, 0, preamble, 24);
+    unsigned start_pos = decoder_sync_search(decoder, bitbuffer, row, 0, preamble, 24);
     // No preamble detected
     if (start_pos == bitbuffer->bits_per_row[row])
         return DECODE_ABORT_EARLY;
@@ -173,5 +173,7 @@ r_device const fineoffset_wh31l = {
         .long_width  = 56,
         .reset_limit = 1000,
         .decode_fn   = &fineoffset_wh31l_decode,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
+        .syncs       = fineoffset_syncs,
 };
@@ -72,7 +72,7 @@ static int fineoffset_wh45_decode(r_device *decoder, bitbuffer_t *bitbuffer)
     }
 
     // Find a data package and extract data buffer
-    unsigned bit_offset = bitbuffer_search(bitbuffer, 0, 0, preamble, 24) + 24;
+    unsigned bit_offset = decoder_sync_search(decoder, bitbuffer, 0, 0, preamble, 24) + 24;
     if (bit_offset + sizeof(b) * 8 > bitbuffer->bits_per_row[0]) { // Did not find a big enough package
         decoder_logf_bitbuffer(decoder, 2, __func__, bitbuffer, "short package at %u", bit_offset);
         return DECODE_ABORT_LENGTH;
@@ -149,5 +149,7 @@ r_device const fineoffset_wh45 = {
         .long_width  = 58,
         .reset_limit = 2500,
         .decode_fn   = &fineoffset_wh45_decode,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
+        .syncs       = fineoffset_syncs,
 };
@@ -170,5 +170,6 @@ r_device const fineoffset_ws90 = {
         .long_width  = 58,
         .reset_limit = 3000,
         .decode_fn   = &fineoffset_ws90_decode,
+        .disabled    = 1, // see the Fine Offset FSK front end
         .fields      = output_fields,
 };
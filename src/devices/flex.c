@@ -267,6 +267,9 @@ static int flex_callback(r_device *decoder, bitbuffer_t *bitbuffer)
         }
     }
 
+    // rows were rewritten in place
+    bitbuffer_invalidate(bitbuffer);
+
     if (decoder->verbose) {
         decoder_log_bitbuffer(decoder, 1, params->name, bitbuffer, "");
     }
@@ -323,10 +326,8 @@ static int flex_callback(r_device *decoder, bitbuffer_t *bitbuffer)
         }
 
         // a simpler representation for csv output
-        row_codes[i] = malloc(8 + bitbuffer->bits_per_row[i] / 4 + 1); // "{nnnn}..\0"
-        if (!row_codes[i])
-            WARN_MALLOC("flex_decode()");
-        else // NOTE: skipped on alloc failure.
+        row_codes[i] = decoder_scratch(decoder, 8 + bitbuffer->bits_per_row[i] / 4 + 1); // "{nnnn}..\0"
+        if (row_codes[i]) // NOTE: skipped on alloc failure.
             sprintf(row_codes[i], "{%d}%s", bitbuffer->bits_per_row[i], row_bytes);
     }
     /* clang-format off */
@@ -340,9 +341,6 @@ static int flex_callback(r_device *decoder, bitbuffer_t *bitbuffer)
     /* clang-format on */
 
     decoder_output_data(decoder, data);
-    for (i = 0; i < bitbuffer->num_rows; i++) {
-        free(row_codes[i]);
-    }
 
     return 1;
 }
@@ -428,6 +426,8 @@ static void help(void)
 
 static unsigned parse_modulation(char const *str)
 {
+    if (!str)
+        str = "";
     if (!strcasecmp(str, "OOK_MC_ZEROBIT"))
         return OOK_PULSE_MANCHESTER_ZEROBIT;
     else if (!strcasecmp(str, "OOK_PCM"))
@@ -454,45 +454,47 @@ static unsigned parse_modulation(char const *str)
         return FSK_PULSE_MANCHESTER_ZEROBIT;
     else {
         fprintf(stderr, "Bad flex spec, unknown modulation!\n");
-        usage();
+        return 0;
     }
-    return 0;
 }
 
-// used for match, preamble, getter, limited to 1024 bits (128 byte).
-static unsigned parse_bits(const char *code, uint8_t *bitrow)
+// used for match, preamble, getter, limited to 1024 bits (128 byte), returns -1 on error.
+static int parse_bits(const char *code, uint8_t *bitrow)
 {
     bitbuffer_t bits = {0};
-    bitbuffer_parse(&bits, code);
+    if (code)
+        bitbuffer_parse(&bits, code);
     if (bits.num_rows != 1) {
         fprintf(stderr, "Bad flex spec, \"match\", \"preamble\", and getter mask need exactly one bit row (%d found)!\n", bits.num_rows);
-        usage();
+        return -1;
     }
     unsigned len = bits.bits_per_row[0];
     if (len > 1024) {
         fprintf(stderr, "Bad flex spec, \"match\", \"preamble\", and getter mask may have up to 1024 bits (%u found)!\n", len);
-        usage();
+        return -1;
     }
     memcpy(bitrow, bits.bb[0], (len + 7) / 8);
-    return len;
+    return (int)len;
 }
 
-// used for symbol decode, limited to 27 bits (32 - 5).
-static uint32_t parse_symbol(const char *code)
+// used for symbol decode, limited to 27 bits (32 - 5), returns -1 on error.
+static int parse_symbol(const char *code, uint32_t *symbol)
 {
     bitbuffer_t bits = {0};
-    bitbuffer_parse(&bits, code);
+    if (code)
+        bitbuffer_parse(&bits, code);
     if (bits.num_rows != 1) {
         fprintf(stderr, "Bad flex spec, \"symbol\" needs exactly one bit row (%d found)!\n", bits.num_rows);
-        usage();
+        return -1;
     }
     unsigned len = bits.bits_per_row[0];
     if (len > 27) {
         fprintf(stderr, "Bad flex spec, \"symbol\" may have up to 27 bits (%u found)!\n", len);
-        usage();
+        return -1;
     }
     uint8_t *b = bits.bb[0];
-    return ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | (b[3] << 0) | len;
+    *symbol = ((uint32_t)b[0] << 24) | (b[1] << 16) | (b[2] << 8) | (b[3] << 0) | len;
+    return 0;
 }
 
 static const char *parse_map(const char *arg, struct flex_get *getter)
@@ -510,6 +512,11 @@ static const char *parse_map(const char *arg, struct flex_get *getter)
         while (*c == ' ') c++;
         if (*c == ']') return c + 1;
 
+        if (i >= GETTER_MAP_SLOTS) {
+            fprintf(stderr, "Bad flex spec, maximum map slots exceeded (%d)!\n", GETTER_MAP_SLOTS);
+            return NULL;
+        }
+
         // first parse a number
         key = strtol(c, (char **)&c, 0); // hex, oct, or dec
 
@@ -537,12 +544,15 @@ static const char *parse_map(const char *arg, struct flex_get *getter)
     return c;
 }
 
-static void parse_getter(const char *arg, struct flex_get *getter)
+// returns -1 on error.
+static int parse_getter(const char *arg, struct flex_get *getter)
 {
     uint8_t bitrow[128];
     while (arg && *arg) {
         if (*arg == '[') {
             arg = parse_map(arg, getter);
+            if (!arg)
+                return -1;
             continue;
         }
         char *p = strchr(arg, ':');
@@ -551,15 +561,20 @@ static void parse_getter(const char *arg, struct flex_get *getter)
         if (*arg == '@')
             getter->bit_offset = strtol(++arg, NULL, 0);
         else if (*arg == '{' || (*arg >= '0' && *arg <= '9')) {
-            getter->bit_count = parse_bits(arg, bitrow);
+            int bit_count = parse_bits(arg, bitrow);
+            if (bit_count < 0)
+                return -1;
+            getter->bit_count = (unsigned)bit_count;
             getter->mask = extract_number(bitrow, 0, getter->bit_count);
         }
         else if (*arg == '%') {
+            free((void *)getter->format);
             getter->format = strdup(arg);
             if (!getter->format)
                 FATAL_STRDUP("parse_getter()");
         }
         else {
+            free((void *)getter->name);
             getter->name = strdup(arg);
             if (!getter->name)
                 FATAL_STRDUP("parse_getter()");
@@ -568,80 +583,114 @@ static void parse_getter(const char *arg, struct flex_get *getter)
     }
     if (!getter->name) {
         fprintf(stderr, "Bad flex spec, \"get\" missing name!\n");
-        usage();
+        return -1;
     }
     /*
     if (decoder->verbose)
         fprintf(stderr, "parse_getter() bit_offset: %d bit_count: %d mask: %lx name: %s\n",
                 getter->bit_offset, getter->bit_count, getter->mask, getter->name);
     */
+    return 0;
 }
 
 // NOTE: this is declared in rtl_433.c also.
-r_device *flex_create_device(char *spec);
+void flex_free_device(r_device *dev);
 
-r_device *flex_create_device(char *spec)
+void flex_free_device(r_device *dev)
 {
-    if (!spec || !*spec || *spec == '?' || !strncasecmp(spec, "help", strlen(spec))) {
-        help();
+    if (!dev)
+        return;
+    struct flex_params *params = dev->decode_ctx;
+    if (params) {
+        free(params->name);
+        for (int g = 0; g < GETTER_SLOTS; ++g) {
+            free((void *)params->getter[g].name);
+            free((void *)params->getter[g].format);
+            for (int m = 0; m < GETTER_MAP_SLOTS; ++m) {
+                free((void *)params->getter[g].map[m].val);
+            }
+        }
+        free(params);
+    }
+    decoder_scratch_free(dev);
+    free((void *)dev->name);
+    free(dev);
+}
+
+// NOTE: this is declared in rtl_433.c also.
+r_device *flex_parse_device(char const *spec);
+
+r_device *flex_parse_device(char const *spec)
+{
+    if (!spec || !*spec) {
+        fprintf(stderr, "Bad flex spec, empty spec!\n");
+        return NULL;
     }
 
     struct flex_params *params = calloc(1, sizeof(*params));
     if (!params) {
-        WARN_CALLOC("flex_create_device()");
+        WARN_CALLOC("flex_parse_device()");
         return NULL; // NOTE: returns NULL on alloc failure.
     }
     r_device *dev = calloc(1, sizeof(*dev));
     if (!dev) {
-        WARN_CALLOC("flex_create_device()");
+        WARN_CALLOC("flex_parse_device()");
         free(params);
         return NULL; // NOTE: returns NULL on alloc failure.
     }
     dev->decode_ctx = params;
     int get_count = 0;
 
-    spec = strdup(spec);
-    if (!spec)
-        FATAL_STRDUP("flex_create_device()");
+    char *spec_copy = strdup(spec);
+    if (!spec_copy)
+        FATAL_STRDUP("flex_parse_device()");
+    char *args = spec_copy;
 
     dev->decode_fn = flex_callback;
     dev->fields = output_fields;
 
     char *key, *val;
-    while (getkwargs(&spec, &key, &val)) {
+    while (getkwargs(&args, &key, &val)) {
         key = remove_ws(key);
         val = trim_ws(val);
 
         if (!key || !*key)
             continue;
         else if (!strcasecmp(key, "n") || !strcasecmp(key, "name")) {
+            if (!val)
+                val = "";
+            free(params->name);
             params->name = strdup(val);
             if (!params->name)
-                FATAL_STRDUP("flex_create_device()");
+                FATAL_STRDUP("flex_parse_device()");
             int name_size = strlen(val) + 27;
             char* flex_name = malloc(name_size);
             if (!flex_name)
-                FATAL_MALLOC("flex_create_device()");
+                FATAL_MALLOC("flex_parse_device()");
             snprintf(flex_name, name_size, "General purpose decoder '%s'", val);
+            free((void *)dev->name);
             dev->name = flex_name;
         }
 
-        else if (!strcasecmp(key, "m") || !strcasecmp(key, "modulation"))
+        else if (!strcasecmp(key, "m") || !strcasecmp(key, "modulation")) {
             dev->modulation = parse_modulation(val);
+            if (!dev->modulation)
+                goto bad_spec;
+        }
         else if (!strcasecmp(key, "s") || !strcasecmp(key, "short"))
-            dev->short_width = atoi(val);
+            dev->short_width = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "l") || !strcasecmp(key, "long"))
-            dev->long_width = atoi(val);
+            dev->long_width = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "y") || !strcasecmp(key, "sync"))
-            dev->sync_width = atoi(val);
+            dev->sync_width = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "g") || !strcasecmp(key, "gap"))
-            dev->gap_limit = atoi(val);
+            dev->gap_limit = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "r") || !strcasecmp(key, "reset"))
-            dev->reset_limit = atoi(val);
+            dev->reset_limit = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "t") || !strcasecmp(key, "tolerance"))
-            dev->tolerance = atoi(val);
+            dev->tolerance = val ? atoi(val) : 0;
         else if (!strcasecmp(key, "prio") || !strcasecmp(key, "priority"))
-            dev->priority = atoi(val);
+            dev->priority = val ? atoi(val) : 0;
 
         else if (!strcasecmp(key, "bits>"))
             params->min_bits = val ? atoi(val) : 0;
@@ -669,11 +718,19 @@ r_device *flex_create_device(char *spec)
         else if (!strcasecmp(key, "reflect"))
             params->reflect = val ? atoi(val) : 1;
 
-        else if (!strcasecmp(key, "match"))
-            params->match_len = parse_bits(val, params->match_bits);
+        else if (!strcasecmp(key, "match")) {
+            int len = parse_bits(val, params->match_bits);
+            if (len < 0)
+                goto bad_spec;
+            params->match_len = (unsigned)len;
+        }
 
-        else if (!strcasecmp(key, "preamble"))
-            params->preamble_len = parse_bits(val, params->preamble_bits);
+        else if (!strcasecmp(key, "preamble")) {
+            int len = parse_bits(val, params->preamble_bits);
+            if (len < 0)
+                goto bad_spec;
+            params->preamble_len = (unsigned)len;
+        }
 
         else if (!strcasecmp(key, "countonly"))
             params->count_only = val ? atoi(val) : 1;
@@ -686,24 +743,30 @@ r_device *flex_create_device(char *spec)
         else if (!strcasecmp(key, "decode_dm"))
             params->decode_dm = val ? atoi(val) : 1;
 
-        else if (!strcasecmp(key, "symbol_zero"))
-            params->symbol_zero = parse_symbol(val);
-        else if (!strcasecmp(key, "symbol_one"))
-            params->symbol_one = parse_symbol(val);
-        else if (!strcasecmp(key, "symbol_sync"))
-            params->symbol_sync = parse_symbol(val);
+        else if (!strcasecmp(key, "symbol_zero")) {
+            if (parse_symbol(val, &params->symbol_zero) < 0)
+                goto bad_spec;
+        }
+        else if (!strcasecmp(key, "symbol_one")) {
+            if (parse_symbol(val, &params->symbol_one) < 0)
+                goto bad_spec;
+        }
+        else if (!strcasecmp(key, "symbol_sync")) {
+            if (parse_symbol(val, &params->symbol_sync) < 0)
+                goto bad_spec;
+        }
 
         else if (!strcasecmp(key, "get")) {
-            if (get_count < GETTER_SLOTS)
-                parse_getter(val, &params->getter[get_count++]);
-            else {
+            if (get_count >= GETTER_SLOTS) {
                 fprintf(stderr, "Maximum getter slots exceeded (%d)!\n", GETTER_SLOTS);
-                usage();
+                goto bad_spec;
             }
+            if (parse_getter(val, &params->getter[get_count++]) < 0)
+                goto bad_spec;
 
         } else {
             fprintf(stderr, "Bad flex spec, unknown keyword (%s)!\n", key);
-            usage();
+            goto bad_spec;
         }
     }
 
@@ -731,30 +794,30 @@ r_device *flex_create_device(char *spec)
 
     if (!params->name || !*params->name) {
         fprintf(stderr, "Bad flex spec, missing name!\n");
-        usage();
+        goto bad_spec;
     }
 
     if (!dev->modulation) {
         fprintf(stderr, "Bad flex spec, missing modulation!\n");
-        usage();
+        goto bad_spec;
     }
 
     if (!dev->short_width) {
         fprintf(stderr, "Bad flex spec, missing short width!\n");
-        usage();
+        goto bad_spec;
     }
 
     if (dev->modulation != OOK_PULSE_MANCHESTER_ZEROBIT
             && dev->modulation != FSK_PULSE_MANCHESTER_ZEROBIT) {
         if (!dev->long_width) {
             fprintf(stderr, "Bad flex spec, missing long width!\n");
-            usage();
+            goto bad_spec;
         }
     }
 
     if (!dev->reset_limit) {
         fprintf(stderr, "Bad flex spec, missing reset limit!\n");
-        usage();
+        goto bad_spec;
     }
 
     if (dev->modulation == OOK_PULSE_DMC
@@ -762,17 +825,17 @@ r_device *flex_create_device(char *spec)
             || dev->modulation == OOK_PULSE_PIWM_DC) {
         if (!dev->tolerance) {
             fprintf(stderr, "Bad flex spec, missing tolerance limit!\n");
-            usage();
+            goto bad_spec;
         }
     }
 
     if (params->symbol_zero && !params->symbol_one) {
         fprintf(stderr, "Bad flex spec, symbol-one missing!\n");
-        usage();
+        goto bad_spec;
     }
     if (params->symbol_one && !params->symbol_zero) {
         fprintf(stderr, "Bad flex spec, symbol-zero missing!\n");
-        usage();
+        goto bad_spec;
     }
 
     /*
@@ -785,6 +848,26 @@ r_device *flex_create_device(char *spec)
     }
     */
 
-    free(spec);
+    free(spec_copy);
+    return dev;
+
+bad_spec:
+    free(spec_copy);
+    flex_free_device(dev);
+    return NULL;
+}
+
+// NOTE: this is declared in rtl_433.c also.
+r_device *flex_create_device(char *spec);
+
+r_device *flex_create_device(char *spec)
+{
+    if (!spec || !*spec || *spec == '?' || !strncasecmp(spec, "help", strlen(spec))) {
+        help();
+    }
+
+    r_device *dev = flex_parse_device(spec);
+    if (!dev)
+        usage();
     return dev;
 }
@@ -112,7 +112,7 @@ static int gridstream_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             0x7F,
             0xF8,
     };
-    uint8_t *b = malloc(bitbuffer->bits_per_row[0] / 8);
+    uint8_t *b;
     uint16_t stream_len;
     char found_crc[5] = "";
     char destwanaddress_str[13];
@@ -128,9 +128,13 @@ static int gridstream_decode(r_device *decoder, bitbuffer_t *bitbuffer)
     int subtype_mod = 0;
     int crcidx;
     int decoded_len;
-    offset = bitbuffer_search(bitbuffer, 0, 0, preambleV4, 36);
+    b = decoder_scratch(decoder, bitbuffer->bits_per_row[0] / 8);
+    if (!b) {
+        return DECODE_FAIL_OTHER;
+    }
+    offset = decoder_sync_search(decoder, bitbuffer, 0, 0, preambleV4, 36);
     if (offset >= bitbuffer->bits_per_row[0]) {
-        offset = bitbuffer_search(bitbuffer, 0, 0, preambleV5, 37);
+        offset = decoder_sync_search(decoder, bitbuffer, 0, 0, preambleV5, 37);
         if (offset >= bitbuffer->bits_per_row[0]) {
             return DECODE_FAIL_SANITY;
         }
@@ -283,35 +287,47 @@ static char const *const output_fields[] = {
         NULL,
 };
 
+static struct sync_word const gridstream_syncs[] = {
+        {{0xAA, 0xAA, 0x00, 0x5F, 0xF0}, 36}, // v4 preamble and sync word
+        {{0xAA, 0xAA, 0x00, 0x7F, 0xF8}, 37}, // v5 preamble and sync word
+        {{0}, 0},
+};
+
 r_device const gridstream96 = {
-        .name        = "Gridstream decoder 9.6k",
-        .modulation  = FSK_PULSE_PCM,
-        .short_width = 104,
-        .long_width  = 104,
-        .reset_limit = 20000,
-        .decode_fn   = &gridstream_decode,
-        .disabled    = 0,
-        .fields      = output_fields,
+        .name         = "Gridstream decoder 9.6k",
+        .modulation   = FSK_PULSE_PCM,
+        .short_width  = 104,
+        .long_width   = 104,
+        .reset_limit  = 20000,
+        .decode_fn    = &gridstream_decode,
+        .scratch_size = BITBUF_COLS,
+        .disabled     = 0,
+        .fields       = output_fields,
+        .syncs        = gridstream_syncs,
 };
 
 r_device const gridstream192 = {
-        .name        = "Gridstream decoder 19.2k",
-        .modulation  = FSK_PULSE_PCM,
-        .short_width = 52,
-        .long_width  = 52,
-        .reset_limit = 20000,
-        .decode_fn   = &gridstream_decode,
-        .disabled    = 0,
-        .fields      = output_fields,
+        .name         = "Gridstream decoder 19.2k",
+        .modulation   = FSK_PULSE_PCM,
+        .short_width  = 52,
+        .long_width   = 52,
+        .reset_limit  = 20000,
+        .decode_fn    = &gridstream_decode,
+        .scratch_size = BITBUF_COLS,
+        .disabled     = 0,
+        .fields       = output_fields,
+        .syncs        = gridstream_syncs,
 };
 
 r_device const gridstream384 = {
-        .name        = "Gridstream decoder 38.4k",
-        .modulation  = FSK_PULSE_PCM,
-        .short_width = 22,
-        .long_width  = 22,
-        .reset_limit = 20000,
-        .decode_fn   = &gridstream_decode,
-        .disabled    = 0,
-        .fields      = output_fields,
+        .name         = "Gridstream decoder 38.4k",
+        .modulation   = FSK_PULSE_PCM,
+        .short_width  = 22,
+        .long_width   = 22,
+        .reset_limit  = 20000,
+        .decode_fn    = &gridstream_decode,
+        .scratch_size = BITBUF_COLS,
+        .disabled     = 0,
+        .fields       = output_fields,
+        .syncs        = gridstream_syncs,
 };
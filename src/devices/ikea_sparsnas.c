@@ -26,7 +26,9 @@ in this file. The sender also has a unique ID which is used in the encryption
 key, hence it is needed here to decrypt the data. The sender ID is on a sticker
 in the battery compartment. There are three groups of three digits there. The
 last six digits are your sender ID. Eg "400 617 633" gives you the sender id
-617633. This number goes into IKEA_SPARSNAS_SENSOR_ID in this file.
+617633. This number can be given as decoder option, e.g. `-R 130:617633`.
+Without the option the sender ID is solved from the message, see
+ikea_sparsnas_solve_sensor_id(), and remembered for each sender.
 
 
 The data is sent using CPFSK modulation. It requires PD_MIN_PULSE_SAMPLES in
@@ -73,6 +75,8 @@ detail. Many thanks to kodarn!
 
 
 #include "decoder.h"
+#include "fatal.h"
+#include <stdlib.h>
 #define IKEA_SPARSNAS_MESSAGE_BITLEN 160    // 20 bytes incl 8 bit length, 8 bit address, 128 bits data, and 16 bits of CRC. Excluding preamble and sync word
 #define IKEA_SPARSNAS_MESSAGE_BYTELEN    ((IKEA_SPARSNAS_MESSAGE_BITLEN + 7) / 8)
 #define IKEA_SPARSNAS_MESSAGE_BITLEN_MAX 260 // Just for early sanity checks
@@ -84,52 +88,99 @@ detail. Many thanks to kodarn!
 
 #define IKEA_SPARSNAS_ID_KEY_SUB 0x5D38E8CB
 
-static uint16_t ikea_sparsnas_pulses_per_kwh = 1000;
-static uint32_t ikea_sparsnas_sensor_id = 0;
+#define IKEA_SPARSNAS_KEY_CACHE_SIZE 8 // number of senders remembered per decoder instance
 
-static uint32_t ikea_sparsnas_brute_force_encryption(uint8_t buffer[18])
-{
-    const uint8_t b5 = buffer[5 + 0];
-    const uint8_t b6 = buffer[5 + 1];
-    const uint8_t b7 = buffer[5 + 2];
-    const uint8_t b8 = buffer[5 + 3];
-    const uint8_t battery_enc = buffer[17];
+static uint16_t ikea_sparsnas_pulses_per_kwh = 1000;
 
-    uint8_t d0, d1, d2;
-    const uint8_t d3 = b8 ^ 0x47;
+/// Solved sender IDs, keyed by the encrypted sender ID bytes which are constant per sender.
+struct ikea_sparsnas_context {
+    uint32_t sensor_id; ///< configured sender ID, 0 to solve from the message
+    unsigned next;      ///< next cache slot to replace
+    struct {
+        uint32_t signature;
+        uint32_t sensor_id;
+    } cache[IKEA_SPARSNAS_KEY_CACHE_SIZE];
+};
 
-    uint32_t dec_sensor_id, key_sensor_id;
-    uint8_t battery_dec, k0, k1, k2, k4;
+/**
+Solve the sender ID from the encrypted message.
+
+The key is derived from k = sensor_id - IKEA_SPARSNAS_ID_KEY_SUB with
+key = {k >> 24, k, k >> 8, 0x47, k >> 16} (bytes), applied to bytes 5 to 17.
+The sender ID has at most 6 digits (< 0x100000), thus:
+- the top byte d0 is 0, so byte 5 must equal k >> 24,
+- d3 = b8 ^ 0x47 is known, and the low key byte is (d3 - 0xCB) & 0xff,
+- which gives d1 = b6 ^ key[1], at most 0x0F,
+- d2 is the remaining unknown, with b7 == d2 ^ ((k >> 8) & 0xff).
+Only the 256 values of d2 need checking, each candidate also has to yield
+a battery level of at most 100.
+*/
+static uint32_t ikea_sparsnas_solve_sensor_id(uint8_t const buffer[18])
+{
+    uint8_t const b5 = buffer[5 + 0];
+    uint8_t const b6 = buffer[5 + 1];
+    uint8_t const b7 = buffer[5 + 2];
+    uint8_t const b8 = buffer[5 + 3];
+    uint8_t const battery_enc = buffer[17];
+
+    uint8_t const d3 = b8 ^ 0x47;
+    uint8_t const k1 = (uint8_t)(d3 - (IKEA_SPARSNAS_ID_KEY_SUB & 0xff));
+    uint8_t const d1 = b6 ^ k1;
+    if (d1 > 0x0F) {
+        return 0; // would result in sensor_id > 999999
+    }
 
-    for (k0=0;k0<0xFF;++k0) {
-        d0 = b5 ^ k0;
-        if (d0 > 0x0F) { //will result in sensor_id > 999999
+    for (unsigned d2 = 0; d2 < 0x100; ++d2) {
+        uint32_t const sensor_id = (uint32_t)d1 << 16 | d2 << 8 | d3;
+        uint32_t const key_id    = sensor_id - IKEA_SPARSNAS_ID_KEY_SUB;
+        uint8_t const k2         = (uint8_t)(key_id >> 8);
+        if ((b7 ^ k2) != d2 || (uint8_t)(key_id >> 24) != b5) {
+            continue;
+        }
+        if (sensor_id > 999999 || (battery_enc ^ k2) > 100) {
             continue; // DECODE_FAIL_SANITY
         }
-        for (k1=0;k1<0xFF;++k1) {
-            d1 = b6 ^ k1;
+        return sensor_id;
+    }
+    return 0;
+}
 
-            for (k2=0;k2<0xFF;++k2) {
+/// Get the sender ID for the message, from the configuration, the cache, or solved.
+static uint32_t ikea_sparsnas_sensor_id(r_device *decoder, struct ikea_sparsnas_context *context, uint8_t const buffer[18])
+{
+    if (context->sensor_id) {
+        return context->sensor_id;
+    }
 
-                d2 = b7 ^ k2;
-                battery_dec = battery_enc ^ k2;
-                dec_sensor_id = (unsigned)d0 << 24 | d1 << 16 | d2 << 8 | d3;
+    uint32_t const signature = (unsigned)buffer[5] << 24 | buffer[6] << 16 | buffer[7] << 8 | buffer[8];
+    for (unsigned i = 0; i < IKEA_SPARSNAS_KEY_CACHE_SIZE; ++i) {
+        if (context->cache[i].sensor_id && context->cache[i].signature == signature) {
+            return context->cache[i].sensor_id;
+        }
+    }
 
-                if (dec_sensor_id > 999999) { //sensor id is at most 6 digits
-                    continue; // DECODE_FAIL_SANITY
-                }
+    uint32_t const sensor_id = ikea_sparsnas_solve_sensor_id(buffer);
+    if (!sensor_id) {
+        decoder_log(decoder, 2, __func__, "No valid sensor ID found.");
+        return 0;
+    }
+    decoder_logf(decoder, 2, __func__, "Found valid sensor ID %06u. If reported values does not make sense, this might be incorrect.", sensor_id);
 
-                for (k4=0;k4<0xFF;++k4) {
-                    key_sensor_id  = ((unsigned)k0 << 24 | k4 << 16 | k2 << 8 | k1) + IKEA_SPARSNAS_ID_KEY_SUB;
+    context->cache[context->next].signature = signature;
+    context->cache[context->next].sensor_id = sensor_id;
+    context->next = (context->next + 1) % IKEA_SPARSNAS_KEY_CACHE_SIZE;
+    return sensor_id;
+}
 
-                    if ((dec_sensor_id == key_sensor_id) && (battery_dec <= 100)) {
-                        return dec_sensor_id;
-                    }
-                }
-            }
-        }
+/// The context is small, allocated on first use unless a sender ID is configured.
+static struct ikea_sparsnas_context *ikea_sparsnas_context(r_device *decoder)
+{
+    if (!decoder->decode_ctx) {
+        decoder->decode_ctx = calloc(1, sizeof(struct ikea_sparsnas_context));
+        if (!decoder->decode_ctx)
+            WARN_CALLOC("ikea_sparsnas_context()");
     }
-   return 0;
+    return decoder->decode_ctx;
 }
 
 static int ikea_sparsnas_decode(r_device *decoder, bitbuffer_t *bitbuffer)
@@ -173,21 +224,16 @@ static int ikea_sparsnas_decode(r_device *decoder, bitbuffer_t *bitbuffer)
     }
 
     //Decryption
-    if (!ikea_sparsnas_sensor_id) {
-        decoder_log(decoder, 2, __func__, "No sensor ID configured. Brute forcing encryption.");
-        ikea_sparsnas_sensor_id = ikea_sparsnas_brute_force_encryption(buffer);
-        if (ikea_sparsnas_sensor_id) {
-            decoder_logf(decoder, 2, __func__, "Found valid sensor ID %06u. If reported values does not make sense, this might be incorrect.", ikea_sparsnas_sensor_id);
-        } else {
-            decoder_log(decoder, 2, __func__, "No valid sensor ID found.");
-        }
-
+    struct ikea_sparsnas_context *context = ikea_sparsnas_context(decoder);
+    if (!context) {
+        return DECODE_FAIL_OTHER;
     }
+    uint32_t const sensor_id = ikea_sparsnas_sensor_id(decoder, context, buffer);
 
     uint8_t decrypted[18];
 
     uint8_t key[5];
-    const uint32_t sensor_id_sub = ikea_sparsnas_sensor_id - IKEA_SPARSNAS_ID_KEY_SUB;
+    const uint32_t sensor_id_sub = sensor_id - IKEA_SPARSNAS_ID_KEY_SUB;
 
     key[0] = (uint8_t)(sensor_id_sub >> 24);
     key[1] = (uint8_t)(sensor_id_sub);
@@ -211,16 +257,16 @@ static int ikea_sparsnas_decode(r_device *decoder, bitbuffer_t *bitbuffer)
         decoder_logf(decoder, 2, __func__, "Received sensor id: %06u", rcv_sensor_id);
     }
 
-    if (rcv_sensor_id != ikea_sparsnas_sensor_id) {
-        decoder_logf(decoder, 2, __func__, "Malformed package, or wrong sensor id. Received sensor id (%06u) not the same as sender (%d)", rcv_sensor_id, ikea_sparsnas_sensor_id);
+    if (rcv_sensor_id != sensor_id) {
+        decoder_logf(decoder, 2, __func__, "Malformed package, or wrong sensor id. Received sensor id (%06u) not the same as sender (%d)", rcv_sensor_id, sensor_id);
     }
 
-    if ((!ikea_sparsnas_sensor_id) || (rcv_sensor_id != ikea_sparsnas_sensor_id)) {
+    if ((!sensor_id) || (rcv_sensor_id != sensor_id)) {
 
         /* clang-format off */
         data_t *data = data_make(
                 "model",         "Model",               DATA_STRING, "Ikea-Sparsnas",
-                "id",            "Sensor ID",           DATA_INT, ikea_sparsnas_sensor_id,
+                "id",            "Sensor ID",           DATA_INT, sensor_id,
                 "mic",           "Integrity",           DATA_STRING,    "CRC",
                 NULL);
         /* clang-format on */
@@ -260,7 +306,7 @@ static int ikea_sparsnas_decode(r_device *decoder, bitbuffer_t *bitbuffer)
             "model",         "Model",               DATA_STRING, "Ikea-Sparsnas",
             "id",            "Sensor ID",           DATA_INT,    rcv_sensor_id,
             "sequence",      "Sequence Number",     DATA_INT,    sequence_number,
-            "battery_ok",    "Battery level",       DATA_INT,    battery * 0.01f, // 0-100
+            "battery_ok",    "Battery level",       DATA_DOUBLE, battery * 0.01f, // 0-100
             "pulses_per_kWh", "Pulses per kWh",     DATA_INT,    ikea_sparsnas_pulses_per_kwh,
             "cumulative_kWh", "Cumulative kWh",     DATA_FORMAT, "%7.3fkWh", DATA_DOUBLE,  cumulative_kWh,
             "effect",        "Effect",              DATA_FORMAT, "%dW", DATA_INT,  effect,
@@ -288,6 +334,29 @@ static char const *const output_fields[] = {
         NULL,
 };
 
+r_device const ikea_sparsnas;
+
+static r_device *ikea_sparsnas_create(char *arg)
+{
+    r_device *r_dev = create_device(&ikea_sparsnas);
+    if (!r_dev) {
+        fprintf(stderr, "ikea_sparsnas_create() failed\n");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    // without a sender ID the context is allocated on first use
+    if (arg && *arg) {
+        struct ikea_sparsnas_context *context = ikea_sparsnas_context(r_dev);
+        if (!context) {
+            free(r_dev);
+            return NULL; // NOTE: returns NULL on alloc failure.
+        }
+        context->sensor_id = strtoul(arg, NULL, 10);
+    }
+
+    return r_dev;
+}
+
 r_device const ikea_sparsnas = {
         .name        = "IKEA Sparsnas Energy Meter Monitor",
         .modulation  = FSK_PULSE_PCM,
@@ -296,5 +365,6 @@ r_device const ikea_sparsnas = {
         .gap_limit   = 1000,
         .reset_limit = 3000,
         .decode_fn   = &ikea_sparsnas_decode,
+        .create_fn   = &ikea_sparsnas_create,
         .fields      = output_fields,
 };
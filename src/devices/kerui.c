@@ -55,6 +55,7 @@ static int kerui_callback(r_device *decoder, bitbuffer_t *bitbuffer)
     b[0] = ~b[0];
     b[1] = ~b[1];
     b[2] = ~b[2];
+    bitbuffer_invalidate(bitbuffer);
 
     id  = (b[0] << 12) | (b[1] << 4) | (b[2] >> 4);
     cmd = b[2] & 0x0F;
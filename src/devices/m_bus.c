@@ -28,55 +28,83 @@ static unsigned bcd2int(uint8_t bcd)
     return 10*(bcd>>4) + (bcd & 0xF);
 }
 
-// Mapping from 6 bits to 4 bits. "3of6" coding used for Mode T
-static uint8_t m_bus_decode_3of6(uint8_t byte)
-{
-    uint8_t out = 0xFF; // Error
-    //fprintf(stderr,"Decode %0d\n", byte);
-    switch(byte) {
-        case 22:    out = 0x0;  break;  // 0x16
-        case 13:    out = 0x1;  break;  // 0x0D
-        case 14:    out = 0x2;  break;  // 0x0E
-        case 11:    out = 0x3;  break;  // 0x0B
-        case 28:    out = 0x4;  break;  // 0x17
-        case 25:    out = 0x5;  break;  // 0x19
-        case 26:    out = 0x6;  break;  // 0x1A
-        case 19:    out = 0x7;  break;  // 0x13
-        case 44:    out = 0x8;  break;  // 0x2C
-        case 37:    out = 0x9;  break;  // 0x25
-        case 38:    out = 0xA;  break;  // 0x26
-        case 35:    out = 0xB;  break;  // 0x23
-        case 52:    out = 0xC;  break;  // 0x34
-        case 49:    out = 0xD;  break;  // 0x31
-        case 50:    out = 0xE;  break;  // 0x32
-        case 41:    out = 0xF;  break;  // 0x29
-        default:    break;  // Error
-    }
-    return out;
-}
-
+// Mapping from 6 bits to 4 bits, 0xFF for invalid codes. "3of6" coding used for Mode T
+static uint8_t const m_bus_3of6_lut[64] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x03, 0xff, 0x01, 0x02, 0xff, // 11: 0x3, 13: 0x1, 14: 0x2
+        0xff, 0xff, 0xff, 0x07, 0xff, 0xff, 0x00, 0xff, 0xff, 0x05, 0x06, 0xff, 0x04, 0xff, 0xff, 0xff, // 19: 0x7, 22: 0x0, 25: 0x5, 26: 0x6, 28: 0x4
+        0xff, 0xff, 0xff, 0x0b, 0xff, 0x09, 0x0a, 0xff, 0xff, 0x0f, 0xff, 0xff, 0x08, 0xff, 0xff, 0xff, // 35: 0xB, 37: 0x9, 38: 0xA, 41: 0xF, 44: 0x8
+        0xff, 0x0d, 0x0e, 0xff, 0x0c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // 49: 0xD, 50: 0xE, 52: 0xC
+};
 
 // Decode input 6 bit nibbles to output 4 bit nibbles (packed in bytes). "3of6" coding used for Mode T
+// Each output byte is a 12 bit group, read as one window and looked up as two 6 bit codes.
+// Stops at the first invalid code, returns the number of bytes decoded.
 // Bad data must be handled with second layer CRC
-static int m_bus_decode_3of6_buffer(uint8_t const *bits, unsigned bit_offset, uint8_t* output, unsigned num_bytes)
+static unsigned m_bus_decode_3of6_buffer(uint8_t const *bits, unsigned bit_offset, uint8_t *output, unsigned num_bytes)
 {
-    for (unsigned n=0; n<num_bytes; ++n) {
-        uint8_t nibble_h = m_bus_decode_3of6(bitrow_get_byte(bits, n*12+bit_offset) >> 2);
-        uint8_t nibble_l = m_bus_decode_3of6(bitrow_get_byte(bits, n*12+bit_offset+6) >> 2);
+    for (unsigned n = 0; n < num_bytes; ++n) {
+        unsigned pos   = bit_offset + n * 12;
+        unsigned shift = pos & 7;
+        uint8_t const *p = &bits[pos >> 3];
+        uint32_t window  = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8;
+        if (shift > 4) {
+            window |= p[2]; // the group spans three bytes
+        }
+        unsigned group   = (window >> (12 - shift)) & 0xFFF;
+        uint8_t nibble_h = m_bus_3of6_lut[group >> 6];
+        uint8_t nibble_l = m_bus_3of6_lut[group & 0x3F];
         if (nibble_h > 0xf || nibble_l > 0xf) {
-            return -1;
+            return n;
         }
         output[n] = (nibble_h << 4) | nibble_l;
     }
-    return 0;
+    return num_bytes;
 }
 
+// CRC-16 of EN 13757-4, poly 0x3D65, MSB first
+static uint16_t const m_bus_crc_table[256] = {
+        0x0000, 0x3d65, 0x7aca, 0x47af, 0xf594, 0xc8f1, 0x8f5e, 0xb23b,
+        0xd64d, 0xeb28, 0xac87, 0x91e2, 0x23d9, 0x1ebc, 0x5913, 0x6476,
+        0x91ff, 0xac9a, 0xeb35, 0xd650, 0x646b, 0x590e, 0x1ea1, 0x23c4,
+        0x47b2, 0x7ad7, 0x3d78, 0x001d, 0xb226, 0x8f43, 0xc8ec, 0xf589,
+        0x1e9b, 0x23fe, 0x6451, 0x5934, 0xeb0f, 0xd66a, 0x91c5, 0xaca0,
+        0xc8d6, 0xf5b3, 0xb21c, 0x8f79, 0x3d42, 0x0027, 0x4788, 0x7aed,
+        0x8f64, 0xb201, 0xf5ae, 0xc8cb, 0x7af0, 0x4795, 0x003a, 0x3d5f,
+        0x5929, 0x644c, 0x23e3, 0x1e86, 0xacbd, 0x91d8, 0xd677, 0xeb12,
+        0x3d36, 0x0053, 0x47fc, 0x7a99, 0xc8a2, 0xf5c7, 0xb268, 0x8f0d,
+        0xeb7b, 0xd61e, 0x91b1, 0xacd4, 0x1eef, 0x238a, 0x6425, 0x5940,
+        0xacc9, 0x91ac, 0xd603, 0xeb66, 0x595d, 0x6438, 0x2397, 0x1ef2,
+        0x7a84, 0x47e1, 0x004e, 0x3d2b, 0x8f10, 0xb275, 0xf5da, 0xc8bf,
+        0x23ad, 0x1ec8, 0x5967, 0x6402, 0xd639, 0xeb5c, 0xacf3, 0x9196,
+        0xf5e0, 0xc885, 0x8f2a, 0xb24f, 0x0074, 0x3d11, 0x7abe, 0x47db,
+        0xb252, 0x8f37, 0xc898, 0xf5fd, 0x47c6, 0x7aa3, 0x3d0c, 0x0069,
+        0x641f, 0x597a, 0x1ed5, 0x23b0, 0x918b, 0xacee, 0xeb41, 0xd624,
+        0x7a6c, 0x4709, 0x00a6, 0x3dc3, 0x8ff8, 0xb29d, 0xf532, 0xc857,
+        0xac21, 0x9144, 0xd6eb, 0xeb8e, 0x59b5, 0x64d0, 0x237f, 0x1e1a,
+        0xeb93, 0xd6f6, 0x9159, 0xac3c, 0x1e07, 0x2362, 0x64cd, 0x59a8,
+        0x3dde, 0x00bb, 0x4714, 0x7a71, 0xc84a, 0xf52f, 0xb280, 0x8fe5,
+        0x64f7, 0x5992, 0x1e3d, 0x2358, 0x9163, 0xac06, 0xeba9, 0xd6cc,
+        0xb2ba, 0x8fdf, 0xc870, 0xf515, 0x472e, 0x7a4b, 0x3de4, 0x0081,
+        0xf508, 0xc86d, 0x8fc2, 0xb2a7, 0x009c, 0x3df9, 0x7a56, 0x4733,
+        0x2345, 0x1e20, 0x598f, 0x64ea, 0xd6d1, 0xebb4, 0xac1b, 0x917e,
+        0x475a, 0x7a3f, 0x3d90, 0x00f5, 0xb2ce, 0x8fab, 0xc804, 0xf561,
+        0x9117, 0xac72, 0xebdd, 0xd6b8, 0x6483, 0x59e6, 0x1e49, 0x232c,
+        0xd6a5, 0xebc0, 0xac6f, 0x910a, 0x2331, 0x1e54, 0x59fb, 0x649e,
+        0x00e8, 0x3d8d, 0x7a22, 0x4747, 0xf57c, 0xc819, 0x8fb6, 0xb2d3,
+        0x59c1, 0x64a4, 0x230b, 0x1e6e, 0xac55, 0x9130, 0xd69f, 0xebfa,
+        0x8f8c, 0xb2e9, 0xf546, 0xc823, 0x7a18, 0x477d, 0x00d2, 0x3db7,
+        0xc83e, 0xf55b, 0xb2f4, 0x8f91, 0x3daa, 0x00cf, 0x4760, 0x7a05,
+        0x1e73, 0x2316, 0x64b9, 0x59dc, 0xebe7, 0xd682, 0x912d, 0xac48,
+};
 
 // Validate CRC
 static int m_bus_crc_valid(r_device *decoder, const uint8_t *bytes, unsigned crc_offset)
 {
-    static const uint16_t CRC_POLY = 0x3D65;
-    uint16_t crc_calc = ~crc16(bytes, crc_offset, CRC_POLY, 0);
+    uint16_t crc_calc = 0;
+    for (unsigned n = 0; n < crc_offset; ++n) {
+        crc_calc = (crc_calc << 8) ^ m_bus_crc_table[(crc_calc >> 8) ^ bytes[n]];
+    }
+    crc_calc = ~crc_calc;
     uint16_t crc_read = (((uint16_t)bytes[crc_offset] << 8) | bytes[crc_offset+1]);
     if (crc_calc != crc_read) {
         decoder_logf(decoder, 1, __func__, "M-Bus: CRC error: Calculated 0x%0X, Read: 0x%0X", (unsigned)crc_calc, (unsigned)crc_read);
@@ -944,117 +972,157 @@ static int m_bus_output_data(r_device *decoder, bitbuffer_t *bitbuffer, const m_
     return 1;
 }
 
+/// Modes told apart by the front end, each device allows a set of them.
+enum m_bus_mode {
+    M_BUS_MODE_NONE = 0,
+    M_BUS_MODE_C    = 1 << 0,
+    M_BUS_MODE_T    = 1 << 1,
+    M_BUS_MODE_S    = 1 << 2,
+    M_BUS_MODE_T_DN = 1 << 3,
+    M_BUS_MODE_R    = 1 << 4,
+    M_BUS_MODE_F    = 1 << 5,
+};
+
 /**
-Wireless M-Bus, Mode C&T.
-@sa m_bus_output_data()
+Find the first preamble and sync of any of the allowed modes in a single pass.
+
+Mode T and C share the sync 0x543D, Mode C continues with 0x54 and the format byte,
+Mode T continues with 3of6 coded data (which can't start with 0x54).
+Mode R (0x55547696) ends in the Mode S sync (0x547696) but runs at a different rate.
+
+@param bitbuffer the package, only the first row is searched
+@param modes the allowed modes
+@param[out] bit_offset the bit offset of the data after the preamble and sync
+@param[out] format the format byte for Mode C and F
+@return the mode found, M_BUS_MODE_NONE if there is no big enough package
 */
-static int m_bus_mode_c_t_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+static enum m_bus_mode m_bus_find_mode(bitbuffer_t *bitbuffer, unsigned modes, unsigned *bit_offset, uint8_t *format)
 {
-    static const uint8_t PREAMBLE_T[]  = {0x54, 0x3D};      // Mode T Preamble (always format A - 3of6 encoded)
-//  static const uint8_t PREAMBLE_CA[] = {0x55, 0x54, 0x3D, 0x54, 0xCD};  // Mode C, format A Preamble
-//  static const uint8_t PREAMBLE_CB[] = {0x55, 0x54, 0x3D, 0x54, 0x3D};  // Mode C, format B Preamble
+    uint8_t const *bits = bitbuffer->bb[0];
+    unsigned const len  = bitbuffer->bits_per_row[0];
 
-    m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
-    m_bus_data_t    data_out    = {0};  // Data from Data Link layer
-    m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
-    char const *mode = "";
+    uint32_t reg = 0;
+    for (unsigned pos = 0; pos < len; ++pos) {
+        reg = (reg << 1) | ((bits[pos >> 3] >> (7 - (pos & 7))) & 1);
+        unsigned next = pos + 1;
 
-    // Validate package length
-    if (bitbuffer->bits_per_row[0] < (32+13*8) || bitbuffer->bits_per_row[0] > (64+256*12)) {  // Min/Max (Preamble + payload)
-        return DECODE_ABORT_LENGTH;
-    }
+        enum m_bus_mode mode = M_BUS_MODE_NONE;
+        if ((modes & M_BUS_MODE_R) && reg == 0x55547696) {
+            mode = M_BUS_MODE_R;
+        }
+        else if ((modes & M_BUS_MODE_S) && (reg & 0xFFFFFF) == 0x547696) {
+            mode = M_BUS_MODE_S;
+        }
+        else if ((modes & M_BUS_MODE_T_DN) && (reg & 0xFFFFFF) == 0xAAAB32) {
+            mode = M_BUS_MODE_T_DN;
+        }
+        else if ((modes & M_BUS_MODE_F) && (reg & 0xFFFF) == 0x55F6) {
+            mode    = M_BUS_MODE_F;
+            *format = bitrow_get_byte(bits, next);
+            next += 8;
+        }
+        else if ((modes & (M_BUS_MODE_C | M_BUS_MODE_T)) && (reg & 0xFFFF) == 0x543D) {
+            if (next + 8 <= len && bitrow_get_byte(bits, next) == 0x54) {
+                mode    = M_BUS_MODE_C;
+                *format = bitrow_get_byte(bits, next + 8);
+                next += 16;
+            }
+            else {
+                mode = M_BUS_MODE_T;
+            }
+            if (!(modes & mode)) {
+                continue;
+            }
+        }
+        else {
+            continue;
+        }
 
-    // Find a Mode T or C data package
-    unsigned bit_offset = bitbuffer_search(bitbuffer, 0, 0, PREAMBLE_T, sizeof(PREAMBLE_T)*8);
-    if (bit_offset + 13*8 >= bitbuffer->bits_per_row[0]) {  // Did not find a big enough package
-        return DECODE_ABORT_EARLY;
+        if (mode != M_BUS_MODE_T_DN && next + 13 * 8 >= len) {
+            return M_BUS_MODE_NONE; // Did not find a big enough package
+        }
+        *bit_offset = next;
+        return mode;
     }
+    return M_BUS_MODE_NONE;
+}
 
-    decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "PREAMBLE_T: found at: %u", bit_offset);
-    bit_offset += sizeof(PREAMBLE_T)*8;     // skip preamble
-
-    uint8_t next_byte = bitrow_get_byte(bitbuffer->bb[0], bit_offset);
-    bit_offset += 8;
-    // Mode C
-    if (next_byte == 0x54) {
-        mode = "C";
-        next_byte = bitrow_get_byte(bitbuffer->bb[0], bit_offset);
-        bit_offset += 8;
-        // Format A
-        if (next_byte == 0xCD) {
-            decoder_log(decoder, 1, __func__, "M-Bus: Mode C, Format A");
-            // Extract data
-            data_in.length = (bitbuffer->bits_per_row[0]-bit_offset)/8;
-            bitbuffer_extract_bytes(bitbuffer, 0, bit_offset, data_in.data, data_in.length*8);
-            // Decode
-            if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1))
-                return DECODE_FAIL_SANITY;
-        } // Format A
-        // Format B
-        else if (next_byte == 0x3D) {
-            decoder_log(decoder, 1, __func__, "M-Bus: Mode C, Format B");
-            // Extract data
-            data_in.length = (bitbuffer->bits_per_row[0]-bit_offset)/8;
-            bitbuffer_extract_bytes(bitbuffer, 0, bit_offset, data_in.data, data_in.length*8);
-            // Decode
-            if (!m_bus_decode_format_b(decoder, &data_in, &data_out, &block1))
-                return DECODE_FAIL_SANITY;
-        } // Format B
-        // Unknown Format
-        else {
-            decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "M-Bus: Mode C, Unknown format: 0x%X", next_byte);
-            return 0;
-        }
-    }   // Mode C
-    // Mode T
-    else {
-        mode = "T";
-        bit_offset -= 8; // Rewind offset to start of telegram
-        decoder_log(decoder, 1, __func__, "M-Bus: Mode T");
-        decoder_log(decoder, 1, __func__, "Experimental - Not tested");
-        // Extract data
+/**
+Wireless M-Bus, Mode C.
+@sa m_bus_output_data()
+*/
+static int m_bus_decode_mode_c(r_device *decoder, bitbuffer_t *bitbuffer, unsigned bit_offset, uint8_t format)
+{
+    m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
+    m_bus_data_t    data_out    = {0};  // Data from Data Link layer
+    m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
 
-        data_in.length = (bitbuffer->bits_per_row[0]-bit_offset)/12;    // Each byte is encoded into 12 bits
+    // Extract data
+    data_in.length = (bitbuffer->bits_per_row[0]-bit_offset)/8;
+    bitbuffer_extract_bytes(bitbuffer, 0, bit_offset, data_in.data, data_in.length*8);
 
-        decoder_logf(decoder, 1, __func__, "MBus telegram length: %u", data_in.length);
-        if (m_bus_decode_3of6_buffer(bitbuffer->bb[0], bit_offset, data_in.data, data_in.length) < 0) {
-            decoder_log(decoder, 1, __func__, "M-Bus: Decoding error");
+    // Format A
+    if (format == 0xCD) {
+        decoder_log(decoder, 1, __func__, "M-Bus: Mode C, Format A");
+        if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1))
             return DECODE_FAIL_SANITY;
-        }
-        // Decode
-        if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1)) {
-            decoder_log_bitrow(decoder, 1, __func__, data_in.data, data_in.length, "MBus telegram unknown format");
+    } // Format A
+    // Format B
+    else if (format == 0x3D) {
+        decoder_log(decoder, 1, __func__, "M-Bus: Mode C, Format B");
+        if (!m_bus_decode_format_b(decoder, &data_in, &data_out, &block1))
             return DECODE_FAIL_SANITY;
-        }
-    }   // Mode T
+    } // Format B
+    // Unknown Format
+    else {
+        decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "M-Bus: Mode C, Unknown format: 0x%X", format);
+        return 0;
+    }
 
-    m_bus_output_data(decoder, bitbuffer, &data_out, &block1, mode);
+    m_bus_output_data(decoder, bitbuffer, &data_out, &block1, "C");
     return 1;
 }
 
 /**
-Wireless M-Bus, Mode R.
+Wireless M-Bus, Mode T.
 @sa m_bus_output_data()
 */
-static int m_bus_mode_r_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+static int m_bus_decode_mode_t(r_device *decoder, bitbuffer_t *bitbuffer, unsigned bit_offset)
 {
-    static const uint8_t PREAMBLE_RA[]  = {0x55, 0x54, 0x76, 0x96};      // Mode R, format A (B not supported)
-
     m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
     m_bus_data_t    data_out    = {0};  // Data from Data Link layer
     m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
 
-    // Validate package length
-    if (bitbuffer->bits_per_row[0] < (32+13*8) || bitbuffer->bits_per_row[0] > (64+256*8)) {  // Min/Max (Preamble + payload)
-        return 0;
+    decoder_log(decoder, 1, __func__, "M-Bus: Mode T");
+    decoder_log(decoder, 1, __func__, "Experimental - Not tested");
+    // Extract data, each byte is encoded into 12 bits, trailing noise ends the telegram
+    unsigned num_bytes = (bitbuffer->bits_per_row[0]-bit_offset)/12;
+    data_in.length = m_bus_decode_3of6_buffer(bitbuffer->bb[0], bit_offset, data_in.data, num_bytes);
+
+    decoder_logf(decoder, 1, __func__, "MBus telegram length: %u", data_in.length);
+    if (data_in.length < BLOCK1A_SIZE) {
+        decoder_log(decoder, 1, __func__, "M-Bus: Decoding error");
+        return DECODE_FAIL_SANITY;
     }
-
-    // Find a data package
-    unsigned bit_offset = bitbuffer_search(bitbuffer, 0, 0, PREAMBLE_RA, sizeof(PREAMBLE_RA)*8);
-    if (bit_offset + 13*8 >= bitbuffer->bits_per_row[0]) {  // Did not find a big enough package
-        return 0;
+    // Decode
+    if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1)) {
+        decoder_log_bitrow(decoder, 1, __func__, data_in.data, data_in.length, "MBus telegram unknown format");
+        return DECODE_FAIL_SANITY;
     }
-    bit_offset += sizeof(PREAMBLE_RA)*8;     // skip preamble
+
+    m_bus_output_data(decoder, bitbuffer, &data_out, &block1, "T");
+    return 1;
+}
+
+/**
+Wireless M-Bus, Mode R.
+@sa m_bus_output_data()
+*/
+static int m_bus_decode_mode_r(r_device *decoder, bitbuffer_t *bitbuffer, unsigned bit_offset)
+{
+    m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
+    m_bus_data_t    data_out    = {0};  // Data from Data Link layer
+    m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
 
     decoder_log(decoder, 1, __func__, "M-Bus: Mode R, Format A");
     decoder_log(decoder, 1, __func__, "Experimental - Not tested");
@@ -1074,94 +1142,105 @@ Wireless M-Bus, Mode F.
 
 Untested code, signal samples missing.
 */
-static int m_bus_mode_f_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+static int m_bus_decode_mode_f(r_device *decoder, bitbuffer_t *bitbuffer, uint8_t format)
 {
-    static const uint8_t PREAMBLE_F[]  = {0x55, 0xF6};      // Mode F Preamble
-//  static const uint8_t PREAMBLE_FA[] = {0x55, 0xF6, 0x8D};  // Mode F, format A Preamble
-//  static const uint8_t PREAMBLE_FB[] = {0x55, 0xF6, 0x72};  // Mode F, format B Preamble
-
-    //m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
-    //m_bus_data_t    data_out    = {0};  // Data from Data Link layer
-    //m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
-
-    // Validate package length
-    if (bitbuffer->bits_per_row[0] < (32+13*8) || bitbuffer->bits_per_row[0] > (64+256*8)) {  // Min/Max (Preamble + payload)
-        return 0;
-    }
-
-    // Find a Mode F data package
-    unsigned bit_offset = bitbuffer_search(bitbuffer, 0, 0, PREAMBLE_F, sizeof(PREAMBLE_F)*8);
-    if (bit_offset + 13*8 >= bitbuffer->bits_per_row[0]) {  // Did not find a big enough package
-        return 0;
-    }
-    bit_offset += sizeof(PREAMBLE_F)*8;     // skip preamble
-
-    uint8_t next_byte = bitrow_get_byte(bitbuffer->bb[0], bit_offset);
-    bit_offset += 8;
     // Format A
-    if (next_byte == 0x8D) {
+    if (format == 0x8D) {
         decoder_log(decoder, 1, __func__, "M-Bus: Mode F, Format A");
         decoder_log(decoder, 1, __func__, "Not implemented");
         return 1;
     } // Format A
     // Format B
-    else if (next_byte == 0x72) {
+    else if (format == 0x72) {
         decoder_log(decoder, 1, __func__, "M-Bus: Mode F, Format B");
         decoder_log(decoder, 1, __func__, "Not implemented");
         return 1;
     }   // Format B
     // Unknown Format
     else {
-        decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "M-Bus: Mode F, Unknown format: 0x%X", next_byte);
+        decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "M-Bus: Mode F, Unknown format: 0x%X", format);
         return 0;
     }
-
-    //m_bus_output_data(decoder, bitbuffer, &data_out, &block1, "F");
-    return 1;
 }
 
 /**
 Wireless M-Bus, Mode S.
 @sa m_bus_output_data()
 */
-static int m_bus_mode_s_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+static int m_bus_decode_mode_s(r_device *decoder, bitbuffer_t *bitbuffer, unsigned bit_offset)
 {
-    static const uint8_t PREAMBLE_S[]  = {0x54, 0x76, 0x96};  // Mode S Preamble
-    static const uint8_t PREAMBLE_T_DN[] = {0xaa, 0xab, 0x32};  // Mode T Downlink Preamble
     bitbuffer_t packet_bits = {0};
     m_bus_data_t    data_in     = {0};  // Data from Physical layer decoded to bytes
     m_bus_data_t    data_out    = {0};  // Data from Data Link layer
     m_bus_block1_t  block1      = {0};  // Block1 fields from Data Link layer
 
+    bitbuffer_manchester_decode(bitbuffer, 0, bit_offset, &packet_bits, 800);
+    data_in.length = packet_bits.bits_per_row[0] / 8;
+    bitbuffer_extract_bytes(&packet_bits, 0, 0, data_in.data, data_in.length * 8);
+
+    if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1))    return 0;
+
+    m_bus_output_data(decoder, bitbuffer, &data_out, &block1, "S");
+    return 1;
+}
+
+/**
+Shared front end, identifies the mode from the preamble and sync once, then decodes.
+*/
+static int m_bus_decode(r_device *decoder, bitbuffer_t *bitbuffer, unsigned modes)
+{
     // Validate package length
-    if (bitbuffer->bits_per_row[0] < (32+13*8) || bitbuffer->bits_per_row[0] > (64+256*8)) {
+    if (bitbuffer->bits_per_row[0] < (32+13*8) || bitbuffer->bits_per_row[0] > (64+256*12)) {  // Min/Max (Preamble + payload)
         return DECODE_ABORT_LENGTH;
     }
 
-    // Find a Mode T-downlink data package
-    unsigned offset = bitbuffer_search(bitbuffer, 0, 0, PREAMBLE_T_DN, sizeof(PREAMBLE_T_DN) * 8);
-    offset += sizeof(PREAMBLE_T_DN) * 8;
-    if (offset < bitbuffer->bits_per_row[0]) { // Did find a big enough package
+    unsigned bit_offset = 0;
+    uint8_t format      = 0;
+    enum m_bus_mode mode = m_bus_find_mode(bitbuffer, modes, &bit_offset, &format);
+    decoder_logf_bitbuffer(decoder, 2, __func__, bitbuffer, "M-Bus: mode 0x%x data at: %u", (unsigned)mode, bit_offset);
+
+    switch (mode) {
+    case M_BUS_MODE_C:
+        return m_bus_decode_mode_c(decoder, bitbuffer, bit_offset, format);
+    case M_BUS_MODE_T:
+        return m_bus_decode_mode_t(decoder, bitbuffer, bit_offset);
+    case M_BUS_MODE_S:
+        return m_bus_decode_mode_s(decoder, bitbuffer, bit_offset);
+    case M_BUS_MODE_T_DN:
         bitbuffer_invert(bitbuffer);
         decoder_logf_bitbuffer(decoder, 1, __func__, bitbuffer, "M-Bus: Mode T Downlink");
         return DECODE_ABORT_EARLY;
-    }
-
-    // Find a Mode S data package
-    unsigned bit_offset = bitbuffer_search(bitbuffer, 0, 0, PREAMBLE_S, sizeof(PREAMBLE_S)*8);
-    bit_offset += sizeof(PREAMBLE_S) * 8;
-    if (bit_offset >= bitbuffer->bits_per_row[0]) { // Did not find a big enough package
+    case M_BUS_MODE_R:
+        return m_bus_decode_mode_r(decoder, bitbuffer, bit_offset);
+    case M_BUS_MODE_F:
+        return m_bus_decode_mode_f(decoder, bitbuffer, format);
+    default:
         return DECODE_ABORT_EARLY;
     }
-    bitbuffer_manchester_decode(bitbuffer, 0, bit_offset, &packet_bits, 800);
-    data_in.length = (bitbuffer->bits_per_row[0]);
-    bitbuffer_extract_bytes(&packet_bits, 0, 0, data_in.data, data_in.length);
+}
 
-    if (!m_bus_decode_format_a(decoder, &data_in, &data_out, &block1))    return 0;
+/// Mode C and T at 100 kbps.
+static int m_bus_mode_c_t_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    return m_bus_decode(decoder, bitbuffer, M_BUS_MODE_C | M_BUS_MODE_T);
+}
 
-    m_bus_output_data(decoder, bitbuffer, &data_out, &block1, "S");
+/// Mode S, T downlink, and Mode C and T at 32.768 kbps.
+static int m_bus_mode_s_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    return m_bus_decode(decoder, bitbuffer, M_BUS_MODE_S | M_BUS_MODE_T_DN | M_BUS_MODE_C | M_BUS_MODE_T);
+}
 
-    return 1;
+/// Mode R at 4.8 kbps.
+static int m_bus_mode_r_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    return m_bus_decode(decoder, bitbuffer, M_BUS_MODE_R);
+}
+
+/// Mode F at 2.4 kbps.
+static int m_bus_mode_f_callback(r_device *decoder, bitbuffer_t *bitbuffer)
+{
+    return m_bus_decode(decoder, bitbuffer, M_BUS_MODE_F);
 }
 
 // NOTE: we'd need to add "value_types_tab X unit_names X n" fields
@@ -1222,6 +1301,7 @@ r_device const m_bus_mode_c_t = {
 };
 
 // Mode T communication in downlink direction at 32.768 kbps
+// Disabled per default, Mode S at the same rate also decodes Mode C and T
 r_device const m_bus_mode_c_t_downlink = {
         .name        = "Wireless M-Bus, Mode T, 32.768kbps (-f 868.3M -s 1000k)", // Minimum samplerate = 1 MHz (15 samples of 32kb/s manchester coded)
         .modulation  = FSK_PULSE_PCM,
@@ -1230,12 +1310,14 @@ r_device const m_bus_mode_c_t_downlink = {
         .reset_limit = ((1000.0 / 32.768) * 9), // 9 bit periods
         .decode_fn   = &m_bus_mode_c_t_callback,
         .fields      = output_fields,
+        .disabled    = 1, // see Mode S
 };
 
 // Mode S1, S1-m, S2, T2 (Meter RX),    (Meter RX not so interesting)
+// Also Mode C and T and the Mode T downlink at the same rate
 // Frequency 868.3 MHz, Bitrate 32.768 kbps, Modulation Manchester FSK
 r_device const m_bus_mode_s = {
-        .name        = "Wireless M-Bus, Mode S, 32.768kbps (-f 868.3M -s 1000k)", // Minimum samplerate = 1 MHz (15 samples of 32kb/s manchester coded)
+        .name        = "Wireless M-Bus, Mode S and T, 32.768kbps (-f 868.3M -s 1000k)", // Minimum samplerate = 1 MHz (15 samples of 32kb/s manchester coded)
         .modulation  = FSK_PULSE_PCM,
         .short_width = (1000.0 / 32.768), // ~31 us per bit
         .long_width  = (1000.0 / 32.768),
@@ -215,6 +215,53 @@ static int validate_os_v2_message(r_device *decoder, unsigned char *msg, int bit
     return 1;
 }
 
+#define OS_V2_MAX_BITS 173
+
+/// Manchester pairs of a byte to a reflected nibble, bits 4-6 are the number of valid leading pairs.
+static uint8_t const os_manchester_nibble[256] = {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x23, 0x23, 0x23, 0x23, 0x37, 0x4f, 0x47, 0x37, 0x33, 0x4b, 0x43, 0x33, 0x23, 0x23, 0x23, 0x23,
+        0x21, 0x21, 0x21, 0x21, 0x35, 0x4d, 0x45, 0x35, 0x31, 0x49, 0x41, 0x31, 0x21, 0x21, 0x21, 0x21,
+        0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x22, 0x22, 0x22, 0x22, 0x36, 0x4e, 0x46, 0x36, 0x32, 0x4a, 0x42, 0x32, 0x22, 0x22, 0x22, 0x22,
+        0x20, 0x20, 0x20, 0x20, 0x34, 0x4c, 0x44, 0x34, 0x30, 0x48, 0x40, 0x30, 0x20, 0x20, 0x20, 0x20,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/// Manchester decode v2.1 data bits to reflected nibbles, returns the number of bits decoded.
+static int os_v2_manchester_decode(bitbuffer_t *bitbuffer, unsigned start, uint8_t *msg)
+{
+    unsigned len = bitbuffer->bits_per_row[0];
+    if (start >= len)
+        return 0;
+    unsigned pairs = (len - start + 1) / 2;
+    if (pairs > OS_V2_MAX_BITS)
+        pairs = OS_V2_MAX_BITS;
+
+    uint8_t raw[(OS_V2_MAX_BITS * 2 + 7) / 8];
+    bitbuffer_extract_bytes(bitbuffer, 0, start, raw, pairs * 2);
+
+    // a byte of pairs is a nibble, the decode stops at the first invalid pair
+    int msg_bits = 0;
+    for (unsigned i = 0; i < (pairs * 2 + 7) / 8; ++i) {
+        unsigned nibble = os_manchester_nibble[raw[i]];
+        msg[i >> 1] |= i & 1 ? nibble & 0x0f : (nibble & 0x0f) << 4;
+        msg_bits += nibble >> 4;
+        if (nibble >> 4 < 4)
+            break;
+    }
+    return msg_bits;
+}
+
 /**
 Various Oregon Scientific protocols.
 
@@ -225,17 +272,8 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
     uint8_t *b = bitbuffer->bb[0];
     data_t *data;
 
-    // Check 2nd and 3rd bytes of stream for possible Oregon Scientific v2.1 sensor data (skip first byte to get past sync/startup bit errors)
-    if (((b[1] != 0x55) || (b[2] != 0x55))
-            && ((b[1] != 0xAA) || (b[2] != 0xAA))) {
-        if (b[3] != 0) {
-            decoder_log_bitrow(decoder, 1, __func__, b, bitbuffer->bits_per_row[0], "Badly formatted OS v2.1 message");
-        }
-        return DECODE_ABORT_EARLY;
-    }
-
-    bitbuffer_t databits = {0};
-    uint8_t *msg = databits.bb[0];
+    uint8_t msg[(OS_V2_MAX_BITS + 7) / 8] = {0};
+    int msg_bits = 0;
 
     // Possible    v2.1 Protocol message
     unsigned int sync_test_val = ((unsigned)b[3] << 24) | (b[4] << 16) | (b[5] << 8) | (b[6]);
@@ -256,17 +294,22 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_logf(decoder, 1, __func__, "OS v2.1 Sync test val %08x found, starting decode at bit %d", sync_test_val, pattern_index);
 
         //decoder_log_bitrow(decoder, 0, __func__, b, bitbuffer->bits_per_row[0], "Raw OSv2 bits");
-        bitbuffer_manchester_decode(bitbuffer, 0, pattern_index + 40, &databits, 173);
-        reflect_nibbles(databits.bb[0], (databits.bits_per_row[0]+7)/8);
-        //decoder_logf_bitbuffer(decoder, 0, __func__, &databits, "MC OSv2 bits (from %d+40)", pattern_index);
+        msg_bits = os_v2_manchester_decode(bitbuffer, pattern_index + 40, msg);
+        //decoder_log_bitrow(decoder, 0, __func__, msg, msg_bits, "MC OSv2 bits");
 
         break;
     }
-    int msg_bits = databits.bits_per_row[0];
 
     int sensor_id = (msg[0] << 8) | msg[1];
     decoder_logf(decoder, 1, __func__,"Found sensor_id (%08x)",sensor_id);
-    if ((sensor_id == ID_THGR122N) || (sensor_id == ID_THGR968)) {
+    // RTGN318, RTGN129, RTGR328N, and RTHN129 only set the lower 12 bits of the type code
+    int type = sensor_id;
+    if ((sensor_id & 0x0fff) == ID_RTGN318 || (sensor_id & 0x0fff) == ID_RTHN129)
+        type = sensor_id & 0x0fff;
+
+    switch (type) {
+    case ID_THGR122N:
+    case ID_THGR968: {
         if (validate_os_v2_message(decoder, msg, 76, msg_bits, 15) != 0)
             return 0;
         /* clang-format off */
@@ -282,7 +325,7 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_WGR968) {
+    case ID_WGR968: {
         if (validate_os_v2_message(decoder, msg, 94, msg_bits, 17) != 0)
             return 0;
         float quadrant      = (msg[4] & 0x0f) * 10 + ((msg[4] >> 4) & 0x0f) * 1 + ((msg[5] >> 4) & 0x0f) * 100;
@@ -302,7 +345,7 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_BHTR968) {
+    case ID_BHTR968: {
         if (validate_os_v2_message(decoder, msg, 92, msg_bits, 19) != 0)
             return 0;
         //unsigned int comfort = msg[7] >> 4;
@@ -333,7 +376,7 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_BTHR918) {
+    case ID_BTHR918: {
         // Similar to the BHTR968, but smaller message and slightly different pressure offset
         if (validate_os_v2_message(decoder, msg, 84, msg_bits, 19) != 0)
             return 0;
@@ -353,7 +396,7 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_RGR968) {
+    case ID_RGR968: {
         if (validate_os_v2_message(decoder, msg, 80, msg_bits, 16) != 0)
             return 0;
         float rain_rate  = ((msg[4] & 0x0f) * 100 + (msg[4] >> 4) * 10 + ((msg[5] >> 4) & 0x0f)) / 10.0F;
@@ -371,84 +414,109 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if ((sensor_id == ID_THR228N || sensor_id == ID_AWR129) && msg_bits == 76) {
-        if (validate_os_v2_message(decoder, msg, 76, msg_bits, 12) != 0)
-            return 0;
-        float temp_c = get_os_temperature(msg);
-        /* clang-format off */
-        data = data_make(
-                "model", "", DATA_COND, sensor_id == ID_THR228N, DATA_STRING, "Oregon-THR228N",
-                "model", "", DATA_COND, sensor_id == ID_AWR129, DATA_STRING, "Oregon-AWR129",
-                "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
-                "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id),
-                "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
-                NULL);
-        /* clang-format on */
-        decoder_output_data(decoder, data);
-        return 1;
-    }
-    else if (sensor_id == ID_THN132N && msg_bits == 64) {
-        if (validate_os_v2_message(decoder, msg, 64, msg_bits, 12) != 0)
-            return 0;
-        // Sanity check BCD digits
-        if (((msg[5] >> 4) & 0x0F) > 9 || (msg[4] & 0x0F) > 9 || ((msg[4] >> 4) & 0x0F) > 9) {
-            decoder_log(decoder, 1, __func__, "THN132N Message failed BCD sanity check.");
-            return DECODE_FAIL_SANITY;
-        }
-        float temp_c = get_os_temperature(msg);
-        // Sanity check value
-        if (temp_c > 70 || temp_c < -50) {
-            decoder_logf(decoder, 1, __func__, "THN132N Message failed values sanity check: temperature_C %3.1fC.", temp_c);
-            return DECODE_FAIL_SANITY;
+    case ID_THR228N: // also ID_THN132N, told apart by the message length
+    case ID_AWR129:
+        if (msg_bits == 76) {
+            if (validate_os_v2_message(decoder, msg, 76, msg_bits, 12) != 0)
+                return 0;
+            float temp_c = get_os_temperature(msg);
+            /* clang-format off */
+            data = data_make(
+                    "model", "", DATA_COND, sensor_id == ID_THR228N, DATA_STRING, "Oregon-THR228N",
+                    "model", "", DATA_COND, sensor_id == ID_AWR129, DATA_STRING, "Oregon-AWR129",
+                    "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
+                    "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id),
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
         }
+        if (sensor_id == ID_THN132N && msg_bits == 64) {
+            if (validate_os_v2_message(decoder, msg, 64, msg_bits, 12) != 0)
+                return 0;
+            // Sanity check BCD digits
+            if (((msg[5] >> 4) & 0x0F) > 9 || (msg[4] & 0x0F) > 9 || ((msg[4] >> 4) & 0x0F) > 9) {
+                decoder_log(decoder, 1, __func__, "THN132N Message failed BCD sanity check.");
+                return DECODE_FAIL_SANITY;
+            }
+            float temp_c = get_os_temperature(msg);
+            // Sanity check value
+            if (temp_c > 70 || temp_c < -50) {
+                decoder_logf(decoder, 1, __func__, "THN132N Message failed values sanity check: temperature_C %3.1fC.", temp_c);
+                return DECODE_FAIL_SANITY;
+            }
 
-        /* clang-format off */
-        data = data_make(
-                "model",                 "",                        DATA_STRING, "Oregon-THN132N",
-                "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
-                "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id),
-                "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
-                NULL);
-        /* clang-format on */
-        decoder_output_data(decoder, data);
-        return 1;
-    }
-    else if ((sensor_id & 0x0fff) == ID_RTGN129 && msg_bits == 80) {
-        if (validate_os_v2_message(decoder, msg, 80, msg_bits, 15) != 0)
+            /* clang-format off */
+            data = data_make(
+                    "model",                 "",                        DATA_STRING, "Oregon-THN132N",
+                    "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
+                    "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id),
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
+        }
+        break;
+    case ID_RTGN318: // also ID_RTGN129 and ID_RTGR328N_1 to _5, told apart by the message length
+        if (msg_bits == 80) {
+            if (validate_os_v2_message(decoder, msg, 80, msg_bits, 15) != 0)
+                return 0;
+            float temp_c = get_os_temperature(msg);
+            /* clang-format off */
+            data = data_make(
+                    "model",                 "",                        DATA_STRING, "Oregon-RTGN129",
+                    "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
+                    "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id), // 1 to 5
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
+                    "humidity",            "Humidity",        DATA_FORMAT, "%u %%",     DATA_INT,        get_os_humidity(msg),
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
+        }
+        if (((sensor_id == ID_RTGR328N_1) || (sensor_id == ID_RTGR328N_2) || (sensor_id == ID_RTGR328N_3) || (sensor_id == ID_RTGR328N_4) || (sensor_id == ID_RTGR328N_5)) && msg_bits == 173) {
+            if (validate_os_v2_message(decoder, msg, 173, msg_bits, 15) != 0)
+                 return 0;
+            /* clang-format off */
+            data = data_make(
+                    "model",            "",             DATA_STRING, "Oregon-RTGR328N",
+                    "id",               "House Code",   DATA_INT,    get_os_rollingcode(msg),
+                    "channel",          "Channel",      DATA_INT,    get_os_channel(msg, sensor_id), // 1 to 5
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    "temperature_C",    "Temperature",  DATA_FORMAT, "%.02f C", DATA_DOUBLE, get_os_temperature(msg),
+                    "humidity",         "Humidity",     DATA_FORMAT, "%u %%",   DATA_INT,    get_os_humidity(msg),
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
+        }
+        if (msg_bits == 76 && (validate_os_v2_message(decoder, msg, 76, msg_bits, 15) == 0)) {
+            float temp_c = get_os_temperature(msg);
+            /* clang-format off */
+            data = data_make(
+                    "model",                 "",                        DATA_STRING, "Oregon-RTGN318",
+                    "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
+                    "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id), // 1 to 5
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
+                    "humidity",            "Humidity",        DATA_FORMAT, "%u %%",     DATA_INT,        get_os_humidity(msg),
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
+        }
+        else if (msg_bits == 100 && (validate_os_v2_message(decoder, msg, 100, msg_bits, 21) == 0)) {
+            // RF Clock message ??
             return 0;
-        float temp_c = get_os_temperature(msg);
-        /* clang-format off */
-        data = data_make(
-                "model",                 "",                        DATA_STRING, "Oregon-RTGN129",
-                "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
-                "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id), // 1 to 5
-                "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
-                "humidity",            "Humidity",        DATA_FORMAT, "%u %%",     DATA_INT,        get_os_humidity(msg),
-                NULL);
-        /* clang-format on */
-        decoder_output_data(decoder, data);
-        return 1;
-    }
-    else if (((sensor_id == ID_RTGR328N_1) || (sensor_id == ID_RTGR328N_2) || (sensor_id == ID_RTGR328N_3) || (sensor_id == ID_RTGR328N_4) || (sensor_id == ID_RTGR328N_5)) && msg_bits == 173) {
-        if (validate_os_v2_message(decoder, msg, 173, msg_bits, 15) != 0)
-             return 0;
-        /* clang-format off */
-        data = data_make(
-                "model",            "",             DATA_STRING, "Oregon-RTGR328N",
-                "id",               "House Code",   DATA_INT,    get_os_rollingcode(msg),
-                "channel",          "Channel",      DATA_INT,    get_os_channel(msg, sensor_id), // 1 to 5
-                "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                "temperature_C",    "Temperature",  DATA_FORMAT, "%.02f C", DATA_DOUBLE, get_os_temperature(msg),
-                "humidity",         "Humidity",     DATA_FORMAT, "%u %%",   DATA_INT,    get_os_humidity(msg),
-                NULL);
-        /* clang-format on */
-        decoder_output_data(decoder, data);
-        return 1;
-    }
-    else if ((sensor_id == ID_RTGR328N_6) || (sensor_id == ID_RTGR328N_7)) {
+        }
+        return 0;
+    case ID_RTGR328N_6:
+    case ID_RTGR328N_7: {
         if (validate_os_v2_message(decoder, msg, 100, msg_bits, 21) != 0)
             return 0;
 
@@ -476,28 +544,8 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if ((sensor_id & 0x0fff) == ID_RTGN318) {
-        if (msg_bits == 76 && (validate_os_v2_message(decoder, msg, 76, msg_bits, 15) == 0)) {
-            float temp_c = get_os_temperature(msg);
-            /* clang-format off */
-            data = data_make(
-                    "model",                 "",                        DATA_STRING, "Oregon-RTGN318",
-                    "id",                        "House Code",    DATA_INT,        get_os_rollingcode(msg),
-                    "channel",             "Channel",         DATA_INT,        get_os_channel(msg, sensor_id), // 1 to 5
-                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                    "temperature_C",    "Celsius",        DATA_FORMAT, "%.02f C", DATA_DOUBLE, temp_c,
-                    "humidity",            "Humidity",        DATA_FORMAT, "%u %%",     DATA_INT,        get_os_humidity(msg),
-                    NULL);
-            /* clang-format on */
-            decoder_output_data(decoder, data);
-            return 1;
-        }
-        else if (msg_bits == 100 && (validate_os_v2_message(decoder, msg, 100, msg_bits, 21) == 0)) {
-            // RF Clock message ??
-            return 0;
-        }
-    }
-    else if (sensor_id == ID_THN129 || (sensor_id & 0x0FFF) == ID_RTHN129) {
+    case ID_THN129:
+    case ID_RTHN129:
         if ((validate_os_v2_message(decoder, msg, 68, msg_bits, 12) == 0)) {
             float temp_c = get_os_temperature(msg);
             /* clang-format off */
@@ -516,8 +564,8 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
             // RF Clock message
             return 0;
         }
-    }
-    else if (sensor_id == ID_BTHGN129) {
+        return 0;
+    case ID_BTHGN129: {
         if (validate_os_v2_message(decoder, msg, 92, msg_bits, 19) != 0)
             return 0;
         float temp_c = get_os_temperature(msg);
@@ -538,34 +586,36 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_UVR128 && msg_bits == 148) {
-        if (validate_os_v2_message(decoder, msg, 148, msg_bits, 12) != 0)
-            return 0;
-        // Sanity check BCD digits
-        if (((msg[4] >> 4) & 0x0F) > 9 || (msg[4] & 0x0F) > 9) {
-            decoder_log(decoder, 1, __func__, "UVR128 Message failed BCD sanity check.");
-            return DECODE_FAIL_SANITY;
-        }
-        int uvidx = get_os_uv(msg);
-        // Sanity check value
-        if (uvidx < 0 || uvidx > 25) {
-            decoder_logf(decoder, 1, __func__, "UVR128 Message failed values sanity check: uv %u.", uvidx);
-            return DECODE_FAIL_SANITY;
-        }
+    case ID_UVR128:
+        if (msg_bits == 148) {
+            if (validate_os_v2_message(decoder, msg, 148, msg_bits, 12) != 0)
+                return 0;
+            // Sanity check BCD digits
+            if (((msg[4] >> 4) & 0x0F) > 9 || (msg[4] & 0x0F) > 9) {
+                decoder_log(decoder, 1, __func__, "UVR128 Message failed BCD sanity check.");
+                return DECODE_FAIL_SANITY;
+            }
+            int uvidx = get_os_uv(msg);
+            // Sanity check value
+            if (uvidx < 0 || uvidx > 25) {
+                decoder_logf(decoder, 1, __func__, "UVR128 Message failed values sanity check: uv %u.", uvidx);
+                return DECODE_FAIL_SANITY;
+            }
 
-        /* clang-format off */
-        data = data_make(
-                "model",                    "",                     DATA_STRING, "Oregon-UVR128",
-                "id",                         "House Code", DATA_INT,        get_os_rollingcode(msg),
-                "uv",                         "UV Index",     DATA_FORMAT, "%u", DATA_INT, uvidx,
-                "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
-                //"channel",                "Channel",        DATA_INT,        get_os_channel(msg, sensor_id),
-                NULL);
-        /* clang-format on */
-        decoder_output_data(decoder, data);
-        return 1;
-    }
-    else if (sensor_id == ID_THGR328N) {
+            /* clang-format off */
+            data = data_make(
+                    "model",                    "",                     DATA_STRING, "Oregon-UVR128",
+                    "id",                         "House Code", DATA_INT,        get_os_rollingcode(msg),
+                    "uv",                         "UV Index",     DATA_FORMAT, "%u", DATA_INT, uvidx,
+                    "battery_ok",          "Battery",         DATA_INT,    !get_os_battery(msg),
+                    //"channel",                "Channel",        DATA_INT,        get_os_channel(msg, sensor_id),
+                    NULL);
+            /* clang-format on */
+            decoder_output_data(decoder, data);
+            return 1;
+        }
+        break;
+    case ID_THGR328N: {
         if (validate_os_v2_message(decoder, msg, 173, msg_bits, 15) != 0)
             return 0;
         /* clang-format off */
@@ -581,7 +631,9 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (msg_bits > 16) {
+    }
+
+    if (msg_bits > 16) {
         decoder_logf_bitrow(decoder, 1, __func__, msg, msg_bits, "Unrecognized Oregon Scientific v2.1 message (device ID %4x)", sensor_id);
     }
     else {
@@ -594,6 +646,39 @@ static int oregon_scientific_v2_1_decode(r_device *decoder, bitbuffer_t *bitbuff
 // ceil((335 + 11) / 8)
 #define EXPECTED_NUM_BYTES 44
 
+// full preamble is 00 00 00 5 (shorter for WGR800X)
+#define OS_V3_PREAMBLE     0x0005
+// CM180 preamble is 00 00 00 46, with 0x46 already data
+#define OS_V3_CM180_SYNC   0x0046
+#define OS_V3_CM180I_SYNC  0x004a
+// workaround for a broken manchester demod
+// CM160 preamble might look like 7f ff ff aa, i.e. ff ff f5
+#define OS_V3_ALT_PREAMBLE 0xfff5
+
+/// Find the first position of each v3 preamble in one pass over the row, the row length if not found.
+static void os_v3_find_preambles(bitbuffer_t *bitbuffer, int *os_pos, int *cm180_pos, int *cm180i_pos, int *alt_pos)
+{
+    uint8_t const *bits = bitbuffer->bb[0];
+    int len             = bitbuffer->bits_per_row[0];
+    *os_pos = *cm180_pos = *cm180i_pos = *alt_pos = len;
+
+    uint16_t reg = 0;
+    for (int pos = 0; pos < len; ++pos) {
+        reg = (uint16_t)(reg << 1 | ((bits[pos >> 3] >> (7 - (pos & 7))) & 1));
+        if (pos < 15)
+            continue;
+        int start = pos - 15;
+        if (reg == OS_V3_PREAMBLE && *os_pos == len)
+            *os_pos = start;
+        else if (reg == OS_V3_CM180_SYNC && *cm180_pos == len)
+            *cm180_pos = start;
+        else if (reg == OS_V3_CM180I_SYNC && *cm180i_pos == len)
+            *cm180i_pos = start;
+        else if (reg == OS_V3_ALT_PREAMBLE && *alt_pos == len)
+            *alt_pos = start;
+    }
+}
+
 /**
 Various Oregon Scientific protocols.
 
@@ -621,19 +706,12 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
     // aligned (at 11) and reflected that's 3 packets:
     // {324} 00 0a 19 84 00 e0 00 c0 00 00 00 3d 70   00 00 0a 19 84 00 e0 00 c0 00 00 00 3d 70   00 00 0a 19 84 00 e0 00 c0 00 00 00 3d 70
 
-    // full preamble is 00 00 00 5 (shorter for WGR800X)
-    uint8_t const os_pattern[] = {0x00, 0x05};
-    // CM180 preamble is 00 00 00 46, with 0x46 already data
-    uint8_t const cm180_pattern[] = {0x00, 0x46};
-    uint8_t const cm180i_pattern[] = {0x00, 0x4A};
-    // workaround for a broken manchester demod
-    // CM160 preamble might look like 7f ff ff aa, i.e. ff ff f5
-    uint8_t const alt_pattern[] = {0xff, 0xf5};
-
-    int os_pos    = bitbuffer_search(bitbuffer, 0, 0, os_pattern, 16) + 16;
-    int cm180_pos = bitbuffer_search(bitbuffer, 0, 0, cm180_pattern, 16) + 8; // keep the 0x46
-    int cm180i_pos = bitbuffer_search(bitbuffer, 0, 0, cm180i_pattern, 16) + 8; // keep the 0x46
-    int alt_pos   = bitbuffer_search(bitbuffer, 0, 0, alt_pattern, 16) + 16;
+    int os_pos, cm180_pos, cm180i_pos, alt_pos;
+    os_v3_find_preambles(bitbuffer, &os_pos, &cm180_pos, &cm180i_pos, &alt_pos);
+    os_pos += 16;
+    cm180_pos += 8;  // keep the 0x46
+    cm180i_pos += 8; // keep the 0x4A
+    alt_pos += 16;
 
     if (bitbuffer->bits_per_row[0] - os_pos >= 7 * 8) {
         msg_pos = os_pos;
@@ -664,7 +742,9 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
     reflect_nibbles(msg, (msg_len + 7) / 8);
 
     int sensor_id = (msg[0] << 8) | msg[1];
-    if (sensor_id == ID_THGR810 || sensor_id == ID_THGR810a) {
+    switch (sensor_id) {
+    case ID_THGR810:
+    case ID_THGR810a: {
         if (validate_os_checksum(decoder, msg, 15) != 0)
             return DECODE_FAIL_MIC;
         // Sanity check BCD digits
@@ -692,7 +772,7 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;                                    //msg[k] = ((msg[k] & 0x0F) << 4) + ((msg[k] & 0xF0) >> 4);
     }
-    else if (sensor_id == ID_THN802) {
+    case ID_THN802: {
         if (validate_os_checksum(decoder, msg, 12) != 0)
             return DECODE_FAIL_MIC;
         float temp_c = get_os_temperature(msg);
@@ -708,7 +788,7 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_UV800) {
+    case ID_UV800: {
         if (validate_os_checksum(decoder, msg, 13) != 0)
             return DECODE_FAIL_MIC;
         int uvidx = get_os_uv(msg);
@@ -724,7 +804,7 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_PCR800) {
+    case ID_PCR800: {
         if (validate_os_checksum(decoder, msg, 18) != 0)
             return DECODE_FAIL_MIC;
         // Sanity check BCD digits
@@ -758,7 +838,7 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_PCR800a) {
+    case ID_PCR800a: {
         if (validate_os_checksum(decoder, msg, 18) != 0)
             return DECODE_FAIL_MIC;
         float rain_rate = get_os_rain_rate(msg);
@@ -776,7 +856,8 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (sensor_id == ID_WGR800 || sensor_id == ID_WGR800a) {
+    case ID_WGR800:
+    case ID_WGR800a: {
         if (validate_os_checksum(decoder, msg, 17) != 0)
             return DECODE_FAIL_MIC;
         // Sanity check BCD digits
@@ -814,7 +895,15 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if ((msg[0] == 0x20) || (msg[0] == 0x21) || (msg[0] == 0x22) || (msg[0] == 0x23) || (msg[0] == 0x24)) { // Owl CM160 Readings
+    }
+
+    // the Owl energy monitors are told apart by the first byte only
+    switch (msg[0]) {
+    case 0x20: // Owl CM160 Readings
+    case 0x21:
+    case 0x22:
+    case 0x23:
+    case 0x24: {
         msg[0] = msg[0] & 0x0F;
 
         if (validate_os_checksum(decoder, msg, 22) != 0)
@@ -845,7 +934,7 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
         decoder_output_data(decoder, data);
         return 1;
     }
-    else if (msg[0] == 0x26) { // Owl CM180 readings
+    case 0x26: { // Owl CM180 readings
         msg[0]    = msg[0] & 0x0f;
         int valid = validate_os_checksum(decoder, msg, 23);
         for (int k = 0; k < EXPECTED_NUM_BYTES; k++) { // Reverse nibbles
@@ -874,8 +963,9 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
             decoder_output_data(decoder, data);
             return 1;
         }
+        return DECODE_FAIL_SANITY;
     }
-    else if (msg[0] == 0x25) { // Owl CM180i readings
+    case 0x25: { // Owl CM180i readings
         int valid = 0;
         msg[0]    = msg[0] & 0x0f;
         // to be done
@@ -914,8 +1004,11 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
             decoder_output_data(decoder, data);
             return 1;
         }
+        return DECODE_FAIL_SANITY;
     }
-    else if ((msg[0] != 0) && (msg[1] != 0)) { // sync nibble was found and some data is present...
+    }
+
+    if ((msg[0] != 0) && (msg[1] != 0)) { // sync nibble was found and some data is present...
         decoder_log(decoder, 1, __func__, "Message received from unrecognized Oregon Scientific v3 sensor.");
         decoder_log_bitrow(decoder, 1, __func__, msg, msg_len, "Message");
         decoder_log_bitrow(decoder, 1, __func__, b, bitbuffer->bits_per_row[0], "Raw");
@@ -929,14 +1022,21 @@ static int oregon_scientific_v3_decode(r_device *decoder, bitbuffer_t *bitbuffer
 
 /**
 Various Oregon Scientific protocols.
+
+The preamble is looked at once to pick the protocol version, the v2.1 data
+is Manchester decoded to nibbles with a table, and the sensor type code
+selects the parser with a switch (a jump table) instead of a chain of compares.
+
 @sa oregon_scientific_v2_1_decode() oregon_scientific_v3_decode()
 */
 static int oregon_scientific_decode(r_device *decoder, bitbuffer_t *bitbuffer)
 {
-    int ret = oregon_scientific_v2_1_decode(decoder, bitbuffer);
-    if (ret <= 0)
-        ret = oregon_scientific_v3_decode(decoder, bitbuffer);
-    return ret;
+    uint8_t const *b = bitbuffer->bb[0];
+
+    // Check 2nd and 3rd bytes of stream for possible Oregon Scientific v2.1 sensor data (skip first byte to get past sync/startup bit errors)
+    if ((b[1] == 0x55 && b[2] == 0x55) || (b[1] == 0xAA && b[2] == 0xAA))
+        return oregon_scientific_v2_1_decode(decoder, bitbuffer);
+    return oregon_scientific_v3_decode(decoder, bitbuffer);
 }
 
 static char const *const output_fields[] = {
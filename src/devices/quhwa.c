@@ -35,6 +35,7 @@ static int quhwa_callback(r_device *decoder, bitbuffer_t *bitbuffer)
     b[0] = ~b[0];
     b[1] = ~b[1];
     b[2] = ~b[2];
+    bitbuffer_invalidate(bitbuffer);
 
     if (bitbuffer->bits_per_row[r] != 18
             || (b[1] & 0x03) != 0x03
@@ -181,5 +181,6 @@ r_device const scmplus = {
         .gap_limit   = 0,
         .reset_limit = 64,
         .decode_fn   = &scmplus_decode,
+        .disabled    = 1, // see the ERT front end
         .fields      = output_fields,
 };
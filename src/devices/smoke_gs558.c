@@ -77,6 +77,7 @@ static int smoke_gs558_callback(r_device *decoder, bitbuffer_t *bitbuffer)
                 && b[3] == 0)
             bitbuffer->bits_per_row[r] = 24;
     }
+    bitbuffer_invalidate(bitbuffer);
 
     r = bitbuffer_find_repeated_row(bitbuffer, 3, 24);
 
@@ -94,6 +95,7 @@ static int smoke_gs558_callback(r_device *decoder, bitbuffer_t *bitbuffer)
     b[0] = reverse8(b[0]);
     b[1] = reverse8(b[1]);
     b[2] = reverse8(b[2]);
+    bitbuffer_invalidate(bitbuffer);
 
     unit = b[0] & 0x1f; // 5 bits
     id = ((b[2] & 0x0f) << 11) | (b[1] << 3) | (b[0] >> 5); // 15 bits
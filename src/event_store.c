@@ -0,0 +1,965 @@
+/** @file
+    Embedded indexed event store.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "event_store.h"
+#include "rtl_433.h"
+#include "data.h"
+#include "abuf.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STORE_DEFAULT_MIB 256
+#define STORE_DEFAULT_DAYS 90
+#define STORE_DEFAULT_DEVICES 65536
+#define STORE_MAX_MODELS 1024
+#define STORE_MIN_SEGMENT (1024 * 1024)
+#define STORE_MAX_SEGMENT (16 * 1024 * 1024)
+#define STORE_TINDEX_STEP 64 // records per time index entry
+#define STORE_DEFAULT_LIMIT 100
+#define STORE_MAX_LIMIT 1000
+#define STORE_BUF_SIZE 20000 // state messages need a large buffer
+#define STORE_KEY_SIZE 256
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define STORE_MAGIC 0x53333452u // "R43S"
+#define STORE_VERSION 1
+#define STORE_CARRIED 1 // record was carried over from a removed segment
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segno;
+    uint32_t reserved;
+} store_seg_header_t;
+
+/// A record is the header, the key and the JSON event, padded to 8 bytes.
+typedef struct {
+    uint32_t len;        ///< record size, written last, 0 marks the end of the segment
+    uint32_t time;       ///< unix time the event was stored
+    uint32_t back;       ///< size of the previous record in the segment, 0 for the first
+    uint16_t key_len;    ///< length of the device key "model/id"
+    uint16_t model_len;  ///< length of the model part of the key
+    uint64_t prev_dev;   ///< locator of the previous record of the device, 0 if none
+    uint64_t prev_model; ///< locator of the previous record of the model, 0 if none
+    uint32_t data_len;   ///< length of the JSON event
+    uint32_t flags;
+    uint32_t dev_count;  ///< events of the device so far
+    uint32_t dev_first;  ///< unix time the device was first seen
+} store_rec_t;
+
+typedef struct {
+    uint32_t time;
+    uint32_t offset;
+} store_tindex_t;
+
+typedef struct {
+    uint32_t segno;
+    uint8_t *map;
+    size_t size;      ///< file size
+    size_t used;      ///< end of the last record
+    size_t last;      ///< offset of the last record, 0 if none
+    time_t t_min;     ///< time range of the records, carried records excluded
+    time_t t_max;
+    unsigned records; ///< records, carried records excluded
+    store_tindex_t *tindex;
+    unsigned tindex_len;
+    unsigned tindex_size;
+} store_seg_t;
+
+typedef struct {
+    char *key;
+    uint32_t hash;
+    uint32_t next; ///< index + 1 of the next entry in the bucket, 0 if none
+    uint32_t count;
+    uint32_t first;
+    uint32_t last;
+    uint64_t loc; ///< locator of the newest record
+} store_entry_t;
+
+/// Devices or models, hashed by key, entries are kept dense.
+typedef struct {
+    store_entry_t *ents;
+    unsigned len;
+    unsigned max;
+    uint32_t *buckets; ///< index + 1 of the first entry, 0 if none
+    unsigned mask;
+} store_table_t;
+
+struct event_store {
+    char *dir;
+    size_t max_size;
+    unsigned max_age;
+    size_t seg_size;
+    store_seg_t *segs; ///< ordered by segment number, the last one is the head
+    unsigned num_segs;
+    unsigned segs_size;
+    store_table_t devices;
+    store_table_t models;
+    char buf[STORE_BUF_SIZE];
+};
+
+/* Locators are the segment number and the offset in the segment */
+
+static uint64_t store_loc(uint32_t segno, size_t offset)
+{
+    return (uint64_t)segno << 32 | offset;
+}
+
+static store_seg_t *store_find_seg(event_store_t *store, uint32_t segno)
+{
+    if (!store->num_segs || segno < store->segs[0].segno)
+        return NULL;
+    unsigned idx = segno - store->segs[0].segno;
+    if (idx >= store->num_segs || store->segs[idx].segno != segno)
+        return NULL;
+    return &store->segs[idx];
+}
+
+/// Check that a record at @p offset is complete and ends before @p end.
+static int store_rec_valid(store_seg_t *seg, size_t offset, size_t end)
+{
+    if (offset < sizeof(store_seg_header_t) || offset % 8 || offset + sizeof(store_rec_t) > end)
+        return 0;
+    store_rec_t const *rec = (store_rec_t const *)&seg->map[offset];
+    return rec->len >= sizeof(store_rec_t) && offset + rec->len <= end
+            && sizeof(store_rec_t) + rec->key_len + rec->data_len <= rec->len
+            && rec->model_len <= rec->key_len;
+}
+
+/// Resolve a locator, returns NULL if the record was removed or the locator is invalid.
+static store_rec_t *store_rec_at(event_store_t *store, uint64_t loc, store_seg_t **segp)
+{
+    store_seg_t *seg = store_find_seg(store, (uint32_t)(loc >> 32));
+    size_t offset    = (size_t)(loc & 0xffffffff);
+    if (!seg || !store_rec_valid(seg, offset, seg->used))
+        return NULL;
+    if (segp)
+        *segp = seg;
+    return (store_rec_t *)&seg->map[offset];
+}
+
+static char const *rec_key(store_rec_t const *rec)
+{
+    return (char const *)(rec + 1);
+}
+
+static char const *rec_data(store_rec_t const *rec)
+{
+    return rec_key(rec) + rec->key_len;
+}
+
+/* Tables */
+
+static uint32_t store_hash(char const *key, size_t len)
+{
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void table_init(store_table_t *t, unsigned max)
+{
+    unsigned buckets = 16;
+    while (buckets < max)
+        buckets *= 2;
+    t->max     = max;
+    t->mask    = buckets - 1;
+    t->ents    = calloc(max, sizeof(*t->ents));
+    if (!t->ents)
+        FATAL_CALLOC("table_init()");
+    t->buckets = calloc(buckets, sizeof(*t->buckets));
+    if (!t->buckets)
+        FATAL_CALLOC("table_init()");
+}
+
+static void table_free(store_table_t *t)
+{
+    for (unsigned i = 0; i < t->len; ++i)
+        free(t->ents[i].key);
+    free(t->ents);
+    free(t->buckets);
+}
+
+static store_entry_t *table_find(store_table_t *t, char const *key, size_t len, uint32_t hash)
+{
+    for (uint32_t i = t->buckets[hash & t->mask]; i; i = t->ents[i - 1].next) {
+        store_entry_t *e = &t->ents[i - 1];
+        if (e->hash == hash && !strncmp(e->key, key, len) && !e->key[len])
+            return e;
+    }
+    return NULL;
+}
+
+/// Find the bucket link which points to entry @p idx.
+static uint32_t *table_link(store_table_t *t, unsigned idx)
+{
+    uint32_t *link = &t->buckets[t->ents[idx].hash & t->mask];
+    while (*link != idx + 1)
+        link = &t->ents[*link - 1].next;
+    return link;
+}
+
+static void table_remove(store_table_t *t, unsigned idx)
+{
+    *table_link(t, idx) = t->ents[idx].next;
+    free(t->ents[idx].key);
+
+    // keep the entries dense, move the last entry into the hole
+    unsigned last = t->len - 1;
+    if (idx != last) {
+        *table_link(t, last) = idx + 1;
+        t->ents[idx]         = t->ents[last];
+    }
+    t->len--;
+}
+
+/// Evict the least recently seen entry, of those the one first seen earliest.
+static void table_evict(store_table_t *t)
+{
+    unsigned evict = 0;
+    for (unsigned i = 1; i < t->len; ++i) {
+        store_entry_t const *e = &t->ents[i];
+        store_entry_t const *o = &t->ents[evict];
+        if (e->last < o->last || (e->last == o->last && e->first < o->first))
+            evict = i;
+    }
+    if (t->len)
+        table_remove(t, evict);
+}
+
+/// Clear the locators which point into the removed segment @p segno.
+static void table_drop_seg(store_table_t *t, uint32_t segno)
+{
+    for (unsigned i = 0; i < t->len; ++i) {
+        if ((uint32_t)(t->ents[i].loc >> 32) == segno)
+            t->ents[i].loc = 0;
+    }
+}
+
+static store_entry_t *table_add(store_table_t *t, char const *key, size_t len, uint32_t hash)
+{
+    if (t->len == t->max)
+        table_evict(t);
+
+    store_entry_t *e = &t->ents[t->len];
+    memset(e, 0, sizeof(*e));
+    e->key = malloc(len + 1);
+    if (!e->key)
+        FATAL_MALLOC("table_add()");
+    memcpy(e->key, key, len);
+    e->key[len] = '\0';
+    e->hash     = hash;
+    e->next     = t->buckets[hash & t->mask];
+    t->len++;
+    t->buckets[hash & t->mask] = t->len;
+    return e;
+}
+
+/* Segments */
+
+static void store_seg_path(event_store_t *store, uint32_t segno, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%08u.seg", store->dir, (unsigned)segno);
+}
+
+static void store_seg_index(store_seg_t *seg, size_t offset)
+{
+    store_rec_t const *rec = (store_rec_t const *)&seg->map[offset];
+    seg->last              = offset;
+    seg->used              = offset + rec->len;
+    if (rec->flags & STORE_CARRIED)
+        return;
+
+    if (!seg->records || rec->time < seg->t_min)
+        seg->t_min = rec->time;
+    if (rec->time > seg->t_max)
+        seg->t_max = rec->time;
+    if (seg->records % STORE_TINDEX_STEP == 0) {
+        if (seg->tindex_len == seg->tindex_size) {
+            unsigned size          = seg->tindex_size ? seg->tindex_size * 2 : 64;
+            store_tindex_t *tindex = realloc(seg->tindex, size * sizeof(*tindex));
+            if (!tindex)
+                FATAL_REALLOC("store_seg_index()");
+            seg->tindex      = tindex;
+            seg->tindex_size = size;
+        }
+        seg->tindex[seg->tindex_len].time   = rec->time;
+        seg->tindex[seg->tindex_len].offset = (uint32_t)offset;
+        seg->tindex_len++;
+    }
+    seg->records++;
+}
+
+/// Map a segment file, creates it if @p create is set. Returns 0 on success.
+static int store_seg_map(event_store_t *store, store_seg_t *seg, uint32_t segno, int create)
+{
+    char path[1024];
+    store_seg_path(store, segno, path, sizeof(path));
+
+    memset(seg, 0, sizeof(*seg));
+    seg->segno = segno;
+
+    int fd = open(path, create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+    if (fd < 0) {
+        print_logf(LOG_ERROR, "Store", "Can't open \"%s\": %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (create && ftruncate(fd, store->seg_size)) {
+        print_logf(LOG_ERROR, "Store", "Can't create \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(store_seg_header_t) || (uint64_t)st.st_size > UINT32_MAX) {
+        print_logf(LOG_ERROR, "Store", "Bad segment \"%s\"", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        print_logf(LOG_ERROR, "Store", "Can't map \"%s\": %s", path, strerror(errno));
+        return -1;
+    }
+    seg->map  = map;
+    seg->size = (size_t)st.st_size;
+    seg->used = sizeof(store_seg_header_t);
+
+    store_seg_header_t *hdr = map;
+    if (create) {
+        hdr->version = STORE_VERSION;
+        hdr->segno   = segno;
+        hdr->magic   = STORE_MAGIC;
+    }
+    else if (hdr->magic != STORE_MAGIC || hdr->version != STORE_VERSION || hdr->segno != segno) {
+        print_logf(LOG_ERROR, "Store", "Bad segment \"%s\"", path);
+        munmap(map, seg->size);
+        return -1;
+    }
+    return 0;
+}
+
+static void store_seg_unmap(store_seg_t *seg)
+{
+    if (seg->map) {
+        msync(seg->map, seg->size, MS_ASYNC);
+        munmap(seg->map, seg->size);
+    }
+    free(seg->tindex);
+    seg->map    = NULL;
+    seg->tindex = NULL;
+}
+
+static store_seg_t *store_push_seg(event_store_t *store)
+{
+    if (store->num_segs == store->segs_size) {
+        unsigned size    = store->segs_size ? store->segs_size * 2 : 16;
+        store_seg_t *segs = realloc(store->segs, size * sizeof(*segs));
+        if (!segs)
+            FATAL_REALLOC("store_push_seg()");
+        store->segs      = segs;
+        store->segs_size = size;
+    }
+    return &store->segs[store->num_segs++];
+}
+
+/// Start a new head segment. Returns 0 on success.
+static int store_rotate(event_store_t *store)
+{
+    uint32_t segno   = store->num_segs ? store->segs[store->num_segs - 1].segno + 1 : 1;
+    store_seg_t *seg = store_push_seg(store);
+    if (store_seg_map(store, seg, segno, 1)) {
+        store->num_segs--;
+        return -1;
+    }
+    return 0;
+}
+
+/* Appending */
+
+/// Write a record to the head segment, returns the locator or 0 on failure.
+static uint64_t store_write(event_store_t *store, store_rec_t const *hdr, char const *key, char const *data)
+{
+    size_t rec_size = (sizeof(store_rec_t) + hdr->key_len + hdr->data_len + 7) & ~(size_t)7;
+    if (rec_size > store->seg_size / 4)
+        return 0;
+
+    store_seg_t *seg = store->num_segs ? &store->segs[store->num_segs - 1] : NULL;
+    if (!seg || seg->used + rec_size > seg->size) {
+        if (store_rotate(store))
+            return 0;
+        seg = &store->segs[store->num_segs - 1];
+    }
+
+    size_t offset    = seg->used;
+    store_rec_t *rec = (store_rec_t *)&seg->map[offset];
+    *rec             = *hdr;
+    rec->len         = 0;
+    rec->back        = seg->last ? (uint32_t)(offset - seg->last) : 0;
+    memcpy((char *)(rec + 1), key, hdr->key_len);
+    memcpy((char *)(rec + 1) + hdr->key_len, data, hdr->data_len);
+    rec->len = (uint32_t)rec_size; // commit
+
+    store_seg_index(seg, offset);
+    return store_loc(seg->segno, offset);
+}
+
+/// Carry the newest records of devices over to the head, then remove the oldest segment.
+/// Models whose newest record is removed move to their newest carried record,
+/// the carried records of a model are chained like regular ones.
+static void store_drop_oldest(event_store_t *store)
+{
+    store_seg_t *seg     = &store->segs[0];
+    uint32_t segno       = seg->segno;
+    store_seg_t *head    = &store->segs[store->num_segs - 1];
+    uint64_t carry_start = store_loc(head->segno, head->used); // locators of the carried records start here
+    size_t carried       = 0;
+    for (size_t offset = sizeof(store_seg_header_t); store_rec_valid(seg, offset, seg->used);) {
+        store_rec_t const *rec = (store_rec_t const *)&seg->map[offset];
+        uint64_t loc           = store_loc(seg->segno, offset);
+        offset += rec->len;
+        if (rec->key_len == rec->model_len)
+            continue; // no device
+        store_entry_t *dev = table_find(&store->devices, rec_key(rec), rec->key_len, store_hash(rec_key(rec), rec->key_len));
+        if (!dev || dev->loc != loc)
+            continue;
+        if (carried + rec->len > store->seg_size / 2)
+            break; // too many devices for the size limit, give up on the rest
+
+        store_entry_t *mdl = table_find(&store->models, rec_key(rec), rec->model_len, store_hash(rec_key(rec), rec->model_len));
+        int move_model     = mdl && ((uint32_t)(mdl->loc >> 32) == segno || mdl->loc >= carry_start);
+
+        store_rec_t hdr = *rec;
+        hdr.flags |= STORE_CARRIED;
+        hdr.prev_dev   = 0;
+        hdr.prev_model = move_model && mdl->loc >= carry_start ? mdl->loc : 0;
+        dev->loc       = store_write(store, &hdr, rec_key(rec), rec_data(rec));
+        if (move_model && dev->loc)
+            mdl->loc = dev->loc;
+        carried += rec->len;
+        seg = &store->segs[0]; // the segment list might have moved
+    }
+
+    table_drop_seg(&store->devices, segno);
+    table_drop_seg(&store->models, segno);
+
+    char path[1024];
+    store_seg_path(store, seg->segno, path, sizeof(path));
+    store_seg_unmap(seg);
+    unlink(path);
+    store->num_segs--;
+    memmove(&store->segs[0], &store->segs[1], store->num_segs * sizeof(*store->segs));
+}
+
+static void store_retention(event_store_t *store, time_t now)
+{
+    while (store->num_segs > 1) {
+        size_t total = 0;
+        for (unsigned i = 0; i < store->num_segs; ++i)
+            total += store->segs[i].size;
+        int too_big = total > store->max_size;
+        int too_old = store->segs[0].records && store->segs[0].t_max + (time_t)store->max_age < now;
+        if (!too_big && !too_old)
+            break;
+        store_drop_oldest(store);
+    }
+}
+
+static char const *store_id_str(data_t *d, char *buf, size_t size)
+{
+    if (d->type == DATA_STRING)
+        return d->value.v_ptr;
+    if (d->type == DATA_INT) {
+        snprintf(buf, size, "%d", d->value.v_int);
+        return buf;
+    }
+    return NULL;
+}
+
+int event_store_append(event_store_t *store, data_t *data, time_t now)
+{
+    char const *model = NULL;
+    char const *id    = NULL;
+    char id_buf[16];
+    for (data_t *d = data; d; d = d->next) {
+        if (!strcmp(d->key, "model") && d->type == DATA_STRING)
+            model = d->value.v_ptr;
+        else if (!strcmp(d->key, "id"))
+            id = store_id_str(d, id_buf, sizeof(id_buf));
+    }
+    if (!model)
+        return 0; // not an event
+
+    char key[STORE_KEY_SIZE];
+    int model_len = snprintf(key, sizeof(key), "%s", model);
+    int key_len   = id ? snprintf(key, sizeof(key), "%s/%s", model, id) : model_len;
+    if (key_len < 0 || key_len >= (int)sizeof(key))
+        return 0;
+
+    size_t data_len = data_print_jsons(data, store->buf, sizeof(store->buf));
+    if (data_len + 1 >= sizeof(store->buf))
+        return 0; // skip truncated events
+
+    uint32_t model_hash = store_hash(key, (size_t)model_len);
+    store_entry_t *mdl  = table_find(&store->models, key, (size_t)model_len, model_hash);
+    if (!mdl)
+        mdl = table_add(&store->models, key, (size_t)model_len, model_hash);
+    store_entry_t *dev = NULL;
+    if (id) {
+        uint32_t hash = store_hash(key, (size_t)key_len);
+        dev           = table_find(&store->devices, key, (size_t)key_len, hash);
+        if (!dev)
+            dev = table_add(&store->devices, key, (size_t)key_len, hash);
+    }
+
+    store_rec_t hdr = {0};
+    hdr.time        = (uint32_t)now;
+    hdr.key_len     = (uint16_t)key_len;
+    hdr.model_len   = (uint16_t)model_len;
+    hdr.prev_model  = mdl->loc;
+    hdr.data_len    = (uint32_t)data_len;
+    if (dev) {
+        hdr.prev_dev  = dev->loc;
+        hdr.dev_count = dev->count + 1;
+        hdr.dev_first = dev->count ? dev->first : (uint32_t)now;
+    }
+
+    uint64_t loc = store_write(store, &hdr, key, store->buf);
+    if (!loc)
+        return 0;
+
+    mdl->loc  = loc;
+    mdl->last = hdr.time;
+    mdl->count++;
+    if (dev) {
+        dev->loc   = loc;
+        dev->count = hdr.dev_count;
+        dev->first = hdr.dev_first;
+        dev->last  = hdr.time;
+    }
+
+    store_retention(store, now);
+    return 1;
+}
+
+/* Opening */
+
+static int segno_cmp(void const *a, void const *b)
+{
+    uint32_t x = *(uint32_t const *)a;
+    uint32_t y = *(uint32_t const *)b;
+    return x < y ? -1 : x > y;
+}
+
+/// Rebuild the indexes from the records of a segment.
+static void store_load_seg(event_store_t *store, store_seg_t *seg)
+{
+    for (size_t offset = seg->used; store_rec_valid(seg, offset, seg->size);) {
+        store_rec_t const *rec = (store_rec_t const *)&seg->map[offset];
+
+        store_seg_index(seg, offset);
+        uint64_t loc = store_loc(seg->segno, offset);
+        offset += rec->len;
+
+        char const *key    = rec_key(rec);
+        store_entry_t *mdl = table_find(&store->models, key, rec->model_len, store_hash(key, rec->model_len));
+        if (!mdl)
+            mdl = table_add(&store->models, key, rec->model_len, store_hash(key, rec->model_len));
+        if (!(rec->flags & STORE_CARRIED)) {
+            mdl->loc  = loc;
+            mdl->last = rec->time;
+            mdl->count++;
+        }
+        else if (!mdl->loc || rec->prev_model == mdl->loc) {
+            mdl->loc = loc; // the model moved to its carried records
+        }
+        if (rec->key_len == rec->model_len)
+            continue;
+        uint32_t hash      = store_hash(key, rec->key_len);
+        store_entry_t *dev = table_find(&store->devices, key, rec->key_len, hash);
+        if (!dev)
+            dev = table_add(&store->devices, key, rec->key_len, hash);
+        dev->loc   = loc;
+        dev->count = rec->dev_count;
+        dev->first = rec->dev_first;
+        dev->last  = rec->time;
+    }
+}
+
+static int store_load(event_store_t *store)
+{
+    DIR *dir = opendir(store->dir);
+    if (!dir) {
+        print_logf(LOG_ERROR, "Store", "Can't open directory \"%s\": %s", store->dir, strerror(errno));
+        return -1;
+    }
+    uint32_t *nums = NULL;
+    unsigned num   = 0;
+    unsigned size  = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        char *end;
+        unsigned long segno = strtoul(ent->d_name, &end, 10);
+        if (end != ent->d_name + 8 || strcmp(end, ".seg") || !segno)
+            continue;
+        if (num == size) {
+            size           = size ? size * 2 : 64;
+            uint32_t *more = realloc(nums, size * sizeof(*nums));
+            if (!more)
+                FATAL_REALLOC("store_load()");
+            nums = more;
+        }
+        nums[num++] = (uint32_t)segno;
+    }
+    closedir(dir);
+
+    qsort(nums, num, sizeof(*nums), segno_cmp);
+    for (unsigned i = 0; i < num; ++i) {
+        if (store->num_segs && nums[i] != store->segs[store->num_segs - 1].segno + 1) {
+            // a gap, only the newest run of segments can be chained
+            for (unsigned j = 0; j < store->num_segs; ++j)
+                store_seg_unmap(&store->segs[j]);
+            store->num_segs = 0;
+        }
+        store_seg_t *seg = store_push_seg(store);
+        if (store_seg_map(store, seg, nums[i], 0)) {
+            store->num_segs--;
+            continue;
+        }
+    }
+    free(nums);
+
+    for (unsigned i = 0; i < store->num_segs; ++i)
+        store_load_seg(store, &store->segs[i]);
+    return 0;
+}
+
+event_store_t *event_store_open(char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices)
+{
+    event_store_t *store = calloc(1, sizeof(*store));
+    if (!store) {
+        WARN_CALLOC("event_store_open()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    store->dir = strdup(dir);
+    if (!store->dir) {
+        WARN_STRDUP("event_store_open()");
+        free(store);
+        return NULL;
+    }
+
+    store->max_size = (size_t)(max_mib ? max_mib : STORE_DEFAULT_MIB) * 1024 * 1024;
+    store->max_age  = (max_days ? max_days : STORE_DEFAULT_DAYS) * 24 * 3600;
+    store->seg_size = store->max_size / 16;
+    if (store->seg_size < STORE_MIN_SEGMENT)
+        store->seg_size = STORE_MIN_SEGMENT;
+    if (store->seg_size > STORE_MAX_SEGMENT)
+        store->seg_size = STORE_MAX_SEGMENT;
+    table_init(&store->devices, max_devices ? max_devices : STORE_DEFAULT_DEVICES);
+    table_init(&store->models, STORE_MAX_MODELS);
+
+    if (store_load(store)) {
+        event_store_close(store);
+        return NULL;
+    }
+    print_logf(LOG_NOTICE, "Store", "Event store \"%s\" with %u segments, %u devices, %u models",
+            store->dir, store->num_segs, store->devices.len, store->models.len);
+    return store;
+}
+
+void event_store_close(event_store_t *store)
+{
+    if (!store)
+        return;
+
+    for (unsigned i = 0; i < store->num_segs; ++i)
+        store_seg_unmap(&store->segs[i]);
+    free(store->segs);
+    table_free(&store->devices);
+    table_free(&store->models);
+    free(store->dir);
+    free(store);
+}
+
+/* Queries */
+
+/// Step to the previous record in log order, skipping carried records.
+static store_rec_t *store_rec_before(event_store_t *store, store_seg_t **segp, store_rec_t *rec)
+{
+    store_seg_t *seg = *segp;
+    for (;;) {
+        if (rec && rec->back) {
+            rec = (store_rec_t *)((uint8_t *)rec - rec->back);
+        }
+        else {
+            // the last record of the previous segment
+            if (seg == store->segs)
+                return NULL;
+            seg--;
+            if (!seg->last)
+                continue;
+            rec = (store_rec_t *)&seg->map[seg->last];
+        }
+        *segp = seg;
+        if (!(rec->flags & STORE_CARRIED))
+            return rec;
+    }
+}
+
+/// Find the newest record at or before @p to, using the segment time ranges and time indexes.
+static store_rec_t *store_locate_time(event_store_t *store, time_t to, store_seg_t **segp)
+{
+    for (unsigned i = store->num_segs; i > 0; --i) {
+        store_seg_t *seg = &store->segs[i - 1];
+        if (!seg->records || seg->t_min > to)
+            continue;
+
+        // the last index entry at or before the time, then at most a step of records
+        unsigned lo = 0;
+        unsigned hi = seg->tindex_len;
+        while (hi - lo > 1) {
+            unsigned mid = (lo + hi) / 2;
+            if (seg->tindex[mid].time <= to)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        store_rec_t *found = NULL;
+        for (size_t offset = seg->tindex[lo].offset; offset < seg->used;) {
+            store_rec_t *rec = (store_rec_t *)&seg->map[offset];
+            offset += rec->len;
+            if (rec->flags & STORE_CARRIED)
+                continue;
+            if (rec->time > to)
+                break;
+            found = rec;
+        }
+        if (found) {
+            *segp = seg;
+            return found;
+        }
+    }
+    return NULL;
+}
+
+static void store_print_str(abuf_t *obuf, char const *key, char const *str)
+{
+    abuf_printf(obuf, "\"%s\":\"", key);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            abuf_printf(obuf, "\\%c", *str);
+        else if ((unsigned char)*str < 0x20)
+            abuf_printf(obuf, "\\u%04x", (unsigned char)*str);
+        else
+            abuf_printf(obuf, "%c", *str);
+    }
+    abuf_cat(obuf, "\",");
+}
+
+static void store_print_event(abuf_t *obuf, store_rec_t const *rec, int first)
+{
+    abuf_printf(obuf, "%s{\"stored\":%u,\"event\":%.*s}", first ? "" : ",",
+            (unsigned)rec->time, (int)rec->data_len, rec_data(rec));
+}
+
+size_t event_store_query(event_store_t *store, event_store_query_t const *query, char *buf, size_t size)
+{
+    abuf_t obuf = {0};
+    abuf_init(&obuf, buf, size);
+
+    time_t from     = query->from;
+    time_t to       = query->to ? query->to : (time_t)UINT32_MAX;
+    unsigned limit  = query->limit ? query->limit : STORE_DEFAULT_LIMIT;
+    limit           = limit > STORE_MAX_LIMIT ? STORE_MAX_LIMIT : limit;
+    int by_model    = query->model && *query->model;
+    int by_device   = by_model && query->id && *query->id;
+    uint64_t cursor = query->cursor;
+
+    store_entry_t *ent = NULL;
+    if (store && by_device) {
+        char key[STORE_KEY_SIZE];
+        int len = snprintf(key, sizeof(key), "%s/%s", query->model, query->id);
+        if (len > 0 && len < (int)sizeof(key))
+            ent = table_find(&store->devices, key, (size_t)len, store_hash(key, (size_t)len));
+    }
+    else if (store && by_model) {
+        size_t len = strlen(query->model);
+        ent        = table_find(&store->models, query->model, len, store_hash(query->model, len));
+    }
+
+    abuf_cat(&obuf, "{");
+    if (by_model)
+        store_print_str(&obuf, "model", query->model);
+    if (by_device)
+        store_print_str(&obuf, "id", query->id);
+    if (ent) {
+        abuf_printf(&obuf, "\"count\":%u,\"last\":%u,", ent->count, ent->last);
+        if (by_device)
+            abuf_printf(&obuf, "\"first\":%u,", ent->first);
+    }
+    abuf_cat(&obuf, "\"events\":[");
+
+    store_seg_t *seg = NULL;
+    store_rec_t *rec = NULL;
+    if (!store) {
+        // no store, no events
+    }
+    else if (cursor) {
+        rec = store_rec_at(store, cursor, &seg);
+    }
+    else if (by_model) {
+        rec = ent ? store_rec_at(store, ent->loc, &seg) : NULL;
+    }
+    else {
+        rec = store_locate_time(store, to, &seg);
+    }
+
+    unsigned count = 0;
+    uint64_t next  = 0;
+    while (rec) {
+        uint64_t loc = store_loc(seg->segno, (size_t)((uint8_t *)rec - seg->map));
+        if (by_model && (rec->model_len != strlen(query->model) || strncmp(rec_key(rec), query->model, rec->model_len)))
+            break; // a stale cursor
+        if (rec->time < from)
+            break;
+        if (count == limit) {
+            next = loc;
+            break;
+        }
+        if (rec->time <= to) {
+            store_print_event(&obuf, rec, !count);
+            count++;
+        }
+
+        if (by_device)
+            rec = rec->prev_dev ? store_rec_at(store, rec->prev_dev, &seg) : NULL;
+        else if (by_model)
+            rec = rec->prev_model ? store_rec_at(store, rec->prev_model, &seg) : NULL;
+        else
+            rec = store_rec_before(store, &seg, rec);
+    }
+
+    abuf_printf(&obuf, "],\"returned\":%u", count);
+    if (next)
+        abuf_printf(&obuf, ",\"next\":\"%llu\"", (unsigned long long)next);
+    abuf_cat(&obuf, "}");
+
+    return size - obuf.left;
+}
+
+/* Output */
+
+typedef struct {
+    struct data_output output;
+    r_cfg_t *cfg;
+    event_store_t *store;
+} data_output_store_t;
+
+static void R_API_CALLCONV data_output_store_print(data_output_t *output, data_t *data)
+{
+    data_output_store_t *out = (data_output_store_t *)output;
+
+    event_store_append(out->store, data, time(NULL));
+}
+
+static void R_API_CALLCONV data_output_store_free(data_output_t *output)
+{
+    data_output_store_t *out = (data_output_store_t *)output;
+
+    if (!out)
+        return;
+
+    if (out->cfg->event_store == out->store)
+        out->cfg->event_store = NULL;
+    event_store_close(out->store);
+    free(out);
+}
+
+struct data_output *data_output_store_create(r_cfg_t *cfg, char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices)
+{
+    data_output_store_t *out = calloc(1, sizeof(data_output_store_t));
+    if (!out) {
+        WARN_CALLOC("data_output_store_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    out->store = event_store_open(dir, max_mib, max_days, max_devices);
+    if (!out->store) {
+        free(out);
+        return NULL;
+    }
+    out->cfg         = cfg;
+    cfg->event_store = out->store;
+
+    out->output.output_print = data_output_store_print;
+    out->output.output_free  = data_output_store_free;
+
+    return &out->output;
+}
+
+#else // _WIN32
+
+event_store_t *event_store_open(char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices)
+{
+    UNUSED(dir);
+    UNUSED(max_mib);
+    UNUSED(max_days);
+    UNUSED(max_devices);
+    print_log(LOG_ERROR, "Store", "The event store is not supported on this platform");
+    return NULL;
+}
+
+void event_store_close(event_store_t *store)
+{
+    UNUSED(store);
+}
+
+int event_store_append(event_store_t *store, data_t *data, time_t now)
+{
+    UNUSED(store);
+    UNUSED(data);
+    UNUSED(now);
+    return 0;
+}
+
+size_t event_store_query(event_store_t *store, event_store_query_t const *query, char *buf, size_t size)
+{
+    UNUSED(store);
+    UNUSED(query);
+    abuf_t obuf = {0};
+    abuf_init(&obuf, buf, size);
+    abuf_cat(&obuf, "{\"events\":[],\"returned\":0}");
+    return size - obuf.left;
+}
+
+struct data_output *data_output_store_create(r_cfg_t *cfg, char const *dir, unsigned max_mib, unsigned max_days, unsigned max_devices)
+{
+    UNUSED(cfg);
+    event_store_open(dir, max_mib, max_days, max_devices); // logs the error
+    return NULL;
+}
+
+#endif // _WIN32 / !_WIN32
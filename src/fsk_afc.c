@@ -0,0 +1,215 @@
+/** @file
+    Automatic frequency control for FSK packages.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "fsk_afc.h"
+#include "data.h"
+#include "fatal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AFC_MAX_DEVICES 256
+#define AFC_KEY_SIZE 64
+#define AFC_EST_RATIO 8         // running average of the center over about 8 packages
+#define AFC_DEV_EST_RATIO 4     // running average of a device offset over about 4 packages
+#define AFC_BASELINE_PACKAGES 4 // packages averaged for the baseline of a device
+
+typedef struct {
+    char key[AFC_KEY_SIZE];
+    float baseline_hz;  ///< mean offset of the first packages
+    float offset_hz;    ///< running average offset
+    unsigned packages;  ///< number of packages seen
+    unsigned last_seen; ///< package sequence when last seen
+} afc_device_t;
+
+struct fsk_afc {
+    int mode;
+    unsigned packages;  ///< number of packages seen, also the sequence number
+    float center_hz;    ///< running average center offset
+    float deviation_hz; ///< running average deviation
+    int applied_ppm;    ///< total frequency correction applied
+    unsigned num_devices;
+    afc_device_t devices[AFC_MAX_DEVICES];
+    float drift_buf[AFC_MAX_DEVICES];
+};
+
+fsk_afc_t *fsk_afc_create(int mode)
+{
+    fsk_afc_t *afc = calloc(1, sizeof(*afc));
+    if (!afc) {
+        WARN_CALLOC("fsk_afc_create()");
+        return NULL;
+    }
+    afc->mode = mode;
+    return afc;
+}
+
+void fsk_afc_free(fsk_afc_t *afc)
+{
+    free(afc);
+}
+
+int fsk_afc_mode(fsk_afc_t const *afc)
+{
+    return afc ? afc->mode : FSK_AFC_OFF;
+}
+
+void fsk_afc_reset(fsk_afc_t *afc)
+{
+    if (!afc)
+        return;
+    afc->packages     = 0;
+    afc->center_hz    = 0.0f;
+    afc->deviation_hz = 0.0f;
+    afc->num_devices  = 0;
+}
+
+static afc_device_t *find_device(fsk_afc_t *afc, char const *key)
+{
+    for (unsigned i = 0; i < afc->num_devices; ++i) {
+        if (!strcmp(afc->devices[i].key, key))
+            return &afc->devices[i];
+    }
+
+    // add a new device, evict the least recently seen if full
+    afc_device_t *dev = NULL;
+    if (afc->num_devices < AFC_MAX_DEVICES) {
+        dev = &afc->devices[afc->num_devices++];
+    }
+    else {
+        dev = &afc->devices[0];
+        for (unsigned i = 1; i < afc->num_devices; ++i) {
+            if (afc->devices[i].last_seen < dev->last_seen)
+                dev = &afc->devices[i];
+        }
+    }
+    *dev = (afc_device_t){0};
+    snprintf(dev->key, sizeof(dev->key), "%s", key);
+    return dev;
+}
+
+void fsk_afc_update(fsk_afc_t *afc, float f1_hz, float f2_hz, char const *key)
+{
+    if (!afc || afc->mode < FSK_AFC_TRACK)
+        return;
+
+    float center    = (f1_hz + f2_hz) / 2.0f;
+    float deviation = fabsf(f1_hz - f2_hz) / 2.0f;
+    if (!afc->packages) {
+        afc->center_hz    = center;
+        afc->deviation_hz = deviation;
+    }
+    else {
+        afc->center_hz += (center - afc->center_hz) / AFC_EST_RATIO;
+        afc->deviation_hz += (deviation - afc->deviation_hz) / AFC_EST_RATIO;
+    }
+    afc->packages++;
+
+    if (afc->mode < FSK_AFC_LEARN || !key || !*key)
+        return;
+
+    afc_device_t *dev = find_device(afc, key);
+    dev->packages++;
+    dev->last_seen = afc->packages;
+    if (dev->packages <= AFC_BASELINE_PACKAGES) {
+        dev->baseline_hz += (center - dev->baseline_hz) / dev->packages; // cumulative mean
+        dev->offset_hz = dev->baseline_hz;
+    }
+    else {
+        dev->offset_hz += (center - dev->offset_hz) / AFC_DEV_EST_RATIO;
+    }
+}
+
+int fsk_afc_seed(fsk_afc_t const *afc, uint32_t samp_rate, int *fm_f1, int *fm_f2)
+{
+    if (!afc || !afc->packages || afc->deviation_hz <= 0.0f || !samp_rate)
+        return 0;
+
+    // FM samples are the frequency offset scaled to +-INT16_MAX at half the sample rate
+    float scale = 2.0f * INT16_MAX / samp_rate;
+    float f1    = (afc->center_hz + afc->deviation_hz) * scale;
+    float f2    = (afc->center_hz - afc->deviation_hz) * scale;
+    if (f1 >= INT16_MAX || f2 <= -INT16_MAX)
+        return 0; // out of range, no useful seed
+    *fm_f1 = (int)f1;
+    *fm_f2 = (int)f2;
+    return *fm_f1 > *fm_f2;
+}
+
+static int cmp_float(void const *a, void const *b)
+{
+    float fa = *(float const *)a;
+    float fb = *(float const *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+int fsk_afc_drift(fsk_afc_t *afc, uint32_t frequency, float *drift_ppm)
+{
+    if (!afc || afc->mode < FSK_AFC_LEARN || !frequency)
+        return 0;
+
+    unsigned count = 0;
+    for (unsigned i = 0; i < afc->num_devices; ++i) {
+        afc_device_t const *dev = &afc->devices[i];
+        if (dev->packages > AFC_BASELINE_PACKAGES)
+            afc->drift_buf[count++] = dev->offset_hz - dev->baseline_hz;
+    }
+    if (!count)
+        return 0;
+
+    qsort(afc->drift_buf, count, sizeof(*afc->drift_buf), cmp_float);
+    float median_hz = count & 1 ? afc->drift_buf[count / 2]
+            : (afc->drift_buf[count / 2 - 1] + afc->drift_buf[count / 2]) / 2.0f;
+    // a tuner running high shows signals at a lower offset
+    *drift_ppm = -median_hz / frequency * 1e6f;
+    return 1;
+}
+
+void fsk_afc_corrected(fsk_afc_t *afc, uint32_t frequency, int ppm)
+{
+    if (!afc)
+        return;
+
+    // the correction moves all signals up by the corrected amount
+    float shift_hz = (float)ppm * frequency / 1e6f;
+    afc->center_hz += shift_hz;
+    for (unsigned i = 0; i < afc->num_devices; ++i) {
+        afc_device_t *dev = &afc->devices[i];
+        dev->offset_hz += shift_hz;
+        if (dev->packages <= AFC_BASELINE_PACKAGES)
+            dev->baseline_hz += shift_hz;
+    }
+    afc->applied_ppm += ppm;
+}
+
+data_t *fsk_afc_report(fsk_afc_t *afc, uint32_t frequency)
+{
+    if (!afc)
+        return NULL;
+
+    float drift_ppm = 0.0f;
+    int has_drift   = fsk_afc_drift(afc, frequency, &drift_ppm);
+
+    /* clang-format off */
+    data_t *data = data_make(
+            "mode",         "", DATA_INT,    afc->mode,
+            "packages",     "", DATA_INT,    afc->packages,
+            "center_Hz",    "", DATA_INT,    (int)lrintf(afc->center_hz),
+            "deviation_Hz", "", DATA_INT,    (int)lrintf(afc->deviation_hz),
+            "devices",      "", DATA_COND,   afc->mode >= FSK_AFC_LEARN, DATA_INT, afc->num_devices,
+            "drift_ppm",    "", DATA_COND,   has_drift, DATA_DOUBLE, (double)roundf(drift_ppm * 10.0f) / 10.0,
+            "applied_ppm",  "", DATA_COND,   afc->mode >= FSK_AFC_CORRECT, DATA_INT, afc->applied_ppm,
+            NULL);
+    /* clang-format on */
+    return data;
+}
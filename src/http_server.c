@@ -19,6 +19,8 @@ A choice of endpoints are available:
 - "/cmd": simple JSON command API
 - "/events": HTTP (chunked) streaming API, streams JSON events
 - "/stream": HTTP (plain) streaming API, streams JSON events
+- "/topology": Gridstream mesh topology snapshot (JSON, add "?format=graphml" for GraphML)
+- "/store": event store query (with "-F store"), by model, id, and time range
 - "/api": RESTful API (not implemented)
 - "ws:": Websocket API (similar to cmd/events API)
 
@@ -46,9 +48,47 @@ Examples:
 
 You will receive JSON events, one per line terminated with CRLF.
 On Events and Stream endpoints a keep-alive of CRLF will be send every 60 seconds.
+
+Recent events are kept in a history of 64 KiB, Websocket clients receive the
+whole history on connect. Events are numbered consecutively and the
+`X-Event-Seq` response header on Events and Stream gives the number of the
+first event sent. Add `since=N` to the query to also replay the history after
+event number N (`since=0` for all), e.g. to resume after a reconnect.
 Use e.g. httpie with `http --stream --timeout=70 :8433/events`
 or `(echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433`
 
+## Compression and binary events
+
+Websocket clients offering permessage-deflate (RFC 7692) get compressed
+messages, the compression context is kept across the messages of a connection
+unless the client asks for "server_no_context_takeover". Events and Stream
+clients sending "Accept-Encoding: gzip" get a gzip stream, flushed after every
+event, e.g. `curl -N --compressed :8433/stream`. Compression needs zlib at build time.
+Add "?format=cbor" to the Websocket URL to receive live events as CBOR
+(RFC 8949) in binary frames, the history and command replies stay JSON text.
+The Websocket command "get_ws_stats" returns the message count, the size of the
+messages as JSON and the bytes sent, which is also logged when a connection closes.
+
+## Topology API
+
+Gridstream 0x55 and 0xD5 frames are indexed into a graph of meters and
+collectors as they are decoded. Edges carry the frame count, the last seen
+time and the RSSI (with "-M level"). The index is capped at 4096 nodes and
+16384 edges, entries not seen for a day are expired.
+The snapshot is a JSON adjacency list, e.g. `http :8433/topology`,
+or a GraphML document, e.g. `http :8433/topology format==graphml`.
+
+## Store API
+
+With an event store ("-F store:<dir>") past events can be queried by
+"model" and "id", and by time range with "from" and "to" (unix time).
+Events are returned newest first, at most "limit" (default 100, max 1000)
+per answer. Pass the "next" value of an answer as "cursor" for the next page.
+Device queries also give the event count and the first and last seen time,
+answers follow the device, model, or time index and never scan the store.
+E.g. `http :8433/store model==LandisGyr-GS id==1a2b3c4d limit==10`
+or `http :8433/store from==1700000000 to==1700003600`.
+
 ## Queries
 
 - "registered_protocols"
@@ -90,6 +130,18 @@ or `(echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433`
 - "report_meta":      "time"|"reltime"|"notime"|"hires"|"utc"|"protocol"|"level"
 - "convert":          "native"|"si"|"customary"
 - "protocol":         1
+- "register_protocol": 1, optional "arg" with decoder parameters
+- "unregister_protocol": 1
+- "add_output":       "json:/tmp/events.json" (as with "-F")
+- "remove_output":    0 (index as listed by "get_outputs")
+- "hop_frequencies":  "868.3M,915M"
+- "reload":           re-read the config file, same as SIGHUP
+- "decode_budget":    1000 (per decoder time budget in us, 0 disables, as with "-Y budget")
+- "restore_demoted":  0 (protocol number, 0 for all), returns the number of decoders restored
+- "first_match":      64 (run all decoders on every Nth package, 0 disables, as with "-Y firstmatch")
+
+Changes to protocols, outputs and frequencies are applied on the main loop,
+i.e. between SDR blocks, the SDR keeps running.
 
 */
 
@@ -103,11 +155,18 @@ or `(echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433`
 #include "optparse.h"
 #include "abuf.h"
 #include "list.h" // used for protocols
+#include "mesh_topology.h"
+#include "event_store.h"
 #include "jsmn.h"
 #include "mongoose.h"
 #include "logger.h"
 #include "fatal.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+#ifdef ZLIB
+#include <zlib.h>
+#endif
 
 // embed index.html so browsers allow access as local
 #define INDEX_HTML \
@@ -128,100 +187,179 @@ or `(echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433`
     "<script src=\"https://triq.org/rxui/js/chunk-vendors.js\"></script>" \
     "<script src=\"https://triq.org/rxui/js/app.js\"></script>"
 
-// generic ring list
+// event history ring
 
-#define DEFAULT_HISTORY_SIZE 100
+#define DEFAULT_HISTORY_BYTES (64 * 1024)
 
-typedef struct {
-    unsigned size;
-    void **data;
-    void **head;
-    void **tail;
-} ring_list_t;
+/*
+Contiguous byte ring of serialized events, bounded in bytes.
 
-static ring_list_t *ring_list_new(unsigned size)
+Each record is stored ready to send as a HTTP chunk, i.e. the length is
+prefixed as hex chunk size: "<len>\r\n<json>\r\n\r\n" where len counts the
+JSON and the line end. A record is never split, if a record does not fit at
+the end of the buffer the ring wraps early and `end` marks the valid data.
+The whole backlog thus is at most two contiguous spans.
+*/
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t head;   ///< offset of the oldest record
+    size_t tail;   ///< offset after the newest record
+    size_t end;    ///< end of valid data if wrapped
+    int wrapped;   ///< tail is before head
+    unsigned count;
+    uint64_t seq;  ///< sequence number of the oldest record
+} event_ring_t;
+
+static event_ring_t *event_ring_new(size_t size)
 {
-    ring_list_t *ring = calloc(1, sizeof(ring_list_t));
+    event_ring_t *ring = calloc(1, sizeof(*ring));
     if (!ring) {
-        WARN_CALLOC("ring_list_new()");
+        WARN_CALLOC("event_ring_new()");
         return NULL;
     }
 
-    ring->data = calloc(size, sizeof(void *));
-    if (!ring->data) {
-        WARN_CALLOC("ring_list_new()");
+    ring->buf = malloc(size);
+    if (!ring->buf) {
+        WARN_MALLOC("event_ring_new()");
         free(ring);
         return NULL;
     }
 
     ring->size = size;
-    ring->tail = ring->data;
+    ring->seq  = 1; // 0 is "before any event" for since queries
 
     return ring;
 }
 
-// the ring needs to be empty before calling this
-static void ring_list_free(ring_list_t *ring)
+static void event_ring_free(event_ring_t *ring)
 {
     if (ring) {
-        if (ring->data)
-            free(ring->data);
+        free(ring->buf);
         free(ring);
     }
 }
 
-// free the data returned
-static void *ring_list_shift(ring_list_t *ring)
+/// Get the JSON data and length of the record at @p rec, returns the whole record length.
+static size_t event_ring_record(char const *rec, char const **json, size_t *json_len)
 {
-    if (!ring->head)
-        return NULL;
+    char *endptr;
+    size_t data_len = strtoul(rec, &endptr, 16); // chunk size, JSON and line end
+    if (json)
+        *json = endptr + 2;
+    if (json_len)
+        *json_len = data_len - 2;
+    return (size_t)(endptr - rec) + 2 + data_len + 2;
+}
 
-    void *ret = *ring->head;
+/// Sequence number of the next record pushed.
+static uint64_t event_ring_next_seq(event_ring_t const *ring)
+{
+    return ring->seq + ring->count;
+}
+
+// drop the oldest record
+static void event_ring_shift(event_ring_t *ring)
+{
+    if (!ring->count)
+        return;
 
-    ++ring->head;
-    if (ring->head >= ring->data + ring->size)
-        ring->head -= ring->size;
-    if (ring->head == ring->tail)
-        ring->head = NULL;
+    ring->head += event_ring_record(&ring->buf[ring->head], NULL, NULL);
+    ring->count--;
+    ring->seq++;
 
-    return ret;
+    if (!ring->count) {
+        ring->head    = 0;
+        ring->tail    = 0;
+        ring->wrapped = 0;
+    }
+    else if (ring->wrapped && ring->head >= ring->end) {
+        ring->head    = 0;
+        ring->wrapped = 0;
+    }
 }
 
-// retain data before passing in and free the data returned.
-static void *ring_list_push(ring_list_t *ring, void *data)
+/// Append a record, drops the oldest records as needed, returns the record or NULL if too large.
+static char const *event_ring_push(event_ring_t *ring, char const *json, size_t len)
 {
-    *ring->tail = data;
-
-    if (!ring->head)
-        ring->head = ring->tail;
+    char hdr[20];
+    int hdr_len = snprintf(hdr, sizeof(hdr), "%lX\r\n", (unsigned long)(len + 2));
+    size_t rec_len = hdr_len + len + 4;
+    if (rec_len > ring->size) {
+        // a record this large would evict everything, skip it
+        ring->seq += ring->count + 1;
+        ring->count   = 0;
+        ring->head    = 0;
+        ring->tail    = 0;
+        ring->wrapped = 0;
+        return NULL;
+    }
 
-    ++ring->tail;
-    if (ring->tail >= ring->data + ring->size)
-        ring->tail -= ring->size;
+    for (;;) {
+        if (!ring->wrapped) {
+            if (ring->size - ring->tail >= rec_len)
+                break; // fits at the end
+            if (ring->head >= rec_len) {
+                // wrap early, fits at the front
+                ring->end     = ring->tail;
+                ring->tail    = 0;
+                ring->wrapped = 1;
+                break;
+            }
+        }
+        else if (ring->head - ring->tail >= rec_len) {
+            break; // fits in the gap
+        }
+        event_ring_shift(ring);
+    }
 
-    if (ring->tail == ring->head)
-        return ring_list_shift(ring);
+    char *rec = &ring->buf[ring->tail];
+    memcpy(rec, hdr, hdr_len);
+    memcpy(rec + hdr_len, json, len);
+    memcpy(rec + hdr_len + len, "\r\n\r\n", 4);
+    ring->tail += rec_len;
+    ring->count++;
 
-    return NULL;
+    return rec;
 }
 
-static void **ring_list_iter(ring_list_t *ring)
+/// Offset of the first record after sequence number @p since, skips records as needed.
+static size_t event_ring_find(event_ring_t const *ring, uint64_t since, int *wrapped)
 {
-    return ring->head;
+    size_t pos = ring->head;
+    *wrapped = 0;
+    for (uint64_t seq = ring->seq; seq <= since && seq < event_ring_next_seq(ring); ++seq) {
+        pos += event_ring_record(&ring->buf[pos], NULL, NULL);
+        if (ring->wrapped && !*wrapped && pos >= ring->end) {
+            pos      = 0;
+            *wrapped = 1;
+        }
+    }
+    return pos;
 }
 
-static void **ring_list_next(ring_list_t *ring, void **iter)
+/// Get the (at most two) contiguous spans of records after sequence number @p since.
+static void event_ring_spans(event_ring_t const *ring, uint64_t since,
+        char const **span1, size_t *len1, char const **span2, size_t *len2)
 {
-    if (!iter)
-        return NULL;
-
-    ++iter;
-    if (iter >= ring->data + ring->size)
-        iter -= ring->size;
-    if (iter == ring->tail)
-        iter = NULL;
+    *len1 = 0;
+    *len2 = 0;
+    *span1 = ring->buf;
+    *span2 = ring->buf;
+    if (!ring->count)
+        return;
 
-    return iter;
+    int skipped_wrap;
+    size_t pos = event_ring_find(ring, since, &skipped_wrap);
+    if (ring->wrapped && !skipped_wrap) {
+        *span1 = &ring->buf[pos];
+        *len1  = ring->end - pos;
+        *len2  = ring->tail;
+    }
+    else {
+        *span1 = &ring->buf[pos];
+        *len1  = ring->tail - pos;
+    }
 }
 
 // data helpers that could go into r_api
@@ -321,6 +459,42 @@ static data_t *protocols_data(r_cfg_t *cfg)
     return data;
 }
 
+/// Cached protocols JSON of a server, valid while the registered decoders are unchanged.
+typedef struct {
+    char *json;
+    unsigned gen;
+} protocols_cache_t;
+
+static char const *protocols_json(protocols_cache_t *cache, r_cfg_t *cfg)
+{
+    if (cache->json && cache->gen == cfg->devices_gen)
+        return cache->json;
+
+    free(cache->json);
+    cache->json = NULL;
+
+    data_t *data = protocols_data(cfg);
+    size_t size = 65536; // we expect the protocol string to be around 60k bytes.
+    for (;;) {
+        char *buf = malloc(size);
+        if (!buf) {
+            WARN_MALLOC("protocols_json()");
+            break;
+        }
+        size_t len = data_print_jsons(data, buf, size);
+        if (len + 1 < size) {
+            cache->json = buf;
+            cache->gen  = cfg->devices_gen;
+            break;
+        }
+        free(buf); // truncated, retry larger
+        size *= 2;
+    }
+    data_free(data);
+
+    return cache->json;
+}
+
 // very narrowly tailored JSON parsing
 
 typedef struct rpc rpc_t;
@@ -336,6 +510,7 @@ struct rpc {
     uint32_t val;
     //list_t params;
     char *id;
+    protocols_cache_t *protocols; ///< of the server
 };
 
 static int jsoneq(const char *json, jsmntok_t *tok, const char *s)
@@ -513,6 +688,18 @@ static int jsonrpc_parse(rpc_t *rpc, struct mg_str const *json)
     return 0;
 }
 
+static void R_API_CALLCONV print_http_data(data_output_t *output, data_t *data, char const *format);
+
+/// Clients may only add console and network client outputs, nothing that writes files or listens.
+static int rpc_output_allowed(char const *arg)
+{
+    if (output_spec_console(arg))
+        return 1;
+    if (strncmp(arg, "mqtt", 4) && strncmp(arg, "influx", 6) && strncmp(arg, "syslog", 6))
+        return 0;
+    return !strstr(arg, "spool") && !strstr(arg, "tls_"); // no spool directories or key files
+}
+
 static void rpc_exec(rpc_t *rpc, r_cfg_t *cfg)
 {
     if (!rpc || !rpc->method || !*rpc->method) {
@@ -571,13 +758,22 @@ static void rpc_exec(rpc_t *rpc, r_cfg_t *cfg)
         rpc->response(rpc, 1, buf, 0);
         data_free(data);
     }
-    else if (!strcmp(rpc->method, "get_protocols")) {
-        char buf[65536]; // we expect the protocol string to be around 60k bytes.
-        data_t *data = protocols_data(cfg);
+    else if (!strcmp(rpc->method, "get_outputs")) {
+        char buf[4096];
+        data_t *data = data_make(
+                "outputs", "", DATA_ARRAY, data_array(cfg->output_specs.len, DATA_STRING, cfg->output_specs.elems),
+                NULL);
         data_print_jsons(data, buf, sizeof(buf));
         rpc->response(rpc, 1, buf, 0);
         data_free(data);
     }
+    else if (!strcmp(rpc->method, "get_protocols")) {
+        char const *json = protocols_json(rpc->protocols, cfg);
+        if (json)
+            rpc->response(rpc, 1, json, 0);
+        else
+            rpc->response(rpc, -1, "Out of memory", 0);
+    }
 
     // Setter
     else if (!strcmp(rpc->method, "hop_interval")) {
@@ -625,8 +821,93 @@ static void rpc_exec(rpc_t *rpc, r_cfg_t *cfg)
         cfg->verbose_bits = rpc->val;
         rpc->response(rpc, 0, "Ok", 0);
     }
-    else if (!strcmp(rpc->method, "protocol")) {
-        // set_protocol(rpc->val);
+    else if (!strcmp(rpc->method, "protocol") || !strcmp(rpc->method, "register_protocol")) {
+        unsigned num = rpc->val;
+        if (num < 1 || num > cfg->num_r_devices || cfg->devices[num - 1].disabled > 2)
+            rpc->response(rpc, -1, "Invalid protocol", 0);
+        else if (find_protocol(cfg, num, NULL))
+            rpc->response(rpc, -1, "Already registered", 0);
+        else {
+            register_protocol(cfg, &cfg->devices[num - 1], rpc->arg);
+            update_dispatch(cfg);
+            rpc->response(rpc, 0, "Ok", 0);
+        }
+    }
+    else if (!strcmp(rpc->method, "unregister_protocol")) {
+        unsigned num = rpc->val;
+        if (num < 1 || num > cfg->num_r_devices || !find_protocol(cfg, num, NULL))
+            rpc->response(rpc, -1, "Not registered", 0);
+        else {
+            unregister_protocol(cfg, &cfg->devices[num - 1]);
+            update_dispatch(cfg);
+            rpc->response(rpc, 0, "Ok", 0);
+        }
+    }
+    else if (!strcmp(rpc->method, "add_output")) {
+        if (!rpc->arg || !*rpc->arg)
+            rpc->response(rpc, -1, "Missing arg", 0);
+        else if (!rpc_output_allowed(rpc->arg))
+            rpc->response(rpc, -1, "Output not allowed", 0);
+        else if (add_output(cfg, rpc->arg) < 0)
+            rpc->response(rpc, -1, "Invalid output", 0);
+        else {
+            start_output(cfg, cfg->output_handler.elems[cfg->output_handler.len - 1]);
+            rpc->response(rpc, 0, "Ok", 0);
+        }
+    }
+    else if (!strcmp(rpc->method, "remove_output")) {
+        // don't let a client remove the output it is talking to
+        struct data_output *output = rpc->val < cfg->output_handler.len ? cfg->output_handler.elems[rpc->val] : NULL;
+        if (output && output->print_data == print_http_data)
+            rpc->response(rpc, -1, "Can't remove HTTP output", 0);
+        else if (remove_output(cfg, rpc->val) < 0)
+            rpc->response(rpc, -1, "Invalid output", 0);
+        else
+            rpc->response(rpc, 0, "Ok", 0);
+    }
+    else if (!strcmp(rpc->method, "hop_frequencies")) {
+        uint32_t frequency[MAX_FREQS];
+        int frequencies = 0;
+        char *p = rpc->arg;
+        while (p && *p && frequencies < MAX_FREQS) {
+            char *endptr = NULL;
+            double val = strtod(p, &endptr);
+            if (p == endptr)
+                break;
+            if (*endptr == 'k' || *endptr == 'K')
+                val *= 1e3;
+            else if (*endptr == 'M' || *endptr == 'm')
+                val *= 1e6;
+            else if (*endptr == 'G' || *endptr == 'g')
+                val *= 1e9;
+            if (*endptr && strchr("kKmMgG", *endptr))
+                endptr++; // skip suffix
+            if (val < 1.0 || val > UINT32_MAX)
+                break;
+            frequency[frequencies++] = (uint32_t)val;
+            p = *endptr == ',' ? endptr + 1 : endptr;
+        }
+        if (!frequencies || (p && *p))
+            rpc->response(rpc, -1, "Invalid frequencies", 0);
+        else {
+            set_hop_frequencies(cfg, frequency, frequencies);
+            rpc->response(rpc, 0, "Ok", 0);
+        }
+    }
+    else if (!strcmp(rpc->method, "decode_budget")) {
+        set_decode_budget(cfg, rpc->val);
+        rpc->response(rpc, 0, "Ok", 0);
+    }
+    else if (!strcmp(rpc->method, "first_match")) {
+        set_first_match(cfg, rpc->val);
+        rpc->response(rpc, 0, "Ok", 0);
+    }
+    else if (!strcmp(rpc->method, "restore_demoted")) {
+        int restored = restore_demoted(cfg, rpc->val);
+        rpc->response(rpc, 2, NULL, restored);
+    }
+    else if (!strcmp(rpc->method, "reload")) {
+        cfg->reload_now = 1; // applied on the main loop
         rpc->response(rpc, 0, "Ok", 0);
     }
 
@@ -678,13 +959,410 @@ struct http_server_context {
     struct mg_serve_http_opts server_opts;
     r_cfg_t *cfg;
     struct data_output *output;
-    ring_list_t *history;
+    event_ring_t *history;
+    list_t ws_codecs;      ///< codecs of the Websocket connections
+    protocols_cache_t protocols;
+};
+
+enum history_mode {
+    HISTORY_WEBSOCKET,
+    HISTORY_CHUNKED,
+    HISTORY_PLAIN,
 };
 
+// per connection encoding and compression
+
+#define NC_F_STREAM MG_F_USER_1 ///< a streaming connection, user_data is a struct nc_context
+#define NC_F_CODEC  MG_F_USER_2 ///< a Websocket connection with a codec in the server list
+
+#define MAX_INFLATE_SIZE (64 * 1024) ///< limit for inflated Websocket messages
+
+/// Encoding state and byte accounting of a Websocket or streaming connection.
+typedef struct {
+    struct mg_connection *nc;
+    char addr[64];       ///< remote address, for the log
+    int binary;          ///< Websocket: send events as CBOR in binary frames
+    int deflate;         ///< Websocket: permessage-deflate, Stream: gzip content encoding
+    int no_context;      ///< Websocket: reset the compressor after each message
+#ifdef ZLIB
+    z_stream tx;
+    z_stream rx;
+    int rx_ready;
+#endif
+    uint8_t *out;        ///< compressor output
+    size_t out_size;
+    uint64_t messages;
+    uint64_t json_bytes; ///< payload bytes as plain JSON
+    uint64_t sent_bytes; ///< payload bytes actually sent
+} nc_codec_t;
+
+static nc_codec_t *codec_new(struct mg_connection *nc)
+{
+    nc_codec_t *codec = calloc(1, sizeof(*codec));
+    if (!codec) {
+        WARN_CALLOC("codec_new()");
+        return NULL;
+    }
+    codec->nc = nc;
+    mg_conn_addr_to_str(nc, codec->addr, sizeof(codec->addr), MG_SOCK_STRINGIFY_IP | MG_SOCK_STRINGIFY_PORT | MG_SOCK_STRINGIFY_REMOTE);
+    return codec;
+}
+
+static void codec_free(void *p)
+{
+    nc_codec_t *codec = p;
+    if (!codec)
+        return;
+
+#ifdef ZLIB
+    if (codec->deflate)
+        deflateEnd(&codec->tx);
+    if (codec->rx_ready)
+        inflateEnd(&codec->rx);
+#endif
+    free(codec->out);
+    free(codec);
+}
+
+static void codec_log_stats(nc_codec_t const *codec, char const *kind)
+{
+    uint64_t saved = codec->json_bytes > codec->sent_bytes ? codec->json_bytes - codec->sent_bytes : 0;
+    print_logf(LOG_INFO, "HTTP server", "%s %s closed, %llu messages, %llu bytes sent for %llu bytes of JSON (%.0f%% saved)",
+            kind, codec->addr, (unsigned long long)codec->messages,
+            (unsigned long long)codec->sent_bytes, (unsigned long long)codec->json_bytes,
+            codec->json_bytes ? 100.0 * saved / codec->json_bytes : 0.0);
+}
+
+#ifdef ZLIB
+/// Start compression with a raw deflate (Websocket) or gzip (Stream) window of @p window_bits.
+static int codec_deflate_init(nc_codec_t *codec, int window_bits, int gzip)
+{
+    if (deflateInit2(&codec->tx, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                gzip ? 16 + window_bits : -window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        print_log(LOG_WARNING, "HTTP server", "Failed to initialize the compressor");
+        return -1;
+    }
+    codec->deflate = 1;
+    return 0;
+}
+
+/// Compress a message with Z_SYNC_FLUSH or Z_FINISH, returns the compressed length or 0 on error.
+/// The output stays valid until the next call.
+static size_t codec_deflate(nc_codec_t *codec, void const *src, size_t len, int flush)
+{
+    size_t pos = 0;
+    codec->tx.next_in  = (Bytef *)src;
+    codec->tx.avail_in = (uInt)len;
+    for (;;) {
+        if (codec->out_size - pos < 64) {
+            size_t size = codec->out_size ? codec->out_size * 2 : 4096;
+            uint8_t *out = realloc(codec->out, size);
+            if (!out) {
+                WARN_REALLOC("codec_deflate()");
+                return 0;
+            }
+            codec->out      = out;
+            codec->out_size = size;
+        }
+        codec->tx.next_out  = codec->out + pos;
+        codec->tx.avail_out = (uInt)(codec->out_size - pos);
+        int ret = deflate(&codec->tx, flush);
+        pos = codec->out_size - codec->tx.avail_out;
+        if (ret == Z_STREAM_END)
+            break;
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return 0;
+        if (flush != Z_FINISH && codec->tx.avail_out > 0)
+            break; // all input consumed and flushed
+    }
+    if (codec->no_context)
+        deflateReset(&codec->tx);
+    return pos;
+}
+
+/// Inflate a permessage-deflate message, returns the inflated message (to be freed) or NULL on error.
+static char *codec_inflate(nc_codec_t *codec, uint8_t const *src, size_t len, size_t *out_len)
+{
+    static uint8_t const tail[4] = {0x00, 0x00, 0xff, 0xff};
+
+    if (!codec->rx_ready) {
+        if (inflateInit2(&codec->rx, -15) != Z_OK)
+            return NULL;
+        codec->rx_ready = 1;
+    }
+
+    char *out = malloc(MAX_INFLATE_SIZE + 1);
+    if (!out) {
+        WARN_MALLOC("codec_inflate()");
+        return NULL;
+    }
+    codec->rx.next_out  = (Bytef *)out;
+    codec->rx.avail_out = MAX_INFLATE_SIZE;
+    // the sender strips the empty stored block of the flush, append it again
+    uint8_t const *parts[2] = {src, tail};
+    size_t lens[2]          = {len, sizeof(tail)};
+    for (int i = 0; i < 2; ++i) {
+        codec->rx.next_in  = (Bytef *)parts[i];
+        codec->rx.avail_in = (uInt)lens[i];
+        int ret = inflate(&codec->rx, Z_SYNC_FLUSH);
+        if ((ret != Z_OK && ret != Z_BUF_ERROR) || codec->rx.avail_in > 0) {
+            free(out);
+            return NULL; // corrupt or too large
+        }
+    }
+    *out_len      = MAX_INFLATE_SIZE - codec->rx.avail_out;
+    out[*out_len] = '\0';
+    return out;
+}
+#endif
+
+/// Send a Websocket frame, sets RSV1 for a compressed message.
+static void ws_send_frame(struct mg_connection *nc, int op, int compressed, void const *data, size_t len)
+{
+    if (!compressed) {
+        mg_send_websocket_frame(nc, op, data, len);
+        return;
+    }
+    // mongoose masks the RSV bits off, build the header here, server frames are not masked
+    uint8_t header[10];
+    size_t header_len = 2;
+    header[0] = (uint8_t)(0x80 | 0x40 | op); // FIN, RSV1
+    if (len < 126) {
+        header[1] = (uint8_t)len;
+    }
+    else if (len < 65536) {
+        header[1]  = 126;
+        header_len = 4;
+    }
+    else {
+        header[1]  = 127;
+        header_len = 10;
+    }
+    uint64_t v = len;
+    for (size_t i = header_len; i > 2; --i, v >>= 8)
+        header[i - 1] = (uint8_t)v;
+    mg_send(nc, header, header_len);
+    mg_send(nc, data, len);
+}
+
+/// Send a message on a Websocket, compressed if negotiated, @p json_len is the length as JSON for accounting.
+static void codec_ws_send(nc_codec_t *codec, struct mg_connection *nc, int op, void const *msg, size_t len, size_t json_len)
+{
+    if (!codec) {
+        mg_send_websocket_frame(nc, op, msg, len);
+        return;
+    }
+    codec->messages += 1;
+    codec->json_bytes += json_len;
+#ifdef ZLIB
+    if (codec->deflate) {
+        size_t out_len = codec_deflate(codec, msg, len, Z_SYNC_FLUSH);
+        // strip the 00 00 ff ff of the sync flush (RFC 7692 7.2.1)
+        if (out_len >= 4) {
+            ws_send_frame(nc, op, 1, codec->out, out_len - 4);
+            codec->sent_bytes += out_len - 4;
+            return;
+        }
+        print_log(LOG_WARNING, "HTTP server", "Compression failed, closing Websocket");
+        nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+        return;
+    }
+#endif
+    ws_send_frame(nc, op, 0, msg, len);
+    codec->sent_bytes += len;
+}
+
+/// Send a message on a stream, compressed if negotiated, chunked if @p chunked is set.
+static void codec_stream_send(nc_codec_t *codec, struct mg_connection *nc, int chunked, void const *msg, size_t len)
+{
+    codec->messages += 1;
+    codec->json_bytes += len;
+#ifdef ZLIB
+    if (codec->deflate) {
+        size_t out_len = codec_deflate(codec, msg, len, Z_SYNC_FLUSH);
+        if (!out_len) {
+            print_log(LOG_WARNING, "HTTP server", "Compression failed, closing stream");
+            nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+            return;
+        }
+        msg = codec->out;
+        len = out_len;
+    }
+#endif
+    if (chunked)
+        mg_send_http_chunk(nc, msg, len);
+    else
+        mg_send(nc, msg, len);
+    codec->sent_bytes += len;
+}
+
+/// End a stream, a compressed stream needs the trailer.
+static void codec_stream_end(nc_codec_t *codec, struct mg_connection *nc, int chunked)
+{
+#ifdef ZLIB
+    if (codec->deflate) {
+        size_t out_len = codec_deflate(codec, NULL, 0, Z_FINISH);
+        if (chunked)
+            mg_send_http_chunk(nc, (char const *)codec->out, out_len);
+        else
+            mg_send(nc, codec->out, out_len);
+        codec->sent_bytes += out_len;
+    }
+#else
+    UNUSED(codec);
+#endif
+    if (chunked)
+        mg_send_http_chunk(nc, "", 0); /* Send empty chunk, the end of response */
+}
+
+static nc_codec_t *ws_codec(struct http_server_context *srv, struct mg_connection *nc)
+{
+    if (!(nc->flags & NC_F_CODEC))
+        return NULL;
+    for (size_t i = 0; i < srv->ws_codecs.len; ++i) {
+        nc_codec_t *codec = srv->ws_codecs.elems[i];
+        if (codec->nc == nc)
+            return codec;
+    }
+    return NULL;
+}
+
+#ifdef ZLIB
+/// Parse one permessage-deflate offer (RFC 7692), returns 1 if it is acceptable.
+static int parse_deflate_offer(char *offer, int *no_context, int *window_bits)
+{
+    char *name = trim_ws(asepc(&offer, ';'));
+    if (strcmp(name, "permessage-deflate"))
+        return 0;
+
+    *no_context  = 0;
+    *window_bits = 0;
+    while (offer) {
+        char *key = trim_ws(asepc(&offer, ';'));
+        char *val = strchr(key, '=');
+        if (val) {
+            *val++ = '\0';
+            key    = trim_ws(key);
+            val    = trim_ws(val);
+            if (*val == '"' && val[1] && val[strlen(val) - 1] == '"') {
+                val[strlen(val) - 1] = '\0';
+                val++;
+            }
+        }
+        if (!strcmp(key, "server_no_context_takeover")) {
+            *no_context = 1;
+        }
+        else if (!strcmp(key, "server_max_window_bits")) {
+            int bits = val ? atoi(val) : 0;
+            if (bits < 9 || bits > 15)
+                return 0; // zlib has no 256 byte window
+            *window_bits = bits;
+        }
+        else if (strcmp(key, "client_no_context_takeover") && strcmp(key, "client_max_window_bits")) {
+            return 0; // the client parameters are hints only, our inflater handles any window
+        }
+    }
+    return 1;
+}
+
+/// Find an acceptable permessage-deflate offer in a Sec-WebSocket-Extensions header.
+static int find_deflate_offer(struct mg_str const *ext, int *no_context, int *window_bits)
+{
+    char buf[256];
+    if (ext->len >= sizeof(buf))
+        return 0;
+    memcpy(buf, ext->p, ext->len);
+    buf[ext->len] = '\0';
+
+    char *p = buf;
+    while (p) {
+        if (parse_deflate_offer(asepc(&p, ','), no_context, window_bits))
+            return 1;
+    }
+    return 0;
+}
+#endif
+
+// ws://127.0.0.1:8433/ws?format=cbor with permessage-deflate
+static void handle_ws_handshake(struct mg_connection *nc, struct http_message *hm)
+{
+    struct http_server_context *srv = nc->user_data;
+
+    nc_codec_t *codec = codec_new(nc);
+    if (!codec)
+        return; // NOTE: a plain Websocket without accounting on alloc failure.
+    char format[8];
+    codec->binary = mg_get_http_var(&hm->query_string, "format", format, sizeof(format)) > 0
+            && !strcmp(format, "cbor");
+    list_push(&srv->ws_codecs, codec);
+    nc->flags |= NC_F_CODEC;
+
+#ifdef ZLIB
+    int no_context, window_bits;
+    struct mg_str *ext = mg_get_http_header(hm, "Sec-WebSocket-Extensions");
+    struct mg_str *key = mg_get_http_header(hm, "Sec-WebSocket-Key");
+    if (!ext || !key || !find_deflate_offer(ext, &no_context, &window_bits)
+            || codec_deflate_init(codec, window_bits ? window_bits : 15, 0))
+        return; // mongoose sends the plain handshake
+    codec->no_context = no_context;
+
+    // the handshake of mongoose with the extension response added
+    static char const magic[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t const *msgs[2] = {(uint8_t const *)key->p, (uint8_t const *)magic};
+    size_t const msg_lens[2] = {key->len, sizeof(magic) - 1};
+    unsigned char sha[20];
+    char b64_sha[30];
+    mg_hash_sha1_v(2, msgs, msg_lens, sha);
+    mg_base64_encode(sha, sizeof(sha), b64_sha);
+
+    mg_printf(nc, "HTTP/1.1 101 Switching Protocols\r\n"
+                  "Upgrade: websocket\r\n"
+                  "Connection: Upgrade\r\n");
+    struct mg_str *proto = mg_get_http_header(hm, "Sec-WebSocket-Protocol");
+    if (proto)
+        mg_printf(nc, "Sec-WebSocket-Protocol: %.*s\r\n", (int)proto->len, proto->p);
+    mg_printf(nc, "Sec-WebSocket-Extensions: permessage-deflate%s", no_context ? "; server_no_context_takeover" : "");
+    if (window_bits)
+        mg_printf(nc, "; server_max_window_bits=%d", window_bits);
+    mg_printf(nc, "\r\nSec-WebSocket-Accept: %s\r\n\r\n", b64_sha);
+#endif
+}
+
+/// Parse the Accept-Encoding header of a stream request, set up gzip if accepted.
+static void stream_negotiate(nc_codec_t *codec, struct http_message *hm)
+{
+#ifdef ZLIB
+    struct mg_str *accept = mg_get_http_header(hm, "Accept-Encoding");
+    if (!accept)
+        return;
+    char buf[256];
+    if (accept->len >= sizeof(buf))
+        return;
+    memcpy(buf, accept->p, accept->len);
+    buf[accept->len] = '\0';
+
+    char *p = buf;
+    while (p) {
+        char *coding = asepc(&p, ',');
+        char *name   = trim_ws(asepc(&coding, ';'));
+        char *q      = coding ? strstr(coding, "q=") : NULL;
+        if (!strcmp(name, "gzip") && !(q && atof(q + 2) == 0.0)) {
+            codec_deflate_init(codec, 15, 1);
+            return;
+        }
+    }
+#else
+    UNUSED(codec);
+    UNUSED(hm);
+#endif
+}
+
 struct nc_context {
     int is_chunked;
+    nc_codec_t *codec;
 };
 
+
 static void handle_options(struct mg_connection *nc, struct http_message *hm)
 {
     UNUSED(hm);
@@ -751,7 +1429,9 @@ static void rpc_response_ws(rpc_t *rpc, int ret_code, char const *message, int a
                 "{\"result\": null}");
     }
     else if (ret_code == 1) {
-        mg_send_websocket_frame(rpc->nc, WEBSOCKET_OP_TEXT, message, strlen(message));
+        // potentially large, e.g. the protocol list, compress if negotiated
+        size_t len = strlen(message);
+        codec_ws_send(ws_codec(rpc->nc->user_data, rpc->nc), rpc->nc, WEBSOCKET_OP_TEXT, message, len, len);
     }
     else if (ret_code == 2) {
         mg_printf_websocket_frame(rpc->nc, WEBSOCKET_OP_TEXT,
@@ -837,23 +1517,193 @@ static void rpc_response_jsoncmd(rpc_t *rpc, int ret_code, char const *message,
     mg_send_http_chunk(rpc->nc, "", 0); /* Send empty chunk, the end of response */
 }
 
+/// Sequence number of the first record after @p since that is still available.
+static uint64_t event_ring_first_seq(event_ring_t const *ring, uint64_t since)
+{
+    uint64_t seq = since + 1 > ring->seq ? since + 1 : ring->seq;
+    return seq < event_ring_next_seq(ring) ? seq : event_ring_next_seq(ring);
+}
+
+/// Replay records after sequence number @p since, always as JSON, @p codec is optional.
+static void send_history(struct mg_connection *nc, nc_codec_t *codec, event_ring_t const *ring, uint64_t since, int mode)
+{
+    uint64_t seq = event_ring_first_seq(ring, since);
+    if (seq >= event_ring_next_seq(ring))
+        return;
+
+    if (mode == HISTORY_CHUNKED && !codec->deflate) {
+        // records are stored as HTTP chunks, send the spans verbatim
+        char const *span1, *span2;
+        size_t len1, len2;
+        event_ring_spans(ring, since, &span1, &len1, &span2, &len2);
+        mg_send(nc, span1, len1);
+        mg_send(nc, span2, len2);
+        codec->messages += event_ring_next_seq(ring) - seq;
+        codec->json_bytes += len1 + len2;
+        codec->sent_bytes += len1 + len2;
+        return;
+    }
+
+    int skipped_wrap;
+    size_t pos = event_ring_find(ring, since, &skipped_wrap);
+    for (uint64_t i = seq; i < event_ring_next_seq(ring); ++i) {
+        char const *json;
+        size_t json_len;
+        pos += event_ring_record(&ring->buf[pos], &json, &json_len);
+        if (mode == HISTORY_WEBSOCKET)
+            codec_ws_send(codec, nc, WEBSOCKET_OP_TEXT, json, json_len, json_len);
+        else
+            codec_stream_send(codec, nc, mode == HISTORY_CHUNKED, json, json_len + 2); // with line end
+        if (ring->wrapped && !skipped_wrap && pos >= ring->end) {
+            pos          = 0;
+            skipped_wrap = 1;
+        }
+    }
+}
+
+/// Parse the optional "since" query var, returns -1 if not given.
+static int get_since_var(struct http_message *hm, uint64_t *since)
+{
+    char buf[24];
+    if (mg_get_http_var(&hm->query_string, "since", buf, sizeof(buf)) <= 0)
+        return -1;
+    *since = strtoull(buf, NULL, 10);
+    return 0;
+}
+
+// http :8433/topology format==graphml
+static void handle_topology(struct mg_connection *nc, struct http_message *hm)
+{
+    struct http_server_context *srv = nc->user_data;
+    char fmt[16];
+    int format = MESH_TOPOLOGY_JSON;
+    if (mg_get_http_var(&hm->query_string, "format", fmt, sizeof(fmt)) > 0 && !strcmp(fmt, "graphml"))
+        format = MESH_TOPOLOGY_GRAPHML;
+
+    mesh_topology_expire(srv->cfg->mesh, time(NULL));
+
+    size_t size = 65536;
+    for (;;) {
+        char *buf = malloc(size);
+        if (!buf) {
+            WARN_MALLOC("handle_topology()");
+            mg_printf(nc, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
+            return;
+        }
+        size_t len = mesh_topology_print(srv->cfg->mesh, format, buf, size);
+        if (len + 1 < size) {
+            mg_printf(nc,
+                    "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: %s\r\n"
+                    "Access-Control-Allow-Origin: *\r\n"
+                    "Content-Length: %u\r\n"
+                    "\r\n",
+                    format == MESH_TOPOLOGY_GRAPHML ? "application/graphml+xml" : "application/json",
+                    (unsigned)len);
+            mg_send(nc, buf, len);
+            free(buf);
+            return;
+        }
+        free(buf); // truncated, retry larger
+        size *= 2;
+    }
+}
+
+// http :8433/store model==LandisGyr-GS id==1a2b3c4d
+static void handle_store(struct mg_connection *nc, struct http_message *hm)
+{
+    struct http_server_context *srv = nc->user_data;
+    if (!srv->cfg->event_store) {
+        mg_printf(nc, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+        return;
+    }
+
+    char model[64] = {0};
+    char id[64]    = {0};
+    char num[24];
+    event_store_query_t query = {0};
+    if (mg_get_http_var(&hm->query_string, "model", model, sizeof(model)) > 0)
+        query.model = model;
+    if (mg_get_http_var(&hm->query_string, "id", id, sizeof(id)) > 0)
+        query.id = id;
+    if (mg_get_http_var(&hm->query_string, "from", num, sizeof(num)) > 0)
+        query.from = (time_t)strtoll(num, NULL, 10);
+    if (mg_get_http_var(&hm->query_string, "to", num, sizeof(num)) > 0)
+        query.to = (time_t)strtoll(num, NULL, 10);
+    if (mg_get_http_var(&hm->query_string, "limit", num, sizeof(num)) > 0)
+        query.limit = (unsigned)strtoul(num, NULL, 10);
+    if (mg_get_http_var(&hm->query_string, "cursor", num, sizeof(num)) > 0)
+        query.cursor = strtoull(num, NULL, 10);
+
+    size_t size = 65536;
+    for (;;) {
+        char *buf = malloc(size);
+        if (!buf) {
+            WARN_MALLOC("handle_store()");
+            mg_printf(nc, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
+            return;
+        }
+        size_t len = event_store_query(srv->cfg->event_store, &query, buf, size);
+        if (len + 1 < size) {
+            mg_printf(nc,
+                    "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Access-Control-Allow-Origin: *\r\n"
+                    "Content-Length: %u\r\n"
+                    "\r\n",
+                    (unsigned)len);
+            mg_send(nc, buf, len);
+            free(buf);
+            return;
+        }
+        free(buf); // truncated, retry larger
+        size *= 2;
+    }
+}
+
+/// Mark a streaming connection, the context replaces the server as user data.
+static struct nc_context *stream_context_new(struct mg_connection *nc, struct http_message *hm, int is_chunked)
+{
+    struct nc_context *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        WARN_CALLOC("stream_context_new()");
+        return NULL;
+    }
+    ctx->codec = codec_new(nc);
+    if (!ctx->codec) {
+        free(ctx);
+        return NULL;
+    }
+    stream_negotiate(ctx->codec, hm);
+    ctx->is_chunked = is_chunked;
+    nc->user_data   = ctx;
+    nc->flags |= NC_F_STREAM;
+    return ctx;
+}
+
 // {"cmd":"sample_rate","val":1024000}
 // http --stream --timeout=70 :8433/events
+// http --stream --timeout=70 ':8433/events?since=0'
 //s.a. https://developer.twitter.com/en/docs/tutorials/consuming-streaming-data.html
 static void handle_json_events(struct mg_connection *nc, struct http_message *hm)
 {
-    UNUSED(hm);
-    /* Send headers */
-    mg_printf(nc, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n");
+    struct http_server_context *srv = nc->user_data;
+    event_ring_t *history = srv->history;
+    uint64_t since;
+    int replay = get_since_var(hm, &since) == 0;
+    uint64_t first = replay ? event_ring_first_seq(history, since) : event_ring_next_seq(history);
 
     /* Mark connection */
-    struct nc_context *ctx = calloc(1, sizeof(*ctx));
-    if (!ctx) {
-        WARN_CALLOC("handle_json_events()");
+    struct nc_context *ctx = stream_context_new(nc, hm, 1);
+    if (!ctx)
         return;
-    }
-    ctx->is_chunked = 1;
-    nc->user_data   = ctx;
+
+    /* Send headers */
+    mg_printf(nc, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n%sX-Event-Seq: %llu\r\n\r\n",
+            ctx->codec->deflate ? "Content-Encoding: gzip\r\n" : "", (unsigned long long)first);
+
+    if (replay)
+        send_history(nc, ctx->codec, history, since, HISTORY_CHUNKED);
 
     mg_set_timer(nc, mg_time() + KEEP_ALIVE); // set keep alive timer
 }
@@ -861,18 +1711,23 @@ static void handle_json_events(struct mg_connection *nc, struct http_message *hm
 // (echo "GET /stream HTTP/1.0\n"; sleep 600) | socat - tcp:127.0.0.1:8433
 static void handle_json_stream(struct mg_connection *nc, struct http_message *hm)
 {
-    UNUSED(hm);
-    /* Send headers */
-    mg_printf(nc, "HTTP/1.1 200 OK\r\n\r\n");
+    struct http_server_context *srv = nc->user_data;
+    event_ring_t *history = srv->history;
+    uint64_t since;
+    int replay = get_since_var(hm, &since) == 0;
+    uint64_t first = replay ? event_ring_first_seq(history, since) : event_ring_next_seq(history);
 
     /* Mark connection */
-    struct nc_context *ctx = calloc(1, sizeof(*ctx));
-    if (!ctx) {
-        WARN_CALLOC("handle_json_stream()");
+    struct nc_context *ctx = stream_context_new(nc, hm, 0);
+    if (!ctx)
         return;
-    }
-    ctx->is_chunked = 0;
-    nc->user_data   = ctx;
+
+    /* Send headers */
+    mg_printf(nc, "HTTP/1.1 200 OK\r\n%sX-Event-Seq: %llu\r\n\r\n",
+            ctx->codec->deflate ? "Content-Encoding: gzip\r\n" : "", (unsigned long long)first);
+
+    if (replay)
+        send_history(nc, ctx->codec, history, since, HISTORY_PLAIN);
 
     mg_set_timer(nc, mg_time() + KEEP_ALIVE); // set keep alive timer
 }
@@ -891,6 +1746,7 @@ static void handle_cmd_rpc(struct mg_connection *nc, struct http_message *hm)
             .response = rpc_response_jsoncmd,
             .method = cmd,
             .arg = arg,
+            .protocols = &ctx->protocols,
     };
 
     /* Send headers */
@@ -922,8 +1778,9 @@ static void handle_json_rpc(struct mg_connection *nc, struct http_message *hm)
     struct http_server_context *ctx = nc->user_data;
 
     rpc_t rpc = {
-            .nc       = nc,
-            .response = rpc_response_jsonrpc,
+            .nc        = nc,
+            .response  = rpc_response_jsonrpc,
+            .protocols = &ctx->protocols,
     };
 
     /* Send headers */
@@ -950,15 +1807,40 @@ static void handle_ws_rpc(struct mg_connection *nc, struct websocket_message *wm
     struct http_server_context *ctx = nc->user_data;
 
     rpc_t rpc = {
-            .nc       = nc,
-            .response = rpc_response_ws,
+            .nc        = nc,
+            .response  = rpc_response_ws,
+            .protocols = &ctx->protocols,
     };
 
     struct mg_str d = {(char *)wm->data, wm->size};
 
+    nc_codec_t *codec = ws_codec(ctx, nc);
+    char *inflated    = NULL;
+#ifdef ZLIB
+    if (codec && codec->deflate && (wm->flags & 0x40)) { // RSV1 marks a compressed message
+        inflated = codec_inflate(codec, wm->data, wm->size, &d.len);
+        if (!inflated) {
+            mg_send_websocket_frame(nc, WEBSOCKET_OP_CLOSE, "\x03\xefinvalid compressed message", 28);
+            nc->flags |= MG_F_SEND_AND_CLOSE;
+            return;
+        }
+        d.p = inflated;
+    }
+#endif
+
     /* Parse JSON */
     int ret = json_parse(&rpc, &d);
-    if (!ret) {
+    if (!ret && codec && rpc.method && !strcmp(rpc.method, "get_ws_stats")) {
+        uint64_t saved = codec->json_bytes > codec->sent_bytes ? codec->json_bytes - codec->sent_bytes : 0;
+        char buf[256];
+        int len = snprintf(buf, sizeof(buf),
+                "{\"result\": {\"format\": \"%s\", \"deflate\": %s, \"messages\": %llu, \"json_bytes\": %llu, \"sent_bytes\": %llu, \"saved_bytes\": %llu}}",
+                codec->binary ? "cbor" : "json", codec->deflate ? "true" : "false",
+                (unsigned long long)codec->messages, (unsigned long long)codec->json_bytes,
+                (unsigned long long)codec->sent_bytes, (unsigned long long)saved);
+        codec_ws_send(codec, nc, WEBSOCKET_OP_TEXT, buf, (size_t)len, (size_t)len);
+    }
+    else if (!ret) {
         rpc_exec(&rpc, ctx->cfg);
     }
     else {
@@ -969,6 +1851,7 @@ static void handle_ws_rpc(struct mg_connection *nc, struct websocket_message *wm
     free(rpc.method);
     free(rpc.id);
     free(rpc.arg);
+    free(inflated);
 }
 
 static void ev_handler(struct mg_connection *nc, int ev, void *ev_data);
@@ -978,16 +1861,11 @@ static void send_keep_alive(struct mg_connection *nc)
     if (nc->handler != ev_handler)
         return; // this should not happen
 
-    struct nc_context *ctx = nc->user_data;
-    if (!ctx)
+    if (!(nc->flags & NC_F_STREAM))
         return; // this should not happen
 
-    if (ctx->is_chunked) {
-        mg_send_http_chunk(nc, "\r\n", 2);
-    }
-    else {
-        mg_send(nc, "\r\n", 2);
-    }
+    struct nc_context *ctx = nc->user_data;
+    codec_stream_send(ctx->codec, nc, ctx->is_chunked, "\r\n", 2);
     mg_set_timer(nc, mg_time() + KEEP_ALIVE); // reset keep alive timer
 }
 
@@ -997,6 +1875,12 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data)
     case MG_EV_TIMER:
         send_keep_alive(nc);
         break;
+    case MG_EV_WEBSOCKET_HANDSHAKE_REQUEST: {
+        struct http_message *hm = (struct http_message *)ev_data;
+
+        handle_ws_handshake(nc, hm);
+        break;
+    }
     case MG_EV_WEBSOCKET_HANDSHAKE_DONE: {
         struct http_server_context *ctx = nc->user_data;
         /* New websocket connection. Send meta. */
@@ -1004,8 +1888,7 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data)
         data_output_print(ctx->output, meta);
         data_free(meta);
         /* Send history */
-        for (void **iter = ring_list_iter(ctx->history); iter; iter = ring_list_next(ctx->history, iter))
-            mg_send_websocket_frame(nc, WEBSOCKET_OP_TEXT, (char *)*iter, strlen((char *)*iter));
+        send_history(nc, ws_codec(ctx, nc), ctx->history, 0, HISTORY_WEBSOCKET);
         break;
     }
     case MG_EV_WEBSOCKET_FRAME: {
@@ -1039,6 +1922,12 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data)
         else if (mg_vcmp(&hm->uri, "/stream") == 0) {
             handle_json_stream(nc, hm);
         }
+        else if (mg_vcmp(&hm->uri, "/topology") == 0) {
+            handle_topology(nc, hm);
+        }
+        else if (mg_vcmp(&hm->uri, "/store") == 0) {
+            handle_store(nc, hm);
+        }
         else if (mg_vcmp(&hm->uri, "/api") == 0) {
             //handle_api_query(nc, hm);
         }
@@ -1052,6 +1941,24 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data)
     }
     case MG_EV_CLOSE:
         //fprintf(stderr, "MG_EV_CLOSE %p %p %p\n", ev_data, nc, nc->user_data);
+        if (nc->flags & NC_F_STREAM) {
+            struct nc_context *cctx = nc->user_data;
+            codec_log_stats(cctx->codec, "Stream");
+            codec_free(cctx->codec);
+            free(cctx);
+            nc->user_data = NULL;
+        }
+        else if (nc->flags & NC_F_CODEC) {
+            struct http_server_context *ctx = nc->user_data;
+            for (size_t i = 0; i < ctx->ws_codecs.len; ++i) {
+                nc_codec_t *codec = ctx->ws_codecs.elems[i];
+                if (codec->nc == nc) {
+                    codec_log_stats(codec, "Websocket");
+                    list_remove(&ctx->ws_codecs, i, codec_free);
+                    break;
+                }
+            }
+        }
         break;
     default:
         break;
@@ -1063,39 +1970,57 @@ static int is_websocket(const struct mg_connection *nc)
     return nc->flags & MG_F_IS_WEBSOCKET;
 }
 
-// event handler to broadcast to all our sockets
-static void http_broadcast_send(struct http_server_context *ctx, char const *msg, size_t len)
+// event handler to broadcast to all our sockets, @p data is encoded as CBOR for binary Websockets
+static void http_broadcast_send(struct http_server_context *ctx, data_t *data, char const *msg, size_t len)
 {
     struct mg_connection *nc;
     struct mg_mgr *mgr = ctx->conn->mgr;
 
-    char *dup = strdup(msg);
-    if (!dup) {
-        WARN_STRDUP("http_broadcast_send()");
-    }
-    else {
-        free(ring_list_push(ctx->history, dup));
-    }
+    char const *rec = event_ring_push(ctx->history, msg, len);
+    char const *json = msg;
+    size_t json_len  = len;
+    size_t rec_len   = rec ? event_ring_record(rec, &json, &json_len) : 0;
+
+    uint8_t *cbor    = NULL; // encoded once on the first binary Websocket
+    size_t cbor_len  = 0;
 
     for (nc = mg_next(mgr, NULL); nc != NULL; nc = mg_next(mgr, nc)) {
         if (nc->handler != ev_handler)
             continue;
 
-        struct nc_context *cctx = nc->user_data; // might not be valid
         if (is_websocket(nc)) {
-            mg_send_websocket_frame(nc, WEBSOCKET_OP_TEXT, msg, len);
-        }
-        else if (cctx && cctx->is_chunked) {
-            mg_send_http_chunk(nc, msg, len);
-            mg_send_http_chunk(nc, "\r\n", 2);
-            mg_set_timer(nc, mg_time() + KEEP_ALIVE); // reset keep alive timer
+            nc_codec_t *codec = ws_codec(ctx, nc);
+            if (codec && codec->binary && data && !cbor) {
+                cbor_len = data_print_cbor(data, NULL, 0);
+                cbor     = malloc(cbor_len);
+                if (!cbor)
+                    WARN_MALLOC("http_broadcast_send()"); // NOTE: falls back to JSON on alloc failure.
+                else
+                    data_print_cbor(data, cbor, cbor_len);
+            }
+            if (codec && codec->binary && cbor)
+                codec_ws_send(codec, nc, WEBSOCKET_OP_BINARY, cbor, cbor_len, len);
+            else
+                codec_ws_send(codec, nc, WEBSOCKET_OP_TEXT, msg, len, len);
         }
-        else if (cctx && !cctx->is_chunked) {
-            mg_send(nc, msg, len);
-            mg_send(nc, "\r\n", 2);
+        else if (nc->flags & NC_F_STREAM) {
+            struct nc_context *cctx = nc->user_data;
+            if (rec && cctx->is_chunked && !cctx->codec->deflate) {
+                mg_send(nc, rec, rec_len); // the record is a complete chunk
+                cctx->codec->json_bytes += json_len + 2;
+                cctx->codec->sent_bytes += json_len + 2;
+            }
+            else if (rec) {
+                codec_stream_send(cctx->codec, nc, cctx->is_chunked, json, json_len + 2); // with line end
+            }
+            else {
+                codec_stream_send(cctx->codec, nc, cctx->is_chunked, msg, len);
+                codec_stream_send(cctx->codec, nc, cctx->is_chunked, "\r\n", 2);
+            }
             mg_set_timer(nc, mg_time() + KEEP_ALIVE); // reset keep alive timer
         }
     }
+    free(cbor);
 }
 
 static struct http_server_context *http_server_start(struct mg_mgr *mgr, char const *host, char const *port, r_cfg_t *cfg, struct data_output *output)
@@ -1112,7 +2037,11 @@ static struct http_server_context *http_server_start(struct mg_mgr *mgr, char co
 
     ctx->cfg     = cfg;
     ctx->output  = output;
-    ctx->history = ring_list_new(DEFAULT_HISTORY_SIZE);
+    ctx->history = event_ring_new(DEFAULT_HISTORY_BYTES);
+    if (!ctx->history) {
+        free(ctx);
+        return NULL;
+    }
 
     char address[253 + 6 + 1]; // dns max + port
     // if the host is an IPv6 address it needs quoting
@@ -1130,6 +2059,7 @@ static struct http_server_context *http_server_start(struct mg_mgr *mgr, char co
     if (ctx->conn == NULL) {
         print_logf(LOG_ERROR, __func__, "Error starting server on address %s: %s", address,
                 *bind_opts.error_string);
+        event_ring_free(ctx->history);
         free(ctx);
         return NULL;
     }
@@ -1161,24 +2091,22 @@ static int http_server_stop(struct http_server_context *ctx)
         if (nc->handler != ev_handler)
             continue;
 
-        struct nc_context *cctx = nc->user_data; // might not be valid
         if (is_websocket(nc)) {
-            mg_send_websocket_frame(nc, WEBSOCKET_OP_TEXT, SHUTDOWN_JSON, sizeof(SHUTDOWN_JSON) - 1);
-        }
-        else if (cctx && cctx->is_chunked) {
-            mg_send_http_chunk(nc, SHUTDOWN_JSON, sizeof(SHUTDOWN_JSON) - 1);
-            mg_send_http_chunk(nc, "\r\n", 2);
-            mg_send_http_chunk(nc, "", 0);            /* Send empty chunk, the end of response */
+            codec_ws_send(ws_codec(ctx, nc), nc, WEBSOCKET_OP_TEXT, SHUTDOWN_JSON, sizeof(SHUTDOWN_JSON) - 1, sizeof(SHUTDOWN_JSON) - 1);
+            nc->flags &= ~NC_F_CODEC; // the codec goes with the server
         }
-        else if (cctx && !cctx->is_chunked) {
-            mg_send(nc, SHUTDOWN_JSON, sizeof(SHUTDOWN_JSON) - 1);
-            mg_send(nc, "\r\n", 2);
+        else if (nc->flags & NC_F_STREAM) {
+            struct nc_context *cctx = nc->user_data;
+            codec_stream_send(cctx->codec, nc, cctx->is_chunked, SHUTDOWN_JSON "\r\n", sizeof(SHUTDOWN_JSON) + 1);
+            codec_stream_end(cctx->codec, nc, cctx->is_chunked);
+            nc->flags |= MG_F_SEND_AND_CLOSE;
         }
     }
+    list_free_elems(&ctx->ws_codecs, codec_free);
 
-    for (void **iter = ring_list_iter(ctx->history); iter; iter = ring_list_next(ctx->history, iter))
-        free((data_t *)*iter);
-    ring_list_free(ctx->history);
+    event_ring_free(ctx->history);
+
+    free(ctx->protocols.json);
 
     free(ctx);
 
@@ -1208,7 +2136,7 @@ static void R_API_CALLCONV print_http_data(data_output_t *output, data_t *data,
         // "events"
         char buf[2048]; // we expect the biggest strings to be around 500 bytes.
         size_t len = data_print_jsons(data, buf, sizeof(buf));
-        http_broadcast_send(http->server, buf, len);
+        http_broadcast_send(http->server, data, buf, len);
     }
     else {
         // "states"
@@ -1219,7 +2147,7 @@ static void R_API_CALLCONV print_http_data(data_output_t *output, data_t *data,
             return; // NOTE: skip output on alloc failure.
         }
         size_t len = data_print_jsons(data, buf, buf_size);
-        http_broadcast_send(http->server, buf, len);
+        http_broadcast_send(http->server, data, buf, len);
         free(buf);
     }
 }
@@ -1250,7 +2178,8 @@ struct data_output *data_output_http_create(struct mg_mgr *mgr, char const *host
 
     http->server = http_server_start(mgr, host, port, cfg, &http->output);
     if (!http->server) {
-        exit(1);
+        free(http);
+        return NULL;
     }
 
     return &http->output;
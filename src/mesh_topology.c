@@ -0,0 +1,476 @@
+/** @file
+    Gridstream mesh topology index.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "mesh_topology.h"
+#include "data.h"
+#include "abuf.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_MAX_NODES 4096
+#define MESH_MAX_EDGES 16384
+#define MESH_MAX_AGE (24 * 3600)
+#define MESH_EXPIRE_INTERVAL 60 // seconds between expiry sweeps on update
+
+#define MESH_ADDR_SIZE 13 // 12 hex digits WAN address and the terminator
+
+enum mesh_kind {
+    MESH_METER,
+    MESH_COLLECTOR,
+};
+
+static char const *const mesh_kind_names[] = {"meter", "collector"};
+
+typedef struct {
+    char addr[MESH_ADDR_SIZE];
+    char wan[MESH_ADDR_SIZE]; ///< the meters own WAN address, if seen
+    char network[5];
+    uint8_t kind;
+    uint32_t count;
+    time_t last_seen;
+} mesh_node_t;
+
+typedef struct {
+    uint32_t src;
+    uint32_t dst;
+    uint32_t count;
+    uint32_t rssi_count;
+    time_t last_seen;
+    float rssi;     ///< last RSSI in dB
+    float rssi_avg; ///< moving average RSSI in dB
+    uint8_t subtype;
+} mesh_edge_t;
+
+struct mesh_topology {
+    unsigned max_nodes;
+    unsigned max_edges;
+    unsigned max_age;
+    unsigned num_nodes;
+    unsigned num_edges;
+    unsigned evicted;
+    time_t last_expire;
+    mesh_node_t *nodes;
+    mesh_edge_t *edges;
+    uint32_t *node_slots; ///< open addressing index, node index plus 1, 0 for empty
+    uint32_t *edge_slots; ///< open addressing index, edge index plus 1, 0 for empty
+    unsigned node_mask;
+    unsigned edge_mask;
+};
+
+static unsigned slots_for(unsigned count)
+{
+    unsigned slots = 16;
+    while (slots < count * 2)
+        slots *= 2;
+    return slots;
+}
+
+mesh_topology_t *mesh_topology_new(unsigned max_nodes, unsigned max_edges, unsigned max_age)
+{
+    mesh_topology_t *topo = calloc(1, sizeof(*topo));
+    if (!topo) {
+        WARN_CALLOC("mesh_topology_new()");
+        return NULL;
+    }
+    topo->max_nodes = max_nodes ? max_nodes : MESH_MAX_NODES;
+    topo->max_edges = max_edges ? max_edges : MESH_MAX_EDGES;
+    topo->max_age   = max_age ? max_age : MESH_MAX_AGE;
+    topo->node_mask = slots_for(topo->max_nodes) - 1;
+    topo->edge_mask = slots_for(topo->max_edges) - 1;
+
+    topo->nodes = calloc(topo->max_nodes, sizeof(*topo->nodes));
+    if (!topo->nodes) {
+        WARN_CALLOC("mesh_topology_new()");
+        mesh_topology_free(topo);
+        return NULL;
+    }
+    topo->edges = calloc(topo->max_edges, sizeof(*topo->edges));
+    if (!topo->edges) {
+        WARN_CALLOC("mesh_topology_new()");
+        mesh_topology_free(topo);
+        return NULL;
+    }
+    topo->node_slots = calloc(topo->node_mask + 1, sizeof(*topo->node_slots));
+    if (!topo->node_slots) {
+        WARN_CALLOC("mesh_topology_new()");
+        mesh_topology_free(topo);
+        return NULL;
+    }
+    topo->edge_slots = calloc(topo->edge_mask + 1, sizeof(*topo->edge_slots));
+    if (!topo->edge_slots) {
+        WARN_CALLOC("mesh_topology_new()");
+        mesh_topology_free(topo);
+        return NULL;
+    }
+
+    return topo;
+}
+
+void mesh_topology_free(mesh_topology_t *topo)
+{
+    if (!topo)
+        return;
+
+    free(topo->nodes);
+    free(topo->edges);
+    free(topo->node_slots);
+    free(topo->edge_slots);
+    free(topo);
+}
+
+/* Index */
+
+static uint32_t hash_addr(char const *addr)
+{
+    uint32_t hash = 2166136261u; // FNV-1a
+    for (; *addr; ++addr)
+        hash = (hash ^ (uint8_t)*addr) * 16777619u;
+    return hash;
+}
+
+static uint32_t hash_link(uint32_t src, uint32_t dst)
+{
+    uint32_t hash = src * 0x9e3779b1u ^ dst;
+    return hash ^ hash >> 15;
+}
+
+/// Find the slot of a node, an empty slot if not found.
+static unsigned node_slot(mesh_topology_t const *topo, char const *addr)
+{
+    unsigned slot = hash_addr(addr) & topo->node_mask;
+    while (topo->node_slots[slot] && strcmp(topo->nodes[topo->node_slots[slot] - 1].addr, addr))
+        slot = (slot + 1) & topo->node_mask;
+    return slot;
+}
+
+/// Find the slot of an edge, an empty slot if not found.
+static unsigned edge_slot(mesh_topology_t const *topo, uint32_t src, uint32_t dst)
+{
+    unsigned slot = hash_link(src, dst) & topo->edge_mask;
+    while (topo->edge_slots[slot]) {
+        mesh_edge_t const *edge = &topo->edges[topo->edge_slots[slot] - 1];
+        if (edge->src == src && edge->dst == dst)
+            break;
+        slot = (slot + 1) & topo->edge_mask;
+    }
+    return slot;
+}
+
+/// Drop nodes and edges last seen before the cutoffs, compact and reindex.
+static void prune(mesh_topology_t *topo, time_t node_cutoff, time_t edge_cutoff)
+{
+    unsigned old_nodes = topo->num_nodes;
+    unsigned old_edges = topo->num_edges;
+
+    // compact nodes, the node slots temporarily map old to new index plus 1
+    unsigned n = 0;
+    for (unsigned i = 0; i < topo->num_nodes; ++i) {
+        if (topo->nodes[i].last_seen < node_cutoff) {
+            topo->node_slots[i] = 0;
+            continue;
+        }
+        topo->node_slots[i] = n + 1;
+        if (n != i)
+            topo->nodes[n] = topo->nodes[i];
+        ++n;
+    }
+    topo->num_nodes = n;
+
+    // compact edges, drop edges to removed nodes
+    unsigned e = 0;
+    for (unsigned i = 0; i < topo->num_edges; ++i) {
+        mesh_edge_t edge = topo->edges[i];
+        uint32_t src     = topo->node_slots[edge.src];
+        uint32_t dst     = topo->node_slots[edge.dst];
+        if (edge.last_seen < edge_cutoff || !src || !dst)
+            continue;
+        edge.src          = src - 1;
+        edge.dst          = dst - 1;
+        topo->edges[e++] = edge;
+    }
+    topo->num_edges = e;
+
+    // rebuild the indexes
+    memset(topo->node_slots, 0, (topo->node_mask + 1) * sizeof(*topo->node_slots));
+    for (unsigned i = 0; i < topo->num_nodes; ++i)
+        topo->node_slots[node_slot(topo, topo->nodes[i].addr)] = i + 1;
+    memset(topo->edge_slots, 0, (topo->edge_mask + 1) * sizeof(*topo->edge_slots));
+    for (unsigned i = 0; i < topo->num_edges; ++i)
+        topo->edge_slots[edge_slot(topo, topo->edges[i].src, topo->edges[i].dst)] = i + 1;
+
+    topo->evicted += old_nodes - topo->num_nodes + old_edges - topo->num_edges;
+}
+
+void mesh_topology_expire(mesh_topology_t *topo, time_t now)
+{
+    if (!topo)
+        return;
+    topo->last_expire = now;
+    time_t cutoff = now - (time_t)topo->max_age;
+    prune(topo, cutoff, cutoff);
+}
+
+/// Make room for the nodes and the edge from @p src to @p dst that are not indexed yet by evicting the oldest entries.
+static void make_room(mesh_topology_t *topo, char const *src, char const *dst, time_t now)
+{
+    unsigned nodes = !topo->node_slots[node_slot(topo, src)]
+            + (strcmp(src, dst) && !topo->node_slots[node_slot(topo, dst)]);
+    if (nodes && topo->num_nodes + nodes > topo->max_nodes) {
+        time_t oldest = now;
+        for (unsigned i = 0; i < topo->num_nodes; ++i) {
+            if (topo->nodes[i].last_seen < oldest)
+                oldest = topo->nodes[i].last_seen;
+        }
+        prune(topo, oldest + 1 < now ? oldest + 1 : now, 0);
+    }
+    uint32_t s = topo->node_slots[node_slot(topo, src)];
+    uint32_t d = topo->node_slots[node_slot(topo, dst)];
+    int new_edge = !s || !d || !topo->edge_slots[edge_slot(topo, s - 1, d - 1)];
+    if (new_edge && topo->num_edges + 1 > topo->max_edges) {
+        time_t oldest = now;
+        for (unsigned i = 0; i < topo->num_edges; ++i) {
+            if (topo->edges[i].last_seen < oldest)
+                oldest = topo->edges[i].last_seen;
+        }
+        prune(topo, 0, oldest + 1 < now ? oldest + 1 : now);
+    }
+}
+
+/// Get or add a node, returns the node index plus 1 or 0 if full.
+static uint32_t add_node(mesh_topology_t *topo, char const *addr, int kind, char const *network, time_t now)
+{
+    unsigned slot = node_slot(topo, addr);
+    if (!topo->node_slots[slot]) {
+        if (topo->num_nodes >= topo->max_nodes)
+            return 0;
+        mesh_node_t *node = &topo->nodes[topo->num_nodes];
+        memset(node, 0, sizeof(*node));
+        strncpy(node->addr, addr, sizeof(node->addr) - 1);
+        node->kind              = kind;
+        topo->node_slots[slot] = ++topo->num_nodes;
+    }
+    mesh_node_t *node = &topo->nodes[topo->node_slots[slot] - 1];
+    if (network)
+        strncpy(node->network, network, sizeof(node->network) - 1);
+    node->count++;
+    node->last_seen = now;
+    return topo->node_slots[slot];
+}
+
+static int is_addr(char const *str, size_t len)
+{
+    if (!str || strlen(str) != len)
+        return 0;
+    for (; *str; ++str) {
+        if (!(*str >= '0' && *str <= '9') && !(*str >= 'a' && *str <= 'f'))
+            return 0;
+    }
+    return 1;
+}
+
+int mesh_topology_update(mesh_topology_t *topo, data_t *data, time_t now)
+{
+    if (!topo)
+        return 0;
+
+    char const *model   = NULL;
+    char const *src     = NULL;
+    char const *dst     = NULL;
+    char const *wan     = NULL;
+    char const *network = NULL;
+    int subtype         = -1;
+    int has_rssi        = 0;
+    double rssi         = 0.0;
+    for (data_t *d = data; d; d = d->next) {
+        if (d->type == DATA_STRING && !strcmp(d->key, "model"))
+            model = d->value.v_ptr;
+        else if (d->type == DATA_STRING && !strcmp(d->key, "id"))
+            src = d->value.v_ptr;
+        else if (d->type == DATA_STRING && !strcmp(d->key, "destaddress"))
+            dst = d->value.v_ptr;
+        else if (d->type == DATA_STRING && !strcmp(d->key, "wanaddress"))
+            wan = d->value.v_ptr;
+        else if (d->type == DATA_STRING && !strcmp(d->key, "networkID"))
+            network = d->value.v_ptr;
+        else if (d->type == DATA_INT && !strcmp(d->key, "subtype"))
+            subtype = d->value.v_int;
+        else if (d->type == DATA_DOUBLE && !strcmp(d->key, "rssi")) {
+            rssi     = d->value.v_dbl;
+            has_rssi = 1;
+        }
+    }
+
+    if (!model || strcmp(model, "LandisGyr-GS") || !is_addr(network, 4))
+        return 0;
+    // 0x55 frames go from a meter to a WAN address, 0xD5 frames from meter to meter
+    int dst_kind;
+    if (subtype == 0x55 && is_addr(src, 8) && is_addr(dst, 12))
+        dst_kind = MESH_COLLECTOR;
+    else if (subtype == 0xD5 && is_addr(src, 8) && is_addr(dst, 8))
+        dst_kind = MESH_METER;
+    else
+        return 0;
+
+    if (now - topo->last_expire >= MESH_EXPIRE_INTERVAL)
+        mesh_topology_expire(topo, now);
+    make_room(topo, src, dst, now);
+
+    uint32_t s = add_node(topo, src, MESH_METER, network, now);
+    uint32_t d = add_node(topo, dst, dst_kind, network, now);
+    if (!s || !d)
+        return 0;
+    if (is_addr(wan, 12))
+        strncpy(topo->nodes[s - 1].wan, wan, sizeof(topo->nodes[s - 1].wan) - 1);
+
+    unsigned slot = edge_slot(topo, s - 1, d - 1);
+    if (!topo->edge_slots[slot]) {
+        if (topo->num_edges >= topo->max_edges)
+            return 0;
+        mesh_edge_t *edge = &topo->edges[topo->num_edges];
+        memset(edge, 0, sizeof(*edge));
+        edge->src              = s - 1;
+        edge->dst              = d - 1;
+        topo->edge_slots[slot] = ++topo->num_edges;
+    }
+    mesh_edge_t *edge = &topo->edges[topo->edge_slots[slot] - 1];
+    edge->subtype     = subtype;
+    edge->count++;
+    edge->last_seen = now;
+    if (has_rssi) {
+        // moving average over the last 16 frames (or fewer)
+        edge->rssi_count += edge->rssi_count < 16;
+        edge->rssi      = rssi;
+        edge->rssi_avg += (rssi - edge->rssi_avg) / edge->rssi_count;
+    }
+
+    return 1;
+}
+
+/* Snapshot */
+
+static void print_json(mesh_topology_t const *topo, abuf_t *buf)
+{
+    unsigned num_nodes = topo ? topo->num_nodes : 0;
+    unsigned num_edges = topo ? topo->num_edges : 0;
+
+    abuf_printf(buf, "{\"nodes\" : %u, \"edges\" : %u, \"evicted\" : %u, \"adjacency\" : [",
+            num_nodes, num_edges, topo ? topo->evicted : 0);
+    if (!num_nodes) {
+        abuf_printf(buf, "%s", "]}");
+        return;
+    }
+
+    // bucket the edges by source node (counting sort)
+    unsigned *start = calloc(num_nodes + 1, sizeof(*start));
+    if (!start) {
+        WARN_CALLOC("mesh_topology_print()");
+        abuf_printf(buf, "%s", "]}");
+        return;
+    }
+    uint32_t *order = malloc((num_edges ? num_edges : 1) * sizeof(*order));
+    if (!order) {
+        WARN_MALLOC("mesh_topology_print()");
+        free(start);
+        abuf_printf(buf, "%s", "]}");
+        return;
+    }
+    for (unsigned i = 0; i < num_edges; ++i)
+        start[topo->edges[i].src + 1]++;
+    for (unsigned i = 0; i < num_nodes; ++i)
+        start[i + 1] += start[i];
+    for (unsigned i = 0; i < num_edges; ++i)
+        order[start[topo->edges[i].src]++] = i;
+    // the starts moved to the ends, shift back
+    memmove(&start[1], &start[0], num_nodes * sizeof(*start));
+    start[0] = 0;
+
+    for (unsigned i = 0; i < num_nodes; ++i) {
+        mesh_node_t const *node = &topo->nodes[i];
+        abuf_printf(buf, "%s{\"id\" : \"%s\", \"kind\" : \"%s\", \"network\" : \"%s\"",
+                i ? ", " : "", node->addr, mesh_kind_names[node->kind], node->network);
+        if (*node->wan)
+            abuf_printf(buf, ", \"wanaddress\" : \"%s\"", node->wan);
+        abuf_printf(buf, ", \"count\" : %u, \"last_seen\" : %lld, \"links\" : [",
+                node->count, (long long)node->last_seen);
+        for (unsigned j = start[i]; j < start[i + 1]; ++j) {
+            mesh_edge_t const *edge = &topo->edges[order[j]];
+            abuf_printf(buf, "%s{\"to\" : \"%s\", \"subtype\" : %u, \"count\" : %u, \"last_seen\" : %lld",
+                    j > start[i] ? ", " : "", topo->nodes[edge->dst].addr, edge->subtype, edge->count,
+                    (long long)edge->last_seen);
+            if (edge->rssi_count)
+                abuf_printf(buf, ", \"rssi\" : %.1f, \"rssi_avg\" : %.1f", edge->rssi, edge->rssi_avg);
+            abuf_printf(buf, "%s", "}");
+        }
+        abuf_printf(buf, "%s", "]}");
+    }
+    abuf_printf(buf, "%s", "]}");
+
+    free(order);
+    free(start);
+}
+
+static void print_graphml(mesh_topology_t const *topo, abuf_t *buf)
+{
+    abuf_printf(buf, "%s",
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+            "<key id=\"kind\" for=\"node\" attr.name=\"kind\" attr.type=\"string\"/>\n"
+            "<key id=\"network\" for=\"node\" attr.name=\"network\" attr.type=\"string\"/>\n"
+            "<key id=\"wanaddress\" for=\"node\" attr.name=\"wanaddress\" attr.type=\"string\"/>\n"
+            "<key id=\"count\" for=\"all\" attr.name=\"count\" attr.type=\"int\"/>\n"
+            "<key id=\"last_seen\" for=\"all\" attr.name=\"last_seen\" attr.type=\"long\"/>\n"
+            "<key id=\"subtype\" for=\"edge\" attr.name=\"subtype\" attr.type=\"int\"/>\n"
+            "<key id=\"rssi\" for=\"edge\" attr.name=\"rssi\" attr.type=\"double\"/>\n"
+            "<key id=\"rssi_avg\" for=\"edge\" attr.name=\"rssi_avg\" attr.type=\"double\"/>\n"
+            "<graph id=\"gridstream\" edgedefault=\"directed\">\n");
+
+    // addresses and networks are validated hex digits, no escaping needed
+    for (unsigned i = 0; topo && i < topo->num_nodes; ++i) {
+        mesh_node_t const *node = &topo->nodes[i];
+        abuf_printf(buf, "<node id=\"%s\"><data key=\"kind\">%s</data><data key=\"network\">%s</data>",
+                node->addr, mesh_kind_names[node->kind], node->network);
+        if (*node->wan)
+            abuf_printf(buf, "<data key=\"wanaddress\">%s</data>", node->wan);
+        abuf_printf(buf, "<data key=\"count\">%u</data><data key=\"last_seen\">%lld</data></node>\n",
+                node->count, (long long)node->last_seen);
+    }
+    for (unsigned i = 0; topo && i < topo->num_edges; ++i) {
+        mesh_edge_t const *edge = &topo->edges[i];
+        abuf_printf(buf, "<edge source=\"%s\" target=\"%s\"><data key=\"subtype\">%u</data>"
+                         "<data key=\"count\">%u</data><data key=\"last_seen\">%lld</data>",
+                topo->nodes[edge->src].addr, topo->nodes[edge->dst].addr, edge->subtype, edge->count,
+                (long long)edge->last_seen);
+        if (edge->rssi_count)
+            abuf_printf(buf, "<data key=\"rssi\">%.1f</data><data key=\"rssi_avg\">%.1f</data>",
+                    edge->rssi, edge->rssi_avg);
+        abuf_printf(buf, "%s", "</edge>\n");
+    }
+
+    abuf_printf(buf, "%s", "</graph>\n</graphml>\n");
+}
+
+size_t mesh_topology_print(mesh_topology_t const *topo, int format, char *buf, size_t size)
+{
+    abuf_t obuf = {0};
+    abuf_init(&obuf, buf, size);
+
+    if (format == MESH_TOPOLOGY_GRAPHML)
+        print_graphml(topo, &obuf);
+    else
+        print_json(topo, &obuf);
+
+    return size - obuf.left;
+}
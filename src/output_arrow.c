@@ -0,0 +1,725 @@
+/** @file
+    Arrow IPC stream output for rtl_433 events.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+/*
+    Writes the Arrow IPC streaming format (columnar format version 1.0,
+    metadata version V5), see https://arrow.apache.org/docs/format/Columnar.html
+
+    A stream is a Schema message, any number of RecordBatch messages, and an
+    end-of-stream marker. A message is a continuation marker, the length of the
+    Flatbuffers metadata, the metadata padded to 8 bytes, and the body buffers.
+
+    The Flatbuffers metadata is built front to back with the vtable directly
+    before each table, child objects always follow their parent so that all
+    offsets point forward.
+
+    Columns are Int64, Float64 or Utf8, nested objects and arrays are stored as
+    JSON text. All columns are nullable, a column without values in the first
+    record batch is Utf8.
+*/
+
+#include "output_arrow.h"
+
+#include "rtl_433.h"
+#include "r_api.h"
+#include "r_device.h"
+#include "data.h"
+#include "list.h"
+#include "r_util.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define ARROW_DEFAULT_ROWS 10000
+#define ARROW_DEFAULT_BYTES (4 * 1024 * 1024)
+#define ARROW_DEFAULT_SECS 600
+#define ARROW_BUF_SIZE 20000 // nested values need a large buffer
+
+enum arrow_type {
+    ARROW_UNSET, ///< no value seen yet
+    ARROW_INT64,
+    ARROW_FLOAT64,
+    ARROW_UTF8,
+};
+
+// Flatbuffers Type union
+#define FB_TYPE_INT 2
+#define FB_TYPE_FLOATINGPOINT 3
+#define FB_TYPE_UTF8 5
+// Flatbuffers MessageHeader union
+#define FB_HEADER_SCHEMA 1
+#define FB_HEADER_RECORDBATCH 3
+#define FB_METADATA_V5 4
+#define FB_PRECISION_DOUBLE 2
+
+/// A growable byte buffer, new space is zeroed.
+typedef struct {
+    uint8_t *ptr;
+    size_t len;
+    size_t size;
+} arrow_buf_t;
+
+typedef struct {
+    char *name;
+    int type;
+    unsigned rows;     ///< rows in this batch, the row is set if equal to the table rows
+    unsigned nulls;    ///< nulls in this batch
+    arrow_buf_t valid; ///< validity bitmap
+    arrow_buf_t data;  ///< Int64/Float64 values or Utf8 offsets
+    arrow_buf_t chars; ///< Utf8 data
+} arrow_column_t;
+
+typedef struct {
+    char *model;
+    FILE *file;
+    int schema_written;
+    int failed;
+    unsigned num_cols;
+    unsigned cols_size;
+    arrow_column_t *cols;
+    unsigned hint;  ///< column after the last matched, keys mostly come in order
+    unsigned rows;  ///< rows in this batch
+    size_t bytes;   ///< approximate size of this batch
+    time_t first;   ///< time the first row of this batch was added
+    unsigned long long total_rows;
+    unsigned batches;
+    unsigned dropped; ///< values without a column in the schema
+} arrow_table_t;
+
+typedef struct {
+    struct data_output output;
+    r_cfg_t *cfg;
+    char *dir;
+    char stamp[LOCAL_TIME_BUFLEN];
+    unsigned max_rows;
+    size_t max_bytes;
+    unsigned max_secs;
+    list_t tables;
+    arrow_table_t *last;
+    arrow_buf_t fb;
+    char buf[ARROW_BUF_SIZE];
+} data_output_arrow_t;
+
+/* Buffers */
+
+static size_t buf_grow(arrow_buf_t *b, size_t len, size_t align)
+{
+    size_t pos = (b->len + align - 1) & ~(align - 1);
+    if (pos + len > b->size) {
+        size_t size = b->size < 256 ? 256 : b->size;
+        while (size < pos + len)
+            size *= 2;
+        uint8_t *ptr = realloc(b->ptr, size);
+        if (!ptr)
+            FATAL_REALLOC("buf_grow()");
+        b->ptr  = ptr;
+        b->size = size;
+    }
+    memset(b->ptr + b->len, 0, pos + len - b->len);
+    b->len = pos + len;
+    return pos;
+}
+
+static void put_le(uint8_t *p, uint64_t v, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void buf_put_le(arrow_buf_t *b, uint64_t v, size_t n)
+{
+    size_t pos = buf_grow(b, n, 1);
+    put_le(b->ptr + pos, v, n);
+}
+
+/* Flatbuffers builder */
+
+typedef struct {
+    unsigned num;
+    uint16_t off[8];
+    uint8_t data[64];
+    size_t len;
+} fb_table_t;
+
+static void fb_table_init(fb_table_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->len = 4; // soffset to the vtable
+}
+
+/// Add a scalar field of @p size bytes, returns the field offset in the table.
+static size_t fb_field(fb_table_t *t, unsigned id, uint64_t val, size_t size)
+{
+    size_t pos = (t->len + size - 1) & ~(size - 1);
+    put_le(&t->data[pos], val, size);
+    t->len     = pos + size;
+    t->off[id] = (uint16_t)pos;
+    if (id >= t->num)
+        t->num = id + 1;
+    return pos;
+}
+
+/// Write the vtable and the table, returns the table position.
+static size_t fb_end_table(arrow_buf_t *b, fb_table_t *t)
+{
+    size_t vt_size = 4 + 2 * t->num;
+    size_t vt      = buf_grow(b, vt_size, 2);
+    put_le(b->ptr + vt, vt_size, 2);
+    put_le(b->ptr + vt + 2, t->len, 2);
+    for (unsigned i = 0; i < t->num; ++i)
+        put_le(b->ptr + vt + 4 + 2 * i, t->off[i], 2);
+
+    size_t table = buf_grow(b, t->len, 8);
+    memcpy(b->ptr + table, t->data, t->len);
+    put_le(b->ptr + table, table - vt, 4);
+    return table;
+}
+
+/// Point the offset field at @p pos to the object at @p target.
+static void fb_patch(arrow_buf_t *b, size_t pos, size_t target)
+{
+    put_le(b->ptr + pos, target - pos, 4);
+}
+
+/// Start a vector of @p count elements, returns the position of the first element.
+static size_t fb_vector(arrow_buf_t *b, size_t count, size_t elem_size, size_t align, size_t *vec)
+{
+    while ((b->len + 4) % align)
+        buf_grow(b, 1, 1);
+    *vec = buf_grow(b, 4 + count * elem_size, 1);
+    put_le(b->ptr + *vec, count, 4);
+    return *vec + 4;
+}
+
+static size_t fb_string(arrow_buf_t *b, char const *str)
+{
+    size_t len = strlen(str);
+    size_t pos = buf_grow(b, 4 + len + 1, 4);
+    put_le(b->ptr + pos, len, 4);
+    memcpy(b->ptr + pos + 4, str, len);
+    return pos;
+}
+
+/// Start a Message, returns the position of the header offset field.
+static size_t fb_message(arrow_buf_t *b, int header_type, uint64_t body_len)
+{
+    b->len      = 0;
+    size_t root = buf_grow(b, 4, 4);
+
+    fb_table_t t;
+    fb_table_init(&t);
+    fb_field(&t, 3, body_len, 8);
+    size_t header_pos = fb_field(&t, 2, 0, 4);
+    fb_field(&t, 0, FB_METADATA_V5, 2);
+    fb_field(&t, 1, header_type, 1);
+    size_t msg = fb_end_table(b, &t);
+    fb_patch(b, root, msg);
+    return msg + header_pos;
+}
+
+/* Stream writing */
+
+static int arrow_write_message(arrow_table_t *table, arrow_buf_t *fb)
+{
+    size_t meta_len = (fb->len + 7) & ~(size_t)7;
+    buf_grow(fb, meta_len - fb->len, 1);
+
+    uint8_t prefix[8];
+    put_le(prefix, 0xffffffff, 4);
+    put_le(prefix + 4, meta_len, 4);
+    if (fwrite(prefix, sizeof(prefix), 1, table->file) != 1
+            || fwrite(fb->ptr, meta_len, 1, table->file) != 1)
+        return -1;
+    return 0;
+}
+
+static void arrow_write_schema(data_output_arrow_t *arrow, arrow_table_t *table)
+{
+    arrow_buf_t *b = &arrow->fb;
+    size_t header  = fb_message(b, FB_HEADER_SCHEMA, 0);
+
+    fb_table_t t;
+    fb_table_init(&t);
+    size_t fields_pos = fb_field(&t, 1, 0, 4);
+    size_t schema     = fb_end_table(b, &t);
+    fb_patch(b, header, schema);
+
+    size_t vec;
+    size_t elems = fb_vector(b, table->num_cols, 4, 4, &vec);
+    fb_patch(b, schema + fields_pos, vec);
+
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        arrow_column_t *col = &table->cols[i];
+        int type_type       = col->type == ARROW_INT64 ? FB_TYPE_INT
+                : col->type == ARROW_FLOAT64           ? FB_TYPE_FLOATINGPOINT
+                                                       : FB_TYPE_UTF8;
+
+        fb_table_init(&t);
+        size_t name_pos     = fb_field(&t, 0, 0, 4);
+        size_t type_pos     = fb_field(&t, 3, 0, 4);
+        size_t children_pos = fb_field(&t, 5, 0, 4);
+        fb_field(&t, 1, 1, 1); // nullable
+        fb_field(&t, 2, type_type, 1);
+        size_t field = fb_end_table(b, &t);
+        fb_patch(b, elems + 4 * i, field);
+
+        fb_patch(b, field + name_pos, fb_string(b, col->name));
+
+        fb_table_init(&t);
+        if (type_type == FB_TYPE_INT) {
+            fb_field(&t, 0, 64, 4); // bitWidth
+            fb_field(&t, 1, 1, 1);  // is_signed
+        }
+        else if (type_type == FB_TYPE_FLOATINGPOINT) {
+            fb_field(&t, 0, FB_PRECISION_DOUBLE, 2);
+        }
+        fb_patch(b, field + type_pos, fb_end_table(b, &t));
+
+        fb_vector(b, 0, 4, 4, &vec);
+        fb_patch(b, field + children_pos, vec);
+    }
+
+    if (arrow_write_message(table, b))
+        table->failed = 1;
+}
+
+static size_t column_bitmap_len(arrow_table_t *table, arrow_column_t *col)
+{
+    return col->nulls ? (table->rows + 7) / 8 : 0;
+}
+
+static void arrow_write_batch(data_output_arrow_t *arrow, arrow_table_t *table)
+{
+    // buffer lengths, each buffer starts 8 byte aligned in the body
+    size_t body_len    = 0;
+    size_t num_buffers = 0;
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        arrow_column_t *col = &table->cols[i];
+        body_len += (column_bitmap_len(table, col) + 7) & ~(size_t)7;
+        body_len += (col->data.len + 7) & ~(size_t)7;
+        num_buffers += 2;
+        if (col->type == ARROW_UTF8) {
+            body_len += (col->chars.len + 7) & ~(size_t)7;
+            num_buffers += 1;
+        }
+    }
+
+    arrow_buf_t *b = &arrow->fb;
+    size_t header  = fb_message(b, FB_HEADER_RECORDBATCH, body_len);
+
+    fb_table_t t;
+    fb_table_init(&t);
+    fb_field(&t, 0, table->rows, 8);
+    size_t nodes_pos   = fb_field(&t, 1, 0, 4);
+    size_t buffers_pos = fb_field(&t, 2, 0, 4);
+    size_t batch       = fb_end_table(b, &t);
+    fb_patch(b, header, batch);
+
+    size_t vec;
+    size_t nodes = fb_vector(b, table->num_cols, 16, 8, &vec);
+    fb_patch(b, batch + nodes_pos, vec);
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        put_le(b->ptr + nodes + 16 * i, table->rows, 8);
+        put_le(b->ptr + nodes + 16 * i + 8, table->cols[i].nulls, 8);
+    }
+
+    size_t buffers = fb_vector(b, num_buffers, 16, 8, &vec);
+    fb_patch(b, batch + buffers_pos, vec);
+    size_t offset = 0;
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        arrow_column_t *col = &table->cols[i];
+        size_t lens[3]      = {column_bitmap_len(table, col), col->data.len, col->chars.len};
+        unsigned n          = col->type == ARROW_UTF8 ? 3 : 2;
+        for (unsigned j = 0; j < n; ++j) {
+            put_le(b->ptr + buffers, offset, 8);
+            put_le(b->ptr + buffers + 8, lens[j], 8);
+            buffers += 16;
+            offset += (lens[j] + 7) & ~(size_t)7;
+        }
+    }
+
+    if (arrow_write_message(table, b)) {
+        table->failed = 1;
+        return;
+    }
+
+    static uint8_t const pad[8] = {0};
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        arrow_column_t *col   = &table->cols[i];
+        arrow_buf_t *bufs[3]  = {&col->valid, &col->data, &col->chars};
+        size_t lens[3]        = {column_bitmap_len(table, col), col->data.len, col->chars.len};
+        unsigned n            = col->type == ARROW_UTF8 ? 3 : 2;
+        for (unsigned j = 0; j < n; ++j) {
+            if (lens[j] && fwrite(bufs[j]->ptr, lens[j], 1, table->file) != 1)
+                table->failed = 1;
+            if (lens[j] % 8 && fwrite(pad, 8 - lens[j] % 8, 1, table->file) != 1)
+                table->failed = 1;
+        }
+    }
+}
+
+/* Columns */
+
+static void column_set_type(arrow_column_t *col, int type, unsigned rows)
+{
+    col->type = type;
+    if (type == ARROW_UTF8) {
+        buf_grow(&col->data, 4 * (rows + 1), 4); // all offsets 0
+    }
+    else {
+        buf_grow(&col->data, 8 * rows, 8);
+    }
+}
+
+static void column_reset(arrow_column_t *col)
+{
+    col->rows      = 0;
+    col->nulls     = 0;
+    col->valid.len = 0;
+    col->data.len  = 0;
+    col->chars.len = 0;
+    if (col->type == ARROW_UTF8)
+        buf_put_le(&col->data, 0, 4);
+}
+
+static void column_append_null(arrow_column_t *col)
+{
+    buf_grow(&col->valid, col->rows / 8 + 1 - col->valid.len, 1);
+    if (col->type == ARROW_UTF8)
+        buf_put_le(&col->data, col->chars.len, 4);
+    else if (col->type != ARROW_UNSET)
+        buf_put_le(&col->data, 0, 8);
+    col->nulls++;
+    col->rows++;
+}
+
+static void column_append_valid(arrow_column_t *col)
+{
+    buf_grow(&col->valid, col->rows / 8 + 1 - col->valid.len, 1);
+    col->valid.ptr[col->rows / 8] |= 1 << (col->rows % 8);
+    col->rows++;
+}
+
+static void column_append_text(arrow_column_t *col, char const *str, size_t len)
+{
+    size_t pos = buf_grow(&col->chars, len, 1);
+    memcpy(col->chars.ptr + pos, str, len);
+    buf_put_le(&col->data, col->chars.len, 4);
+    column_append_valid(col);
+}
+
+/// Render a value as JSON text, returns the length or -1 if it does not fit.
+static int arrow_value_json(data_output_arrow_t *arrow, data_t *d, char const **text)
+{
+    data_t tmp = *d;
+    tmp.next   = NULL;
+    size_t len = data_print_jsons(&tmp, arrow->buf, sizeof(arrow->buf));
+    size_t pre = strlen(d->key) + 4; // {"key":
+    if (len + 1 >= sizeof(arrow->buf) || len < pre + 1)
+        return -1;
+    *text = arrow->buf + pre;
+    return (int)(len - pre - 1);
+}
+
+static void column_append(data_output_arrow_t *arrow, arrow_table_t *table, arrow_column_t *col, data_t *d)
+{
+    int kind = d->type == DATA_INT ? ARROW_INT64
+            : d->type == DATA_DOUBLE ? ARROW_FLOAT64
+                                     : ARROW_UTF8;
+
+    // the type is decided by the first value, promote Int64 to Float64 while the schema is open
+    if (col->type == ARROW_UNSET)
+        column_set_type(col, kind, col->rows);
+    else if (col->type == ARROW_INT64 && kind == ARROW_FLOAT64 && !table->schema_written) {
+        for (unsigned i = 0; i < col->rows; ++i) {
+            uint8_t *p = col->data.ptr + 8 * i;
+            int64_t v  = 0;
+            for (int j = 7; j >= 0; --j)
+                v = (int64_t)((uint64_t)v << 8 | p[j]);
+            double dbl = (double)v;
+            uint64_t u;
+            memcpy(&u, &dbl, sizeof(u));
+            put_le(p, u, 8);
+        }
+        col->type = ARROW_FLOAT64;
+    }
+
+    if (col->type == ARROW_INT64 && kind == ARROW_INT64) {
+        buf_put_le(&col->data, (uint64_t)(int64_t)d->value.v_int, 8);
+        column_append_valid(col);
+    }
+    else if (col->type == ARROW_FLOAT64 && kind != ARROW_UTF8) {
+        double dbl = kind == ARROW_INT64 ? d->value.v_int : d->value.v_dbl;
+        uint64_t u;
+        memcpy(&u, &dbl, sizeof(u));
+        buf_put_le(&col->data, u, 8);
+        column_append_valid(col);
+    }
+    else if (col->type == ARROW_UTF8 && d->type == DATA_STRING) {
+        char const *str = d->value.v_ptr;
+        column_append_text(col, str, strlen(str));
+    }
+    else if (col->type == ARROW_UTF8) {
+        char const *text;
+        int len = arrow_value_json(arrow, d, &text);
+        if (len < 0)
+            column_append_null(col);
+        else
+            column_append_text(col, text, (size_t)len);
+    }
+    else {
+        column_append_null(col); // does not fit the column type
+        table->dropped++;
+    }
+}
+
+/* Tables */
+
+static arrow_column_t *table_add_column(arrow_table_t *table, char const *name)
+{
+    if (table->num_cols == table->cols_size) {
+        unsigned size        = table->cols_size ? table->cols_size * 2 : 32;
+        arrow_column_t *cols = realloc(table->cols, size * sizeof(*cols));
+        if (!cols)
+            FATAL_REALLOC("table_add_column()");
+        table->cols      = cols;
+        table->cols_size = size;
+    }
+    arrow_column_t *col = &table->cols[table->num_cols++];
+    memset(col, 0, sizeof(*col));
+    col->name = strdup(name);
+    if (!col->name)
+        FATAL_STRDUP("table_add_column()");
+    while (col->rows < table->rows)
+        column_append_null(col);
+    return col;
+}
+
+static arrow_column_t *table_find_column(arrow_table_t *table, char const *name)
+{
+    for (unsigned n = 0; n < table->num_cols; ++n) {
+        unsigned i = (table->hint + n) % table->num_cols;
+        if (!strcmp(table->cols[i].name, name)) {
+            table->hint = i + 1;
+            return &table->cols[i];
+        }
+    }
+    return NULL;
+}
+
+static arrow_table_t *arrow_table_get(data_output_arrow_t *arrow, char const *model)
+{
+    if (arrow->last && !strcmp(arrow->last->model, model))
+        return arrow->last;
+    for (void **iter = arrow->tables.elems; iter && *iter; ++iter) {
+        arrow_table_t *table = *iter;
+        if (!strcmp(table->model, model))
+            return arrow->last = table;
+    }
+
+    arrow_table_t *table = calloc(1, sizeof(*table));
+    if (!table)
+        FATAL_CALLOC("arrow_table_get()");
+    table->model = strdup(model);
+    if (!table->model)
+        FATAL_STRDUP("arrow_table_get()");
+
+    // the schema starts with the well-known and the declared fields of the decoder
+    char const **fields = determine_device_fields(arrow->cfg, arrow->cfg->output_device);
+    for (char const **p = fields; p && *p; ++p) {
+        if (!table_find_column(table, *p))
+            table_add_column(table, *p);
+    }
+    free((void *)fields);
+
+    char path[1024];
+    char name[256];
+    size_t len = 0;
+    for (char const *p = model; *p && len < sizeof(name) - 1; ++p)
+        name[len++] = (*p >= '0' && *p <= '9') || (*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z') || *p == '-' ? *p : '_';
+    name[len] = '\0';
+    snprintf(path, sizeof(path), "%s/%s-%s.arrows", arrow->dir, name, arrow->stamp);
+    table->file = fopen(path, "wb");
+    if (!table->file) {
+        print_logf(LOG_ERROR, "Arrow", "Can't create \"%s\"", path);
+        table->failed = 1;
+    }
+    else {
+        print_logf(LOG_INFO, "Arrow", "Writing \"%s\" to \"%s\"", model, path);
+    }
+
+    list_push(&arrow->tables, table);
+    return arrow->last = table;
+}
+
+static void arrow_table_flush(data_output_arrow_t *arrow, arrow_table_t *table)
+{
+    if (!table->rows)
+        return;
+
+    if (!table->failed && !table->schema_written) {
+        // columns without values are Utf8
+        for (unsigned i = 0; i < table->num_cols; ++i) {
+            if (table->cols[i].type == ARROW_UNSET)
+                column_set_type(&table->cols[i], ARROW_UTF8, table->rows);
+        }
+        arrow_write_schema(arrow, table);
+        table->schema_written = 1;
+    }
+    if (!table->failed) {
+        arrow_write_batch(arrow, table);
+        fflush(table->file);
+        table->batches++;
+        table->total_rows += table->rows;
+    }
+    if (table->failed)
+        print_logf(LOG_ERROR, "Arrow", "Write failed for \"%s\", dropping %u rows", table->model, table->rows);
+
+    for (unsigned i = 0; i < table->num_cols; ++i)
+        column_reset(&table->cols[i]);
+    table->rows  = 0;
+    table->bytes = 0;
+}
+
+static void arrow_table_add(data_output_arrow_t *arrow, arrow_table_t *table, data_t *data)
+{
+    if (!table->rows)
+        table->first = time(NULL);
+
+    for (data_t *d = data; d; d = d->next) {
+        arrow_column_t *col = table_find_column(table, d->key);
+        if (!col && table->schema_written) {
+            table->dropped++;
+            continue;
+        }
+        if (!col)
+            col = table_add_column(table, d->key);
+        if (col->rows > table->rows)
+            continue; // duplicate key
+
+        size_t bytes = col->data.len + col->chars.len;
+        column_append(arrow, table, col, d);
+        table->bytes += col->data.len + col->chars.len - bytes;
+    }
+
+    // fill the unset columns of this row
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        if (table->cols[i].rows == table->rows)
+            column_append_null(&table->cols[i]);
+    }
+    table->rows++;
+}
+
+static void arrow_table_free(arrow_table_t *table)
+{
+    if (table->file) {
+        uint8_t eos[8];
+        put_le(eos, 0xffffffff, 4);
+        put_le(eos + 4, 0, 4);
+        if (table->schema_written && !table->failed)
+            fwrite(eos, sizeof(eos), 1, table->file);
+        fclose(table->file);
+    }
+    print_logf(LOG_INFO, "Arrow", "Wrote %llu rows in %u batches for \"%s\"%s",
+            table->total_rows, table->batches, table->model, table->dropped ? ", some values did not fit the schema" : "");
+
+    for (unsigned i = 0; i < table->num_cols; ++i) {
+        arrow_column_t *col = &table->cols[i];
+        free(col->name);
+        free(col->valid.ptr);
+        free(col->data.ptr);
+        free(col->chars.ptr);
+    }
+    free(table->cols);
+    free(table->model);
+    free(table);
+}
+
+/* Output */
+
+static void R_API_CALLCONV data_output_arrow_print(data_output_t *output, data_t *data)
+{
+    data_output_arrow_t *arrow = (data_output_arrow_t *)output;
+
+    char const *model = NULL;
+    for (data_t *d = data; d; d = d->next) {
+        if (d->type == DATA_STRING && !strcmp(d->key, "model")) {
+            model = d->value.v_ptr;
+            break;
+        }
+    }
+    if (!model)
+        return; // not an event
+
+    arrow_table_t *table = arrow_table_get(arrow, model);
+    arrow_table_add(arrow, table, data);
+    if (table->rows >= arrow->max_rows || table->bytes >= arrow->max_bytes)
+        arrow_table_flush(arrow, table);
+
+    time_t now = time(NULL);
+    for (void **iter = arrow->tables.elems; iter && *iter; ++iter) {
+        arrow_table_t *t = *iter;
+        if (t->rows && now - t->first >= (time_t)arrow->max_secs)
+            arrow_table_flush(arrow, t);
+    }
+}
+
+static void R_API_CALLCONV data_output_arrow_free(data_output_t *output)
+{
+    data_output_arrow_t *arrow = (data_output_arrow_t *)output;
+
+    if (!arrow)
+        return;
+
+    for (void **iter = arrow->tables.elems; iter && *iter; ++iter)
+        arrow_table_flush(arrow, *iter);
+    list_free_elems(&arrow->tables, (list_elem_free_fn)arrow_table_free);
+
+    free(arrow->fb.ptr);
+    free(arrow->dir);
+    free(arrow);
+}
+
+struct data_output *data_output_arrow_create(r_cfg_t *cfg, char const *dir, unsigned max_rows, size_t max_bytes, unsigned max_secs)
+{
+    data_output_arrow_t *arrow = calloc(1, sizeof(data_output_arrow_t));
+    if (!arrow) {
+        WARN_CALLOC("data_output_arrow_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+    arrow->dir = strdup(dir);
+    if (!arrow->dir) {
+        WARN_STRDUP("data_output_arrow_create()");
+        free(arrow);
+        return NULL;
+    }
+
+    arrow->cfg       = cfg;
+    arrow->max_rows  = max_rows ? max_rows : ARROW_DEFAULT_ROWS;
+    arrow->max_bytes = max_bytes ? max_bytes : ARROW_DEFAULT_BYTES;
+    arrow->max_secs  = max_secs ? max_secs : ARROW_DEFAULT_SECS;
+
+    // files of a run are named by the start time, a stream can't be appended to
+    format_time_str(arrow->stamp, "%Y%m%d-%H%M%S", 0, 0);
+
+    arrow->output.output_print = data_output_arrow_print;
+    arrow->output.output_free  = data_output_arrow_free;
+
+    print_logf(LOG_NOTICE, "Arrow", "Writing Arrow streams to \"%s\" every %u rows, %u KiB, or %u s",
+            arrow->dir, arrow->max_rows, (unsigned)(arrow->max_bytes / 1024), arrow->max_secs);
+
+    return &arrow->output;
+}
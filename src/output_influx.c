@@ -18,6 +18,7 @@
 #include "logger.h"
 #include "fatal.h"
 #include "r_util.h"
+#include "spool.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -40,9 +41,14 @@ typedef struct {
     tls_opts_t tls_opts;
     int databufidxfill;
     struct mbuf databufs[2];
-
+    spool_t *spool;      // optional durable spool
+    uint64_t batch_last; // last spooled sequence number in the request
+    double retry_time;   // don't resend spooled data before
 } influx_client_t;
 
+#define INFLUX_SPOOL_BATCH (64 * 1024) // max request size when sending spooled data
+#define INFLUX_SPOOL_RETRY 10          // seconds between retries of failed spooled requests
+
 static void influx_client_send(influx_client_t *ctx);
 
 static void influx_client_event(struct mg_connection *nc, int ev, void *ev_data)
@@ -69,6 +75,9 @@ static void influx_client_event(struct mg_connection *nc, int ev, void *ev_data)
     case MG_EV_HTTP_CHUNK: // response is normally empty (so mongoose thinks we received a chunk only)
     case MG_EV_HTTP_REPLY:
         nc->flags |= MG_F_CLOSE_IMMEDIATELY;
+        // a bad request will never succeed, don't retry spooled data
+        if (ctx && ctx->spool && (hm->resp_code / 100 == 2 || hm->resp_code == 400))
+            spool_ack(ctx->spool, ctx->batch_last);
         if (hm->resp_code == 204) {
             // mark influx data as sent
         }
@@ -83,6 +92,8 @@ static void influx_client_event(struct mg_connection *nc, int ev, void *ev_data)
     case MG_EV_CLOSE:
         if (ctx) {
             ctx->conn = NULL;
+            if (ctx->spool && spool_acked(ctx->spool) < ctx->batch_last)
+                ctx->retry_time = mg_time() + INFLUX_SPOOL_RETRY; // failed, back off
             influx_client_send(ctx);
         }
         break;
@@ -98,10 +109,34 @@ static influx_client_t *influx_client_init(influx_client_t *ctx, char const *url
     return ctx;
 }
 
+// fill the send buffer with spooled lines from the acknowledged cursor
+static void influx_client_fill_spooled(influx_client_t *ctx, struct mbuf *buf)
+{
+    if (ctx->conn || mg_time() < ctx->retry_time)
+        return;
+
+    buf->len = 0;
+    void const *rec;
+    size_t len;
+    uint64_t seq = spool_acked(ctx->spool);
+    while (spool_read(ctx->spool, seq + 1, &rec, &len)) {
+        if (buf->len && buf->len + len > INFLUX_SPOOL_BATCH)
+            break;
+        mbuf_append(buf, rec, len);
+        seq++;
+    }
+    mbuf_append(buf, "", 1); // terminate the body
+    buf->len--;
+    ctx->batch_last = seq;
+}
+
 static void influx_client_send(influx_client_t *ctx)
 {
     struct mbuf *buf = &ctx->databufs[ctx->databufidxfill];
 
+    if (ctx->spool)
+        influx_client_fill_spooled(ctx, buf);
+
     /*fprintf(stderr, "Influx %p msg: \"%s\" with %lu/%lu %s\n",
             (void*)ctx, buf->buf, buf->len, buf->size,
             ctx->conn ? "buffering" : "to be sent");*/
@@ -297,6 +332,7 @@ static void R_API_CALLCONV print_influx_data(data_output_t *output, data_t *data
     char *str;
     char *end;
     struct mbuf *buf = &influx->databufs[influx->databufidxfill];
+    size_t line_start = buf->len;
     bool comma = false;
 
     data_t *data_org = data;
@@ -406,6 +442,12 @@ static void R_API_CALLCONV print_influx_data(data_output_t *output, data_t *data
     }
     mbuf_snprintf(buf, "\n");
 
+    if (influx->spool) {
+        // the line goes to the spool, the buffer is refilled from there
+        spool_append(influx->spool, &buf->buf[line_start], buf->len - line_start);
+        buf->len = 0;
+    }
+
     influx_client_send(influx);
 }
 
@@ -438,6 +480,8 @@ static void R_API_CALLCONV data_output_influx_free(data_output_t *output)
         influx->conn->flags |= MG_F_CLOSE_IMMEDIATELY;
     }
 
+    spool_close(influx->spool);
+
     free(influx);
 }
 
@@ -457,6 +501,9 @@ struct data_output *data_output_influx_create(struct mg_mgr *mgr, char *opts)
     influx_sanitize_tag(influx->hostname, NULL);
 
     char *token = NULL;
+    char *spool_dir = NULL;
+    int spool_size = 0;
+    int spool_age = 0;
 
     // param/opts starts with URL
     char *url = opts;
@@ -478,12 +525,13 @@ struct data_output *data_output_influx_create(struct mg_mgr *mgr, char *opts)
     if (mg_parse_uri(mg_mk_str(url), NULL, NULL, &host, NULL, &path,
                 &query, NULL) != 0
             || !host.len || !path.len || !query.len) {
-        print_logf(LOG_FATAL, __func__, "Invalid URL to InfluxDB specified.%s%s%s"
+        print_logf(LOG_ERROR, __func__, "Invalid URL to InfluxDB specified.%s%s%s"
                         " Something like \"influx://<host>/write?org=<org>&bucket=<bucket>\" required at least.",
                 !host.len ? " No host specified." : "",
                 !path.len ? " No path component specified." : "",
                 !query.len ? " No query parameters specified." : "");
-        exit(1);
+        data_output_influx_free(&influx->output);
+        return NULL;
     }
 
     // parse auth and format options
@@ -495,14 +543,28 @@ struct data_output *data_output_influx_create(struct mg_mgr *mgr, char *opts)
             continue;
         else if (!strcasecmp(key, "t") || !strcasecmp(key, "token"))
             token = val;
+        else if (!strcasecmp(key, "spool"))
+            spool_dir = val;
+        else if (!strcasecmp(key, "spool_size"))
+            spool_size = atoiv(val, 0);
+        else if (!strcasecmp(key, "spool_age"))
+            spool_age = atoiv(val, 0);
         else if (!tls_param(&influx->tls_opts, key, val)) {
             // ok
         }
         else {
-            print_logf(LOG_FATAL, __func__, "Invalid key \"%s\" option.", key);
-            exit(1);
+            print_logf(LOG_ERROR, __func__, "Invalid key \"%s\" option.", key);
+            data_output_influx_free(&influx->output);
+            return NULL;
         }
     }
+#if !MG_ENABLE_SSL
+    if (influx->tls_opts.tls_ca_cert) {
+        print_log(LOG_ERROR, __func__, "influxs (TLS) not available");
+        data_output_influx_free(&influx->output);
+        return NULL;
+    }
+#endif
 
     influx->output.print_data   = print_influx_data;
     influx->output.print_array  = print_influx_array;
@@ -516,5 +578,15 @@ struct data_output *data_output_influx_create(struct mg_mgr *mgr, char *opts)
     influx->mgr = mgr;
     influx_client_init(influx, url, token);
 
+    if (spool_dir) {
+        influx->spool = spool_open(spool_dir, (size_t)spool_size * 1024 * 1024, spool_age * 3600);
+        if (!influx->spool) {
+            print_logf(LOG_ERROR, "InfluxDB", "Can't open spool \"%s\".", spool_dir);
+            data_output_influx_free(&influx->output);
+            return NULL;
+        }
+        print_logf(LOG_NOTICE, "InfluxDB", "Spooling InfluxDB data in \"%s\".", spool_dir);
+    }
+
     return &influx->output;
 }
@@ -16,6 +16,7 @@
 #include "logger.h"
 #include "fatal.h"
 #include "r_util.h"
+#include "spool.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -34,8 +35,22 @@ typedef struct mqtt_client {
     char client_id[256];
     uint16_t message_id;
     int publish_flags; // MG_MQTT_RETAIN | MG_MQTT_QOS(0)
+    int qos;
+    int connected;    // CONNACK received
+    spool_t *spool;   // optional durable spool
+    uint64_t sent;    // last spooled sequence number sent
 } mqtt_client_t;
 
+#define MQTT_SPOOL_WINDOW 32 // max unacknowledged spooled messages in flight
+
+static void mqtt_client_pump(mqtt_client_t *ctx);
+
+// message ids are 1 to 65535
+static uint16_t mqtt_spool_msg_id(uint64_t seq)
+{
+    return (uint16_t)(seq % 65535 + 1);
+}
+
 static void mqtt_client_event(struct mg_connection *nc, int ev, void *ev_data)
 {
     // note that while shutting down the ctx is NULL
@@ -71,9 +86,24 @@ static void mqtt_client_event(struct mg_connection *nc, int ev, void *ev_data)
         }
         else {
             print_log(LOG_NOTICE, "MQTT", "MQTT Connection established.");
+            if (ctx) {
+                ctx->connected = 1;
+                mqtt_client_pump(ctx);
+            }
         }
         break;
     case MG_EV_MQTT_PUBACK:
+        if (ctx && ctx->spool) {
+            // acknowledge up to the spooled message with this id
+            for (uint64_t seq = spool_acked(ctx->spool) + 1; seq <= ctx->sent; ++seq) {
+                if (mqtt_spool_msg_id(seq) == msg->message_id) {
+                    spool_ack(ctx->spool, seq);
+                    break;
+                }
+            }
+            mqtt_client_pump(ctx);
+            break;
+        }
         print_logf(LOG_NOTICE, "MQTT", "MQTT Message publishing acknowledged (msg_id: %u)", msg->message_id);
         break;
     case MG_EV_MQTT_SUBACK:
@@ -89,6 +119,10 @@ static void mqtt_client_event(struct mg_connection *nc, int ev, void *ev_data)
             break; // shuttig down
         if (ctx->prev_status == 0)
             print_log(LOG_WARNING, "MQTT", "MQTT Connection failed...");
+        // resend unacknowledged spooled messages on the next connection
+        ctx->connected = 0;
+        if (ctx->spool)
+            ctx->sent = spool_acked(ctx->spool);
         // reconnect
         char const *error_string = NULL;
         ctx->connect_opts.error_string = &error_string;
@@ -102,6 +136,7 @@ static void mqtt_client_event(struct mg_connection *nc, int ev, void *ev_data)
     }
 }
 
+/// Returns NULL if TLS is not available or the address is invalid.
 static mqtt_client_t *mqtt_client_init(struct mg_mgr *mgr, tls_opts_t *tls_opts, char const *host, char const *port, char const *user, char const *pass, char const *client_id, int retain, int qos)
 {
     mqtt_client_t *ctx = calloc(1, sizeof(*ctx));
@@ -111,6 +146,7 @@ static mqtt_client_t *mqtt_client_init(struct mg_mgr *mgr, tls_opts_t *tls_opts,
     ctx->mqtt_opts.user_name = user;
     ctx->mqtt_opts.password  = pass;
     ctx->publish_flags  = MG_MQTT_QOS(qos) | (retain ? MG_MQTT_RETAIN : 0);
+    ctx->qos            = qos;
     // TODO: these should be user configurable options
     //ctx->opts.keepalive = 60;
     //ctx->timeout = 10000L;
@@ -150,8 +186,9 @@ static mqtt_client_t *mqtt_client_init(struct mg_mgr *mgr, tls_opts_t *tls_opts,
         ctx->connect_opts.ssl_psk_identity  = tls_opts->tls_psk_identity;
         ctx->connect_opts.ssl_psk_key       = tls_opts->tls_psk_key;
 #else
-        print_log(LOG_FATAL, __func__, "mqtts (TLS) not available");
-        exit(1);
+        print_log(LOG_ERROR, __func__, "mqtts (TLS) not available");
+        free(ctx);
+        return NULL;
 #endif
     }
     char const *error_string = NULL;
@@ -159,16 +196,57 @@ static mqtt_client_t *mqtt_client_init(struct mg_mgr *mgr, tls_opts_t *tls_opts,
     ctx->conn = mg_connect_opt(mgr, ctx->address, mqtt_client_event, ctx->connect_opts);
     ctx->connect_opts.error_string = NULL;
     if (!ctx->conn) {
-        print_logf(LOG_FATAL, "MQTT", "MQTT connect (%s) failed%s%s", ctx->address,
+        print_logf(LOG_ERROR, "MQTT", "MQTT connect (%s) failed%s%s", ctx->address,
                 error_string ? ": " : "", error_string ? error_string : "");
-        exit(1);
+        free(ctx);
+        return NULL;
     }
 
     return ctx;
 }
 
+/// Send spooled messages from the acknowledged cursor, with QoS 0 messages count as delivered when sent.
+static void mqtt_client_pump(mqtt_client_t *ctx)
+{
+    if (!ctx->spool || !ctx->connected || !ctx->conn)
+        return;
+
+    if (ctx->sent < spool_acked(ctx->spool))
+        ctx->sent = spool_acked(ctx->spool); // records were dropped
+
+    void const *rec;
+    size_t len;
+    while (ctx->sent - spool_acked(ctx->spool) < MQTT_SPOOL_WINDOW
+            && spool_read(ctx->spool, ctx->sent + 1, &rec, &len)) {
+        // record is the topic and the payload separated by a NUL
+        char const *topic = rec;
+        size_t topic_len  = strlen(topic) + 1;
+        ctx->sent++;
+        mg_mqtt_publish(ctx->conn, topic, mqtt_spool_msg_id(ctx->sent), ctx->publish_flags,
+                topic + topic_len, len - topic_len);
+        if (!ctx->qos)
+            spool_ack(ctx->spool, ctx->sent);
+    }
+}
+
 static void mqtt_client_publish(mqtt_client_t *ctx, char const *topic, char const *str)
 {
+    if (ctx->spool) {
+        size_t topic_len = strlen(topic) + 1;
+        size_t str_len   = strlen(str);
+        char *rec        = malloc(topic_len + str_len);
+        if (!rec) {
+            WARN_MALLOC("mqtt_client_publish()");
+            return;
+        }
+        memcpy(rec, topic, topic_len);
+        memcpy(rec + topic_len, str, str_len);
+        spool_append(ctx->spool, rec, topic_len + str_len);
+        free(rec);
+        mqtt_client_pump(ctx);
+        return;
+    }
+
     if (!ctx->conn || !ctx->conn->proto_handler)
         return;
 
@@ -182,6 +260,8 @@ static void mqtt_client_free(mqtt_client_t *ctx)
         ctx->conn->user_data = NULL;
         ctx->conn->flags |= MG_F_CLOSE_IMMEDIATELY;
     }
+    if (ctx)
+        spool_close(ctx->spool);
     free(ctx);
 }
 
@@ -241,6 +321,7 @@ static char *append_topic(char *topic, data_t *data)
     return topic;
 }
 
+/// Returns the end of the topic, NULL if the format is invalid. The formats are checked on create.
 static char *expand_topic(char *topic, char const *format, data_t *data, char const *hostname)
 {
     // collect well-known top level keys
@@ -298,8 +379,8 @@ static char *expand_topic(char *topic, char const *format, data_t *data, char co
         }
         // check for proper closing
         if (*format != ']') {
-            print_log(LOG_FATAL, __func__, "unterminated token");
-            exit(1);
+            print_log(LOG_ERROR, __func__, "unterminated token");
+            return NULL;
         }
         ++format;
 
@@ -319,8 +400,8 @@ static char *expand_topic(char *topic, char const *format, data_t *data, char co
         else if (!strncmp(t_start, "protocol", t_end - t_start))
             data_token = data_protocol;
         else {
-            print_logf(LOG_FATAL, __func__, "unknown token \"%.*s\"", (int)(t_end - t_start), t_start);
-            exit(1);
+            print_logf(LOG_ERROR, __func__, "unknown token \"%.*s\"", (int)(t_end - t_start), t_start);
+            return NULL;
         }
 
         // append token or default
@@ -483,6 +564,25 @@ static char *mqtt_topic_default(char const *topic, char const *base, char const
     return ret;
 }
 
+/// Check the tokens of a topic format, returns -1 if invalid.
+static int mqtt_topic_check(char const *format, char const *hostname)
+{
+    // without data a token expands to at most the hostname
+    size_t size = strlen(format) + 1;
+    for (char const *p = format; *p; ++p) {
+        if (*p == '[')
+            size += strlen(hostname);
+    }
+    char *topic = malloc(size);
+    if (!topic) {
+        WARN_MALLOC("mqtt_topic_check()");
+        return 0; // NOTE: skip the check on alloc failure.
+    }
+    int valid = expand_topic(topic, format, NULL, hostname) != NULL;
+    free(topic);
+    return valid ? 0 : -1;
+}
+
 struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, char const *dev_hint)
 {
     data_output_mqtt_t *mqtt = calloc(1, sizeof(data_output_mqtt_t));
@@ -516,6 +616,9 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
     char *pass = NULL;
     int retain = 0;
     int qos = 0;
+    char *spool_dir = NULL;
+    int spool_size = 0;
+    int spool_age = 0;
 
     // parse host and port
     tls_opts_t tls_opts = {0};
@@ -543,6 +646,12 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
             retain = atobv(val, 1);
         else if (!strcasecmp(key, "q") || !strcasecmp(key, "qos"))
             qos = atoiv(val, 1);
+        else if (!strcasecmp(key, "spool"))
+            spool_dir = val;
+        else if (!strcasecmp(key, "spool_size"))
+            spool_size = atoiv(val, 0);
+        else if (!strcasecmp(key, "spool_age"))
+            spool_age = atoiv(val, 0);
         // Simple key-topic mapping
         else if (!strcasecmp(key, "d") || !strcasecmp(key, "devices"))
             mqtt->devices = mqtt_topic_default(val, base_topic, path_devices);
@@ -553,7 +662,8 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
             print_log(LOG_FATAL, "MQTT", "for \"beforeid\"  use e.g. \"devices=rtl_433/[hostname]/devices[/type][/model][/subtype][/channel][/id]\"");
             print_log(LOG_FATAL, "MQTT", "for \"replaceid\" use e.g. \"devices=rtl_433/[hostname]/devices[/type][/model][/subtype][/channel]\"");
             print_log(LOG_FATAL, "MQTT", "for \"no\"        use e.g. \"devices=rtl_433/[hostname]/devices[/type][/model][/subtype][/id]\"");
-            exit(1);
+            data_output_mqtt_free(&mqtt->output);
+            return NULL;
         }
         // JSON events to single topic
         else if (!strcasecmp(key, "e") || !strcasecmp(key, "events"))
@@ -571,8 +681,9 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
             // ok
         }
         else {
-            print_logf(LOG_FATAL, __func__, "Invalid key \"%s\" option.", key);
-            exit(1);
+            print_logf(LOG_ERROR, __func__, "Invalid key \"%s\" option.", key);
+            data_output_mqtt_free(&mqtt->output);
+            return NULL;
         }
     }
 
@@ -588,6 +699,12 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
         print_logf(LOG_NOTICE, "MQTT", "Publishing events info to MQTT topic \"%s\".", mqtt->events);
     if (mqtt->states)
         print_logf(LOG_NOTICE, "MQTT", "Publishing states info to MQTT topic \"%s\".", mqtt->states);
+    if ((mqtt->devices && mqtt_topic_check(mqtt->devices, mqtt->hostname) < 0)
+            || (mqtt->events && mqtt_topic_check(mqtt->events, mqtt->hostname) < 0)
+            || (mqtt->states && mqtt_topic_check(mqtt->states, mqtt->hostname) < 0)) {
+        data_output_mqtt_free(&mqtt->output);
+        return NULL;
+    }
 
     mqtt->output.print_data   = print_mqtt_data;
     mqtt->output.print_array  = print_mqtt_array;
@@ -597,6 +714,22 @@ struct data_output *data_output_mqtt_create(struct mg_mgr *mgr, char *param, cha
     mqtt->output.output_free  = data_output_mqtt_free;
 
     mqtt->mqc = mqtt_client_init(mgr, &tls_opts, host, port, user, pass, client_id, retain, qos);
+    if (!mqtt->mqc) {
+        data_output_mqtt_free(&mqtt->output);
+        return NULL;
+    }
+
+    if (spool_dir) {
+        mqtt->mqc->spool = spool_open(spool_dir, (size_t)spool_size * 1024 * 1024, spool_age * 3600);
+        if (!mqtt->mqc->spool) {
+            print_logf(LOG_ERROR, "MQTT", "Can't open spool \"%s\".", spool_dir);
+            data_output_mqtt_free(&mqtt->output);
+            return NULL;
+        }
+        mqtt->mqc->sent = spool_acked(mqtt->mqc->spool);
+        print_logf(LOG_NOTICE, "MQTT", "Spooling MQTT messages in \"%s\"%s.", spool_dir,
+                qos ? "" : " (use qos=1 to have delivery acknowledged)");
+    }
 
     return &mqtt->output;
 }
@@ -0,0 +1,316 @@
+/** @file
+    Shared memory ring output for rtl_433 events.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "output_shm.h"
+#include "shm_ring.h"
+
+#include "data.h"
+#include "r_util.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SHM_DEFAULT_SIZE (4 * 1024 * 1024)
+#define SHM_MIN_SIZE (64 * 1024)
+#define SHM_BUF_SIZE 20000 // state messages need a large buffer
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct {
+    struct data_output output;
+    shm_ring_header_t *hdr;
+    uint8_t *data;
+    size_t map_size;
+    char buf[SHM_BUF_SIZE];
+} data_output_shm_t;
+
+/// Advance the tail until @p end fits, readers must see the tail before the data is overwritten.
+static void shm_reclaim(shm_ring_header_t *hdr, uint8_t const *data, uint64_t end)
+{
+    uint64_t mask = hdr->size - 1;
+    uint64_t tail = hdr->tail;
+    if (end - tail <= hdr->size)
+        return;
+
+    while (end - tail > hdr->size) {
+        shm_ring_record_t const *rec = (shm_ring_record_t const *)&data[tail & mask];
+        if (rec->len == SHM_RING_SKIP)
+            tail += hdr->size - (tail & mask);
+        else
+            tail += shm_ring_record_size(rec->len);
+    }
+    __atomic_store_n(&hdr->tail, tail, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static void shm_write(data_output_shm_t *shm, char const *msg, size_t len)
+{
+    shm_ring_header_t *hdr = shm->hdr;
+    uint64_t mask          = hdr->size - 1;
+    uint64_t head          = hdr->head;
+    size_t rec_size        = shm_ring_record_size(len);
+    if (rec_size > hdr->size / 2)
+        return; // never expected with events
+
+    // a record never wraps, fill the rest of the data area with a skip record
+    size_t room = hdr->size - (head & mask);
+    if (room < rec_size) {
+        shm_reclaim(hdr, shm->data, head + room);
+        shm_ring_record_t *skip = (shm_ring_record_t *)&shm->data[head & mask];
+        skip->len  = SHM_RING_SKIP;
+        skip->time = 0;
+        skip->seq  = 0;
+        head += room;
+    }
+
+    shm_reclaim(hdr, shm->data, head + rec_size);
+    shm_ring_record_t *rec = (shm_ring_record_t *)&shm->data[head & mask];
+    rec->len  = (uint32_t)len;
+    rec->time = (uint32_t)time(NULL);
+    rec->seq  = hdr->seq + 1;
+    memcpy(&shm->data[(head & mask) + sizeof(*rec)], msg, len);
+
+    __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&hdr->head, head + rec_size, __ATOMIC_RELEASE);
+}
+
+static void R_API_CALLCONV data_output_shm_print(data_output_t *output, data_t *data)
+{
+    data_output_shm_t *shm = (data_output_shm_t *)output;
+
+    size_t len = data_print_jsons(data, shm->buf, sizeof(shm->buf));
+    if (len + 1 >= sizeof(shm->buf))
+        return; // skip truncated output
+
+    shm_write(shm, shm->buf, len);
+}
+
+static void R_API_CALLCONV data_output_shm_free(data_output_t *output)
+{
+    data_output_shm_t *shm = (data_output_shm_t *)output;
+
+    if (!shm)
+        return;
+
+    if (shm->hdr) {
+        __atomic_store_n(&shm->hdr->closed, 1, __ATOMIC_RELEASE);
+        munmap(shm->hdr, shm->map_size);
+    }
+
+    free(shm);
+}
+
+/// Map the ring file, continue an existing ring of the same size, otherwise create a new one.
+static int shm_map(data_output_shm_t *shm, char const *path, size_t size)
+{
+    size_t map_size = sizeof(shm_ring_header_t) + size;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        print_logf(LOG_ERROR, "SHM", "Can't open \"%s\": %s", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        print_logf(LOG_ERROR, "SHM", "Can't stat \"%s\": %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if ((size_t)st.st_size != map_size) {
+        // readers might have the old size mapped, start over with a new file
+        close(fd);
+        unlink(path);
+        fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0 || ftruncate(fd, map_size)) {
+            print_logf(LOG_ERROR, "SHM", "Can't create \"%s\": %s", path, strerror(errno));
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+    }
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        print_logf(LOG_ERROR, "SHM", "Can't map \"%s\": %s", path, strerror(errno));
+        return -1;
+    }
+
+    shm->hdr      = map;
+    shm->data     = (uint8_t *)map + sizeof(shm_ring_header_t);
+    shm->map_size = map_size;
+
+    shm_ring_header_t *hdr = shm->hdr;
+    if (hdr->magic != SHM_RING_MAGIC || hdr->version != SHM_RING_VERSION || hdr->size != size
+            || hdr->head < hdr->tail || hdr->head - hdr->tail > size) {
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->version = SHM_RING_VERSION;
+        hdr->size    = size;
+        __atomic_store_n(&hdr->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&hdr->closed, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+struct data_output *data_output_shm_create(int log_level, char const *path, size_t size)
+{
+    data_output_shm_t *shm = calloc(1, sizeof(data_output_shm_t));
+    if (!shm) {
+        WARN_CALLOC("data_output_shm_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    if (!size)
+        size = SHM_DEFAULT_SIZE;
+    size_t pow2 = SHM_MIN_SIZE;
+    while (pow2 < size)
+        pow2 *= 2;
+
+    if (shm_map(shm, path, pow2)) {
+        free(shm);
+        return NULL;
+    }
+
+    shm->output.log_level    = log_level;
+    shm->output.output_print = data_output_shm_print;
+    shm->output.output_free  = data_output_shm_free;
+
+    print_logf(LOG_NOTICE, "SHM", "Writing events to ring \"%s\" (%u KiB), seq %llu",
+            path, (unsigned)(pow2 / 1024), (unsigned long long)shm->hdr->seq);
+
+    return &shm->output;
+}
+
+// Unit testing
+#ifdef _TEST
+#include <sched.h>
+#include <sys/wait.h>
+
+#define TEST_RECORDS 200000
+
+/// Length of the test record @p n, varies so the skip records land anywhere.
+static size_t test_len(unsigned n)
+{
+    return 12 + n * 7919u % 1500;
+}
+
+/// Fill the test record @p n, the number and a filler derived from it.
+static void test_fill(char *buf, unsigned n)
+{
+    size_t len = test_len(n);
+    snprintf(buf, 12, "%010u:", n);
+    memset(&buf[11], 'a' + n % 26, len - 11);
+}
+
+/// Tail the ring until the writer closes it, returns the number of bad records.
+static unsigned test_reader(char const *path)
+{
+    shm_ring_reader_t ring;
+    if (shm_ring_open(&ring, path, 1) < 0) {
+        fprintf(stderr, "FAIL: can't open the ring\n");
+        return 1;
+    }
+    char buf[2048];
+    char want[2048];
+    unsigned failed   = 0;
+    unsigned received = 0;
+    unsigned first    = 0;
+    unsigned last     = 0;
+    int len;
+    while ((len = shm_ring_read(&ring, buf, sizeof(buf))) >= 0) {
+        if (len == 0) {
+            sched_yield();
+            continue;
+        }
+        unsigned n = (unsigned)strtoul(buf, NULL, 10);
+        test_fill(want, n);
+        if ((size_t)len != test_len(n) || memcmp(buf, want, (size_t)len) || n <= last || n != ring.next_seq - 1) {
+            fprintf(stderr, "FAIL: record %u after %u (seq %llu, len %d)\n", n, last, (unsigned long long)ring.next_seq - 1, len);
+            ++failed;
+        }
+        if (!first)
+            first = n;
+        last = n;
+        ++received;
+    }
+    if (last != TEST_RECORDS || received + ring.lost != last - first + 1) {
+        fprintf(stderr, "FAIL: read %u to %u, %u received, %llu lost\n", first, last, received, (unsigned long long)ring.lost);
+        ++failed;
+    }
+    fprintf(stderr, "output_shm:: reader: %u received, %llu lost, %u bad\n", received, (unsigned long long)ring.lost, failed);
+    shm_ring_close(&ring);
+    return failed;
+}
+
+int main(void)
+{
+    fprintf(stderr, "output_shm:: test\n");
+
+    char path[] = "/tmp/test_output_shm_XXXXXX";
+    int fd      = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "FAIL: can't create the ring file\n");
+        return 1;
+    }
+    close(fd);
+
+    data_output_t *output = data_output_shm_create(LOG_WARNING, path, SHM_MIN_SIZE);
+    if (!output) {
+        unlink(path);
+        return 1;
+    }
+
+    // a concurrent writer and reader, the writer overruns the reader on the small ring
+    pid_t pid = fork();
+    if (pid == 0)
+        exit(test_reader(path) ? 1 : 0);
+
+    char buf[2048];
+    for (unsigned n = 1; n <= TEST_RECORDS; ++n) {
+        test_fill(buf, n);
+        shm_write((data_output_shm_t *)output, buf, test_len(n));
+        if (n % 256 == 0)
+            sched_yield(); // let the reader catch up now and then
+    }
+    data_output_free(output);
+
+    int status = 1;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid)
+        status = 1;
+    unlink(path);
+
+    int failed = !WIFEXITED(status) || WEXITSTATUS(status);
+    fprintf(stderr, "output_shm:: test %s.\n", failed ? "failed" : "passed");
+    return failed;
+}
+#endif /* _TEST */
+
+#else // _WIN32
+
+struct data_output *data_output_shm_create(int log_level, char const *path, size_t size)
+{
+    UNUSED(log_level);
+    UNUSED(path);
+    UNUSED(size);
+    print_log(LOG_ERROR, "SHM", "Shared memory output is not supported on this platform");
+    return NULL;
+}
+
+#endif // _WIN32 / !_WIN32
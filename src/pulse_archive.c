@@ -0,0 +1,659 @@
+/** @file
+    Pulse-level archive of detected packages.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "pulse_archive.h"
+#include "optparse.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define ftruncate _chsize
+#define fileno _fileno
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#ifdef ZLIB
+#include <zlib.h>
+#endif
+
+#define ARCHIVE_MAGIC 0x50333452u // "R43P"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_BLOCK_MAGIC 0x4b4c4250u // "PBLK"
+#define ARCHIVE_BLOCK_SIZE (64 * 1024)
+#define ARCHIVE_BLOCK_SECS 60
+#define ARCHIVE_MAX_RECORD (24 * 10 + PD_MAX_PULSES * 2 * 5) // all varints at their longest
+#define ARCHIVE_STORED_SIZE (ARCHIVE_BLOCK_SIZE + ARCHIVE_MAX_RECORD + 1024) // room for the deflate overhead
+#define ARCHIVE_DEFLATED 1 // block flag
+#define ARCHIVE_FSK 1      // record flag
+
+/*
+File layout, all integers little-endian:
+
+    file header:  magic "R43P" (u32), version (u32)
+    block header: magic "PBLK" (u32), flags (u32), records (u32), raw length (u32),
+                  stored length (u32), first time (i64, us), last time (i64, us)
+    block data:   stored length bytes, the records deflated or stored
+
+A record is a sequence of varints, "z" marks zigzag coded signed values,
+"d" marks deltas against the previous record of the block (0 at the start):
+
+    flags, time (zd, us), offset (zd, samples), sample rate, depth bits,
+    center frequency (zd, Hz), F1 and F2 (z, Hz offset), RSSI, SNR, noise, range (z, 0.1 dB),
+    OOK low and high estimate (z), FSK F1 and F2 estimate and average (z),
+    number of pulses, then per pulse the pulse and the gap width (zd, samples)
+*/
+
+#define ARCHIVE_HEADER_SIZE 8
+#define ARCHIVE_BLOCK_HEADER_SIZE 36
+
+typedef struct {
+    uint32_t flags;
+    uint32_t records;
+    uint32_t raw_len;
+    uint32_t stored_len;
+    int64_t t_first;
+    int64_t t_last;
+} archive_block_t;
+
+/// The previous values for the delta coding.
+typedef struct {
+    int64_t time;
+    int64_t offset;
+    int64_t center;
+} archive_prev_t;
+
+struct pulse_archive {
+    FILE *file;
+    char *path;
+    archive_block_t block;
+    archive_prev_t prev;
+    uint8_t raw[ARCHIVE_BLOCK_SIZE + ARCHIVE_MAX_RECORD];
+    uint8_t *stored; ///< deflate buffer, NULL without zlib
+    size_t stored_size;
+};
+
+/* Little-endian fixed width */
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static uint32_t get_u32(uint8_t const *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_i64(uint8_t *p, int64_t v)
+{
+    put_u32(p, (uint32_t)((uint64_t)v & 0xffffffff));
+    put_u32(p + 4, (uint32_t)((uint64_t)v >> 32));
+}
+
+static int64_t get_i64(uint8_t const *p)
+{
+    return (int64_t)((uint64_t)get_u32(p) | (uint64_t)get_u32(p + 4) << 32);
+}
+
+/* Varints */
+
+static uint8_t *put_uvar(uint8_t *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint8_t *put_svar(uint8_t *p, int64_t v)
+{
+    return put_uvar(p, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+/// Read a varint, returns 0 on a truncated or overlong varint.
+static int get_uvar(uint8_t const **p, uint8_t const *end, uint64_t *v)
+{
+    uint64_t val = 0;
+    for (unsigned shift = 0; shift < 64 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        val |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = val;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int get_svar(uint8_t const **p, uint8_t const *end, int64_t *v)
+{
+    uint64_t u;
+    if (!get_uvar(p, end, &u))
+        return 0;
+    *v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return 1;
+}
+
+static int64_t tenths(float db)
+{
+    return (int64_t)lrintf(db * 10.0f);
+}
+
+/* Writing */
+
+static int archive_read_block_header(FILE *file, archive_block_t *block)
+{
+    uint8_t hdr[ARCHIVE_BLOCK_HEADER_SIZE];
+    if (fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr) || get_u32(hdr) != ARCHIVE_BLOCK_MAGIC)
+        return 0;
+    block->flags      = get_u32(hdr + 4);
+    block->records    = get_u32(hdr + 8);
+    block->raw_len    = get_u32(hdr + 12);
+    block->stored_len = get_u32(hdr + 16);
+    block->t_first    = get_i64(hdr + 20);
+    block->t_last     = get_i64(hdr + 28);
+    return block->raw_len <= sizeof(((pulse_archive_t *)0)->raw);
+}
+
+/// Find the end of the last complete block, returns -1 if the file is not an archive.
+static long archive_valid_end(FILE *file)
+{
+    uint8_t hdr[ARCHIVE_HEADER_SIZE];
+    if (fseek(file, 0, SEEK_SET) || fread(hdr, 1, sizeof(hdr), file) != sizeof(hdr)
+            || get_u32(hdr) != ARCHIVE_MAGIC || get_u32(hdr + 4) != ARCHIVE_VERSION)
+        return -1;
+
+    if (fseek(file, 0, SEEK_END))
+        return -1;
+    long size = ftell(file);
+    long end  = ARCHIVE_HEADER_SIZE;
+    fseek(file, end, SEEK_SET);
+    archive_block_t block;
+    while (archive_read_block_header(file, &block)) {
+        long next = end + ARCHIVE_BLOCK_HEADER_SIZE + (long)block.stored_len;
+        if (next > size)
+            break;
+        end = next;
+        fseek(file, end, SEEK_SET);
+    }
+    return end;
+}
+
+pulse_archive_t *pulse_archive_create(char const *path, int truncate)
+{
+    pulse_archive_t *archive = calloc(1, sizeof(*archive));
+    if (!archive) {
+        WARN_CALLOC("pulse_archive_create()");
+        return NULL;
+    }
+    archive->path = strdup(path);
+    if (!archive->path) {
+        WARN_STRDUP("pulse_archive_create()");
+        free(archive);
+        return NULL;
+    }
+#ifdef ZLIB
+    archive->stored_size = compressBound(sizeof(archive->raw));
+    archive->stored      = malloc(archive->stored_size);
+    if (!archive->stored) {
+        WARN_MALLOC("pulse_archive_create()");
+        pulse_archive_close(archive);
+        return NULL;
+    }
+#endif
+
+    archive->file = truncate ? NULL : fopen(path, "r+b");
+    if (archive->file) {
+        long end = archive_valid_end(archive->file);
+        if (end < 0) {
+            print_logf(LOG_ERROR, "Archive", "\"%s\" is not a pulse archive", path);
+            pulse_archive_close(archive);
+            return NULL;
+        }
+        fflush(archive->file);
+        if (ftruncate(fileno(archive->file), end)) {
+            print_logf(LOG_ERROR, "Archive", "Can't truncate \"%s\": %s", path, strerror(errno));
+        }
+        fseek(archive->file, end, SEEK_SET);
+        print_logf(LOG_NOTICE, "Archive", "Appending to \"%s\" at %ld bytes", path, end);
+        return archive;
+    }
+
+    archive->file = fopen(path, "w+b");
+    if (!archive->file) {
+        print_logf(LOG_ERROR, "Archive", "Can't create \"%s\": %s", path, strerror(errno));
+        pulse_archive_close(archive);
+        return NULL;
+    }
+    uint8_t hdr[ARCHIVE_HEADER_SIZE];
+    put_u32(hdr, ARCHIVE_MAGIC);
+    put_u32(hdr + 4, ARCHIVE_VERSION);
+    if (fwrite(hdr, 1, sizeof(hdr), archive->file) != sizeof(hdr)) {
+        print_logf(LOG_ERROR, "Archive", "Can't write \"%s\": %s", path, strerror(errno));
+        pulse_archive_close(archive);
+        return NULL;
+    }
+    return archive;
+}
+
+static int archive_flush(pulse_archive_t *archive)
+{
+    archive_block_t *block = &archive->block;
+    if (!block->records)
+        return 0;
+
+    uint8_t const *data = archive->raw;
+    block->stored_len   = block->raw_len;
+    block->flags        = 0;
+#ifdef ZLIB
+    uLongf stored_len = archive->stored_size;
+    if (compress2(archive->stored, &stored_len, archive->raw, block->raw_len, Z_DEFAULT_COMPRESSION) == Z_OK
+            && stored_len < block->raw_len) {
+        data              = archive->stored;
+        block->stored_len = (uint32_t)stored_len;
+        block->flags      = ARCHIVE_DEFLATED;
+    }
+#endif
+
+    uint8_t hdr[ARCHIVE_BLOCK_HEADER_SIZE];
+    put_u32(hdr, ARCHIVE_BLOCK_MAGIC);
+    put_u32(hdr + 4, block->flags);
+    put_u32(hdr + 8, block->records);
+    put_u32(hdr + 12, block->raw_len);
+    put_u32(hdr + 16, block->stored_len);
+    put_i64(hdr + 20, block->t_first);
+    put_i64(hdr + 28, block->t_last);
+    int ok = fwrite(hdr, 1, sizeof(hdr), archive->file) == sizeof(hdr)
+            && fwrite(data, 1, block->stored_len, archive->file) == block->stored_len
+            && !fflush(archive->file);
+    if (!ok)
+        print_logf(LOG_ERROR, "Archive", "Can't write \"%s\": %s", archive->path, strerror(errno));
+
+    *block         = (archive_block_t){0};
+    archive->prev  = (archive_prev_t){0};
+    return ok ? 0 : -1;
+}
+
+int pulse_archive_write(pulse_archive_t *archive, pulse_data_t const *data, int fsk, int64_t time_us)
+{
+    if (!archive || !data->num_pulses)
+        return 0;
+
+    archive_block_t *block = &archive->block;
+    if (block->records && time_us - block->t_first > ARCHIVE_BLOCK_SECS * 1000000LL)
+        archive_flush(archive); // keep the loss on a crash to a minute
+
+    archive_prev_t *prev = &archive->prev;
+    uint8_t *p           = archive->raw + block->raw_len;
+    unsigned num_pulses  = data->num_pulses < PD_MAX_PULSES ? data->num_pulses : PD_MAX_PULSES;
+    int64_t center       = (int64_t)llrintf(data->centerfreq_hz);
+
+    p = put_uvar(p, fsk ? ARCHIVE_FSK : 0);
+    p = put_svar(p, time_us - prev->time);
+    p = put_svar(p, (int64_t)data->offset - prev->offset);
+    p = put_uvar(p, data->sample_rate);
+    p = put_uvar(p, data->depth_bits);
+    p = put_svar(p, center - prev->center);
+    p = put_svar(p, (int64_t)lrintf(data->freq1_hz));
+    p = put_svar(p, (int64_t)lrintf(data->freq2_hz));
+    p = put_svar(p, tenths(data->rssi_db));
+    p = put_svar(p, tenths(data->snr_db));
+    p = put_svar(p, tenths(data->noise_db));
+    p = put_svar(p, tenths(data->range_db));
+    p = put_svar(p, data->ook_low_estimate);
+    p = put_svar(p, data->ook_high_estimate);
+    p = put_svar(p, data->fsk_f1_est);
+    p = put_svar(p, data->fsk_f2_est);
+    p = put_svar(p, data->fsk_f1_avg);
+    p = put_svar(p, data->fsk_f2_avg);
+    p = put_uvar(p, num_pulses);
+    int prev_pulse = 0;
+    int prev_gap   = 0;
+    for (unsigned i = 0; i < num_pulses; ++i) {
+        p          = put_svar(p, data->pulse[i] - prev_pulse);
+        p          = put_svar(p, data->gap[i] - prev_gap);
+        prev_pulse = data->pulse[i];
+        prev_gap   = data->gap[i];
+    }
+
+    if (!block->records)
+        block->t_first = time_us;
+    block->t_last = time_us;
+    block->records++;
+    block->raw_len = (uint32_t)(p - archive->raw);
+    prev->time     = time_us;
+    prev->offset   = (int64_t)data->offset;
+    prev->center   = center;
+
+    if (block->raw_len >= ARCHIVE_BLOCK_SIZE)
+        return archive_flush(archive);
+    return 0;
+}
+
+void pulse_archive_close(pulse_archive_t *archive)
+{
+    if (!archive)
+        return;
+    if (archive->file) {
+        archive_flush(archive);
+        fclose(archive->file);
+    }
+    free(archive->stored);
+    free(archive->path);
+    free(archive);
+}
+
+/* Reading */
+
+typedef struct {
+    long offset; ///< file offset of the block header
+    archive_block_t block;
+} archive_index_t;
+
+/// Decode the records of a block, returns the number of packages replayed.
+static int archive_replay_block(uint8_t const *raw, archive_block_t const *block, int64_t from, int64_t to,
+        pulse_data_t *data, pulse_archive_cb cb, void *ctx)
+{
+    uint8_t const *p   = raw;
+    uint8_t const *end = raw + block->raw_len;
+    archive_prev_t prev = {0};
+    int count = 0;
+
+    for (unsigned n = 0; n < block->records; ++n) {
+        uint64_t flags, sample_rate, depth_bits, num_pulses;
+        int64_t dt, doffset, dcenter, f1, f2, rssi, snr, noise, range;
+        int64_t ook_low, ook_high, f1_est, f2_est, f1_avg, f2_avg;
+        int ok = get_uvar(&p, end, &flags)
+                && get_svar(&p, end, &dt)
+                && get_svar(&p, end, &doffset)
+                && get_uvar(&p, end, &sample_rate)
+                && get_uvar(&p, end, &depth_bits)
+                && get_svar(&p, end, &dcenter)
+                && get_svar(&p, end, &f1)
+                && get_svar(&p, end, &f2)
+                && get_svar(&p, end, &rssi)
+                && get_svar(&p, end, &snr)
+                && get_svar(&p, end, &noise)
+                && get_svar(&p, end, &range)
+                && get_svar(&p, end, &ook_low)
+                && get_svar(&p, end, &ook_high)
+                && get_svar(&p, end, &f1_est)
+                && get_svar(&p, end, &f2_est)
+                && get_svar(&p, end, &f1_avg)
+                && get_svar(&p, end, &f2_avg)
+                && get_uvar(&p, end, &num_pulses)
+                && num_pulses <= PD_MAX_PULSES;
+        if (!ok) {
+            print_log(LOG_WARNING, "Archive", "Skipping a corrupt block");
+            return count;
+        }
+
+        pulse_data_clear(data);
+        int64_t prev_pulse = 0;
+        int64_t prev_gap   = 0;
+        for (unsigned i = 0; i < num_pulses; ++i) {
+            int64_t dp, dg;
+            if (!get_svar(&p, end, &dp) || !get_svar(&p, end, &dg)) {
+                print_log(LOG_WARNING, "Archive", "Skipping a corrupt block");
+                return count;
+            }
+            prev_pulse += dp;
+            prev_gap += dg;
+            data->pulse[i] = (int)prev_pulse;
+            data->gap[i]   = (int)prev_gap;
+        }
+        prev.time += dt;
+        prev.offset += doffset;
+        prev.center += dcenter;
+
+        if ((from && prev.time < from) || (to && prev.time > to))
+            continue;
+
+        data->num_pulses        = (unsigned)num_pulses;
+        data->offset            = (uint64_t)prev.offset;
+        data->sample_rate       = (uint32_t)sample_rate;
+        data->depth_bits        = (unsigned)depth_bits;
+        data->centerfreq_hz     = (float)prev.center;
+        data->freq1_hz          = (float)f1;
+        data->freq2_hz          = (float)f2;
+        data->rssi_db           = rssi * 0.1f;
+        data->snr_db            = snr * 0.1f;
+        data->noise_db          = noise * 0.1f;
+        data->range_db          = range * 0.1f;
+        data->ook_low_estimate  = (int)ook_low;
+        data->ook_high_estimate = (int)ook_high;
+        data->fsk_f1_est        = (int)f1_est;
+        data->fsk_f2_est        = (int)f2_est;
+        data->fsk_f1_avg        = (int)f1_avg;
+        data->fsk_f2_avg        = (int)f2_avg;
+        cb(data, flags & ARCHIVE_FSK, prev.time, ctx);
+        count++;
+    }
+    return count;
+}
+
+/// Replay the blocks @p first to @p last (exclusive) of the index.
+static int archive_replay_blocks(FILE *file, archive_index_t const *index, unsigned first, unsigned last,
+        int64_t from, int64_t to, pulse_archive_cb cb, void *ctx)
+{
+    pulse_data_t *data = malloc(sizeof(*data));
+    if (!data) {
+        WARN_MALLOC("pulse_archive_replay()");
+        return -1;
+    }
+    // the raw buffer is followed by the stored (deflated) buffer
+    uint8_t *raw = malloc(2 * ARCHIVE_STORED_SIZE);
+    if (!raw) {
+        WARN_MALLOC("pulse_archive_replay()");
+        free(data);
+        return -1;
+    }
+    uint8_t *stored = raw + ARCHIVE_STORED_SIZE;
+
+    int count = 0;
+    for (unsigned i = first; i < last; ++i) {
+        archive_block_t const *block = &index[i].block;
+        if (fseek(file, index[i].offset + ARCHIVE_BLOCK_HEADER_SIZE, SEEK_SET)
+                || block->stored_len > ARCHIVE_STORED_SIZE
+                || fread(stored, 1, block->stored_len, file) != block->stored_len) {
+            print_log(LOG_WARNING, "Archive", "Skipping a truncated block");
+            continue;
+        }
+        if (block->flags & ARCHIVE_DEFLATED) {
+#ifdef ZLIB
+            uLongf raw_len = block->raw_len;
+            if (uncompress(raw, &raw_len, stored, block->stored_len) != Z_OK || raw_len != block->raw_len) {
+                print_log(LOG_WARNING, "Archive", "Skipping a corrupt block");
+                continue;
+            }
+#else
+            print_log(LOG_ERROR, "Archive", "Deflated blocks need zlib support");
+            count = -1;
+            break;
+#endif
+        }
+        else {
+            memcpy(raw, stored, block->raw_len);
+        }
+        count += archive_replay_block(raw, block, from, to, data, cb, ctx);
+    }
+
+    free(raw);
+    free(data);
+    return count;
+}
+
+/// Parse unix seconds or "YYYY-MM-DD[THH:MM[:SS]]" in local time, returns microseconds or 0.
+static int64_t archive_parse_time(char const *str)
+{
+    int y = 0, mo = 0, d = 0, h = 0, mi = 0, s = 0;
+    if (sscanf(str, "%d-%d-%d%*[T ]%d:%d:%d", &y, &mo, &d, &h, &mi, &s) >= 3) {
+        struct tm tm = {0};
+        tm.tm_year   = y - 1900;
+        tm.tm_mon    = mo - 1;
+        tm.tm_mday   = d;
+        tm.tm_hour   = h;
+        tm.tm_min    = mi;
+        tm.tm_sec    = s;
+        tm.tm_isdst  = -1;
+        return (int64_t)mktime(&tm) * 1000000LL;
+    }
+    return (int64_t)strtoll(str, NULL, 10) * 1000000LL;
+}
+
+static unsigned archive_default_jobs(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (unsigned)cores : 1;
+#else
+    return 1;
+#endif
+}
+
+int pulse_archive_replay(char const *spec, pulse_archive_cb cb, void *ctx)
+{
+    char *path = strdup(spec);
+    if (!path) {
+        WARN_STRDUP("pulse_archive_replay()");
+        return -1;
+    }
+    char *opts = strchr(path, ',');
+    if (opts)
+        *opts++ = '\0';
+
+    int64_t from  = 0;
+    int64_t to    = 0;
+    unsigned jobs = archive_default_jobs();
+    char *key, *val;
+    while (getkwargs(&opts, &key, &val)) {
+        if (!key || !*key)
+            continue;
+        else if (!strcasecmp(key, "from") && val)
+            from = archive_parse_time(val);
+        else if (!strcasecmp(key, "to") && val)
+            to = archive_parse_time(val);
+        else if (!strcasecmp(key, "jobs") && val)
+            jobs = (unsigned)atoi(val);
+        else
+            print_logf(LOG_WARNING, "Archive", "Unknown replay option \"%s\"", key);
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        print_logf(LOG_ERROR, "Archive", "Can't open \"%s\": %s", path, strerror(errno));
+        free(path);
+        return -1;
+    }
+    long end = archive_valid_end(file);
+    if (end < 0) {
+        print_logf(LOG_ERROR, "Archive", "\"%s\" is not a pulse archive", path);
+        fclose(file);
+        free(path);
+        return -1;
+    }
+
+    // the block headers are the time index
+    archive_index_t *index = NULL;
+    unsigned num_blocks    = 0;
+    unsigned index_size    = 0;
+    long offset            = ARCHIVE_HEADER_SIZE;
+    while (offset < end && !fseek(file, offset, SEEK_SET)) {
+        archive_block_t block;
+        if (!archive_read_block_header(file, &block))
+            break;
+        if ((!from || block.t_last >= from) && (!to || block.t_first <= to)) {
+            if (num_blocks == index_size) {
+                index_size           = index_size ? index_size * 2 : 256;
+                archive_index_t *new = realloc(index, index_size * sizeof(*index));
+                if (!new) {
+                    WARN_REALLOC("pulse_archive_replay()");
+                    break;
+                }
+                index = new;
+            }
+            index[num_blocks++] = (archive_index_t){.offset = offset, .block = block};
+        }
+        offset += ARCHIVE_BLOCK_HEADER_SIZE + (long)block.stored_len;
+    }
+    print_logf(LOG_NOTICE, "Archive", "Replaying %u blocks of \"%s\"", num_blocks, path);
+
+    if (jobs > num_blocks)
+        jobs = num_blocks;
+    if (jobs < 1)
+        jobs = 1;
+
+#ifndef _WIN32
+    if (jobs > 1) {
+        fflush(NULL); // don't duplicate buffered output in the workers
+        unsigned started = 0;
+        for (unsigned job = 0; job < jobs; ++job) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                // a worker decodes a time slice of the blocks
+                // the workers share stdout and stderr, buffer to write whole lines
+                static char out_buf[ARCHIVE_BLOCK_SIZE];
+                static char err_buf[ARCHIVE_BLOCK_SIZE];
+                setvbuf(stdout, out_buf, _IOLBF, sizeof(out_buf));
+                setvbuf(stderr, err_buf, _IOLBF, sizeof(err_buf));
+                unsigned first = (unsigned)((uint64_t)num_blocks * job / jobs);
+                unsigned last  = (unsigned)((uint64_t)num_blocks * (job + 1) / jobs);
+                // the inherited file shares its offset with the other workers, open our own
+                fclose(file);
+                file      = fopen(path, "rb");
+                int count = file ? archive_replay_blocks(file, index, first, last, from, to, cb, ctx) : -1;
+                // the outputs, reports and cleanup belong to the main process
+                fflush(NULL);
+                _exit(count < 0 ? 1 : 0);
+            }
+            if (pid < 0) {
+                print_logf(LOG_ERROR, "Archive", "Can't start a worker: %s", strerror(errno));
+                break;
+            }
+            started++;
+        }
+        int failed = started < jobs;
+        while (started--) {
+            int status = 0;
+            if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+                failed = 1;
+        }
+        print_logf(LOG_NOTICE, "Archive", "Replayed \"%s\" with %u workers", path, jobs);
+        free(index);
+        fclose(file);
+        free(path);
+        return failed ? -1 : 0;
+    }
+#endif
+
+    int count = archive_replay_blocks(file, index, 0, num_blocks, from, to, cb, ctx);
+
+    free(index);
+    fclose(file);
+    free(path);
+    return count;
+}
@@ -50,6 +50,10 @@ struct pulse_detect {
 
     int verbosity; ///< Debug output verbosity, 0=None, 1=Levels, 2=Histograms
 
+    int fsk_f1_seed; ///< Expected F1 frequency for new FSK packages, 0 if none
+    int fsk_f2_seed; ///< Expected F2 frequency for new FSK packages, 0 if none
+    int fsk_block_start; ///< Start of the FM samples not yet passed to the block detector, -1 if none
+
     pulse_detect_fsk_t pulse_detect_fsk;
 };
 
@@ -62,6 +66,7 @@ pulse_detect_t *pulse_detect_create(void)
     }
 
     pulse_detect_set_levels(pulse_detect, 0, 0.0, -12.1442, 9.0, 0);
+    pulse_detect->fsk_block_start = -1;
 
     return pulse_detect;
 }
@@ -92,6 +97,12 @@ void pulse_detect_set_levels(pulse_detect_t *pulse_detect, int use_mag_est, floa
     //        high_low_ratio, pulse_detect->ook_high_low_ratio);
 }
 
+void pulse_detect_set_fsk_seed(pulse_detect_t *pulse_detect, int fm_f1, int fm_f2)
+{
+    pulse_detect->fsk_f1_seed = fm_f1;
+    pulse_detect->fsk_f2_seed = fm_f2;
+}
+
 /// convert amplitude (16384 FS) to attenuation in (integer) dB, offset by 3.
 static inline int amp_to_att(int a)
 {
@@ -229,6 +240,9 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                     s->pulse_length = 0;
                     s->max_pulse = 0;
                     pulse_detect_fsk_init(&s->pulse_detect_fsk);
+                    s->fsk_block_start = s->data_counter + 1; // the block detector starts with the next sample
+                    if (s->fsk_f1_seed > s->fsk_f2_seed)
+                        pulse_detect_fsk_seed(&s->pulse_detect_fsk, s->fsk_f1_seed, s->fsk_f2_seed);
                     s->ook_state = PD_OOK_STATE_PULSE;
                 }
                 else {    // We are still idle..
@@ -276,12 +290,21 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                     pulses->fsk_f1_est += fm_data[s->data_counter] / OOK_EST_HIGH_RATIO - pulses->fsk_f1_est / OOK_EST_HIGH_RATIO;
                 }
                 // FSK Demodulation
-                if (pulses->num_pulses == 0) {    // Only during first pulse
+                if (pulses->num_pulses == 0 && fpdm != FSK_PULSE_DETECT_BLOCK) {    // Only during first pulse
                     if (fpdm == FSK_PULSE_DETECT_OLD) {
                         pulse_detect_fsk_classic(&s->pulse_detect_fsk, fm_data[s->data_counter], fsk_pulses);
                     } else {
                         pulse_detect_fsk_minmax(&s->pulse_detect_fsk, fm_data[s->data_counter], fsk_pulses);
                     }
+                    // Average the frequencies while the carrier is on, the estimators are biased to the extremes
+                    if (s->pulse_detect_fsk.fsk_state == PD_FSK_STATE_FH) {
+                        s->pulse_detect_fsk.fm_f1_sum += fm_data[s->data_counter];
+                        s->pulse_detect_fsk.fm_f1_count++;
+                    }
+                    else if (s->pulse_detect_fsk.fsk_state == PD_FSK_STATE_FL) {
+                        s->pulse_detect_fsk.fm_f2_sum += fm_data[s->data_counter];
+                        s->pulse_detect_fsk.fm_f2_count++;
+                    }
                 }
                 break;
             case PD_OOK_STATE_GAP_START:    // Beginning of gap - it might be a spurious gap
@@ -294,6 +317,11 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                 // Or this gap is for real?
                 else if (s->pulse_length >= PD_MIN_PULSE_SAMPLES) {
                     s->ook_state = PD_OOK_STATE_GAP;
+                    // The first pulse ended, pass its FM samples to the block detector
+                    if (fpdm == FSK_PULSE_DETECT_BLOCK && s->fsk_block_start >= 0) {
+                        pulse_detect_fsk_block(&s->pulse_detect_fsk, &fm_data[s->fsk_block_start], s->data_counter - s->fsk_block_start, fsk_pulses);
+                        s->fsk_block_start = -1;
+                    }
                     // Determine if FSK modulation is detected
                     if (fsk_pulses->num_pulses > PD_MIN_PULSES) {
                         // Store last pulse/gap
@@ -302,6 +330,9 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                         // Store estimates
                         fsk_pulses->fsk_f1_est = s->pulse_detect_fsk.fm_f1_est;
                         fsk_pulses->fsk_f2_est = s->pulse_detect_fsk.fm_f2_est;
+                        pulse_detect_fsk_t const *fsk = &s->pulse_detect_fsk;
+                        fsk_pulses->fsk_f1_avg = fsk->fm_f1_count ? (int)(fsk->fm_f1_sum / fsk->fm_f1_count) : 0;
+                        fsk_pulses->fsk_f2_avg = fsk->fm_f2_count ? (int)(fsk->fm_f2_sum / fsk->fm_f2_count) : 0;
                         fsk_pulses->ook_low_estimate = s->ook_low_estimate;
                         fsk_pulses->ook_high_estimate = s->ook_high_estimate;
                         pulses->end_ago = len - s->data_counter;
@@ -321,7 +352,7 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
                     }
                 } // if
                 // FSK Demodulation (continue during short gap - we might return...)
-                if (pulses->num_pulses == 0) {    // Only during first pulse
+                if (pulses->num_pulses == 0 && fpdm != FSK_PULSE_DETECT_BLOCK) {    // Only during first pulse
                     if (fpdm == FSK_PULSE_DETECT_OLD) {
                         pulse_detect_fsk_classic(&s->pulse_detect_fsk, fm_data[s->data_counter], fsk_pulses);
                     } else {
@@ -385,6 +416,17 @@ int pulse_detect_package(pulse_detect_t *pulse_detect, int16_t const *envelope_d
         s->data_counter += 1;
     } // while
 
+    // Still in the first pulse? Pass the FM samples of this chunk to the block detector
+    if (fpdm == FSK_PULSE_DETECT_BLOCK && s->fsk_block_start >= 0) {
+        if ((s->ook_state == PD_OOK_STATE_PULSE || s->ook_state == PD_OOK_STATE_GAP_START) && pulses->num_pulses == 0) {
+            pulse_detect_fsk_block(&s->pulse_detect_fsk, &fm_data[s->fsk_block_start], len - s->fsk_block_start, fsk_pulses);
+            s->fsk_block_start = 0;
+        }
+        else {
+            s->fsk_block_start = -1;
+        }
+    }
+
     s->data_counter = 0;
     if (pulse_detect->verbosity >= LOG_DEBUG) {
         print_att_hist("Out of data", att_hist);
@@ -31,6 +31,17 @@ void pulse_detect_fsk_init(pulse_detect_fsk_t *s)
     s->skip_samples = 40;
 }
 
+void pulse_detect_fsk_seed(pulse_detect_fsk_t *s, int fm_f1, int fm_f2)
+{
+    if (fm_f1 <= fm_f2)
+        return; // not a usable seed
+    s->fm_f1_seed   = fm_f1;
+    s->fm_f2_seed   = fm_f2;
+    s->var_test_max = (int16_t)MIN(fm_f1, INT16_MAX);
+    s->var_test_min = (int16_t)MAX(fm_f2, INT16_MIN);
+    s->skip_samples = PD_MIN_PULSE_SAMPLES;
+}
+
 void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *fsk_pulses)
 {
     int const fm_f1_delta = abs(fm_n - s->fm_f1_est); // Get delta from F1 frequency estimate
@@ -43,6 +54,23 @@ void pulse_detect_fsk_classic(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t
             if (s->fsk_pulse_length < PD_MIN_PULSE_SAMPLES) {
                 s->fm_f1_est = s->fm_f1_est/2 + fm_n/2;        // Quick initial estimator
             }
+            // Seeded and initial frequency near F1 or F2? Then prime the other estimate with the seeded deviation
+            else if (s->fm_f1_seed > s->fm_f2_seed
+                    && MIN(abs(s->fm_f1_est - s->fm_f1_seed), abs(s->fm_f1_est - s->fm_f2_seed)) < (s->fm_f1_seed - s->fm_f2_seed) / 2) {
+                int const fm_seed_delta = s->fm_f1_seed - s->fm_f2_seed;
+                // Initial frequency was high (pulse)
+                if (abs(s->fm_f1_est - s->fm_f1_seed) < abs(s->fm_f1_est - s->fm_f2_seed)) {
+                    s->fsk_state = PD_FSK_STATE_FH;
+                    s->fm_f2_est = s->fm_f1_est - fm_seed_delta;
+                }
+                // Initial frequency was low (gap), store a zero width pulse before it
+                else {
+                    s->fsk_state = PD_FSK_STATE_FL;
+                    s->fm_f2_est = s->fm_f1_est;
+                    s->fm_f1_est = s->fm_f2_est + fm_seed_delta;
+                    fsk_pulses->pulse[0] = 0;
+                }
+            }
             // Above default frequency delta?
             else if (fm_f1_delta > (FSK_DEFAULT_FM_DELTA/2)) {
                 // Positive frequency delta - Initial frequency was low (gap)
@@ -219,3 +247,117 @@ void pulse_detect_fsk_minmax(pulse_detect_fsk_t *s, int16_t fm_n, pulse_data_t *
         s->skip_samples -= 1;
     }
 }
+
+#define FSK_BLOCK_SAMPLES 64 // block size of the block detector, one bit mask word
+#define FSK_BLOCK_DECAY   10 // limit decay per sample, as in the minmax detector
+
+#if defined(__GNUC__) || defined(__clang__)
+#define fsk_ctz64(x)      __builtin_ctzll(x)
+#define fsk_popcount64(x) __builtin_popcountll(x)
+#else
+static inline unsigned fsk_ctz64(uint64_t x)
+{
+    unsigned n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static inline unsigned fsk_popcount64(uint64_t x)
+{
+    unsigned n = 0;
+    for (; x; x &= x - 1)
+        n++;
+    return n;
+}
+#endif
+
+void pulse_detect_fsk_block(pulse_detect_fsk_t *s, int16_t const *fm_data, unsigned len, pulse_data_t *fsk_pulses)
+{
+    // Skip a few samples in the beginning, as in the minmax detector
+    unsigned skip = MIN((unsigned)s->skip_samples, len);
+    s->skip_samples -= skip;
+    fm_data += skip;
+    len -= skip;
+
+    while (len > 0) {
+        unsigned const n = MIN(len, FSK_BLOCK_SAMPLES);
+
+        // Block limits, a plain loop the compiler can vectorize
+        int hi = fm_data[0];
+        int lo = fm_data[0];
+        for (unsigned i = 1; i < n; ++i) {
+            hi = MAX(hi, fm_data[i]);
+            lo = MIN(lo, fm_data[i]);
+        }
+        int max = MAX(hi, s->var_test_max);
+        int min = MIN(lo, s->var_test_min);
+        int const mid = (max + min) / 2;
+
+        // Threshold the block into a bit mask, bit i is set for a sample above the midpoint
+        uint64_t bits  = 0;
+        int64_t sum    = 0;
+        int64_t f1_sum = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            int const above = fm_data[i] > mid;
+            bits |= (uint64_t)above << i;
+            sum += fm_data[i];
+            f1_sum += above ? fm_data[i] : 0;
+        }
+        unsigned const f1_count = fsk_popcount64(bits);
+        s->fm_f1_sum += f1_sum;
+        s->fm_f2_sum += sum - f1_sum;
+        s->fm_f1_count += f1_count;
+        s->fm_f2_count += n - f1_count;
+
+        // Decay the limits towards the midpoint by the samples on their side
+        max -= FSK_BLOCK_DECAY * (int)f1_count;
+        min += FSK_BLOCK_DECAY * (int)(n - f1_count);
+        if (max < min)
+            max = min = mid;
+        s->var_test_max = (int16_t)max;
+        s->var_test_min = (int16_t)min;
+
+        // The initial frequency is the level before the first sample
+        if (s->fsk_state == PD_FSK_STATE_INIT)
+            s->fsk_state = (bits & 1) ? PD_FSK_STATE_FH : PD_FSK_STATE_FL;
+        uint64_t const prev = s->fsk_state == PD_FSK_STATE_FH;
+
+        // Transitions, bit i is set if sample i differs from the one before
+        uint64_t edges = bits ^ (bits << 1 | prev);
+        if (n < FSK_BLOCK_SAMPLES)
+            edges &= ((uint64_t)1 << n) - 1;
+        unsigned pos = 0;
+        while (edges) {
+            unsigned const edge = fsk_ctz64(edges);
+            s->fsk_pulse_length += edge - pos;
+            if (s->fsk_state == PD_FSK_STATE_FH) {
+                s->fsk_state = PD_FSK_STATE_FL;
+                fsk_pulses->pulse[fsk_pulses->num_pulses] = s->fsk_pulse_length;
+            }
+            else {
+                s->fsk_state = PD_FSK_STATE_FH;
+                fsk_pulses->gap[fsk_pulses->num_pulses] = s->fsk_pulse_length;
+                fsk_pulses->num_pulses += 1;
+                // When pulse buffer is full free some of the buffer, as in the minmax detector
+                if (fsk_pulses->num_pulses >= PD_MAX_PULSES) {
+                    pulse_data_shift(fsk_pulses);
+                }
+            }
+            s->fsk_pulse_length = 0;
+            pos = edge;
+            edges &= edges - 1;
+        }
+        s->fsk_pulse_length += n - pos;
+
+        fm_data += n;
+        len -= n;
+    }
+
+    if (s->fm_f1_count)
+        s->fm_f1_est = (int)(s->fm_f1_sum / s->fm_f1_count);
+    if (s->fm_f2_count)
+        s->fm_f2_est = (int)(s->fm_f2_sum / s->fm_f2_count);
+}
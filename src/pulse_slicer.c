@@ -16,20 +16,65 @@
 #include "bitbuffer.h"
 #include "util.h"
 #include "logger.h"
+#include "r_util.h"
+#include "compat_time.h"
 #include "decoder_util.h" // TODO: this should be refactored
+#include "sync_match.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
 #include <limits.h>
 
+#define BUDGET_STRIKES 8 // recent over budget runs without events to demote a decoder
+#define BUDGET_SAMPLE 16 // a demoted decoder runs on every Nth package only
+
+/// Demote decoders which repeatedly exceed the time budget without producing events.
+static void account_budget(r_device *device, unsigned elapsed_us, int ret)
+{
+    device->decode_us += elapsed_us;
+
+    if (ret > 0) {
+        // a real signal, always promote
+        device->budget_strikes = 0;
+        if (device->demoted) {
+            device->demoted = 0;
+            print_logf(LOG_NOTICE, "Budget", "Decoder [%u] \"%s\" restored after a successful decode",
+                    device->protocol_num, device->name);
+        }
+    }
+    else if (elapsed_us <= device->budget_us) {
+        if (device->budget_strikes)
+            device->budget_strikes--;
+    }
+    else if (++device->budget_strikes >= BUDGET_STRIKES && !device->demoted) {
+        device->demoted = BUDGET_SAMPLE;
+        print_logf(LOG_WARNING, "Budget", "Decoder [%u] \"%s\" took %u us (budget %u us), running on every %uth package only",
+                device->protocol_num, device->name, elapsed_us, device->budget_us, device->demoted);
+    }
+}
+
 static int account_event(r_device *device, bitbuffer_t *bits, char const *demod_name)
 {
     // run decoder
     int ret = 0;
-    if (device->decode_fn) {
+    if (device->sync_match && !(sync_match_scan(device->sync_match, bits) & device->sync_mask)) {
+        ret = DECODE_ABORT_EARLY; // none of the sync words seen, don't run the decoder
+    }
+    else if (device->decode_fn && device->budget_us) {
+        uint64_t start = monotonic_time_us();
+        ret = device->decode_fn(device, bits);
+        uint64_t end = monotonic_time_us();
+        uint64_t elapsed = end > start ? end - start : 0;
+        account_budget(device, elapsed < UINT_MAX ? (unsigned)elapsed : UINT_MAX, ret);
+    }
+    else if (device->decode_fn) {
         ret = device->decode_fn(device, bits);
     }
+    decoder_scratch_reset(device);
+    bitbuffer_invalidate(bits); // cached copies were in the scratch
+    if (device->sync_match)
+        sync_match_done(device->sync_match);
 
     // statistics accounting
     device->decode_events += 1;
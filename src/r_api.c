@@ -22,8 +22,11 @@
 #include "r_private.h"
 #include "rtl_433_devices.h"
 #include "r_device.h"
+#include "decoder_util.h"
 #include "pulse_slicer.h"
 #include "pulse_detect_fsk.h"
+#include "fsk_afc.h"
+#include "sync_match.h"
 #include "sdr.h"
 #include "data.h"
 #include "data_tag.h"
@@ -36,7 +39,12 @@
 #include "output_influx.h"
 #include "output_trigger.h"
 #include "output_rtltcp.h"
+#include "output_shm.h"
+#include "output_arrow.h"
+#include "event_store.h"
+#include "mesh_topology.h"
 #include "write_sigrok.h"
+#include "pulse_archive.h"
 #include "mongoose.h"
 #include "compat_time.h"
 #include "logger.h"
@@ -126,6 +134,23 @@ void set_sample_rate(r_cfg_t *cfg, uint32_t sample_rate)
     sdr_set_sample_rate(cfg->dev, sample_rate, 0);
 }
 
+void set_hop_frequencies(r_cfg_t *cfg, uint32_t const *frequencies, int count)
+{
+    if (count < 1)
+        return;
+    if (count > MAX_FREQS)
+        count = MAX_FREQS;
+    memcpy(cfg->frequency, frequencies, count * sizeof(*frequencies));
+    cfg->frequencies = count;
+    cfg->frequency_index = 0;
+    if (cfg->frequencies > 1 && cfg->hop_times == 0) {
+        cfg->hop_time[cfg->hop_times++] = DEFAULT_HOP_TIME;
+    }
+    time(&cfg->hop_start_time);
+    // cfg->center_frequency = frequencies[0]; // actually applied in the sdr event
+    sdr_set_center_freq(cfg->dev, cfg->frequency[0], 1);
+}
+
 void set_gain_str(struct r_cfg *cfg, char const *gain_str)
 {
     free(cfg->gain_str);
@@ -154,6 +179,8 @@ void r_init_cfg(r_cfg_t *cfg)
 
     list_ensure_size(&cfg->in_files, 100);
     list_ensure_size(&cfg->output_handler, 16);
+    list_ensure_size(&cfg->output_specs, 16);
+    list_ensure_size(&cfg->output_args, 16);
 
     // collect devices list, this should be a module
     r_device r_devices[] = {
@@ -219,22 +246,36 @@ void r_free_cfg(r_cfg_t *cfg)
             fclose(dumper->file);
     }
     list_free_elems(&cfg->demod->dumper, free);
+    pulse_archive_close(cfg->demod->pulse_archive);
+
+    list_free_elems(&cfg->demod->dispatch, NULL);
 
     list_free_elems(&cfg->demod->r_devs, (list_elem_free_fn)free_protocol);
+    sync_match_free(cfg->demod->sync_match);
 
     if (cfg->demod->am_analyze)
         am_analyze_free(cfg->demod->am_analyze);
 
     pulse_detect_free(cfg->demod->pulse_detect);
 
+    fsk_afc_free(cfg->demod->fsk_afc);
+
     list_free_elems(&cfg->raw_handler, (list_elem_free_fn)raw_output_free);
 
     r_logger_set_log_handler(NULL, NULL);
 
     list_free_elems(&cfg->output_handler, (list_elem_free_fn)data_output_free);
 
+    list_free_elems(&cfg->output_specs, free);
+
+    list_free_elems(&cfg->output_args, free);
+
+    list_free_elems(&cfg->conf_outputs, free);
+
     list_free_elems(&cfg->data_tags, (list_elem_free_fn)data_tag_free);
 
+    mesh_topology_free(cfg->mesh);
+
     list_free_elems(&cfg->in_files, NULL);
 
     free(cfg->demod);
@@ -284,7 +325,10 @@ void register_protocol(r_cfg_t *cfg, r_device *r_dev, char *arg)
     p->output_fn  = data_acquired_handler;
     p->output_ctx = cfg;
 
+    p->budget_us = cfg->demod->decode_budget_us;
+
     list_push(&cfg->demod->r_devs, p);
+    cfg->devices_gen++;
 
     if (cfg->verbosity >= LOG_INFO) {
         fprintf(stderr, "Registering protocol [%u] \"%s\"\n", r_dev->protocol_num, r_dev->name);
@@ -294,6 +338,7 @@ void register_protocol(r_cfg_t *cfg, r_device *r_dev, char *arg)
 void free_protocol(r_device *r_dev)
 {
     // free(r_dev->name);
+    decoder_scratch_free(r_dev);
     free(r_dev->decode_ctx);
     free(r_dev);
 }
@@ -305,6 +350,7 @@ void unregister_protocol(r_cfg_t *cfg, r_device *r_dev)
         if (!strcmp(p->name, r_dev->name)) {
             list_remove(&cfg->demod->r_devs, i, (list_elem_free_fn)free_protocol);
             i--; // so we don't skip the next elem now shifted down
+            cfg->devices_gen++;
         }
     }
 }
@@ -319,6 +365,37 @@ void register_all_protocols(r_cfg_t *cfg, unsigned disabled)
     }
 }
 
+r_device *find_protocol(r_cfg_t *cfg, unsigned protocol_num, char const *name)
+{
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        if (protocol_num && r_dev->protocol_num == protocol_num)
+            return r_dev;
+        if (!protocol_num && name && !strcmp(r_dev->name, name))
+            return r_dev;
+    }
+    return NULL;
+}
+
+void update_dispatch(r_cfg_t *cfg)
+{
+    cfg->devices_gen++;
+
+    // one automaton for the sync words of all decoders
+    sync_match_free(cfg->demod->sync_match);
+    cfg->demod->sync_match = sync_match_create(&cfg->demod->r_devs);
+
+    // check if we need FM demod
+    cfg->demod->enable_FM_demod = 0;
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        if (r_dev->modulation >= FSK_DEMOD_MIN_VAL) {
+            cfg->demod->enable_FM_demod = 1;
+            break;
+        }
+    }
+}
+
 /* output helper */
 
 void calc_rssi_snr(r_cfg_t *cfg, pulse_data_t *pulse_data)
@@ -480,7 +557,96 @@ char const **determine_csv_fields(r_cfg_t *cfg, char const *const *well_known, i
     return (char const **)field_list.elems;
 }
 
-int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
+// find the fields output for a single decoder
+char const **determine_device_fields(r_cfg_t *cfg, r_device *r_dev)
+{
+    list_t field_list = {0};
+    list_ensure_size(&field_list, 40);
+
+    char const **well_known = well_known_output_fields(cfg);
+    list_push_all(&field_list, (void **)well_known);
+    free((void *)well_known);
+
+    if (r_dev && r_dev->fields)
+        list_push_all(&field_list, (void **)r_dev->fields);
+    convert_csv_fields(cfg, (char const **)field_list.elems);
+
+    return (char const **)field_list.elems;
+}
+
+void set_decode_budget(r_cfg_t *cfg, unsigned budget_us)
+{
+    cfg->demod->decode_budget_us = budget_us;
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        r_dev->budget_us = budget_us;
+    }
+}
+
+int restore_demoted(r_cfg_t *cfg, unsigned protocol_num)
+{
+    int restored = 0;
+    for (void **iter = cfg->demod->r_devs.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        if (protocol_num && r_dev->protocol_num != protocol_num)
+            continue;
+        if (r_dev->demoted)
+            restored++;
+        r_dev->demoted        = 0;
+        r_dev->demoted_skip   = 0;
+        r_dev->budget_strikes = 0;
+    }
+    return restored;
+}
+
+/// Demoted decoders only run on every Nth package.
+static int skip_demoted(r_device *r_dev)
+{
+    if (!r_dev->demoted)
+        return 0;
+    if (++r_dev->demoted_skip < r_dev->demoted)
+        return 1;
+    r_dev->demoted_skip = 0;
+    return 0;
+}
+
+/// Slice a package with the given decoder, the decoder modulation must match the package.
+static int slice_package(r_device *r_dev, pulse_data_t *pulse_data)
+{
+    switch (r_dev->modulation) {
+    case OOK_PULSE_PCM:
+    // case OOK_PULSE_RZ:
+        return pulse_slicer_pcm(pulse_data, r_dev);
+    case OOK_PULSE_PPM:
+        return pulse_slicer_ppm(pulse_data, r_dev);
+    case OOK_PULSE_PWM:
+        return pulse_slicer_pwm(pulse_data, r_dev);
+    case OOK_PULSE_MANCHESTER_ZEROBIT:
+        return pulse_slicer_manchester_zerobit(pulse_data, r_dev);
+    case OOK_PULSE_PIWM_RAW:
+        return pulse_slicer_piwm_raw(pulse_data, r_dev);
+    case OOK_PULSE_PIWM_DC:
+        return pulse_slicer_piwm_dc(pulse_data, r_dev);
+    case OOK_PULSE_DMC:
+        return pulse_slicer_dmc(pulse_data, r_dev);
+    case OOK_PULSE_PWM_OSV1:
+        return pulse_slicer_osv1(pulse_data, r_dev);
+    case OOK_PULSE_NRZS:
+        return pulse_slicer_nrzs(pulse_data, r_dev);
+    // FSK decoders
+    case FSK_PULSE_PCM:
+        return pulse_slicer_pcm(pulse_data, r_dev);
+    case FSK_PULSE_PWM:
+        return pulse_slicer_pwm(pulse_data, r_dev);
+    case FSK_PULSE_MANCHESTER_ZEROBIT:
+        return pulse_slicer_manchester_zerobit(pulse_data, r_dev);
+    default:
+        fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
+        return 0;
+    }
+}
+
+static int run_demods(list_t *r_devs, pulse_data_t *pulse_data, int fsk)
 {
     int p_events = 0;
 
@@ -497,97 +663,152 @@ int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
             // Run only current priority
             if (r_dev->priority != priority)
                 continue;
+            // Run only decoders for this package type
+            if ((r_dev->modulation >= FSK_DEMOD_MIN_VAL) != fsk)
+                continue;
+            if (skip_demoted(r_dev))
+                continue;
 
-            switch (r_dev->modulation) {
-            case OOK_PULSE_PCM:
-            // case OOK_PULSE_RZ:
-                p_events += pulse_slicer_pcm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PPM:
-                p_events += pulse_slicer_ppm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PWM:
-                p_events += pulse_slicer_pwm(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_MANCHESTER_ZEROBIT:
-                p_events += pulse_slicer_manchester_zerobit(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PIWM_RAW:
-                p_events += pulse_slicer_piwm_raw(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PIWM_DC:
-                p_events += pulse_slicer_piwm_dc(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_DMC:
-                p_events += pulse_slicer_dmc(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_PWM_OSV1:
-                p_events += pulse_slicer_osv1(pulse_data, r_dev);
-                break;
-            case OOK_PULSE_NRZS:
-                p_events += pulse_slicer_nrzs(pulse_data, r_dev);
-                break;
-            // FSK decoders
-            case FSK_PULSE_PCM:
-            case FSK_PULSE_PWM:
-            case FSK_PULSE_MANCHESTER_ZEROBIT:
-                break;
-            default:
-                fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
-            }
+            int ret = slice_package(r_dev, pulse_data);
+            if (ret > 0)
+                r_dev->dispatch_hits++;
+            p_events += ret;
         }
     }
 
     return p_events;
 }
 
+int run_ook_demods(list_t *r_devs, pulse_data_t *pulse_data)
+{
+    return run_demods(r_devs, pulse_data, 0);
+}
+
 int run_fsk_demods(list_t *r_devs, pulse_data_t *fsk_pulse_data)
 {
-    int p_events = 0;
+    return run_demods(r_devs, fsk_pulse_data, 1);
+}
 
-    unsigned next_priority = 0; // next smallest on each loop through decoders
-    // run all decoders of each priority, stop if an event is produced
-    for (unsigned priority = 0; !p_events && priority < UINT_MAX; priority = next_priority) {
-        next_priority = UINT_MAX;
-        for (void **iter = r_devs->elems; iter && *iter; ++iter) {
-            r_device *r_dev = *iter;
+/* first match dispatch */
 
-            // Find next smallest priority
-            if (r_dev->priority > priority && r_dev->priority < next_priority)
-                next_priority = r_dev->priority;
-            // Run only current priority
-            if (r_dev->priority != priority)
-                continue;
+#define DISPATCH_RESORT 256 // packages between re-sorting by hit rate
 
-            switch (r_dev->modulation) {
-            // OOK decoders
-            case OOK_PULSE_PCM:
-            // case OOK_PULSE_RZ:
-            case OOK_PULSE_PPM:
-            case OOK_PULSE_PWM:
-            case OOK_PULSE_MANCHESTER_ZEROBIT:
-            case OOK_PULSE_PIWM_RAW:
-            case OOK_PULSE_PIWM_DC:
-            case OOK_PULSE_DMC:
-            case OOK_PULSE_PWM_OSV1:
-            case OOK_PULSE_NRZS:
-                break;
-            case FSK_PULSE_PCM:
-                p_events += pulse_slicer_pcm(fsk_pulse_data, r_dev);
-                break;
-            case FSK_PULSE_PWM:
-                p_events += pulse_slicer_pwm(fsk_pulse_data, r_dev);
+// hit rate score, decayed on each re-sort
+static unsigned dispatch_score(r_device const *r_dev)
+{
+    return r_dev->dispatch_score + r_dev->dispatch_hits;
+}
+
+// order by priority, then by hit rate, stable otherwise
+static void dispatch_sort(list_t *dispatch)
+{
+    void **elems = dispatch->elems;
+    for (size_t i = 1; i < dispatch->len; ++i) {
+        r_device *r_dev = elems[i];
+        size_t j = i;
+        for (; j > 0; --j) {
+            r_device *prev = elems[j - 1];
+            if (prev->priority < r_dev->priority
+                    || (prev->priority == r_dev->priority && dispatch_score(prev) >= dispatch_score(r_dev)))
                 break;
-            case FSK_PULSE_MANCHESTER_ZEROBIT:
-                p_events += pulse_slicer_manchester_zerobit(fsk_pulse_data, r_dev);
+            elems[j] = prev;
+        }
+        elems[j] = r_dev;
+    }
+}
+
+static void dispatch_update(r_cfg_t *cfg)
+{
+    struct dm_state *demod = cfg->demod;
+
+    if (demod->dispatch_gen != cfg->devices_gen || demod->dispatch.len != demod->r_devs.len) {
+        // decoders changed, rebuild
+        list_clear(&demod->dispatch, NULL);
+        list_ensure_size(&demod->dispatch, demod->r_devs.len);
+        for (void **iter = demod->r_devs.elems; iter && *iter; ++iter)
+            list_push(&demod->dispatch, *iter);
+        demod->dispatch_gen = cfg->devices_gen;
+    }
+    else if (demod->dispatch_packages % DISPATCH_RESORT) {
+        return;
+    }
+
+    for (void **iter = demod->dispatch.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        r_dev->dispatch_score = dispatch_score(r_dev) / 2;
+        r_dev->dispatch_hits  = 0;
+    }
+    dispatch_sort(&demod->dispatch);
+}
+
+static int run_first_match(r_cfg_t *cfg, pulse_data_t *pulse_data, int fsk)
+{
+    struct dm_state *demod = cfg->demod;
+
+    demod->dispatch_packages++;
+    dispatch_update(cfg);
+
+    // safety valve: periodically run all decoders to find overlaps a first match would miss
+    if (demod->dispatch_packages % demod->first_match_full == 0) {
+        int p_events = 0;
+        unsigned matches = 0;
+        for (void **iter = demod->dispatch.elems; iter && *iter; ++iter) {
+            r_device *r_dev = *iter;
+            // the list is ordered by priority, stop after the first priority producing events
+            if (p_events && r_dev->priority != ((r_device *)iter[-1])->priority)
                 break;
-            default:
-                fprintf(stderr, "Unknown modulation %u in protocol!\n", r_dev->modulation);
+            if ((r_dev->modulation >= FSK_DEMOD_MIN_VAL) != fsk)
+                continue;
+            if (skip_demoted(r_dev))
+                continue;
+            int ret = slice_package(r_dev, pulse_data);
+            if (ret > 0) {
+                r_dev->dispatch_hits++;
+                matches++;
             }
+            p_events += ret;
         }
+        demod->dispatch_full_runs++;
+        if (matches > 1)
+            demod->dispatch_overlaps++;
+        return p_events;
     }
 
-    return p_events;
+    for (void **iter = demod->dispatch.elems; iter && *iter; ++iter) {
+        r_device *r_dev = *iter;
+        if ((r_dev->modulation >= FSK_DEMOD_MIN_VAL) != fsk)
+            continue;
+        if (skip_demoted(r_dev))
+            continue;
+        int ret = slice_package(r_dev, pulse_data);
+        if (ret > 0) {
+            r_dev->dispatch_hits++;
+            return ret; // first match wins
+        }
+    }
+
+    return 0;
+}
+
+void set_first_match(r_cfg_t *cfg, unsigned full_interval)
+{
+    cfg->demod->first_match      = full_interval > 0;
+    cfg->demod->first_match_full = full_interval;
+    cfg->demod->dispatch_gen     = cfg->devices_gen - 1; // force a rebuild
+}
+
+int run_ook_dispatch(r_cfg_t *cfg, pulse_data_t *pulse_data)
+{
+    if (!cfg->demod->first_match)
+        return run_demods(&cfg->demod->r_devs, pulse_data, 0);
+    return run_first_match(cfg, pulse_data, 0);
+}
+
+int run_fsk_dispatch(r_cfg_t *cfg, pulse_data_t *fsk_pulse_data)
+{
+    if (!cfg->demod->first_match)
+        return run_demods(&cfg->demod->r_devs, fsk_pulse_data, 1);
+    return run_first_match(cfg, fsk_pulse_data, 1);
 }
 
 /* handlers */
@@ -673,10 +894,58 @@ void log_device_handler(r_device *r_dev, int level, data_t *data)
 }
 
 /** Pass the data structure to all output handlers. Frees data afterwards. */
+/// Update the AFC with the current FSK package, once per package, keyed by "model/id" of the event.
+static void update_fsk_afc(r_cfg_t *cfg, data_t *data)
+{
+    pulse_data_t const *pulses = &cfg->demod->fsk_pulse_data;
+    if (pulses->fsk_f1_avg <= pulses->fsk_f2_avg || pulses->offset == cfg->demod->afc_last_offset)
+        return;
+    cfg->demod->afc_last_offset = pulses->offset;
+
+    char const *model = NULL;
+    char const *id    = NULL;
+    char id_buf[16];
+    for (data_t *d = data; d; d = d->next) {
+        if (!strcmp(d->key, "model") && d->type == DATA_STRING)
+            model = d->value.v_ptr;
+        else if (!strcmp(d->key, "id") && d->type == DATA_STRING)
+            id = d->value.v_ptr;
+        else if (!strcmp(d->key, "id") && d->type == DATA_INT) {
+            snprintf(id_buf, sizeof(id_buf), "%d", d->value.v_int);
+            id = id_buf;
+        }
+    }
+    char key[64] = {0};
+    if (model && id)
+        snprintf(key, sizeof(key), "%s/%s", model, id);
+
+    float f1_hz = (float)pulses->fsk_f1_avg / INT16_MAX * cfg->samp_rate / 2.0f;
+    float f2_hz = (float)pulses->fsk_f2_avg / INT16_MAX * cfg->samp_rate / 2.0f;
+    fsk_afc_update(cfg->demod->fsk_afc, f1_hz, f2_hz, key);
+}
+
+/// Index a Gridstream event in the mesh topology, whatever the outputs are.
+static void update_mesh(r_cfg_t *cfg, data_t *data)
+{
+    for (data_t *d = data; d; d = d->next) {
+        if (strcmp(d->key, "model"))
+            continue;
+        if (d->type != DATA_STRING || strcmp(d->value.v_ptr, "LandisGyr-GS"))
+            return;
+        if (!cfg->mesh)
+            cfg->mesh = mesh_topology_new(0, 0, 0);
+        mesh_topology_update(cfg->mesh, data, time(NULL));
+        return;
+    }
+}
+
 void data_acquired_handler(r_device *r_dev, data_t *data)
 {
     r_cfg_t *cfg = r_dev->output_ctx;
 
+    if (cfg->demod->fsk_afc && r_dev->modulation >= FSK_DEMOD_MIN_VAL)
+        update_fsk_afc(cfg, data);
+
 #ifndef NDEBUG
     // check for undeclared csv fields
     for (data_t *d = data; d; d = d->next) {
@@ -894,10 +1163,14 @@ void data_acquired_handler(r_device *r_dev, data_t *data)
         data            = data_tag_apply(tag, data, cfg->in_filename);
     }
 
+    update_mesh(cfg, data);
+
+    cfg->output_device = r_dev;
     for (size_t i = 0; i < cfg->output_handler.len; ++i) { // list might contain NULLs
         data_output_t *output = cfg->output_handler.elems[i];
         data_output_print(output, data);
     }
+    cfg->output_device = NULL;
     data_free(data);
 }
 
@@ -946,6 +1219,20 @@ data_t *create_report_data(r_cfg_t *cfg, int level)
             data_append(data,
                     "fail_sanity",  "", DATA_INT, r_dev->decode_fails[-DECODE_FAIL_SANITY],
                     NULL);
+        if (r_dev->budget_us)
+            data_append(data,
+                    "decode_us",    "", DATA_INT, r_dev->decode_us,
+                    NULL);
+        if (r_dev->demoted)
+            data_append(data,
+                    "demoted",      "", DATA_INT, r_dev->demoted,
+                    NULL);
+        // only decoder_scratch() allocations, not a decoder's own malloc() calls
+        if (r_dev->scratch_allocs)
+            data_append(data,
+                    "scratch_allocs", "", DATA_INT, r_dev->scratch_allocs,
+                    "scratch_bytes",  "", DATA_INT, r_dev->scratch_size,
+                    NULL);
 
         list_push(&dev_data_list, data);
     }
@@ -959,12 +1246,26 @@ data_t *create_report_data(r_cfg_t *cfg, int level)
     char since_str[LOCAL_TIME_BUFLEN];
     format_time_str(since_str, "%Y-%m-%dT%H:%M:%S", cfg->report_time_tz, cfg->frames_since);
 
+    if (cfg->demod->first_match)
+        data_append(data,
+                "full_runs",    "", DATA_INT, cfg->demod->dispatch_full_runs,
+                "overlaps",     "", DATA_INT, cfg->demod->dispatch_overlaps,
+                NULL);
+
     data = data_make(
             "enabled",          "", DATA_INT, r_devs->len,
             "since",            "", DATA_STRING, since_str,
             "frames",           "", DATA_DATA, data,
             "stats",            "", DATA_ARRAY, data_array(dev_data_list.len, DATA_DATA, dev_data_list.elems),
             NULL);
+    if (cfg->startup_us)
+        data_append(data,
+                "startup_us",   "", DATA_INT, cfg->startup_us,
+                NULL);
+    if (cfg->demod->fsk_afc)
+        data_append(data,
+                "afc",          "", DATA_DATA, fsk_afc_report(cfg->demod->fsk_afc, cfg->center_frequency),
+                NULL);
 
     list_free_elems(&dev_data_list, NULL);
     return data;
@@ -978,6 +1279,8 @@ void flush_report_data(r_cfg_t *cfg)
     cfg->frames_count = 0;
     cfg->frames_fsk = 0;
     cfg->frames_events = 0;
+    cfg->demod->dispatch_full_runs = 0;
+    cfg->demod->dispatch_overlaps  = 0;
 
     for (void **iter = r_devs->elems; iter && *iter; ++iter) {
         r_device *r_dev = *iter;
@@ -990,11 +1293,14 @@ void flush_report_data(r_cfg_t *cfg)
         r_dev->decode_fails[2] = 0;
         r_dev->decode_fails[3] = 0;
         r_dev->decode_fails[4] = 0;
+        r_dev->decode_us = 0;
+        r_dev->scratch_allocs = 0;
     }
 }
 
 /* setup */
 
+/// Parse an optional ", v = <n>" log level, returns -1 if invalid.
 static int lvlarg_param(char **param, int default_verb)
 {
     if (!param || !*param) {
@@ -1010,29 +1316,30 @@ static int lvlarg_param(char **param, int default_verb)
         p++;
     if (*p != 'v') {
         fprintf(stderr, "Unknown output option \"%s\"\n", *param);
-        exit(1);
+        return -1;
     }
     p++;
     while (*p == ' ' || *p == '\t')
         p++;
     if (*p != '=') {
         fprintf(stderr, "Unknown output option \"%s\"\n", *param);
-        exit(1);
+        return -1;
     }
     p++;
     while (*p == ' ' || *p == '\t')
         p++;
     char *endptr;
     int val = strtol(p, &endptr, 10);
-    if (p == endptr) {
+    if (p == endptr || val < 0) {
         fprintf(stderr, "Invalid output option \"%s\"\n", *param);
-        exit(1);
+        return -1;
     }
     *param = endptr;
     return val;
 }
 
 /// Opens the path @p param (or STDOUT if empty or `-`) for append writing, removes leading `,` and `:` from path name.
+/// Returns NULL if the file can't be opened.
 static FILE *fopen_output(char const *param)
 {
     if (!param || !*param) {
@@ -1050,21 +1357,155 @@ static FILE *fopen_output(char const *param)
     FILE *file = fopen(param, "a");
     if (!file) {
         fprintf(stderr, "rtl_433: failed to open output file\n");
-        exit(1);
     }
     return file;
 }
 
-void add_json_output(r_cfg_t *cfg, char *param)
+int output_spec_console(char const *spec)
+{
+    if (!spec || !*spec)
+        return 1; // the default kv output
+    if (strncmp(spec, "json", 4) && strncmp(spec, "csv", 3) && strncmp(spec, "log", 3) && strncmp(spec, "kv", 2))
+        return 0;
+    // the path follows the type or the log level, e.g. "json:out.json" or "kv,v=5:-"
+    char const *path = arg_param(spec);
+    if (path && *path == ',')
+        path = strchr(path, ':');
+    if (path && *path == ':')
+        path++;
+    return !path || !*path || !strcmp(path, "-");
+}
+
+int add_json_output(r_cfg_t *cfg, char *param)
 {
     int log_level = lvlarg_param(&param, 0);
-    list_push(&cfg->output_handler, data_output_json_create(log_level, fopen_output(param)));
+    FILE *file    = log_level < 0 ? NULL : fopen_output(param);
+    if (!file)
+        return -1;
+    list_push(&cfg->output_handler, data_output_json_create(log_level, file));
+    return 0;
 }
 
-void add_csv_output(r_cfg_t *cfg, char *param)
+int add_csv_output(r_cfg_t *cfg, char *param)
 {
     int log_level = lvlarg_param(&param, 0);
-    list_push(&cfg->output_handler, data_output_csv_create(log_level, fopen_output(param)));
+    FILE *file    = log_level < 0 ? NULL : fopen_output(param);
+    if (!file)
+        return -1;
+    list_push(&cfg->output_handler, data_output_csv_create(log_level, file));
+    return 0;
+}
+
+int add_output(r_cfg_t *cfg, char *arg)
+{
+    size_t outputs = cfg->output_handler.len;
+    char *spec = strdup(arg);
+    if (!spec)
+        FATAL_STRDUP("add_output()");
+    // the parsers modify the args and outputs keep pointers into them, e.g. the MQTT credentials
+    char *args = strdup(arg);
+    if (!args)
+        FATAL_STRDUP("add_output()");
+
+    int ret = 0;
+    if (strncmp(args, "json", 4) == 0) {
+        ret = add_json_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "csv", 3) == 0) {
+        ret = add_csv_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "log", 3) == 0) {
+        ret = add_log_output(cfg, arg_param(args));
+        cfg->has_logout |= ret == 0;
+    }
+    else if (strncmp(args, "kv", 2) == 0) {
+        ret = add_kv_output(cfg, arg_param(args));
+        cfg->has_logout |= ret == 0;
+    }
+    else if (strncmp(args, "mqtt", 4) == 0) {
+        ret = add_mqtt_output(cfg, args);
+    }
+    else if (strncmp(args, "influx", 6) == 0) {
+        ret = add_influx_output(cfg, args);
+    }
+    else if (strncmp(args, "syslog", 6) == 0) {
+        ret = add_syslog_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "http", 4) == 0) {
+        ret = add_http_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "shm", 3) == 0) {
+        ret = add_shm_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "arrow", 5) == 0) {
+        ret = add_arrow_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "store", 5) == 0) {
+        ret = add_store_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "trigger", 7) == 0) {
+        ret = add_trigger_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "null", 4) == 0) {
+        add_null_output(cfg, arg_param(args));
+    }
+    else if (strncmp(args, "rtl_tcp", 7) == 0) {
+        add_rtltcp_output(cfg, arg_param(arg)); // raw outputs are only added at startup
+        free(spec);
+        free(args);
+        return 0; // a raw output, not a data output
+    }
+    else {
+        ret = -1;
+    }
+    if (ret < 0) {
+        free(spec);
+        free(args);
+        return -1;
+    }
+
+    // keep the spec list in step, outputs might have been added without a spec
+    while (cfg->output_specs.len + 1 < cfg->output_handler.len) {
+        char *none = strdup("");
+        if (!none)
+            FATAL_STRDUP("add_output()");
+        list_push(&cfg->output_specs, none);
+        list_push(&cfg->output_args, NULL);
+    }
+    if (cfg->output_handler.len > outputs) {
+        list_push(&cfg->output_specs, spec);
+        list_push(&cfg->output_args, args);
+    }
+    else {
+        free(spec);
+        free(args);
+    }
+    return 0;
+}
+
+int remove_output(r_cfg_t *cfg, unsigned idx)
+{
+    if (idx >= cfg->output_handler.len)
+        return -1;
+
+    list_remove(&cfg->output_handler, idx, (list_elem_free_fn)data_output_free);
+    if (idx < cfg->output_specs.len)
+        list_remove(&cfg->output_specs, idx, free);
+    if (idx < cfg->output_args.len)
+        list_remove(&cfg->output_args, idx, free);
+    return 0;
+}
+
+void start_output(r_cfg_t *cfg, data_output_t *output)
+{
+    char const **well_known = well_known_output_fields(cfg);
+    int num_output_fields;
+    char const **output_fields = determine_csv_fields(cfg, well_known, &num_output_fields);
+
+    data_output_start(output, output_fields, num_output_fields);
+
+    free((void *)output_fields);
+    free((void *)well_known);
 }
 
 void start_outputs(r_cfg_t *cfg, char const *const *well_known)
@@ -1080,60 +1521,204 @@ void start_outputs(r_cfg_t *cfg, char const *const *well_known)
     free((void *)output_fields);
 }
 
-void add_log_output(r_cfg_t *cfg, char *param)
+int add_log_output(r_cfg_t *cfg, char *param)
 {
     int log_level = lvlarg_param(&param, LOG_TRACE);
-    list_push(&cfg->output_handler, data_output_log_create(log_level, fopen_output(param)));
+    FILE *file    = log_level < 0 ? NULL : fopen_output(param);
+    if (!file)
+        return -1;
+    list_push(&cfg->output_handler, data_output_log_create(log_level, file));
+    return 0;
 }
 
-void add_kv_output(r_cfg_t *cfg, char *param)
+int add_kv_output(r_cfg_t *cfg, char *param)
 {
     int log_level = lvlarg_param(&param, LOG_TRACE);
-    list_push(&cfg->output_handler, data_output_kv_create(log_level, fopen_output(param)));
+    FILE *file    = log_level < 0 ? NULL : fopen_output(param);
+    if (!file)
+        return -1;
+    list_push(&cfg->output_handler, data_output_kv_create(log_level, file));
+    return 0;
 }
 
-void add_mqtt_output(r_cfg_t *cfg, char *param)
+int add_mqtt_output(r_cfg_t *cfg, char *param)
 {
-    list_push(&cfg->output_handler, data_output_mqtt_create(get_mgr(cfg), param, cfg->dev_query));
+    data_output_t *output = data_output_mqtt_create(get_mgr(cfg), param, cfg->dev_query);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
 }
 
-void add_influx_output(r_cfg_t *cfg, char *param)
+int add_influx_output(r_cfg_t *cfg, char *param)
 {
-    list_push(&cfg->output_handler, data_output_influx_create(get_mgr(cfg), param));
+    data_output_t *output = data_output_influx_create(get_mgr(cfg), param);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
 }
 
-void add_syslog_output(r_cfg_t *cfg, char *param)
+int add_syslog_output(r_cfg_t *cfg, char *param)
 {
     int log_level = lvlarg_param(&param, LOG_WARNING);
+    if (log_level < 0)
+        return -1;
     char const *host = "localhost";
     char const *port = "514";
     char const *extra = hostport_param(param, &host, &port);
     if (extra && *extra) {
-        print_logf(LOG_FATAL, "Syslog UDP", "Unknown parameters \"%s\"", extra);
+        print_logf(LOG_ERROR, "Syslog UDP", "Unknown parameters \"%s\"", extra);
+        return -1;
     }
     print_logf(LOG_CRITICAL, "Syslog UDP", "Sending datagrams to %s port %s", host, port);
 
-    list_push(&cfg->output_handler, data_output_syslog_create(log_level, host, port));
+    data_output_t *output = data_output_syslog_create(log_level, host, port);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
 }
 
-void add_http_output(r_cfg_t *cfg, char *param)
+int add_http_output(r_cfg_t *cfg, char *param)
 {
     // Note: no log_level, the HTTP-API consumes all log levels.
     char const *host = "0.0.0.0";
     char const *port = "8433";
     char const *extra = hostport_param(param, &host, &port);
     if (extra && *extra) {
-        print_logf(LOG_FATAL, "HTTP server", "Unknown parameters \"%s\"", extra);
+        print_logf(LOG_ERROR, "HTTP server", "Unknown parameters \"%s\"", extra);
+        return -1;
     }
     print_logf(LOG_CRITICAL, "HTTP server", "Starting HTTP server at %s port %s", host, port);
 
-    list_push(&cfg->output_handler, data_output_http_create(get_mgr(cfg), host, port, cfg));
+    data_output_t *output = data_output_http_create(get_mgr(cfg), host, port, cfg);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
+}
+
+int add_shm_output(r_cfg_t *cfg, char *param)
+{
+    char const *path = "/dev/shm/rtl_433";
+    int log_level    = 0;
+    int size_kib     = 0;
+
+    if (param && *param && *param != ',')
+        path = asepc(&param, ',');
+    else if (param && *param == ',')
+        param++;
+
+    char *key, *val;
+    while (getkwargs(&param, &key, &val)) {
+        key = remove_ws(key);
+        val = trim_ws(val);
+        if (!key || !*key)
+            continue;
+        else if (!strcasecmp(key, "size"))
+            size_kib = atoiv(val, 0);
+        else if (!strcasecmp(key, "v"))
+            log_level = atoiv(val, LOG_TRACE);
+        else {
+            print_logf(LOG_ERROR, "SHM", "Unknown parameters \"%s\"", key);
+            return -1;
+        }
+    }
+
+    data_output_t *output = data_output_shm_create(log_level, path, (size_t)size_kib * 1024);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
 }
 
-void add_trigger_output(r_cfg_t *cfg, char *param)
+int add_arrow_output(r_cfg_t *cfg, char *param)
+{
+    char const *dir = ".";
+    int rows        = 0;
+    int size_kib    = 0;
+    int secs        = 0;
+
+    if (param && *param && *param != ',')
+        dir = asepc(&param, ',');
+    else if (param && *param == ',')
+        param++;
+
+    char *key, *val;
+    while (getkwargs(&param, &key, &val)) {
+        key = remove_ws(key);
+        val = trim_ws(val);
+        if (!key || !*key)
+            continue;
+        else if (!strcasecmp(key, "rows"))
+            rows = atoiv(val, 0);
+        else if (!strcasecmp(key, "size"))
+            size_kib = atoiv(val, 0);
+        else if (!strcasecmp(key, "secs"))
+            secs = atoiv(val, 0);
+        else {
+            print_logf(LOG_ERROR, "Arrow", "Unknown parameters \"%s\"", key);
+            return -1;
+        }
+    }
+
+    data_output_t *output = data_output_arrow_create(cfg, dir, (unsigned)rows, (size_t)size_kib * 1024, (unsigned)secs);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
+}
+
+int add_store_output(r_cfg_t *cfg, char *param)
+{
+    char const *dir = ".";
+    int size_mib    = 0;
+    int days        = 0;
+    int devices     = 0;
+
+    if (param && *param && *param != ',')
+        dir = asepc(&param, ',');
+    else if (param && *param == ',')
+        param++;
+
+    char *key, *val;
+    while (getkwargs(&param, &key, &val)) {
+        key = remove_ws(key);
+        val = trim_ws(val);
+        if (!key || !*key)
+            continue;
+        else if (!strcasecmp(key, "size"))
+            size_mib = atoiv(val, 0);
+        else if (!strcasecmp(key, "days"))
+            days = atoiv(val, 0);
+        else if (!strcasecmp(key, "devices"))
+            devices = atoiv(val, 0);
+        else {
+            print_logf(LOG_ERROR, "Store", "Unknown parameters \"%s\"", key);
+            return -1;
+        }
+    }
+
+    if (cfg->event_store) {
+        print_log(LOG_ERROR, "Store", "Only one event store is supported");
+        return -1;
+    }
+    data_output_t *output = data_output_store_create(cfg, dir, (unsigned)size_mib, (unsigned)days, (unsigned)devices);
+    if (!output)
+        return -1;
+    list_push(&cfg->output_handler, output);
+    return 0;
+}
+
+int add_trigger_output(r_cfg_t *cfg, char *param)
 {
     // Note: no log_level, we never trigger on logs.
-    list_push(&cfg->output_handler, data_output_trigger_create(fopen_output(param)));
+    FILE *file = fopen_output(param);
+    if (!file)
+        return -1;
+    list_push(&cfg->output_handler, data_output_trigger_create(file));
+    return 0;
 }
 
 void add_null_output(r_cfg_t *cfg, char *param)
@@ -1169,6 +1754,9 @@ void add_sr_dumper(r_cfg_t *cfg, char const *spec, int overwrite)
 
 void close_dumpers(struct r_cfg *cfg)
 {
+    pulse_archive_close(cfg->demod->pulse_archive);
+    cfg->demod->pulse_archive = NULL;
+
     for (void **iter = cfg->demod->dumper.elems; iter && *iter; ++iter) {
         file_info_t *dumper = *iter;
         if (dumper->file && (dumper->file != stdout)) {
@@ -1202,6 +1790,22 @@ void add_dumper(r_cfg_t *cfg, char const *spec, int overwrite)
         return;
     }
 
+    file_info_t info = {0};
+    file_info_parse_filename(&info, spec);
+    if (info.format == PULSE_ARCHIVE) {
+        if (cfg->demod->pulse_archive) {
+            fprintf(stderr, "Only one pulse archive is supported (%s)\n", spec);
+            exit(1);
+        }
+        // an archive is appended to, unless overwrite is requested
+        cfg->demod->pulse_archive = pulse_archive_create(info.path, overwrite);
+        if (!cfg->demod->pulse_archive) {
+            fprintf(stderr, "Failed to open %s\n", spec);
+            exit(1);
+        }
+        return;
+    }
+
     file_info_t *dumper = calloc(1, sizeof(*dumper));
     if (!dumper)
         FATAL_CALLOC("add_dumper()");
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <errno.h>
 #include <signal.h>
+#include <math.h>
 
 #include "rtl_433.h"
 #include "r_private.h"
@@ -37,6 +38,8 @@
 #include "pulse_analyzer.h"
 #include "pulse_detect.h"
 #include "pulse_detect_fsk.h"
+#include "fsk_afc.h"
+#include "pulse_archive.h"
 #include "pulse_slicer.h"
 #include "rfraw.h"
 #include "data.h"
@@ -123,6 +126,8 @@ static void delay_timer_wait(delay_timer_t *delay_timer, unsigned delay_us)
 }
 
 r_device *flex_create_device(char *spec); // maybe put this in some header file?
+r_device *flex_parse_device(char const *spec);
+void flex_free_device(r_device *dev);
 
 static void print_version(void)
 {
@@ -156,13 +161,17 @@ static void usage(int exit_code)
             "  [-R <device> | help] Enable only the specified device decoding protocol (can be used multiple times)\n"
             "       Specify a negative number to disable a device decoding protocol (can be used multiple times)\n"
             "  [-X <spec> | help] Add a general purpose decoder (prepend -R 0 to disable all decoders)\n"
-            "  [-Y auto | classic | minmax] FSK pulse detector mode.\n"
+            "  [-Y auto | classic | minmax | block] FSK pulse detector mode.\n"
             "  [-Y level=<dB level>] Manual detection level used to determine pulses (-1.0 to -30.0) (0=auto).\n"
             "  [-Y minlevel=<dB level>] Manual minimum detection level used to determine pulses (-1.0 to -99.0).\n"
             "  [-Y minsnr=<dB level>] Minimum SNR to determine pulses (1.0 to 99.0).\n"
             "  [-Y autolevel] Set minlevel automatically based on average estimated noise.\n"
             "  [-Y squelch] Skip frames below estimated noise level to reduce cpu load.\n"
             "  [-Y ampest | magest] Choose amplitude or magnitude level estimator.\n"
+            "  [-Y budget[=<us>]] Decoders repeatedly over this time budget only run on every 16th package (default: 1000 us).\n"
+            "  [-Y firstmatch[=<n>]] Order decoders by hit rate and stop at the first match, run all decoders on every n-th package (default: 64).\n"
+            "  [-Y afc[=<mode>]] FSK frequency control: 1 track offsets and seed the estimators (default), 2 also learn device offsets\n"
+            "       and report the tuner drift, 3 also adjust the frequency correction.\n"
             "\t\t= Analyze/Debug options =\n"
             "  [-A] Pulse Analyzer. Enable pulse analysis and decode attempt.\n"
             "       Disable all decoders with -R 0 if you want analyzer output only.\n"
@@ -174,7 +183,7 @@ static void usage(int exit_code)
             "  [-w <filename> | help] Save data stream to output file (a '-' dumps samples to stdout)\n"
             "  [-W <filename> | help] Save data stream to output file, overwrite existing file\n"
             "\t\t= Data output options =\n"
-            "  [-F log | kv | json | csv | mqtt | influx | syslog | trigger | null | help] Produce decoded output in given format.\n"
+            "  [-F log | kv | json | csv | mqtt | influx | syslog | shm | arrow | store | trigger | null | help] Produce decoded output in given format.\n"
             "       Append output to file with :<filename> (e.g. -F csv:log.csv), defaults to stdout.\n"
             "       Specify host/port for syslog with e.g. -F syslog:127.0.0.1:1514\n"
             "  [-M time[:<options>] | protocol | level | noise[:<secs>] | stats | bits | help] Add various meta data to each output.\n"
@@ -265,7 +274,7 @@ static void help_output(void)
 {
     term_help_printf(
             "\t\t= Output format option =\n"
-            "  [-F log|kv|json|csv|mqtt|influx|syslog|trigger|null] Produce decoded output in given format.\n"
+            "  [-F log|kv|json|csv|mqtt|influx|syslog|shm|arrow|store|trigger|null] Produce decoded output in given format.\n"
             "\tWithout this option the default is LOG and KV output. Use \"-F null\" to remove the default.\n"
             "\tAppend output to file with :<filename> (e.g. -F csv:log.csv), defaults to stdout.\n"
             "\tSpecify MQTT server with e.g. -F mqtt://localhost:1883\n"
@@ -282,7 +291,15 @@ static void help_output(void)
             "\tSpecify InfluxDB 2.0 server with e.g. -F \"influx://localhost:9999/api/v2/write?org=<org>&bucket=<bucket>,token=<authtoken>\"\n"
             "\tSpecify InfluxDB 1.x server with e.g. -F \"influx://localhost:8086/write?db=<db>&p=<password>&u=<user>\"\n"
             "\t  Additional parameter -M time:unix:usec:utc for correct timestamps in InfluxDB recommended\n"
-            "\tSpecify host/port for syslog with e.g. -F syslog:127.0.0.1:1514\n");
+            "\tMQTT and InfluxDB options spool=<dir>, spool_size=<MiB>, spool_age=<hours> queue data on disk\n"
+            "\t  until delivered, e.g. -F \"mqtt://host:1883,qos=1,spool=/var/spool/rtl_433/mqtt\"\n"
+            "\tSpecify host/port for syslog with e.g. -F syslog:127.0.0.1:1514\n"
+            "\tWrite JSON events to a shared memory ring with e.g. -F shm:/dev/shm/rtl_433,size=<KiB>\n"
+            "\t  (default path /dev/shm/rtl_433, default size 4096 KiB), read it with include/shm_ring.h\n"
+            "\tWrite Arrow IPC streams, one file per model, with e.g. -F arrow:<dir>,rows=<n>,size=<KiB>,secs=<s>\n"
+            "\t  (a record batch is written every 10000 rows, 4096 KiB, or 600 s, and at exit)\n"
+            "\tKeep an indexed event store for the HTTP API with e.g. -F store:<dir>,size=<MiB>,days=<n>,devices=<n>\n"
+            "\t  (default size 256 MiB, 90 days, 65536 devices), query it at /store\n");
     exit(0);
 }
 
@@ -351,7 +368,11 @@ static void help_read(void)
             "\tE.g. default detection by extension: path/filename.am.s16\n"
             "\tforced overrides: am:s16:path/filename.ext\n\n"
             "\tReading from pipes also support format options.\n"
-            "\tE.g reading complex 32-bit float: CU32:-\n");
+            "\tE.g reading complex 32-bit float: CU32:-\n\n"
+            "\tA pulse archive ('rpa') is replayed through the decoders in parallel,\n"
+            "\toptions follow the path: path/filename.rpa[,from=<time>][,to=<time>][,jobs=<n>]\n"
+            "\tTimes are unix seconds or YYYY-MM-DD[THH:MM[:SS]] local time,\n"
+            "\tjobs defaults to the number of CPU cores.\n");
     exit(0);
 }
 
@@ -370,10 +391,99 @@ static void help_write(void)
             "\tParameters must be separated by non-alphanumeric chars and are case-insensitive.\n"
             "\tOverrides can be prefixed, separated by colon (':')\n\n"
             "\tE.g. default detection by extension: path/filename.am.s16\n"
-            "\tforced overrides: am:s16:path/filename.ext\n");
+            "\tforced overrides: am:s16:path/filename.ext\n\n"
+            "\tA pulse archive ('rpa') keeps every detected package compressed,\n"
+            "\t-w appends to an existing archive, -W starts a new one.\n");
     exit(0);
 }
 
+/// Log the estimated tuner drift when it changes, apply it as frequency correction if enabled.
+static void check_afc_drift(r_cfg_t *cfg)
+{
+    struct dm_state *demod = cfg->demod;
+    float drift_ppm        = 0.0f;
+    if (!fsk_afc_drift(demod->fsk_afc, cfg->center_frequency, &drift_ppm))
+        return;
+
+    int ppm = (int)lrintf(drift_ppm);
+    if (ppm != demod->afc_drift_logged) {
+        print_logf(LOG_NOTICE, "AFC", "Estimated tuner drift %+.1f ppm at %u Hz.", drift_ppm, cfg->center_frequency);
+        demod->afc_drift_logged = ppm;
+    }
+    if (fsk_afc_mode(demod->fsk_afc) < FSK_AFC_CORRECT || !cfg->dev || fabsf(drift_ppm) < 1.0f)
+        return;
+
+    if (sdr_set_freq_correction(cfg->dev, cfg->ppm_error + ppm, 1) < 0)
+        return;
+    cfg->ppm_error += ppm;
+    fsk_afc_corrected(demod->fsk_afc, cfg->center_frequency, ppm);
+    demod->afc_drift_logged = 0;
+}
+
+/// The unix time in microseconds of the start of a package.
+static int64_t package_time_us(r_cfg_t *cfg, pulse_data_t const *data)
+{
+    int64_t ago_us = cfg->samp_rate ? (int64_t)data->start_ago * 1000000 / cfg->samp_rate : 0;
+    return (int64_t)cfg->demod->now.tv_sec * 1000000 + cfg->demod->now.tv_usec - ago_us;
+}
+
+/// Check if all outputs are line oriented console outputs, i.e. can be shared by replay workers.
+static int outputs_shareable(r_cfg_t *cfg)
+{
+    if (cfg->raw_handler.len)
+        return 0;
+    for (size_t i = 0; i < cfg->output_handler.len; ++i) {
+        char const *spec = i < cfg->output_specs.len ? cfg->output_specs.elems[i] : "";
+        if (cfg->output_handler.elems[i] && !output_spec_console(spec))
+            return 0; // sockets, servers, and output files with state
+    }
+    return 1;
+}
+
+/// Dispatch a package replayed from a pulse archive, like a pulse data file input.
+static int replay_package(pulse_data_t *data, int fsk, int64_t time_us, void *ctx)
+{
+    r_cfg_t *cfg           = ctx;
+    struct dm_state *demod = cfg->demod;
+    if (cfg->exit_async)
+        return 0;
+
+    demod->now.tv_sec  = (time_t)(time_us / 1000000);
+    demod->now.tv_usec = (long)(time_us % 1000000);
+    if (data->sample_rate)
+        cfg->samp_rate = data->sample_rate;
+    if (data->centerfreq_hz > 0.0f)
+        cfg->center_frequency = (uint32_t)data->centerfreq_hz;
+    demod->sample_file_pos = (float)data->offset / cfg->samp_rate;
+
+    for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
+        file_info_t const *dumper = *iter;
+        if (dumper->format == VCD_LOGIC) pulse_data_print_vcd(dumper->file, data, fsk ? '"' : '\'');
+        if (dumper->format == PULSE_OOK) pulse_data_dump(dumper->file, data);
+    }
+    if (demod->pulse_archive)
+        pulse_archive_write(demod->pulse_archive, data, fsk, time_us);
+
+    int p_events;
+    if (fsk) {
+        p_events = run_fsk_dispatch(cfg, data);
+        cfg->frames_fsk++;
+    }
+    else {
+        p_events = run_ook_dispatch(cfg, data);
+        cfg->frames_count++;
+    }
+    cfg->frames_events += p_events > 0;
+
+    if (cfg->verbosity >= LOG_DEBUG)
+        pulse_data_print(data);
+    if (demod->analyze_pulses && (cfg->grab_mode <= 1 || (cfg->grab_mode == 2 && p_events == 0) || (cfg->grab_mode == 3 && p_events > 0))) {
+        r_device device = {.log_fn = log_device_handler, .output_ctx = cfg};
+        pulse_analyzer(data, fsk ? PULSE_DATA_FSK : PULSE_DATA_OOK, &device);
+    }
+    return p_events;
+}
+
 static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
 {
     //fprintf(stderr, "sdr_callback... %u\n", len);
@@ -442,7 +552,7 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
     }
     int noise_only = avg_db < demod->noise_level + 3.0f; // or demod->min_level_auto?
     // always process frames if loader, dumper, or analyzers are in use, otherwise skip silent frames
-    int process_frame = demod->squelch_offset <= 0 || !noise_only || demod->load_info.format || demod->analyze_pulses || demod->dumper.len || demod->samp_grab;
+    int process_frame = demod->squelch_offset <= 0 || !noise_only || demod->load_info.format || demod->analyze_pulses || demod->dumper.len || demod->pulse_archive || demod->samp_grab;
     if (noise_only) {
         demod->noise_level = (demod->noise_level * 7 + avg_db) / 8; // fast fall over 8 frames
         // If auto_level and noise level well below min_level and significant change in noise level
@@ -497,7 +607,7 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
     }
 
     int d_events = 0; // Sensor events successfully detected
-    if (demod->r_devs.len || demod->analyze_pulses || demod->dumper.len || demod->samp_grab) {
+    if (demod->r_devs.len || demod->analyze_pulses || demod->dumper.len || demod->pulse_archive || demod->samp_grab) {
         // Detect a package and loop through demodulators with pulse data
         int package_type = PULSE_DATA_OOK;  // Just to get us started
         for (void **iter = demod->dumper.elems; iter && *iter; ++iter) {
@@ -507,6 +617,12 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
                 break;
             }
         }
+        if (demod->fsk_afc) {
+            int fm_f1 = 0;
+            int fm_f2 = 0;
+            fsk_afc_seed(demod->fsk_afc, cfg->samp_rate, &fm_f1, &fm_f2);
+            pulse_detect_set_fsk_seed(demod->pulse_detect, fm_f1, fm_f2);
+        }
         while (package_type && process_frame) {
             int p_events = 0; // Sensor events successfully detected per package
             package_type = pulse_detect_package(demod->pulse_detect, demod->am_buf, demod->buf.fm, n_samples, cfg->samp_rate, cfg->input_pos, &demod->pulse_data, &demod->fsk_pulse_data, fpdm);
@@ -521,7 +637,7 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
                 calc_rssi_snr(cfg, &demod->pulse_data);
                 if (demod->analyze_pulses) fprintf(stderr, "Detected OOK package\t%s\n", time_pos_str(cfg, demod->pulse_data.start_ago, time_str));
 
-                p_events += run_ook_demods(&demod->r_devs, &demod->pulse_data);
+                p_events += run_ook_dispatch(cfg, &demod->pulse_data);
                 cfg->frames_count++;
                 cfg->frames_events += p_events > 0;
 
@@ -531,6 +647,8 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
                     if (dumper->format == U8_LOGIC) pulse_data_dump_raw(demod->u8_buf, n_samples, cfg->input_pos, &demod->pulse_data, 0x02);
                     if (dumper->format == PULSE_OOK) pulse_data_dump(dumper->file, &demod->pulse_data);
                 }
+                if (demod->pulse_archive)
+                    pulse_archive_write(demod->pulse_archive, &demod->pulse_data, 0, package_time_us(cfg, &demod->pulse_data));
 
                 if (cfg->verbosity >= LOG_TRACE) pulse_data_print(&demod->pulse_data);
                 if (cfg->raw_mode == 1 || (cfg->raw_mode == 2 && p_events == 0) || (cfg->raw_mode == 3 && p_events > 0)) {
@@ -546,7 +664,7 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
                 calc_rssi_snr(cfg, &demod->fsk_pulse_data);
                 if (demod->analyze_pulses) fprintf(stderr, "Detected FSK package\t%s\n", time_pos_str(cfg, demod->fsk_pulse_data.start_ago, time_str));
 
-                p_events += run_fsk_demods(&demod->r_devs, &demod->fsk_pulse_data);
+                p_events += run_fsk_dispatch(cfg, &demod->fsk_pulse_data);
                 cfg->frames_fsk++;
                 cfg->frames_events += p_events > 0;
 
@@ -556,6 +674,8 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
                     if (dumper->format == U8_LOGIC) pulse_data_dump_raw(demod->u8_buf, n_samples, cfg->input_pos, &demod->fsk_pulse_data, 0x04);
                     if (dumper->format == PULSE_OOK) pulse_data_dump(dumper->file, &demod->fsk_pulse_data);
                 }
+                if (demod->pulse_archive)
+                    pulse_archive_write(demod->pulse_archive, &demod->fsk_pulse_data, 1, package_time_us(cfg, &demod->fsk_pulse_data));
 
                 if (cfg->verbosity >= LOG_TRACE) pulse_data_print(&demod->fsk_pulse_data);
                 if (cfg->raw_mode == 1 || (cfg->raw_mode == 2 && p_events == 0) || (cfg->raw_mode == 3 && p_events > 0)) {
@@ -730,6 +850,8 @@ static void sdr_callback(unsigned char *iq_buf, uint32_t len, void *ctx)
         cfg->exit_async = 1;
         print_log(LOG_CRITICAL, __func__, "Time expired, exiting!");
     }
+    if (demod->fsk_afc)
+        check_afc_drift(cfg);
     if (cfg->stats_now || (cfg->report_stats && cfg->stats_interval && rawtime >= cfg->stats_time)) {
         event_occurred_handler(cfg, create_report_data(cfg, cfg->stats_now ? 3 : cfg->report_stats));
         flush_report_data(cfg);
@@ -821,9 +943,18 @@ static void parse_conf_file(r_cfg_t *cfg, char const *path)
     if (!path || !*path || !strcmp(path, "null") || !strcmp(path, "0"))
         return;
 
+    size_t outputs = cfg->output_specs.len;
     char *conf = readconf(path);
     parse_conf_text(cfg, conf);
     //free(conf); // TODO: check no args are dangling, then use free
+
+    // a reload only changes the outputs of the config file
+    for (size_t i = outputs; i < cfg->output_specs.len; ++i) {
+        char *spec = strdup(cfg->output_specs.elems[i]);
+        if (!spec)
+            FATAL_STRDUP("parse_conf_file()");
+        list_push(&cfg->conf_outputs, spec);
+    }
 }
 
 static void parse_conf_try_default_files(r_cfg_t *cfg)
@@ -833,6 +964,7 @@ static void parse_conf_try_default_files(r_cfg_t *cfg)
         fprintf(stderr, "Trying conf file at \"%s\"...\n", paths[a]);
         if (hasconf(paths[a])) {
             fprintf(stderr, "Reading conf from \"%s\".\n", paths[a]);
+            cfg->conf_file = paths[a];
             parse_conf_file(cfg, paths[a]);
             break;
         }
@@ -874,6 +1006,7 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
             cfg->verbosity = atobv(arg, 1);
         break;
     case 'c':
+        cfg->conf_file = arg;
         parse_conf_file(cfg, arg);
         break;
     case 'd':
@@ -1162,42 +1295,7 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
         if (!arg)
             help_output();
 
-        if (strncmp(arg, "json", 4) == 0) {
-            add_json_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "csv", 3) == 0) {
-            add_csv_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "log", 3) == 0) {
-            add_log_output(cfg, arg_param(arg));
-            cfg->has_logout = 1;
-        }
-        else if (strncmp(arg, "kv", 2) == 0) {
-            add_kv_output(cfg, arg_param(arg));
-            cfg->has_logout = 1;
-        }
-        else if (strncmp(arg, "mqtt", 4) == 0) {
-            add_mqtt_output(cfg, arg);
-        }
-        else if (strncmp(arg, "influx", 6) == 0) {
-            add_influx_output(cfg, arg);
-        }
-        else if (strncmp(arg, "syslog", 6) == 0) {
-            add_syslog_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "http", 4) == 0) {
-            add_http_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "trigger", 7) == 0) {
-            add_trigger_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "null", 4) == 0) {
-            add_null_output(cfg, arg_param(arg));
-        }
-        else if (strncmp(arg, "rtl_tcp", 7) == 0) {
-            add_rtltcp_output(cfg, arg_param(arg));
-        }
-        else {
+        if (add_output(cfg, arg) < 0) {
             fprintf(stderr, "Invalid output format: %s\n", arg);
             usage(1);
         }
@@ -1253,6 +1351,8 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
                 cfg->fsk_pulse_detect_mode = FSK_PULSE_DETECT_OLD;
             else if (kwargs_match(p, "minmax", &val))
                 cfg->fsk_pulse_detect_mode = FSK_PULSE_DETECT_NEW;
+            else if (kwargs_match(p, "block", &val))
+                cfg->fsk_pulse_detect_mode = FSK_PULSE_DETECT_BLOCK;
             else if (kwargs_match(p, "ampest", &val))
                 cfg->demod->use_mag_est = 0;
             else if (kwargs_match(p, "verbose", &val))
@@ -1267,6 +1367,19 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
                 cfg->demod->min_snr = arg_float(val, "-Y minsnr: ");
             else if (kwargs_match(p, "filter", &val))
                 cfg->demod->low_pass = arg_float(val, "-Y filter: ");
+            else if (kwargs_match(p, "budget", &val))
+                set_decode_budget(cfg, (unsigned)atoiv(val, 1000));
+            else if (kwargs_match(p, "firstmatch", &val))
+                set_first_match(cfg, atoiv(val, 64));
+            else if (kwargs_match(p, "afc", &val)) {
+                int mode = atoiv(val, FSK_AFC_TRACK);
+                if (mode < FSK_AFC_OFF || mode > FSK_AFC_CORRECT) {
+                    fprintf(stderr, "Invalid AFC mode: %s\n", p);
+                    usage(1);
+                }
+                fsk_afc_free(cfg->demod->fsk_afc);
+                cfg->demod->fsk_afc = mode ? fsk_afc_create(mode) : NULL;
+            }
             else {
                 fprintf(stderr, "Unknown pulse detector setting: %s\n", p);
                 usage(1);
@@ -1291,6 +1404,249 @@ static void parse_conf_option(r_cfg_t *cfg, int opt, char *arg)
     }
 }
 
+/// Check a metric number argument (e.g. "868.3M") without exiting on errors.
+static int is_metric_arg(char const *arg)
+{
+    if (!arg || !*arg)
+        return 0;
+    char *endptr;
+    double val = strtod(arg, &endptr);
+    if (arg == endptr || val <= 0.0)
+        return 0;
+    while (*endptr == ' ' || *endptr == '\t')
+        ++endptr;
+    return !*endptr || (strchr("kKmMgG", *endptr) && !endptr[1]);
+}
+
+/// Check if a list of spec strings contains @p spec.
+static int find_spec(list_t const *specs, char const *spec)
+{
+    for (void **iter = specs->elems; iter && *iter; ++iter) {
+        if (!strcmp(*iter, spec))
+            return 1;
+    }
+    return 0;
+}
+
+/** Re-read the config file and apply changed protocols, decoders, outputs, and frequencies.
+
+    Only the sections (protocol, decoder, output, frequency, hop_interval) present
+    in the config file are compared with the running state, other sections and
+    options which need a restart are left alone. Only outputs which came from the
+    config file are removed, outputs from the command line or the HTTP API stay.
+    The whole file is checked before any change is applied, only outputs which
+    fail to start (e.g. a file that can't be opened) are reported and skipped.
+    This runs on the main loop, i.e. between SDR blocks.
+*/
+static void reload_conf_file(r_cfg_t *cfg)
+{
+    if (!cfg->conf_file || !hasconf(cfg->conf_file)) {
+        print_logf(LOG_WARNING, "Reload", "No config file \"%s\" to reload.", cfg->conf_file ? cfg->conf_file : "");
+        return;
+    }
+    char *conf = readconf(cfg->conf_file);
+    if (!conf)
+        return;
+
+    unsigned num_devs = cfg->num_r_devices;
+    char *want = calloc(num_devs, sizeof(*want));
+    if (!want)
+        FATAL_CALLOC("reload_conf_file()");
+    char **want_args = calloc(num_devs, sizeof(*want_args));
+    if (!want_args)
+        FATAL_CALLOC("reload_conf_file()");
+    for (unsigned i = 0; i < num_devs; ++i) {
+        want[i] = cfg->devices[i].disabled == 0;
+    }
+    list_t flex_devs = {0};
+    list_t output_specs = {0};
+    uint32_t frequency[MAX_FREQS];
+    int frequencies = 0;
+    int hop_time[MAX_FREQS];
+    int hop_times = 0;
+    int has_protocols = 0;
+    int ignored = 0;
+    int invalid = 0;
+
+    // collect and check the new state
+    int opt;
+    char *arg;
+    char *p = conf;
+    while ((opt = getconf(&p, conf_keywords, &arg)) != -1) {
+        switch (opt) {
+        case 'R': {
+            if (!arg || *arg == 'v')
+                break;
+            int n = atoi(arg);
+            if (n > (int)num_devs || -n > (int)num_devs
+                    || (n > 0 && cfg->devices[n - 1].disabled > 2)
+                    || (n < 0 && cfg->devices[-n - 1].disabled > 2)) {
+                print_logf(LOG_ERROR, "Reload", "Protocol number specified (%d) is invalid", n);
+                invalid++;
+                break;
+            }
+            if (n >= 0 && !has_protocols)
+                memset(want, 0, num_devs); // no defaults
+            has_protocols = 1;
+            if (n >= 1) {
+                want[n - 1] = 1;
+                want_args[n - 1] = arg_param(arg);
+            }
+            else if (n <= -1) {
+                want[-n - 1] = 0;
+            }
+            else {
+                memset(want, 0, num_devs);
+            }
+            break;
+        }
+        case 'X': {
+            r_device *flex_device = flex_parse_device(arg);
+            if (!flex_device) {
+                print_logf(LOG_ERROR, "Reload", "Invalid flex decoder \"%s\"", arg ? arg : "");
+                invalid++;
+                break;
+            }
+            list_push(&flex_devs, flex_device);
+            break;
+        }
+        case 'F':
+            if (arg && strncmp(arg, "rtl_tcp", 7) != 0) // raw outputs need a restart
+                list_push(&output_specs, arg);
+            else
+                ignored++;
+            break;
+        case 'f':
+            if (!is_metric_arg(arg)) {
+                print_logf(LOG_ERROR, "Reload", "Invalid frequency \"%s\"", arg ? arg : "");
+                invalid++;
+            }
+            else if (frequencies < MAX_FREQS) {
+                frequency[frequencies++] = atouint32_metric(arg, "-f: ");
+            }
+            break;
+        case 'H':
+            if (arg && hop_times < MAX_FREQS && atoi(arg) > 0)
+                hop_time[hop_times++] = atoi_time(arg, "-H: ");
+            break;
+        default:
+            ignored++;
+            break;
+        }
+    }
+
+    if (invalid) {
+        print_logf(LOG_ERROR, "Reload", "Config file \"%s\" has errors, keeping the running state.", cfg->conf_file);
+        free(conf);
+        free(want);
+        free(want_args);
+        list_free_elems(&flex_devs, (list_elem_free_fn)flex_free_device);
+        list_free_elems(&output_specs, NULL);
+        return;
+    }
+
+    // apply protocols
+    int protocols_added = 0;
+    int protocols_removed = 0;
+    for (unsigned i = 0; has_protocols && i < num_devs; ++i) {
+        r_device *running = find_protocol(cfg, i + 1, NULL);
+        if (want[i] && !running) {
+            register_protocol(cfg, &cfg->devices[i], want_args[i]);
+            protocols_added++;
+        }
+        else if (!want[i] && running) {
+            unregister_protocol(cfg, &cfg->devices[i]);
+            protocols_removed++;
+        }
+    }
+
+    // apply flex decoders, matched by name
+    if (flex_devs.len) {
+        // devices from a create_fn have no protocol_num either, only look at flex decoders
+        r_device const *flex_template = flex_devs.elems[0];
+        for (size_t i = 0; i < cfg->demod->r_devs.len; ++i) {
+            r_device *r_dev = cfg->demod->r_devs.elems[i];
+            if (r_dev->protocol_num || r_dev->decode_fn != flex_template->decode_fn)
+                continue;
+            int found = 0;
+            for (void **iter = flex_devs.elems; iter && *iter; ++iter) {
+                found |= !strcmp(((r_device *)*iter)->name, r_dev->name);
+            }
+            if (!found) {
+                list_remove(&cfg->demod->r_devs, i, (list_elem_free_fn)flex_free_device);
+                i--; // so we don't skip the next elem now shifted down
+                protocols_removed++;
+            }
+        }
+        for (void **iter = flex_devs.elems; iter && *iter; ++iter) {
+            r_device *flex_device = *iter;
+            if (find_protocol(cfg, 0, flex_device->name)) {
+                flex_free_device(flex_device);
+                continue;
+            }
+            register_protocol(cfg, flex_device, "");
+            free(flex_device); // the registered copy keeps the decode_ctx and name
+            protocols_added++;
+        }
+        list_free_elems(&flex_devs, NULL);
+    }
+
+    // apply outputs, matched by spec, outputs from the command line or the HTTP API stay
+    int outputs_added = 0;
+    int outputs_removed = 0;
+    if (output_specs.len) {
+        for (size_t c = cfg->conf_outputs.len; c > 0; --c) {
+            char const *spec = cfg->conf_outputs.elems[c - 1];
+            size_t i = cfg->output_specs.len;
+            while (i > 0 && strcmp(cfg->output_specs.elems[i - 1], spec))
+                --i;
+            if (i > 0 && find_spec(&output_specs, spec))
+                continue;
+            if (i > 0) {
+                remove_output(cfg, (unsigned)(i - 1));
+                outputs_removed++;
+            }
+            // not running anymore (removed over HTTP) or not wanted, a wanted one is added again below
+            list_remove(&cfg->conf_outputs, c - 1, free);
+        }
+        for (void **iter = output_specs.elems; iter && *iter; ++iter) {
+            if (find_spec(&cfg->conf_outputs, *iter))
+                continue;
+            if (add_output(cfg, *iter) < 0) {
+                print_logf(LOG_ERROR, "Reload", "Invalid output format: %s", (char *)*iter);
+                continue;
+            }
+            start_output(cfg, cfg->output_handler.elems[cfg->output_handler.len - 1]);
+            char *spec = strdup(*iter);
+            if (!spec)
+                FATAL_STRDUP("reload_conf_file()");
+            list_push(&cfg->conf_outputs, spec);
+            outputs_added++;
+        }
+    }
+
+    // apply hop times and frequencies
+    if (hop_times) {
+        memcpy(cfg->hop_time, hop_time, sizeof(hop_time));
+        cfg->hop_times = hop_times;
+    }
+    if (frequencies && (frequencies != cfg->frequencies
+            || memcmp(frequency, cfg->frequency, frequencies * sizeof(*frequency)))) {
+        set_hop_frequencies(cfg, frequency, frequencies);
+    }
+
+    update_dispatch(cfg);
+
+    print_logf(LOG_NOTICE, "Reload", "Reloaded \"%s\": %d protocols added, %d removed, %d outputs added, %d removed%s",
+            cfg->conf_file, protocols_added, protocols_removed, outputs_added, outputs_removed,
+            ignored ? ", other options need a restart" : "");
+
+    free(conf);
+    free(want);
+    free(want_args);
+    list_free_elems(&output_specs, NULL);
+}
+
 static r_cfg_t g_cfg;
 
 // TODO: SIGINFO is not in POSIX...
@@ -1335,6 +1691,10 @@ static void sighandler(int signum)
         g_cfg.hop_now = 1;
         return;
     }
+    else if (signum == SIGHUP) {
+        g_cfg.reload_now = 1;
+        return;
+    }
     else {
         write_err("Signal caught, exiting!\n");
     }
@@ -1393,6 +1753,9 @@ static void sdr_handler(struct mg_connection *nc, int ev_type, void *ev_data)
     }
 
     if (ev->ev == SDR_EV_DATA) {
+        // AFC offsets are relative to the center frequency
+        if (cfg->demod->fsk_afc && cfg->center_frequency != ev->center_frequency)
+            fsk_afc_reset(cfg->demod->fsk_afc);
         cfg->samp_rate        = ev->sample_rate;
         cfg->center_frequency = ev->center_frequency;
         sdr_callback((unsigned char *)ev->buf, ev->len, cfg);
@@ -1545,6 +1908,8 @@ int main(int argc, char **argv) {
     int r = 0;
     struct dm_state *demod;
     r_cfg_t *cfg = &g_cfg;
+    struct timeval startup_tv;
+    get_time_now(&startup_tv);
 
     print_version(); // always print the version info
     sdr_redirect_logging();
@@ -1595,7 +1960,14 @@ int main(int argc, char **argv) {
     }
 
     if (cfg->report_time == REPORT_TIME_DEFAULT) {
-        if (cfg->in_files.len)
+        // a pulse archive carries the wall clock time of each package
+        int archives_only = cfg->in_files.len > 0;
+        for (void **iter = cfg->in_files.elems; iter && *iter; ++iter) {
+            file_info_t info = {0};
+            file_info_parse_filename(&info, *iter);
+            archives_only &= info.format == PULSE_ARCHIVE;
+        }
+        if (cfg->in_files.len && !archives_only)
             cfg->report_time = REPORT_TIME_SAMPLES;
         else
             cfg->report_time = REPORT_TIME_DATE;
@@ -1627,13 +1999,7 @@ int main(int argc, char **argv) {
     }
 
     // check if we need FM demod
-    for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
-        r_device *r_dev = *iter;
-        if (r_dev->modulation >= FSK_DEMOD_MIN_VAL) {
-          demod->enable_FM_demod = 1;
-          break;
-        }
-    }
+    update_dispatch(cfg);
 
     {
         char decoders_str[1024];
@@ -1666,6 +2032,14 @@ int main(int argc, char **argv) {
     start_outputs(cfg, well_known);
     free((void *)well_known);
 
+    {
+        struct timeval now_tv, startup_time;
+        get_time_now(&now_tv);
+        timeval_subtract(&startup_time, &now_tv, &startup_tv);
+        cfg->startup_us = startup_time.tv_sec * 1000000 + startup_time.tv_usec;
+        print_logf(LOG_INFO, "rtl_433", "Startup took %u us", cfg->startup_us);
+    }
+
     if (cfg->out_block_size < MINIMAL_BUF_LENGTH ||
             cfg->out_block_size > MAXIMAL_BUF_LENGTH) {
         print_logf(LOG_ERROR, "Block Size",
@@ -1740,9 +2114,9 @@ int main(int argc, char **argv) {
                 pulse_data_t pulse_data = {0};
                 rfraw_parse(&pulse_data, line);
                 if (!pulse_data.fsk_f2_est)
-                    r += run_ook_demods(&demod->r_devs, &pulse_data);
+                    r += run_ook_dispatch(cfg, &pulse_data);
                 else
-                    r += run_fsk_demods(&demod->r_devs, &pulse_data);
+                    r += run_fsk_dispatch(cfg, &pulse_data);
             } else
             for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
                 r_device *r_dev = *iter;
@@ -1766,9 +2140,9 @@ int main(int argc, char **argv) {
             pulse_data_t pulse_data = {0};
             rfraw_parse(&pulse_data, cfg->test_data);
             if (!pulse_data.fsk_f2_est)
-                r += run_ook_demods(&demod->r_devs, &pulse_data);
+                r += run_ook_dispatch(cfg, &pulse_data);
             else
-                r += run_fsk_demods(&demod->r_devs, &pulse_data);
+                r += run_fsk_dispatch(cfg, &pulse_data);
         } else
         for (void **iter = demod->r_devs.elems; iter && *iter; ++iter) {
             r_device *r_dev = *iter;
@@ -1794,15 +2168,49 @@ int main(int argc, char **argv) {
             cfg->stop_time += cfg->duration;
         }
 
+        char *in_path = NULL;
         for (void **iter = cfg->in_files.elems; iter && *iter; ++iter) {
             cfg->in_filename = *iter;
 
+            // pulse archive replay options follow the path, e.g. "archive.rpa,from=2024-05-01T10:00"
+            char const *replay_opts = strstr(cfg->in_filename, ".rpa,");
+            free(in_path);
+            in_path = NULL;
+            if (replay_opts) {
+                replay_opts += 4;
+                in_path = strdup(cfg->in_filename);
+                if (!in_path)
+                    FATAL_STRDUP("in_path");
+                in_path[replay_opts - cfg->in_filename] = '\0';
+            }
+
             file_info_clear(&demod->load_info); // reset all info
-            file_info_parse_filename(&demod->load_info, cfg->in_filename);
+            file_info_parse_filename(&demod->load_info, in_path ? in_path : cfg->in_filename);
             // apply file info or default
             cfg->samp_rate        = demod->load_info.sample_rate ? demod->load_info.sample_rate : sample_rate_0;
             cfg->center_frequency = demod->load_info.center_frequency ? demod->load_info.center_frequency : cfg->frequency[0];
 
+            // special case for pulse archive file-inputs
+            if (demod->load_info.format == PULSE_ARCHIVE) {
+                print_logf(LOG_CRITICAL, "Input", "Test mode active. Replaying pulse archive: %s", cfg->in_filename); // Essential information (not quiet)
+                // workers can't share the dumpers and most outputs, replay in one process then
+                char const *jobs = demod->dumper.len || demod->pulse_archive || !outputs_shareable(cfg) ? ",jobs=1" : "";
+                char *spec       = malloc(strlen(demod->load_info.path) + strlen(replay_opts ? replay_opts : "") + strlen(jobs) + 1);
+                if (!spec)
+                    FATAL_MALLOC("spec");
+                sprintf(spec, "%s%s%s", demod->load_info.path, replay_opts ? replay_opts : "", jobs);
+                int replayed = pulse_archive_replay(spec, replay_package, cfg);
+                free(spec);
+                if (replayed < 0) {
+                    print_logf(LOG_ERROR, "Input", "Replaying \"%s\" failed!", cfg->in_filename);
+                    break;
+                }
+                if (cfg->verbosity >= LOG_NOTICE && replayed > 0) {
+                    print_logf(LOG_NOTICE, "Input", "Pulse archive issued %d packages", replayed);
+                }
+                continue;
+            }
+
             FILE *in_file;
             if (strcmp(demod->load_info.path, "-") == 0) { // read samples from stdin
                 in_file = stdin;
@@ -1852,12 +2260,16 @@ int main(int argc, char **argv) {
                             exit(1);
                         }
                     }
+                    if (demod->pulse_archive) {
+                        get_time_now(&demod->now);
+                        pulse_archive_write(demod->pulse_archive, &demod->pulse_data, demod->pulse_data.fsk_f2_est != 0, package_time_us(cfg, &demod->pulse_data));
+                    }
 
                     if (demod->pulse_data.fsk_f2_est) {
-                        run_fsk_demods(&demod->r_devs, &demod->pulse_data);
+                        run_fsk_dispatch(cfg, &demod->pulse_data);
                     }
                     else {
-                        int p_events = run_ook_demods(&demod->r_devs, &demod->pulse_data);
+                        int p_events = run_ook_dispatch(cfg, &demod->pulse_data);
                         if (cfg->verbosity >= LOG_DEBUG)
                             pulse_data_print(&demod->pulse_data);
                         if (demod->analyze_pulses && (cfg->grab_mode <= 1 || (cfg->grab_mode == 2 && p_events == 0) || (cfg->grab_mode == 3 && p_events > 0))) {
@@ -1940,6 +2352,7 @@ int main(int argc, char **argv) {
                 fclose(in_file = stdin);
         }
 
+        free(in_path);
         close_dumpers(cfg);
         free(test_mode_buf);
         free(test_mode_float_buf);
@@ -1964,6 +2377,7 @@ int main(int argc, char **argv) {
     sigaction(SIGPIPE, &sigact, NULL);
     sigaction(SIGUSR1, &sigact, NULL);
     sigaction(SIGINFO, &sigact, NULL);
+    sigaction(SIGHUP, &sigact, NULL);
 #else
     SetConsoleCtrlHandler((PHANDLER_ROUTINE)console_handler, TRUE);
 #endif
@@ -1993,6 +2407,11 @@ int main(int argc, char **argv) {
 
     while (!cfg->exit_async) {
         mg_mgr_poll(cfg->mgr, 500);
+        // SDR blocks are processed in the poll, apply a reload in between
+        if (cfg->reload_now) {
+            cfg->reload_now = 0;
+            reload_conf_file(cfg);
+        }
     }
     if (cfg->verbosity >= LOG_INFO)
         print_log(LOG_INFO, "rtl_433", "stopping...");
@@ -0,0 +1,409 @@
+/** @file
+    Durable on-disk event spool for network outputs.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "spool.h"
+#include "logger.h"
+#include "fatal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SPOOL_SEGMENT_SIZE (1024 * 1024)
+#define SPOOL_MAX_BYTES (64 * 1024 * 1024)
+#define SPOOL_MAX_AGE (7 * 24 * 3600)
+
+/*
+Segment files are named by the hex sequence number of the first record.
+Each record is a header of length and unix time followed by the data,
+padded to 8 bytes. A zero length marks the end of the segment, the length
+is written last so a partially written record is never seen.
+*/
+typedef struct {
+    uint32_t len;
+    uint32_t time;
+} spool_rec_t;
+
+typedef struct {
+    uint64_t first;     ///< sequence number of the first record
+    unsigned count;     ///< number of records
+    size_t used;        ///< bytes used
+    uint32_t last_time; ///< time of the newest record
+    char *map;
+} spool_seg_t;
+
+struct spool {
+    char *path;
+    size_t max_bytes;
+    unsigned max_age;
+    spool_seg_t *segs;
+    unsigned seg_count;
+    unsigned seg_cap;
+    uint64_t *cursor; ///< mapped acknowledged sequence number
+    uint64_t next;
+    uint64_t dropped;
+    // cache of the last read position
+    unsigned read_seg;
+    uint64_t read_seq;
+    size_t read_pos;
+};
+
+static size_t spool_rec_size(size_t len)
+{
+    return (sizeof(spool_rec_t) + len + 7) & ~(size_t)7;
+}
+
+static void *spool_map_file(char const *name, size_t size)
+{
+    int fd = open(name, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        print_logf(LOG_ERROR, "Spool", "Can't open \"%s\": %s", name, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || ((size_t)st.st_size < size && ftruncate(fd, size))) {
+        print_logf(LOG_ERROR, "Spool", "Can't size \"%s\": %s", name, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        print_logf(LOG_ERROR, "Spool", "Can't map \"%s\": %s", name, strerror(errno));
+        return NULL;
+    }
+    return map;
+}
+
+static void spool_seg_name(spool_t *spool, uint64_t first, char *buf, size_t size)
+{
+    snprintf(buf, size, "%s/%016llx.seg", spool->path, (unsigned long long)first);
+}
+
+// walk the records to recover the count and end of a segment
+static void spool_seg_scan(spool_seg_t *seg)
+{
+    seg->count = 0;
+    seg->used  = 0;
+    while (seg->used + sizeof(spool_rec_t) <= SPOOL_SEGMENT_SIZE) {
+        spool_rec_t *rec = (spool_rec_t *)&seg->map[seg->used];
+        if (!rec->len || seg->used + spool_rec_size(rec->len) > SPOOL_SEGMENT_SIZE)
+            break;
+        seg->last_time = rec->time;
+        seg->used += spool_rec_size(rec->len);
+        seg->count++;
+    }
+}
+
+// remove the oldest segment
+static void spool_seg_drop(spool_t *spool)
+{
+    spool_seg_t *seg = &spool->segs[0];
+    uint64_t end     = seg->first + seg->count;
+    if (*spool->cursor + 1 < end) {
+        uint64_t lost = end - 1 - *spool->cursor;
+        spool->dropped += lost;
+        print_logf(LOG_WARNING, "Spool", "Dropping %llu undelivered events from \"%s\"",
+                (unsigned long long)lost, spool->path);
+        *spool->cursor = end - 1;
+    }
+
+    char name[1024];
+    spool_seg_name(spool, seg->first, name, sizeof(name));
+    munmap(seg->map, SPOOL_SEGMENT_SIZE);
+    unlink(name);
+
+    spool->seg_count--;
+    memmove(&spool->segs[0], &spool->segs[1], spool->seg_count * sizeof(spool_seg_t));
+    spool->read_seq = 0; // invalidate read cache
+}
+
+// drop acknowledged, aged and excess segments, always keeps the newest segment
+static void spool_prune(spool_t *spool)
+{
+    uint32_t now = (uint32_t)time(NULL);
+    while (spool->seg_count > 1) {
+        spool_seg_t *seg = &spool->segs[0];
+        if (seg->first + seg->count - 1 <= *spool->cursor
+                || (size_t)spool->seg_count * SPOOL_SEGMENT_SIZE > spool->max_bytes
+                || seg->last_time + spool->max_age < now)
+            spool_seg_drop(spool);
+        else
+            break;
+    }
+}
+
+static spool_seg_t *spool_seg_new(spool_t *spool, uint64_t first)
+{
+    if (spool->seg_count >= spool->seg_cap)
+        spool_seg_drop(spool);
+
+    char name[1024];
+    spool_seg_name(spool, first, name, sizeof(name));
+    char *map = spool_map_file(name, SPOOL_SEGMENT_SIZE);
+    if (!map)
+        return NULL;
+
+    spool_seg_t *seg = &spool->segs[spool->seg_count++];
+    memset(seg, 0, sizeof(*seg));
+    seg->first = first;
+    seg->map   = map;
+    spool_seg_scan(seg);
+    return seg;
+}
+
+static int spool_seg_cmp(void const *a, void const *b)
+{
+    uint64_t fa = ((spool_seg_t const *)a)->first;
+    uint64_t fb = ((spool_seg_t const *)b)->first;
+    return fa < fb ? -1 : fa > fb;
+}
+
+spool_t *spool_open(char const *path, size_t max_bytes, unsigned max_age)
+{
+    if (mkdir(path, 0755) && errno != EEXIST) {
+        print_logf(LOG_ERROR, "Spool", "Can't create spool directory \"%s\": %s", path, strerror(errno));
+        return NULL;
+    }
+
+    spool_t *spool = calloc(1, sizeof(*spool));
+    if (!spool) {
+        WARN_CALLOC("spool_open()");
+        return NULL;
+    }
+    spool->path = strdup(path);
+    if (!spool->path) {
+        WARN_STRDUP("spool_open()");
+        free(spool);
+        return NULL;
+    }
+    spool->max_bytes = max_bytes ? max_bytes : SPOOL_MAX_BYTES;
+    spool->max_age   = max_age ? max_age : SPOOL_MAX_AGE;
+    spool->seg_cap   = spool->max_bytes / SPOOL_SEGMENT_SIZE + 2;
+    spool->segs      = calloc(spool->seg_cap, sizeof(spool_seg_t));
+    if (!spool->segs) {
+        WARN_CALLOC("spool_open()");
+        free(spool->path);
+        free(spool);
+        return NULL;
+    }
+
+    char name[1024];
+    snprintf(name, sizeof(name), "%s/cursor", path);
+    spool->cursor = spool_map_file(name, sizeof(uint64_t));
+    if (!spool->cursor) {
+        spool_close(spool);
+        return NULL;
+    }
+
+    // recover existing segments
+    DIR *dir = opendir(path);
+    struct dirent *ent;
+    while (dir && (ent = readdir(dir)) != NULL) {
+        char *end;
+        unsigned long long first = strtoull(ent->d_name, &end, 16);
+        if (!first || strcmp(end, ".seg") || spool->seg_count >= spool->seg_cap)
+            continue;
+        spool_seg_new(spool, first);
+    }
+    if (dir)
+        closedir(dir);
+    qsort(spool->segs, spool->seg_count, sizeof(spool_seg_t), spool_seg_cmp);
+
+    spool->next = *spool->cursor + 1;
+    if (spool->seg_count) {
+        spool_seg_t *last = &spool->segs[spool->seg_count - 1];
+        if (last->first + last->count > spool->next)
+            spool->next = last->first + last->count;
+    }
+    spool_prune(spool);
+
+    if (spool->next - 1 > *spool->cursor)
+        print_logf(LOG_NOTICE, "Spool", "Resuming \"%s\" with %llu undelivered events",
+                path, (unsigned long long)(spool->next - 1 - *spool->cursor));
+
+    return spool;
+}
+
+void spool_close(spool_t *spool)
+{
+    if (!spool)
+        return;
+
+    for (unsigned i = 0; i < spool->seg_count; ++i)
+        munmap(spool->segs[i].map, SPOOL_SEGMENT_SIZE);
+    if (spool->cursor)
+        munmap(spool->cursor, sizeof(uint64_t));
+    free(spool->segs);
+    free(spool->path);
+    free(spool);
+}
+
+uint64_t spool_append(spool_t *spool, void const *data, size_t len)
+{
+    size_t rec_size = spool_rec_size(len);
+    if (!len || rec_size + sizeof(spool_rec_t) > SPOOL_SEGMENT_SIZE) {
+        print_logf(LOG_WARNING, "Spool", "Can't spool a record of %zu bytes", len);
+        return 0;
+    }
+
+    spool_seg_t *seg = spool->seg_count ? &spool->segs[spool->seg_count - 1] : NULL;
+    // keep a zero length header as end mark
+    if (!seg || seg->first + seg->count != spool->next
+            || seg->used + rec_size + sizeof(spool_rec_t) > SPOOL_SEGMENT_SIZE) {
+        seg = spool_seg_new(spool, spool->next);
+        if (!seg)
+            return 0;
+        spool_prune(spool);
+        seg = &spool->segs[spool->seg_count - 1];
+    }
+
+    spool_rec_t *rec = (spool_rec_t *)&seg->map[seg->used];
+    memcpy(rec + 1, data, len);
+    rec->time = (uint32_t)time(NULL);
+    rec->len  = (uint32_t)len;
+
+    seg->used += rec_size;
+    seg->count++;
+    seg->last_time = rec->time;
+
+    return spool->next++;
+}
+
+int spool_read(spool_t *spool, uint64_t seq, void const **data, size_t *len)
+{
+    if (seq <= *spool->cursor || seq >= spool->next)
+        return 0;
+
+    // continue from the last read if possible, otherwise find the segment
+    if (!spool->read_seq || seq < spool->read_seq
+            || spool->read_seg >= spool->seg_count
+            || seq >= spool->segs[spool->read_seg].first + spool->segs[spool->read_seg].count) {
+        unsigned i = 0;
+        while (i < spool->seg_count && seq >= spool->segs[i].first + spool->segs[i].count)
+            i++;
+        if (i >= spool->seg_count || seq < spool->segs[i].first)
+            return 0;
+        spool->read_seg = i;
+        spool->read_seq = spool->segs[i].first;
+        spool->read_pos = 0;
+    }
+
+    spool_seg_t *seg = &spool->segs[spool->read_seg];
+    while (spool->read_seq < seq) {
+        spool_rec_t *rec = (spool_rec_t *)&seg->map[spool->read_pos];
+        spool->read_pos += spool_rec_size(rec->len);
+        spool->read_seq++;
+    }
+
+    spool_rec_t *rec = (spool_rec_t *)&seg->map[spool->read_pos];
+    *data = rec + 1;
+    *len  = rec->len;
+    return 1;
+}
+
+void spool_ack(spool_t *spool, uint64_t seq)
+{
+    if (seq <= *spool->cursor)
+        return;
+    if (seq >= spool->next)
+        seq = spool->next - 1;
+    *spool->cursor = seq;
+    spool_prune(spool);
+}
+
+uint64_t spool_acked(spool_t const *spool)
+{
+    return *spool->cursor;
+}
+
+uint64_t spool_next(spool_t const *spool)
+{
+    return spool->next;
+}
+
+uint64_t spool_dropped(spool_t const *spool)
+{
+    return spool->dropped;
+}
+
+#else
+// Windows variant, no spool support yet
+
+struct spool {
+    int unused;
+};
+
+spool_t *spool_open(char const *path, size_t max_bytes, unsigned max_age)
+{
+    (void)max_bytes;
+    (void)max_age;
+    print_logf(LOG_ERROR, "Spool", "Spool \"%s\" not supported on this platform", path);
+    return NULL;
+}
+
+void spool_close(spool_t *spool)
+{
+    (void)spool;
+}
+
+uint64_t spool_append(spool_t *spool, void const *data, size_t len)
+{
+    (void)spool;
+    (void)data;
+    (void)len;
+    return 0;
+}
+
+int spool_read(spool_t *spool, uint64_t seq, void const **data, size_t *len)
+{
+    (void)spool;
+    (void)seq;
+    (void)data;
+    (void)len;
+    return 0;
+}
+
+void spool_ack(spool_t *spool, uint64_t seq)
+{
+    (void)spool;
+    (void)seq;
+}
+
+uint64_t spool_acked(spool_t const *spool)
+{
+    (void)spool;
+    return 0;
+}
+
+uint64_t spool_next(spool_t const *spool)
+{
+    (void)spool;
+    return 1;
+}
+
+uint64_t spool_dropped(spool_t const *spool)
+{
+    (void)spool;
+    return 0;
+}
+
+#endif // _WIN32 / !_WIN32
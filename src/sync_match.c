@@ -0,0 +1,431 @@
+/** @file
+    Sync word matching for all decoders in one pass.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+#include "sync_match.h"
+#include "bitbuffer.h"
+#include "r_device.h"
+#include "list.h"
+#include "fatal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYNC_MATCH_MAX_PATTERNS 64 // one bit each in the output masks
+#define SYNC_MATCH_MAX_HITS     64 // more hits fall back to a plain search in the decoder
+
+/// Stepping a whole byte from a state.
+typedef struct {
+    uint16_t next[256]; ///< state after the byte
+    uint8_t hit[256];   ///< a sync word ends within the byte, step the bits to find it
+} sync_step_t;
+
+struct sync_match {
+    unsigned num_patterns;
+    struct sync_word patterns[SYNC_MATCH_MAX_PATTERNS];
+    unsigned num_states;
+    uint16_t (*next)[2]; ///< state after a 0 or 1 bit
+    uint64_t *out;       ///< sync words ending in a state, including the failure states
+    sync_step_t *step;
+
+    bitbuffer_t const *scanned; ///< bitbuffer of the last scan, the hits are for this one
+    unsigned num_hits;
+    int overflow;
+    sync_hit_t hits[SYNC_MATCH_MAX_HITS];
+};
+
+static int sync_word_equal(struct sync_word const *a, uint8_t const *bytes, unsigned bits)
+{
+    if (a->bits != bits)
+        return 0;
+    unsigned full = bits / 8;
+    if (memcmp(a->bytes, bytes, full))
+        return 0;
+    unsigned rest = bits % 8;
+    uint8_t mask  = (uint8_t)(0xff00 >> rest);
+    return !rest || ((a->bytes[full] ^ bytes[full]) & mask) == 0;
+}
+
+int sync_match_pattern(sync_match_t const *sm, uint8_t const *bytes, unsigned bits)
+{
+    if (!sm)
+        return -1;
+    for (unsigned i = 0; i < sm->num_patterns; ++i) {
+        if (sync_word_equal(&sm->patterns[i], bytes, bits))
+            return (int)i;
+    }
+    return -1;
+}
+
+/// Add the sync words of a decoder, returns the mask of the decoder or 0 if they don't fit.
+static uint64_t sync_match_add(sync_match_t *sm, struct sync_word const *syncs)
+{
+    uint64_t mask = 0;
+    for (struct sync_word const *w = syncs; w->bits; ++w) {
+        if (w->bits > 8 * sizeof(w->bytes))
+            return 0;
+        int p = sync_match_pattern(sm, w->bytes, w->bits);
+        if (p < 0) {
+            if (sm->num_patterns >= SYNC_MATCH_MAX_PATTERNS)
+                return 0;
+            p = (int)sm->num_patterns++;
+            sm->patterns[p] = *w;
+        }
+        mask |= (uint64_t)1 << p;
+    }
+    return mask;
+}
+
+static int sync_match_build(sync_match_t *sm)
+{
+    unsigned max_states = 1;
+    for (unsigned p = 0; p < sm->num_patterns; ++p)
+        max_states += sm->patterns[p].bits;
+
+    sm->next = calloc(max_states, sizeof(*sm->next));
+    if (!sm->next) {
+        WARN_CALLOC("sync_match_create()");
+        return -1;
+    }
+    sm->out = calloc(max_states, sizeof(*sm->out));
+    if (!sm->out) {
+        WARN_CALLOC("sync_match_create()");
+        return -1;
+    }
+    unsigned *fail = calloc(max_states, sizeof(*fail));
+    if (!fail) {
+        WARN_CALLOC("sync_match_create()");
+        return -1;
+    }
+
+    // trie of the sync words, state 0 is the root and never a child
+    sm->num_states = 1;
+    for (unsigned p = 0; p < sm->num_patterns; ++p) {
+        struct sync_word const *w = &sm->patterns[p];
+        unsigned s = 0;
+        for (unsigned i = 0; i < w->bits; ++i) {
+            int bit = (w->bytes[i / 8] >> (7 - i % 8)) & 1;
+            if (!sm->next[s][bit])
+                sm->next[s][bit] = (uint16_t)sm->num_states++;
+            s = sm->next[s][bit];
+        }
+        sm->out[s] |= (uint64_t)1 << p;
+    }
+
+    // failure links breadth first, missing edges become the edges of the failure state
+    unsigned *queue = calloc(sm->num_states, sizeof(*queue));
+    if (!queue) {
+        WARN_CALLOC("sync_match_create()");
+        free(fail);
+        return -1;
+    }
+    unsigned head = 0;
+    unsigned tail = 0;
+    for (int bit = 0; bit < 2; ++bit) {
+        unsigned v = sm->next[0][bit];
+        if (v)
+            queue[tail++] = v; // failure state is the root
+    }
+    while (head < tail) {
+        unsigned u = queue[head++];
+        for (int bit = 0; bit < 2; ++bit) {
+            unsigned v = sm->next[u][bit];
+            if (v) {
+                fail[v] = sm->next[fail[u]][bit];
+                sm->out[v] |= sm->out[fail[v]];
+                queue[tail++] = v;
+            }
+            else {
+                sm->next[u][bit] = sm->next[fail[u]][bit];
+            }
+        }
+    }
+    free(queue);
+    free(fail);
+
+    // byte steps
+    sm->step = malloc(sm->num_states * sizeof(*sm->step));
+    if (!sm->step) {
+        WARN_MALLOC("sync_match_create()");
+        return -1;
+    }
+    for (unsigned s = 0; s < sm->num_states; ++s) {
+        for (unsigned byte = 0; byte < 256; ++byte) {
+            unsigned t   = s;
+            uint64_t hit = 0;
+            for (int i = 7; i >= 0; --i) {
+                t = sm->next[t][(byte >> i) & 1];
+                hit |= sm->out[t];
+            }
+            sm->step[s].next[byte] = (uint16_t)t;
+            sm->step[s].hit[byte]  = hit != 0;
+        }
+    }
+    return 0;
+}
+
+sync_match_t *sync_match_create(list_t *r_devs)
+{
+    sync_match_t *sm = calloc(1, sizeof(*sm));
+    if (!sm) {
+        WARN_CALLOC("sync_match_create()");
+        return NULL; // NOTE: returns NULL on alloc failure.
+    }
+
+    for (void **iter = r_devs->elems; iter && *iter; ++iter) {
+        r_device *r_dev  = *iter;
+        r_dev->sync_mask = r_dev->syncs ? sync_match_add(sm, r_dev->syncs) : 0;
+    }
+    if (!sm->num_patterns || sync_match_build(sm) < 0) {
+        sync_match_free(sm);
+        sm = NULL;
+    }
+
+    // decoders without (usable) sync words always run
+    for (void **iter = r_devs->elems; iter && *iter; ++iter) {
+        r_device *r_dev   = *iter;
+        r_dev->sync_match = sm && r_dev->sync_mask ? sm : NULL;
+    }
+    return sm;
+}
+
+void sync_match_free(sync_match_t *sm)
+{
+    if (!sm)
+        return;
+    free(sm->next);
+    free(sm->out);
+    free(sm->step);
+    free(sm);
+}
+
+/// Step single bits, the top @p n bits of @p byte, and record the hits.
+static unsigned sync_match_bits(sync_match_t *sm, unsigned state, uint8_t byte, unsigned n, unsigned row, unsigned pos, uint64_t *seen)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        state         = sm->next[state][(byte >> (7 - i)) & 1];
+        uint64_t hits = sm->out[state];
+        if (!hits)
+            continue;
+        *seen |= hits;
+        for (unsigned p = 0; p < sm->num_patterns; ++p) {
+            if (!(hits >> p & 1))
+                continue;
+            if (sm->num_hits >= SYNC_MATCH_MAX_HITS) {
+                sm->overflow = 1;
+                continue;
+            }
+            sm->hits[sm->num_hits++] = (sync_hit_t){
+                    .row     = (uint16_t)row,
+                    .offset  = (uint16_t)(pos + i + 1 - sm->patterns[p].bits),
+                    .pattern = p,
+            };
+        }
+    }
+    return state;
+}
+
+uint64_t sync_match_scan(sync_match_t *sm, bitbuffer_t const *bitbuffer)
+{
+    uint64_t seen = 0;
+    sm->scanned   = bitbuffer;
+    sm->num_hits  = 0;
+    sm->overflow  = 0;
+
+    for (unsigned row = 0; row < bitbuffer->num_rows; ++row) {
+        uint8_t const *bits = bitbuffer->bb[row];
+        unsigned const len  = bitbuffer->bits_per_row[row];
+        unsigned const full = len / 8;
+        unsigned state      = 0;
+        for (unsigned i = 0; i < full; ++i) {
+            sync_step_t const *step = &sm->step[state];
+            if (!step->hit[bits[i]])
+                state = step->next[bits[i]];
+            else
+                state = sync_match_bits(sm, state, bits[i], 8, row, i * 8, &seen);
+        }
+        if (len % 8)
+            sync_match_bits(sm, state, bits[full], len % 8, row, full * 8, &seen);
+    }
+    return seen;
+}
+
+void sync_match_done(sync_match_t *sm)
+{
+    sm->scanned = NULL;
+}
+
+sync_hit_t const *sync_match_hits(sync_match_t const *sm, bitbuffer_t const *bitbuffer, unsigned *count)
+{
+    if (!sm || sm->scanned != bitbuffer || sm->overflow)
+        return NULL;
+    *count = sm->num_hits;
+    return sm->hits;
+}
+
+// Unit testing
+#ifdef _TEST
+#include "decoder_util.h"
+
+#define ASSERT(expr) \
+    do { \
+        if (expr) { \
+            ++passed; \
+        } else { \
+            ++failed; \
+            fprintf(stderr, "FAIL: line %d: %s\n", __LINE__, #expr); \
+        } \
+    } while (0)
+
+static void add_bits(bitbuffer_t *bits, uint8_t const *bytes, unsigned len)
+{
+    for (unsigned i = 0; i < len; ++i)
+        bitbuffer_add_bit(bits, (bytes[i / 8] >> (7 - i % 8)) & 1);
+}
+
+/// Count the searches where decoder_sync_search() and bitbuffer_search() differ, from every start in every row.
+static unsigned search_mismatches(r_device *dev, bitbuffer_t *bits, struct sync_word const *w)
+{
+    unsigned mismatches = 0;
+    for (unsigned row = 0; row < bits->num_rows; ++row) {
+        for (unsigned start = 0; start <= bits->bits_per_row[row]; ++start) {
+            unsigned want = bitbuffer_search(bits, row, start, w->bytes, w->bits);
+            unsigned got  = decoder_sync_search(dev, bits, row, start, w->bytes, w->bits);
+            if (got != want) {
+                fprintf(stderr, "row %u start %u bits %u: %u <> %u\n", row, start, w->bits, got, want);
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+int main(void)
+{
+    unsigned passed = 0;
+    unsigned failed = 0;
+
+    fprintf(stderr, "sync_match:: test\n");
+
+    // 0xaa2d and 0x2dd4 overlap in 0xaa2dd4, the 36 bit word is a prefix of the 37 bit word
+    static struct sync_word const syncs_a[] = {
+            {{0xaa, 0x2d}, 16},
+            {{0x2d, 0xd4}, 16},
+            {{0xaa, 0xaa}, 16},
+            {{0}, 0},
+    };
+    static struct sync_word const syncs_b[] = {
+            {{0x2d, 0xd4}, 16},
+            {{0xa5, 0x90}, 12},
+            {{0x12, 0x34, 0x56, 0x78, 0x90}, 36},
+            {{0x12, 0x34, 0x56, 0x78, 0x98}, 37},
+            {{0}, 0},
+    };
+    r_device dev_a = {.name = "a", .syncs = syncs_a};
+    r_device dev_b = {.name = "b", .syncs = syncs_b};
+    r_device dev_c = {.name = "c"};
+
+    list_t r_devs = {0};
+    list_push(&r_devs, &dev_a);
+    list_push(&r_devs, &dev_b);
+    list_push(&r_devs, &dev_c);
+
+    fprintf(stderr, "TEST: sync_match:: Create\n");
+    sync_match_t *sm = sync_match_create(&r_devs);
+    ASSERT(sm != NULL);
+    if (!sm) {
+        fprintf(stderr, "sync_match:: test (%u/%u) passed, (%u) failed.\n", passed, passed + failed, failed);
+        return 1;
+    }
+    ASSERT(dev_a.sync_match == sm && dev_b.sync_match == sm);
+    ASSERT(dev_c.sync_match == NULL && dev_c.sync_mask == 0);
+    ASSERT(dev_a.sync_mask == 0x07 && dev_b.sync_mask == 0x3a); // 0x2dd4 is shared
+    ASSERT(sync_match_pattern(sm, syncs_b[2].bytes, 36) == 4);
+    ASSERT(sync_match_pattern(sm, syncs_b[3].bytes, 37) == 5);
+    ASSERT(sync_match_pattern(sm, (uint8_t const *)"\xa5\x9f", 12) == 3); // bits past the length are ignored
+    ASSERT(sync_match_pattern(sm, (uint8_t const *)"\xa5\x90", 13) == -1);
+
+    bitbuffer_t bits = {0};
+    uint8_t const junk[] = {0x5b, 0x3c};
+    uint8_t const overlap[] = {0xaa, 0x2d, 0xd4};
+    uint8_t const long37[] = {0x12, 0x34, 0x56, 0x78, 0x98};
+    uint8_t const long36[] = {0x12, 0x34, 0x56, 0x78, 0x90};
+
+    // row 0: overlapping words at an odd offset, then both long words
+    add_bits(&bits, junk, 3);
+    add_bits(&bits, overlap, 24);
+    add_bits(&bits, junk, 5);
+    add_bits(&bits, long37, 37);
+    add_bits(&bits, junk, 2);
+    add_bits(&bits, long36, 36);
+    add_bits(&bits, junk, 4);
+    // row 1: the 12 bit word twice, the row ends mid-byte with it
+    bitbuffer_add_row(&bits);
+    add_bits(&bits, syncs_b[1].bytes, 12);
+    add_bits(&bits, junk, 7);
+    add_bits(&bits, syncs_b[1].bytes, 12);
+    // row 2: the 36 bit word at the end of a row, not the 37 bit word
+    bitbuffer_add_row(&bits);
+    add_bits(&bits, junk, 9);
+    add_bits(&bits, long36, 36);
+
+    fprintf(stderr, "TEST: sync_match:: Scan\n");
+    uint64_t seen = sync_match_scan(sm, &bits);
+    ASSERT(seen == 0x3b); // all but 0xaaaa
+    unsigned count = 0;
+    sync_hit_t const *hits = sync_match_hits(sm, &bits, &count);
+    ASSERT(hits != NULL);
+    ASSERT(count == 8);
+    if (hits && count == 8) {
+        ASSERT(hits[0].row == 0 && hits[0].offset == 3 && hits[0].pattern == 0);
+        ASSERT(hits[1].row == 0 && hits[1].offset == 11 && hits[1].pattern == 1);
+        ASSERT(hits[2].row == 0 && hits[2].offset == 32 && hits[2].pattern == 4);
+        ASSERT(hits[3].row == 0 && hits[3].offset == 32 && hits[3].pattern == 5);
+        ASSERT(hits[4].row == 0 && hits[4].offset == 71 && hits[4].pattern == 4);
+        ASSERT(hits[5].row == 1 && hits[5].offset == 0 && hits[5].pattern == 3);
+        ASSERT(hits[6].row == 1 && hits[6].offset == 19 && hits[6].pattern == 3);
+        ASSERT(hits[7].row == 2 && hits[7].offset == 9 && hits[7].pattern == 4);
+    }
+    ASSERT(sync_match_hits(sm, NULL, &count) == NULL);
+
+    fprintf(stderr, "TEST: sync_match:: Search from every start\n");
+    for (struct sync_word const *w = syncs_a; w->bits; ++w)
+        ASSERT(search_mismatches(&dev_a, &bits, w) == 0);
+    for (struct sync_word const *w = syncs_b; w->bits; ++w)
+        ASSERT(search_mismatches(&dev_b, &bits, w) == 0);
+    // not a declared sync word, searches the row
+    static struct sync_word const other = {{0xd4}, 6};
+    ASSERT(search_mismatches(&dev_a, &bits, &other) == 0);
+
+    fprintf(stderr, "TEST: sync_match:: Hits overflow\n");
+    bitbuffer_t preamble = {0};
+    for (int i = 0; i < 20; ++i)
+        add_bits(&preamble, overlap, 8); // 73 overlapping 0xaaaa
+    add_bits(&preamble, overlap, 24);
+    seen = sync_match_scan(sm, &preamble);
+    ASSERT(seen == 0x07);
+    ASSERT(sync_match_hits(sm, &preamble, &count) == NULL);
+    for (struct sync_word const *w = syncs_a; w->bits; ++w)
+        ASSERT(search_mismatches(&dev_a, &preamble, w) == 0);
+
+    fprintf(stderr, "TEST: sync_match:: Done\n");
+    sync_match_scan(sm, &bits);
+    sync_match_done(sm);
+    ASSERT(sync_match_hits(sm, &bits, &count) == NULL);
+
+    sync_match_free(sm);
+    list_free_elems(&r_devs, NULL);
+
+    fprintf(stderr, "sync_match:: test (%u/%u) passed, (%u) failed.\n", passed, passed + failed, failed);
+
+    return failed > 0 ? 1 : 0;
+}
+#endif /* _TEST */
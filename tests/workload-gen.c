@@ -0,0 +1,364 @@
+/** @file
+    Synthetic workload generator.
+
+    Writes a CU8 IQ file and an OOK pulse file with a reproducible mix of
+    signals, used to train and benchmark the profile-guided optimized build.
+
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+*/
+
+// gcc -Wall -o workload-gen tests/workload-gen.c -lm && ./workload-gen DIR [ROUNDS]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SAMPLE_RATE 1000000 // 1 us per sample
+#define IQ_FILE "workload_915M_1000k.cu8"
+#define OOK_FILE "workload_1000k.ook"
+
+/*
+The workload is a number of rounds, each with:
+- OOK PWM, PPM, and Manchester coded packets with repeated rows,
+- Oregon Scientific v2.1 and v3 packets with a valid checksum,
+- a FSK PCM packet with a common 0x2dd4 sync word,
+- Gridstream v4 and v5 frames (subtypes 0x55, 0xD5, 0xD2) with valid CRC
+  at each of the three bit widths of the Gridstream decoders.
+The OOK packets are also written as pulse data.
+Payloads come from a fixed seed, noise is added to the IQ samples.
+*/
+
+static uint32_t rand_state = 0x433u;
+
+static uint32_t lcg_rand(void)
+{
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 8;
+}
+
+/// Roughly gaussian noise of about @p amp LSB.
+static double noise(double amp)
+{
+    double sum = 0.0;
+    for (int i = 0; i < 4; ++i)
+        sum += (double)(lcg_rand() & 0xffff) / 0xffff - 0.5;
+    return sum * amp;
+}
+
+static FILE *iq_file;
+static FILE *ook_file;
+static double phase;
+static uint64_t total_samples;
+
+static void put_sample(double amp, double freq)
+{
+    phase += 2.0 * M_PI * freq / SAMPLE_RATE;
+    if (phase > M_PI)
+        phase -= 2.0 * M_PI;
+    if (phase < -M_PI)
+        phase += 2.0 * M_PI;
+    double i = 127.5 + amp * cos(phase) + noise(6.0);
+    double q = 127.5 + amp * sin(phase) + noise(6.0);
+    uint8_t iq[2];
+    iq[0] = (uint8_t)(i < 0 ? 0 : i > 255 ? 255 : i);
+    iq[1] = (uint8_t)(q < 0 ? 0 : q > 255 ? 255 : q);
+    fwrite(iq, 1, 2, iq_file);
+    total_samples++;
+}
+
+static void silence(unsigned us)
+{
+    for (unsigned n = 0; n < us; ++n)
+        put_sample(0.0, 0.0);
+}
+
+/// OOK carrier on (@p on set) or off for @p us, also logged as pulse data.
+static unsigned ook_pulse;
+static unsigned ook_count;
+
+static void ook(int on, unsigned us)
+{
+    for (unsigned n = 0; n < us; ++n)
+        put_sample(on ? 60.0 : 0.0, 25000.0);
+    if (on) {
+        ook_pulse = us;
+    }
+    else {
+        fprintf(ook_file, "%u %u\n", ook_pulse, us);
+        ook_count++;
+    }
+}
+
+static void ook_end(unsigned gap)
+{
+    ook(0, gap);
+    fprintf(ook_file, ";end\n");
+}
+
+static void ook_start(void)
+{
+    fprintf(ook_file, ";ook\n;freq1 25000\n");
+}
+
+static void fsk_bits(uint8_t const *bits, unsigned num_bits, unsigned bit_us, double deviation)
+{
+    for (unsigned n = 0; n < num_bits; ++n) {
+        int bit = (bits[n / 8] >> (7 - n % 8)) & 1;
+        for (unsigned s = 0; s < bit_us; ++s)
+            put_sample(60.0, bit ? deviation : -deviation);
+    }
+}
+
+static void pwm_packet(void)
+{
+    uint8_t msg[5];
+    for (int i = 0; i < 5; ++i)
+        msg[i] = (uint8_t)lcg_rand();
+    ook_start();
+    for (int row = 0; row < 4; ++row) {
+        for (int n = 0; n < 40; ++n) {
+            int bit = (msg[n / 8] >> (7 - n % 8)) & 1;
+            ook(1, bit ? 500 : 1500);
+            ook(0, n == 39 ? 4000 : bit ? 1500 : 500);
+        }
+    }
+    ook_end(10000);
+}
+
+static void ppm_packet(void)
+{
+    uint8_t msg[5];
+    for (int i = 0; i < 5; ++i)
+        msg[i] = (uint8_t)lcg_rand();
+    ook_start();
+    for (int row = 0; row < 6; ++row) {
+        for (int n = 0; n < 36; ++n) {
+            int bit = (msg[n / 8] >> (7 - n % 8)) & 1;
+            ook(1, 500);
+            ook(0, bit ? 2000 : 1000);
+        }
+        ook(1, 500);
+        ook(0, 9000);
+    }
+    ook_end(10000);
+}
+
+/// Manchester coded OOK at 488 us half bits, a 1 is a pulse then a gap, leading 0 bits start with the first pulse.
+static void manchester_bits(uint8_t const *msg, unsigned num_bits)
+{
+    ook_start();
+    int level    = 0;
+    int started  = 0; // the leading gap is skipped
+    unsigned run = 0;
+    for (unsigned n = 0; n < num_bits; ++n) {
+        int bit = (msg[n / 8] >> (7 - n % 8)) & 1;
+        // two half bits, equal levels merge into one pulse or gap
+        for (int h = 0; h < 2; ++h) {
+            int l = h ? !bit : bit;
+            if (l != level) {
+                if (run)
+                    ook(level, run);
+                level = l;
+                run   = 0;
+            }
+            started |= level;
+            if (started)
+                run += 488;
+        }
+    }
+    if (level)
+        ook(1, run);
+    ook_end(10000);
+}
+
+static void manchester_packet(void)
+{
+    uint8_t msg[8] = {0xff, 0xff, 0xa0};
+    for (int i = 3; i < 8; ++i)
+        msg[i] = (uint8_t)lcg_rand();
+    manchester_bits(msg, 64);
+}
+
+static void fsk_packet(void)
+{
+    uint8_t msg[16] = {0xaa, 0xaa, 0xaa, 0x2d, 0xd4};
+    for (int i = 5; i < 16; ++i)
+        msg[i] = (uint8_t)lcg_rand();
+    fsk_bits(msg, sizeof(msg) * 8, 100, 40000.0);
+    silence(5000);
+}
+
+static uint16_t crc16(uint8_t const *msg, unsigned len, uint16_t poly, uint16_t init)
+{
+    uint16_t rem = init;
+    for (unsigned i = 0; i < len; ++i) {
+        rem ^= msg[i] << 8;
+        for (int b = 0; b < 8; ++b)
+            rem = (rem & 0x8000) ? (uint16_t)((rem << 1) ^ poly) : (uint16_t)(rem << 1);
+    }
+    return rem;
+}
+
+static void put_bits(uint8_t *bits, unsigned *pos, uint32_t val, unsigned num_bits)
+{
+    for (unsigned n = num_bits; n > 0; --n) {
+        if ((val >> (n - 1)) & 1)
+            bits[*pos / 8] |= 0x80 >> (*pos % 8);
+        (*pos)++;
+    }
+}
+
+/// An Oregon Scientific v2.1 THGR122N or v3 THGR810 packet with a valid checksum.
+static void oregon_packet(int version)
+{
+    // type code, measurement nibbles, checksum, and trailing nibbles
+    uint8_t nib[20]          = {0x1, 0xd, 0x2, 0x0};
+    unsigned const num_nib   = version == 2 ? 19 : 20;
+    unsigned const cksum_idx = 15;
+    if (version == 3) {
+        nib[0] = 0xf;
+        nib[1] = 0x8;
+        nib[2] = 0x2;
+        nib[3] = 0x4;
+    }
+    for (unsigned i = 4; i < num_nib; ++i)
+        nib[i] = lcg_rand() % 5; // small digits keep the humidity in range
+    nib[11] = 0;                 // and the temperature positive and below 100 C
+    unsigned sum = 0;
+    for (unsigned i = 0; i < cksum_idx; ++i)
+        sum += nib[i];
+    nib[cksum_idx]     = sum & 0xf;
+    nib[cksum_idx + 1] = (sum >> 4) & 0xf;
+
+    // nibbles are sent LSB first, v2.1 sends each bit as a pair of the inverted and the bit
+    uint8_t bits[32] = {0};
+    unsigned pos     = 0;
+    if (version == 2) {
+        put_bits(bits, &pos, 0xff5555, 24);
+        put_bits(bits, &pos, 0x5599, 16);
+        for (unsigned n = 0; n < num_nib * 4; ++n)
+            put_bits(bits, &pos, (nib[n / 4] >> (n % 4)) & 1 ? 1 : 2, 2);
+    }
+    else {
+        put_bits(bits, &pos, 0x00000005, 32);
+        for (unsigned n = 0; n < num_nib * 4; ++n)
+            put_bits(bits, &pos, (nib[n / 4] >> (n % 4)) & 1, 1);
+    }
+    manchester_bits(bits, pos);
+}
+
+/// A Gridstream frame, bytes in UART framing (start bit, LSB first, stop bit) after the sync word.
+static void gridstream_packet(int version, int subtype, unsigned bit_us)
+{
+    static uint16_t const crc_init[] = {0x5fd6, 0xe623, 0xD553};
+
+    uint8_t b[128] = {0x2A, (uint8_t)subtype};
+    unsigned len;
+    unsigned total;
+    if (subtype == 0xD2) {
+        len  = 0x10;
+        b[2] = (uint8_t)len;
+        for (unsigned i = 3; i < len + 1; ++i)
+            b[i] = (uint8_t)lcg_rand();
+        uint16_t crc = crc16(&b[3], len - 2, 0x1021, crc_init[lcg_rand() % 3]);
+        b[len + 1]   = crc >> 8;
+        b[len + 2]   = crc & 0xff;
+        total        = len + 3 + 2; // the decoder expects trailing bytes
+    }
+    else {
+        len  = subtype == 0x55 ? 0x23 : (lcg_rand() & 1) ? 0x47 : 0x1a;
+        b[2] = 0;
+        b[3] = (uint8_t)len;
+        for (unsigned i = 4; i < len + 2; ++i)
+            b[i] = (uint8_t)lcg_rand();
+        uint16_t crc = crc16(&b[4], len - 2, 0x1021, crc_init[lcg_rand() % 3]);
+        b[len + 2]   = crc >> 8;
+        b[len + 3]   = crc & 0xff;
+        total        = len + 4 + 2;
+    }
+
+    uint8_t bits[256] = {0};
+    unsigned pos      = 0;
+    put_bits(bits, &pos, 0xaaaaaa, 24);
+    put_bits(bits, &pos, 0x001, 10);
+    if (version == 4)
+        put_bits(bits, &pos, 0x1ff, 10);
+    else
+        put_bits(bits, &pos, 0x7ff, 11);
+    for (unsigned i = 0; i < total; ++i) {
+        uint8_t rev = 0;
+        for (int k = 0; k < 8; ++k)
+            rev |= ((b[i] >> k) & 1) << (7 - k);
+        put_bits(bits, &pos, 0, 1);
+        put_bits(bits, &pos, rev, 8);
+        put_bits(bits, &pos, 1, 1);
+    }
+    put_bits(bits, &pos, 0xff, 8);
+    fsk_bits(bits, pos, bit_us, 50000.0);
+    silence(25000);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s DIR [ROUNDS]\n", argv[0]);
+        return 1;
+    }
+    char const *dir = argv[1];
+    int rounds      = argc > 2 ? atoi(argv[2]) : 8;
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", dir, IQ_FILE);
+    iq_file = fopen(path, "wb");
+    if (!iq_file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dir, OOK_FILE);
+    ook_file = fopen(path, "w");
+    if (!ook_file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        fclose(iq_file);
+        return 1;
+    }
+    fprintf(ook_file, ";pulse data\n;version 1\n;timescale 1us\n");
+
+    static unsigned const gridstream_us[] = {104, 52, 22};
+    for (int r = 0; r < rounds; ++r) {
+        silence(20000);
+        pwm_packet();
+        silence(20000);
+        ppm_packet();
+        silence(20000);
+        manchester_packet();
+        silence(20000);
+        oregon_packet(2);
+        silence(20000);
+        oregon_packet(3);
+        silence(20000);
+        fsk_packet();
+        for (int w = 0; w < 3; ++w) {
+            gridstream_packet(4, 0x55, gridstream_us[w]);
+            gridstream_packet(5, 0xD5, gridstream_us[w]);
+            gridstream_packet(r & 1 ? 4 : 5, 0xD2, gridstream_us[w]);
+        }
+    }
+    silence(100000);
+
+    fclose(iq_file);
+    fclose(ook_file);
+    printf("Wrote %d rounds, %.1f s of IQ samples and %u OOK pulses to %s\n",
+            rounds, (double)total_samples / SAMPLE_RATE, ook_count, dir);
+    return 0;
+}